@@ -0,0 +1,92 @@
+//***********************************************************************************************
+//Impromptu Modular: Modules for VCV Rack by Marc Boulé
+//***********************************************************************************************
+
+
+#include "AdvGateUtil.hpp"
+
+
+const uint32_t AdvGateTable::builtinHitMasks[NUM_BUILTIN] = 
+{0x00003F, 0x0F0F0F, 0x000FFF, 0x0F0F00, 0x03FFFF, 0xFFFFFF, 0x00000F, 0x03F03F, 0x000F00, 0x03F000, 0x0F0000, 0};
+//	  25%		TRI		  50%		T23		  75%		FUL		  TR1 		DUO		  TR2 	     D2		  TR3  TRIG		
+
+
+AdvGateTable advGates;
+
+
+GatePattern GatePattern::fromTicks(uint64_t ticksLow, uint64_t ticksHigh, bool clockOnSingle) {
+	GatePattern pattern;
+	pattern.ticks[0] = ticksLow;
+	pattern.ticks[1] = ticksHigh & (uint64_t)0xFFFFFFFF;
+	pattern.trig = false;
+	pattern.clockOnSingle = clockOnSingle;
+	return pattern;
+}
+
+
+GatePattern GatePattern::fromHitMask24(uint32_t hitMask, bool clockOnSingle) {
+	uint64_t ticks[2] = {0, 0};
+	for (int t = 0; t < AdvGateTable::TICKS; t++) {
+		if (((hitMask >> (t >> 2)) & 0x1) != 0)
+			ticks[t >> 6] |= ((uint64_t)0x1 << (t & 63));
+	}
+	return fromTicks(ticks[0], ticks[1], clockOnSingle);
+}
+
+
+GatePattern GatePattern::ratchet(int hits, int dutyPercent) {
+	uint64_t ticks[2] = {0, 0};
+	hits = (hits < 1 ? 1 : (hits > AdvGateTable::TICKS ? AdvGateTable::TICKS : hits));
+	for (int h = 0; h < hits; h++) {
+		int start = (h * AdvGateTable::TICKS) / hits;
+		int length = (((h + 1) * AdvGateTable::TICKS) / hits - start) * dutyPercent / 100;
+		if (length < 1)
+			length = 1;// a hit is always at least one tick
+		for (int t = start; t < start + length; t++)
+			ticks[t >> 6] |= ((uint64_t)0x1 << (t & 63));
+	}
+	return fromTicks(ticks[0], ticks[1]);
+}
+
+
+GatePattern GatePattern::trigger() {
+	GatePattern pattern = fromTicks(0, 0);
+	pattern.trig = true;
+	return pattern;
+}
+
+
+AdvGateTable::AdvGateTable() {
+	for (int patternId = 0; patternId < MAX_PATTERNS; patternId++) {
+		if (patternId == GATE_TRIG)
+			setPattern(patternId, GatePattern::trigger());
+		else if (patternId < NUM_BUILTIN)
+			setPattern(patternId, GatePattern::fromHitMask24(builtinHitMasks[patternId], patternId == GATE_25));
+		else 
+			setPattern(patternId, GatePattern::fromTicks(0, 0));
+	}
+}
+
+
+void AdvGateTable::setPattern(int patternId, const GatePattern &pattern) {
+	for (int i = 0; i < 4; i++)
+		codePlanes[0][patternId][i] = 0;
+	for (int pps = 1; pps <= MAX_PPS; pps++) {
+		uint64_t *planes = codePlanes[pps][patternId];
+		for (int i = 0; i < 4; i++)
+			planes[i] = 0;
+		for (int pulse = 0; pulse < pps; pulse++) {
+			int code;
+			if (pattern.trig)
+				code = (pulse == 0 ? 3 : 0);
+			else if (pattern.clockOnSingle && pps == 1)
+				code = 2;
+			else {
+				int tick = pulse * (TICKS / pps);
+				code = (int)((pattern.ticks[tick >> 6] >> (tick & 63)) & (uint64_t)0x1);
+			}
+			planes[pulse >> 6] |= ((uint64_t)(code & 0x1) << (pulse & 63));
+			planes[2 + (pulse >> 6)] |= ((uint64_t)(code >> 1) << (pulse & 63));
+		}
+	}
+}
@@ -0,0 +1,66 @@
+//***********************************************************************************************
+//Impromptu Modular: Modules for VCV Rack by Marc Boulé
+//***********************************************************************************************
+
+#ifndef ADV_GATE_UTIL_HPP
+#define ADV_GATE_UTIL_HPP
+
+
+#include <cstdint>
+
+
+// Advanced gate patterns, shared by PhraseSeq16/32, SemiModularSynth, GateSeq64 and Foundry
+// A pattern is the shape of a gate over one step, at 96 ticks per step (bit t of the pattern is tick t)
+// Pulse k of a step that has pps pulses starts at tick k * (96 / pps), so any pps from 1 to 96 can be used; when pps 
+//   doesn't divide 96 the pulses are 96 / pps ticks apart (rounded down) as they always were in Foundry, so that patches keep their gates
+// Gate codes: 0 = gate off for current pulse, 1 = gate on, 2 = clock high, 3 = trigger
+
+
+struct GatePattern {
+	uint64_t ticks[2];// ticks 0 to 63, then ticks 64 to 95 in the low bits
+	bool trig;// trigger on the first pulse of the step only, ticks are not used
+	bool clockOnSingle;// gate follows the clock when there is only one pulse per step
+	
+	static GatePattern fromTicks(uint64_t ticksLow, uint64_t ticksHigh, bool clockOnSingle = false);
+	static GatePattern fromHitMask24(uint32_t hitMask, bool clockOnSingle = false);// 24 ticks per step masks, each bit is 4 ticks
+	static GatePattern ratchet(int hits, int dutyPercent);// hits evenly spaced in the step, each high for dutyPercent of its share
+	static GatePattern trigger();
+};
+
+
+class AdvGateTable {
+	public:
+	
+	static const int TICKS = 96;
+	static const int MAX_PPS = 96;
+	static const int MAX_PATTERNS = 16;// built-in patterns, then user patterns
+	
+	// Built-in patterns, same numbering as the gate modes in PhraseSeq and the gate types in Foundry
+	enum BuiltinIds {GATE_25, GATE_TRI, GATE_50, GATE_T23, GATE_75, GATE_FUL, GATE_TR1, GATE_DUO, GATE_TR2, GATE_D2, GATE_TR3, GATE_TRIG, NUM_BUILTIN};
+	static const uint32_t builtinHitMasks[NUM_BUILTIN];
+
+	
+	private:
+	
+	// Codes expanded to pulse resolution for each pps, as two bitplanes: bit k of plane n is bit n of the code of pulse k
+	uint64_t codePlanes[MAX_PPS + 1][MAX_PATTERNS][4];// [pps][patternId][plane * 2 + pulse word]
+	
+	
+	public:
+	
+	AdvGateTable();// built-in patterns, user patterns are all off
+	void setPattern(int patternId, const GatePattern &pattern);// user patterns are [NUM_BUILTIN : MAX_PATTERNS - 1]
+	
+	inline int getCode(int patternId, int pulse, int pps) const {// pulse is [0 : pps - 1], no branches
+		const uint64_t *planes = codePlanes[pps][patternId];
+		int word = pulse >> 6;
+		int shift = pulse & 63;
+		return (int)(((planes[word] >> shift) & (uint64_t)0x1) | (((planes[2 + word] >> shift) & (uint64_t)0x1) << 1));
+	}
+};
+
+
+extern AdvGateTable advGates;// built-in patterns only, see AdvGateUtil.cpp
+
+
+#endif
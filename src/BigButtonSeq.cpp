@@ -78,11 +78,13 @@ struct BigButtonSeq : Module {
 	
 
 	unsigned int lightRefreshCounter = 0;	
+	LightState lightState;
 	float bigLight = 0.0f;
 	float metronomeLightStart = 0.0f;
 	float metronomeLightDiv = 0.0f;
 	int chan = 0;
 	int len = 0; 
+	unsigned int gateMask = 0;// one bit per channel, gate of the current step in the channel's bank (see updateGateMask())
 	Trigger clockTrigger;
 	Trigger resetTrigger;
 	Trigger bankTrigger;
@@ -95,21 +97,29 @@ struct BigButtonSeq : Module {
 	PulseGenerator bigLightPulse;
 
 	
-	inline void toggleGate(int chan) {gates[chan][bank[chan]] ^= (((uint64_t)1) << (uint64_t)indexStep);}
-	inline void setGate(int chan) {gates[chan][bank[chan]] |= (((uint64_t)1) << (uint64_t)indexStep);}
-	inline void clearGate(int chan) {gates[chan][bank[chan]] &= ~(((uint64_t)1) << (uint64_t)indexStep);}
+	inline void toggleGate(int chan) {gates[chan][bank[chan]] ^= (((uint64_t)1) << (uint64_t)indexStep); gateMask ^= (1u << chan);}
+	inline void setGate(int chan) {gates[chan][bank[chan]] |= (((uint64_t)1) << (uint64_t)indexStep); gateMask |= (1u << chan);}
+	inline void clearGate(int chan) {gates[chan][bank[chan]] &= ~(((uint64_t)1) << (uint64_t)indexStep); gateMask &= ~(1u << chan);}
 	inline bool getGate(int chan) {return !((gates[chan][bank[chan]] & (((uint64_t)1) << (uint64_t)indexStep)) == 0);}
+	inline void updateGateMask() {// must be called when indexStep, a bank or whole gate words change (the gate functions above keep it up to date)
+		unsigned int mask = 0;
+		for (int c = 0; c < 6; c++)
+			mask |= ((unsigned int)((gates[c][bank[c]] >> (uint64_t)indexStep) & 0x1)) << c;
+		gateMask = mask;
+	}
 	inline int calcChan() {
 		float chanInputValue = inputs[CHAN_INPUT].value / 10.0f * (6.0f - 1.0f);
 		return (int) clamp(roundf(params[CHAN_PARAM].value + chanInputValue), 0.0f, (6.0f - 1.0f));		
 	}
 	
 	BigButtonSeq() : Module(NUM_PARAMS, NUM_INPUTS, NUM_OUTPUTS, NUM_LIGHTS) {		
+		lightState.init(&lights);
 		onReset();
 	}
 
 	
 	void onReset() override {
+		IM_TIME_SCOPE("BigButtonSeq", TIMING_RESET);
 		writeFillsToMemory = false;
 		quantizeBig = true;
 		indexStep = 0;
@@ -118,6 +128,7 @@ struct BigButtonSeq : Module {
 			gates[c][0] = 0;
 			gates[c][1] = 0;
 		}
+		updateGateMask();
 		clockIgnoreOnReset = (long) (clockIgnoreOnResetDuration * engineGetSampleRate());
 		lastPeriod = 2.0;
 		clockTime = 0.0;
@@ -135,10 +146,13 @@ struct BigButtonSeq : Module {
 		// }
 		int chanRnd = calcChan();
 		gates[chanRnd][bank[chanRnd]] = randomu64();
+		updateGateMask();
 	}
 
 	
 	json_t *toJson() override {
+		IM_TIME_SCOPE("BigButtonSeq", TIMING_TOJSON);
+		IM_LOG_LIGHTS("BigButtonSeq", lightState);
 		json_t *rootJ = json_object();
 
 		// indexStep
@@ -177,6 +191,7 @@ struct BigButtonSeq : Module {
 
 
 	void fromJson(json_t *rootJ) override {
+		IM_TIME_SCOPE("BigButtonSeq", TIMING_FROMJSON);
 		// indexStep
 		json_t *indexStepJ = json_object_get(rootJ, "indexStep");
 		if (indexStepJ)
@@ -227,6 +242,8 @@ struct BigButtonSeq : Module {
 		json_t *quantizeBigJ = json_object_get(rootJ, "quantizeBig");
 		if (quantizeBigJ)
 			quantizeBig = json_is_true(quantizeBigJ);
+		
+		updateGateMask();
 	}
 
 	
@@ -260,12 +277,16 @@ struct BigButtonSeq : Module {
 			}
 
 			// Bank button
-			if (bankTrigger.process(params[BANK_PARAM].value + inputs[BANK_INPUT].value))
+			if (bankTrigger.process(params[BANK_PARAM].value + inputs[BANK_INPUT].value)) {
 				bank[chan] = 1 - bank[chan];
+				updateGateMask();
+			}
 			
 			// Clear button
-			if (params[CLEAR_PARAM].value + inputs[CLEAR_INPUT].value > 0.5f)
+			if (params[CLEAR_PARAM].value + inputs[CLEAR_INPUT].value > 0.5f) {
 				gates[chan][bank[chan]] = 0;
+				gateMask &= ~(1u << chan);
+			}
 			
 			// Del button
 			if (params[DEL_PARAM].value + inputs[DEL_INPUT].value > 0.5f) {
@@ -297,6 +318,7 @@ struct BigButtonSeq : Module {
 		if (clockIgnoreOnReset == 0l) {
 			if (clockTrigger.process(inputs[CLK_INPUT].value)) {
 				if ((++indexStep) >= len) indexStep = 0;
+				updateGateMask();
 				
 				// Fill button
 				fillPressed = (params[FILL_PARAM].value + inputs[FILL_INPUT].value) > 0.5f;
@@ -328,6 +350,7 @@ struct BigButtonSeq : Module {
 		// Reset
 		if (resetTrigger.process(params[RESET_PARAM].value + inputs[RESET_INPUT].value)) {
 			indexStep = 0;
+			updateGateMask();
 			outPulse.trigger(0.001f);
 			outLightPulse.trigger(0.02f);
 			metronomeLightStart = 1.0f;
@@ -345,11 +368,9 @@ struct BigButtonSeq : Module {
 		bool bigPulseState = bigPulse.process((float)sampleTime);
 		bool outPulseState = outPulse.process((float)sampleTime);
 		bool retriggingOnReset = (clockIgnoreOnReset != 0l && retrigGatesOnReset);
-		for (int i = 0; i < 6; i++) {
-			bool gate = getGate(i);
-			bool outSignal = (((gate || (i == chan && fillPressed)) && outPulseState) || (gate && bigPulseState && i == chan));
-			outputs[CHAN_OUTPUTS + i].value = ((outSignal && !retriggingOnReset) ? 10.0f : 0.0f);
-		}
+		unsigned int outMask = calcOutMask(outPulseState, bigPulseState) & (0u - (unsigned int)!retriggingOnReset);
+		for (int i = 0; i < 6; i++)
+			outputs[CHAN_OUTPUTS + i].value = (float)((outMask >> i) & 0x1) * 10.0f;
 
 		
 		lightRefreshCounter++;
@@ -359,24 +380,23 @@ struct BigButtonSeq : Module {
 			// Gate light outputs
 			bool bigLightPulseState = bigLightPulse.process((float)sampleTime * displayRefreshStepSkips);
 			bool outLightPulseState = outLightPulse.process((float)sampleTime * displayRefreshStepSkips);
+			unsigned int outLightMask = calcOutMask(outLightPulseState, bigLightPulseState);
 			for (int i = 0; i < 6; i++) {
-				bool gate = getGate(i);
-				bool outLight  = (((gate || (i == chan && fillPressed)) && outLightPulseState) || (gate && bigLightPulseState && i == chan));
-				lights[(CHAN_LIGHTS + i) * 2 + 1].setBrightnessSmooth(outLight ? 1.0f : 0.0f, displayRefreshStepSkips);
-				lights[(CHAN_LIGHTS + i) * 2 + 0].value = (i == chan ? (1.0f - lights[(CHAN_LIGHTS + i) * 2 + 1].value) / 2.0f : 0.0f);
+				lightState.setBrightnessSmooth((CHAN_LIGHTS + i) * 2 + 1, (float)((outLightMask >> i) & 0x1), displayRefreshStepSkips);
+				lightState.set((CHAN_LIGHTS + i) * 2 + 0, (i == chan ? (1.0f - lights[(CHAN_LIGHTS + i) * 2 + 1].value) / 2.0f : 0.0f));
 			}
 
 			// Big button lights
-			lights[BIG_LIGHT].value = bank[chan] == 1 ? 1.0f : 0.0f;
-			lights[BIGC_LIGHT].value = bigLight;
+			lightState.set(BIG_LIGHT, bank[chan] == 1 ? 1.0f : 0.0f);
+			lightState.set(BIGC_LIGHT, bigLight);
 			
 			// Metronome light
-			lights[METRONOME_LIGHT + 1].value = metronomeLightStart;
-			lights[METRONOME_LIGHT + 0].value = metronomeLightDiv;
+			lightState.set(METRONOME_LIGHT + 1, metronomeLightStart);
+			lightState.set(METRONOME_LIGHT + 0, metronomeLightDiv);
 		
 			// Other push button lights
-			lights[WRITEFILL_LIGHT].value = writeFillsToMemory ? 1.0f : 0.0f;
-			lights[QUANTIZEBIG_LIGHT].value = quantizeBig ? 1.0f : 0.0f;
+			lightState.set(WRITEFILL_LIGHT, writeFillsToMemory ? 1.0f : 0.0f);
+			lightState.set(QUANTIZEBIG_LIGHT, quantizeBig ? 1.0f : 0.0f);
 		
 			bigLight -= (bigLight / lightLambda) * (float)sampleTime * displayRefreshStepSkips;	
 			metronomeLightStart -= (metronomeLightStart / lightLambda) * (float)sampleTime * displayRefreshStepSkips;	
@@ -390,6 +410,13 @@ struct BigButtonSeq : Module {
 	}// step()
 	
 	
+	inline unsigned int calcOutMask(bool pulseState, bool bigPulseState) {
+		// one bit per channel: a gate (or the fill on the current channel) during the clock pulse, or a gate on the current channel during the big button pulse
+		unsigned int chanBit = 1u << chan;
+		unsigned int fillMask = chanBit & (0u - (unsigned int)fillPressed);
+		return ((gateMask | fillMask) & (0u - (unsigned int)pulseState)) | (gateMask & chanBit & (0u - (unsigned int)bigPulseState));
+	}
+	
 	inline void performPending(int chan, float lightTime) {
 		if (pendingOp == 1) {
 			if (!getGate(chan)) {
@@ -414,7 +441,7 @@ struct BigButtonSeqWidget : ModuleWidget {
 		std::shared_ptr<Font> font;
 		
 		ChanDisplayWidget() {
-			font = Font::load(assetPlugin(plugin, "res/fonts/Segment14.ttf"));
+			font = imAssets.getFont();
 		}
 
 		void draw(NVGcontext *vg) override {
@@ -437,7 +464,7 @@ struct BigButtonSeqWidget : ModuleWidget {
 		std::shared_ptr<Font> font;
 		
 		StepsDisplayWidget() {
-			font = Font::load(assetPlugin(plugin, "res/fonts/Segment14.ttf"));
+			font = imAssets.getFont();
 		}
 
 		void draw(NVGcontext *vg) override {
@@ -538,6 +565,7 @@ struct BigButtonSeqWidget : ModuleWidget {
 	
 	
 	BigButtonSeqWidget(BigButtonSeq *module) : ModuleWidget(module) {
+		IM_TIME_SCOPE("BigButtonSeq", TIMING_WIDGET);
 		// Main panel from Inkscape
         DynamicSVGPanel *panel = new DynamicSVGPanel();
         panel->addPanel(SVG::load(assetPlugin(plugin, "res/light/BigButtonSeq.svg")));
@@ -547,10 +575,10 @@ struct BigButtonSeqWidget : ModuleWidget {
         addChild(panel);
 
 		// Screws
-		addChild(createDynamicScrew<IMScrew>(Vec(15, 0), &module->panelTheme));
-		addChild(createDynamicScrew<IMScrew>(Vec(box.size.x-30, 0), &module->panelTheme));
-		addChild(createDynamicScrew<IMScrew>(Vec(15, 365), &module->panelTheme));
-		addChild(createDynamicScrew<IMScrew>(Vec(box.size.x-30, 365), &module->panelTheme));
+		panel->addChild(createDynamicScrew<IMScrew>(Vec(15, 0), &module->panelTheme));
+		panel->addChild(createDynamicScrew<IMScrew>(Vec(box.size.x-30, 0), &module->panelTheme));
+		panel->addChild(createDynamicScrew<IMScrew>(Vec(15, 365), &module->panelTheme));
+		panel->addChild(createDynamicScrew<IMScrew>(Vec(box.size.x-30, 365), &module->panelTheme));
 
 		
 		
@@ -668,6 +696,13 @@ Model *modelBigButtonSeq = Model::create<BigButtonSeq, BigButtonSeqWidget>("Impr
 
 /*CHANGE LOG
 
+0.6.17:
+display font taken from the plugin asset cache
+lights are written through LightState, so that only changed lights are written
+screws are drawn in the panel's framebuffer
+optional timing instrumentation (IM_TIMING)
+gate outputs and lights computed from a per-step gate mask
+
 0.6.12:
 input refresh optimization
 
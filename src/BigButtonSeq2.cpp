@@ -1,5 +1,5 @@
 //***********************************************************************************************
-//Six channel 128-step sequencer module for VCV Rack by Marc Boulé
+//Six channel 1024-step sequencer module for VCV Rack by Marc Boulé
 //
 //Based on code from the Fundamental and AudibleInstruments plugins by Andrew Belt 
 //and graphics from the Component Library by Wes Milholen 
@@ -64,33 +64,50 @@ struct BigButtonSeq2 : Module {
 		NUM_LIGHTS
 	};
 	
+	struct RecEvent {
+		int chan;
+		bool write;// true is a big button push, false is a del
+		float cv;
+	};
+	static const int MAX_PENDING = 6;
+	static const int MAX_STEPS = 1024;
+	static const int NUM_WORDS = MAX_STEPS / 64;// gate words per channel and bank, also number of CV pages
+	static const int NUM_CV_STEPS = 128;// a 0-10V LEN CV spans the first 128 lengths, as it did before MAX_STEPS was increased
+	enum GateOpIds {OP_ROTATE_EARLIER, OP_ROTATE_LATER, OP_SHIFT_EARLIER, OP_SHIFT_LATER, OP_INVERT, OP_COPY_BANK, OP_RANDOM_DENSITY};
+	static constexpr float maxSnapPeriod = 2.0f;// in seconds, longest step for which presses are quantized (a slower or stopped clock writes right away)
+	
 	// Need to save
 	int panelTheme = 0;
 	int metronomeDiv = 4;
 	bool writeFillsToMemory;
 	bool quantizeBig;
 	bool sampleAndHold;
+	int snapPoint;// percent of the step after which a quantized big button or del goes to the next step
+	int snapSwing;// percent of a step pair taken by the even steps, 50 is a straight clock
 	int indexStep;
 	int bank[6];
-	uint64_t gates[6][2][2];// channel , bank , 64x2 page for 128
-	float cv[6][2][128];// channel , bank , indexStep
+	uint64_t gates[6][2][NUM_WORDS];// channel , bank , 64 steps per word
+	float cv[6][2][MAX_STEPS];// channel , bank , step; preallocated, saved in pages of 64 steps
 	
 	// No need to save
 	long clockIgnoreOnReset;
-	double lastPeriod;//2.0 when not seen yet (init or stopped clock and went greater than 2s, which is max period supported for time-snap)
-	double clockTime;//clock time counter (time since last clock)
-	int pendingOp;// 0 means nothing pending, +1 means pending big button push, -1 means pending del
-	float pendingCV;// 
+	int pendingGateOp;// gateOp() requested by the menu, -1 when none; applied by step() so that the gates are only changed by the audio thread
+	float pairPeriod;// filtered length of two consecutive steps in samples, 0.0f when not seen yet
+	float lastInterval;// last clock interval in samples, 0.0f when not seen yet since a reset
+	bool oddStep;// parity of the clock edges since the last reset, the swing follows the clock rather than indexStep (odd lengths)
+	RecEvent pending[MAX_PENDING];// big button and del events waiting for the next step, at most one per channel
+	int numPending;
 	bool fillPressed;
 
 	unsigned int lightRefreshCounter = 0;	
+	LightState lightState;
 	float bigLight = 0.0f;
 	float metronomeLightStart = 0.0f;
 	float metronomeLightDiv = 0.0f;
 	int channel = 0;
 	int length = 0; 
 	float sampleHoldBuf[6] = {0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f};
-	Trigger clockTrigger;
+	ClockInput clockTrigger;
 	Trigger resetTrigger;
 	Trigger bankTrigger;
 	Trigger bigTrigger;
@@ -98,22 +115,41 @@ struct BigButtonSeq2 : Module {
 	Trigger writeFillTrigger;
 	Trigger quantizeBigTrigger;
 	Trigger sampleHoldTrigger;
-	Trigger internalSHTriggers[6];
+	unsigned int gateMask = 0;// one bit per channel, gate of the current step in the channel's bank (see updateGateMask())
+	unsigned int lastOutMask = 0;// gate outputs of the previous sample, for the S&H
 	//PulseGenerator outPulse;
 	PulseGenerator outLightPulse;
 	PulseGenerator bigPulse;
 	PulseGenerator bigLightPulse;
 
 	
+	inline uint64_t lengthMask(int w) {// bits of word w that are inside the current length
+		int n = length - (w << 6);
+		return n >= 64 ? ~((uint64_t)0) : (n <= 0 ? (uint64_t)0 : ((((uint64_t)1) << (uint64_t)n) - 1));
+	}
 	inline bool getGate(int chan) {return !((gates[chan][bank[chan]][indexStep >> 6] & (((uint64_t)1) << (uint64_t)(indexStep & 0x3F))) == 0);}
-	inline void setGate(int chan) {gates[chan][bank[chan]][indexStep >> 6] |= (((uint64_t)1) << (uint64_t)(indexStep & 0x3F));}
-	inline void clearGate(int chan) {gates[chan][bank[chan]][indexStep >> 6] &= ~(((uint64_t)1) << (uint64_t)(indexStep & 0x3F));}
-	inline void toggleGate(int chan) {gates[chan][bank[chan]][indexStep >> 6] ^= (((uint64_t)1) << (uint64_t)(indexStep & 0x3F));}
-	inline void clearGates(int chan, int bnk) {gates[chan][bnk][0] = 0; gates[chan][bnk][1] = 0;}
-	inline void randomizeGates(int chan, int bnk) {gates[chan][bnk][0] = randomu64(); gates[chan][bnk][1] = randomu64();}
-	inline void writeCV(int chan, float cvValue) {cv[chan][bank[chan]][indexStep] = cvValue;}
+	inline void setGate(int chan) {gates[chan][bank[chan]][indexStep >> 6] |= (((uint64_t)1) << (uint64_t)(indexStep & 0x3F)); gateMask |= (1u << chan);}
+	inline void clearGate(int chan) {gates[chan][bank[chan]][indexStep >> 6] &= ~(((uint64_t)1) << (uint64_t)(indexStep & 0x3F)); gateMask &= ~(1u << chan);}
+	inline void toggleGate(int chan) {gates[chan][bank[chan]][indexStep >> 6] ^= (((uint64_t)1) << (uint64_t)(indexStep & 0x3F)); gateMask ^= (1u << chan);}
+	inline void updateGateMask() {// must be called when indexStep, a bank or whole gate words change (the gate functions above keep it up to date)
+		unsigned int mask = 0;
+		for (int c = 0; c < 6; c++)
+			mask |= ((unsigned int)((gates[c][bank[c]][indexStep >> 6] >> (uint64_t)(indexStep & 0x3F)) & 0x1)) << c;
+		gateMask = mask;
+	}
+	inline void clearGates(int chan, int bnk) {memset(gates[chan][bnk], 0, sizeof(gates[chan][bnk]));}
+	inline void randomizeGates(int chan, int bnk) {for (int w = 0; w < NUM_WORDS; w++) gates[chan][bnk][w] = randomu64();}
+	inline float readCV(int chan, int bnk, int step) {return cv[chan][bnk][step];}
 	inline void writeCV(int chan, int bnk, int step, float cvValue) {cv[chan][bnk][step] = cvValue;}
-	inline void sampleOutput(int chan) {sampleHoldBuf[chan] = cv[chan][bank[chan]][indexStep];}
+	inline void writeCV(int chan, float cvValue) {writeCV(chan, bank[chan], indexStep, cvValue);}
+	inline void clearCVs(int chan, int bnk) {memset(cv[chan][bnk], 0, sizeof(cv[chan][bnk]));}
+	inline bool isZeroPage(int chan, int bnk, int p) {// true when the 64 steps of page p are all 0.0f (saved as null)
+		for (int s = (p << 6); s < ((p + 1) << 6); s++)
+			if (cv[chan][bnk][s] != 0.0f)
+				return false;
+		return true;
+	}
+	inline void sampleOutput(int chan) {sampleHoldBuf[chan] = readCV(chan, bank[chan], indexStep);}
 	inline int calcChan() {
 		float chanInputValue = inputs[CHAN_INPUT].value / 10.0f * (6.0f - 1.0f);
 		return (int) clamp(roundf(params[CHAN_PARAM].value + chanInputValue), 0.0f, (6.0f - 1.0f));		
@@ -121,28 +157,33 @@ struct BigButtonSeq2 : Module {
 
 	
 	BigButtonSeq2() : Module(NUM_PARAMS, NUM_INPUTS, NUM_OUTPUTS, NUM_LIGHTS) {		
+		lightState.init(&lights);
 		onReset();
 	}
 
 	
 	void onReset() override {
+		IM_TIME_SCOPE("BigButtonSeq2", TIMING_RESET);
 		writeFillsToMemory = false;
 		quantizeBig = true;
 		sampleAndHold = false;
+		snapPoint = 50;
+		snapSwing = 50;
 		indexStep = 0;
 		for (int c = 0; c < 6; c++) {
 			bank[c] = 0;
 			for (int b = 0; b < 2; b++) {
 				clearGates(c, b);
-				for (int s = 0; s < 128; s++)
-					writeCV(c, b, s, 0.0f);
+				clearCVs(c, b);
 			}
 		}
+		updateGateMask();
 		clockIgnoreOnReset = (long) (clockIgnoreOnResetDuration * engineGetSampleRate());
-		lastPeriod = 2.0;
-		clockTime = 0.0;
-		pendingOp = 0;
-		pendingCV = 0.0f;
+		pairPeriod = 0.0f;
+		lastInterval = 0.0f;
+		oddStep = false;
+		numPending = 0;
+		pendingGateOp = -1;
 		fillPressed = false;
 	}
 
@@ -159,12 +200,15 @@ struct BigButtonSeq2 : Module {
 		// }
 		int chanRnd = calcChan();
 		randomizeGates(chanRnd, bank[chanRnd]);
-		for (int s = 0; s < 128; s++)
+		for (int s = 0; s < MAX_STEPS; s++)
 			writeCV(chanRnd, bank[chanRnd], s, ((float)(randomu32() % 7)) + ((float)(randomu32() % 12)) / 12.0f - 3.0f);
+		updateGateMask();
 	}
 
 	
 	json_t *toJson() override {
+		IM_TIME_SCOPE("BigButtonSeq2", TIMING_TOJSON);
+		IM_LOG_LIGHTS("BigButtonSeq2", lightState);
 		json_t *rootJ = json_object();
 
 		// indexStep
@@ -176,41 +220,32 @@ struct BigButtonSeq2 : Module {
 			json_array_insert_new(bankJ, c, json_integer(bank[c]));
 		json_object_set_new(rootJ, "bank", bankJ);
 
-		// gates LS64
-		json_t *gatesLJ = json_array();
-		for (int c = 0; c < 6; c++)
-			for (int b = 0; b < 8; b++) {// bank to store is like uint64_t to store, so go to 8
-				// first to get stored is 16 lsbits of bank 0, then next 16 bits,... to 16 msbits of bank 1
-				unsigned int intValue = (unsigned int) ( (uint64_t)0xFFFF & (gates[c][b/4][0] >> (uint64_t)(16 * (b % 4))) );
-				json_array_insert_new(gatesLJ, b + (c << 3) , json_integer(intValue));
-			}
-		json_object_set_new(rootJ, "gatesL", gatesLJ);
-		// gates MS64
-		json_t *gatesMJ = json_array();
+		// gates2
+		json_t *gates2J = json_array();
 		for (int c = 0; c < 6; c++)
-			for (int b = 0; b < 8; b++) {// bank to store is like uint64_t to store, so go to 8
-				// first to get stored is 16 lsbits of bank 0, then next 16 bits,... to 16 msbits of bank 1
-				unsigned int intValue = (unsigned int) ( (uint64_t)0xFFFF & (gates[c][b/4][1] >> (uint64_t)(16 * (b % 4))) );
-				json_array_insert_new(gatesMJ, b + (c << 3) , json_integer(intValue));
-			}
-		json_object_set_new(rootJ, "gatesM", gatesMJ);
+			for (int b = 0; b < 2; b++)
+				for (int w = 0; w < NUM_WORDS; w++)
+					for (int i = 0; i < 4; i++) {// each word is stored as 4 ints of 16 bits, lsbits first
+						unsigned int intValue = (unsigned int) ( (uint64_t)0xFFFF & (gates[c][b][w] >> (uint64_t)(16 * i)) );
+						json_array_append_new(gates2J, json_integer(intValue));
+					}
+		json_object_set_new(rootJ, "gates2", gates2J);
 
-		// CV bank 0
-		json_t *cv0J = json_array();
-		for (int c = 0; c < 6; c++) {
-			for (int s = 0; s < 128; s++) {
-				json_array_insert_new(cv0J, s + c * 128, json_real(cv[c][0][s]));
-			}
-		}
-		json_object_set_new(rootJ, "cv0", cv0J);
-		// CV bank 1
-		json_t *cv1J = json_array();
-		for (int c = 0; c < 6; c++) {
-			for (int s = 0; s < 128; s++) {
-				json_array_insert_new(cv1J, s + c * 128, json_real(cv[c][1][s]));
-			}
-		}
-		json_object_set_new(rootJ, "cv1", cv1J);
+		// cv2
+		json_t *cv2J = json_array();
+		for (int c = 0; c < 6; c++)
+			for (int b = 0; b < 2; b++)
+				for (int p = 0; p < NUM_WORDS; p++) {// pages of 64 steps, null for a page of all 0.0f
+					if (isZeroPage(c, b, p))
+						json_array_append_new(cv2J, json_null());
+					else {
+						json_t *pageJ = json_array();
+						for (int s = 0; s < 64; s++)
+							json_array_append_new(pageJ, json_real(cv[c][b][(p << 6) + s]));
+						json_array_append_new(cv2J, pageJ);
+					}
+				}
+		json_object_set_new(rootJ, "cv2", cv2J);
 
 		// panelTheme
 		json_object_set_new(rootJ, "panelTheme", json_integer(panelTheme));
@@ -227,11 +262,18 @@ struct BigButtonSeq2 : Module {
 		// sampleAndHold
 		json_object_set_new(rootJ, "sampleAndHold", json_boolean(sampleAndHold));
 
+		// snapPoint
+		json_object_set_new(rootJ, "snapPoint", json_integer(snapPoint));
+
+		// snapSwing
+		json_object_set_new(rootJ, "snapSwing", json_integer(snapSwing));
+
 		return rootJ;
 	}
 
 
 	void fromJson(json_t *rootJ) override {
+		IM_TIME_SCOPE("BigButtonSeq2", TIMING_FROMJSON);
 		// indexStep
 		json_t *indexStepJ = json_object_get(rootJ, "indexStep");
 		if (indexStepJ)
@@ -247,56 +289,98 @@ struct BigButtonSeq2 : Module {
 					bank[c] = json_integer_value(bankArrayJ);
 			}
 
-		// gates LS64
-		json_t *gatesLJ = json_object_get(rootJ, "gatesL");
-		uint64_t bank8intsL[8] = {0,0,0,0,0,0,0,0};
-		if (gatesLJ) {
-			for (int c = 0; c < 6; c++) {
-				for (int b = 0; b < 8; b++) {// bank to store is like to uint64_t to store, so go to 8
-					// first to get read is 16 lsbits of bank 0, then next 16 bits,... to 16 msbits of bank 1
-					json_t *gateLJ = json_array_get(gatesLJ, b + (c << 3));
-					if (gateLJ)
-						bank8intsL[b] = (uint64_t) json_integer_value(gateLJ);
+		// gates2
+		json_t *gates2J = json_object_get(rootJ, "gates2");
+		if (gates2J) {
+			for (int c = 0; c < 6; c++)
+				for (int b = 0; b < 2; b++)
+					for (int w = 0; w < NUM_WORDS; w++) {
+						uint64_t word = 0;
+						for (int i = 0; i < 4; i++) {
+							json_t *gate2J = json_array_get(gates2J, (((c * 2 + b) * NUM_WORDS + w) << 2) + i);
+							if (gate2J)
+								word |= ((uint64_t) json_integer_value(gate2J)) << (uint64_t)(16 * i);
+						}
+						gates[c][b][w] = word;
+					}
+		}
+		else {// legacy 128 step memory, steps 128 and up are cleared
+			for (int c = 0; c < 6; c++)
+				for (int b = 0; b < 2; b++)
+					clearGates(c, b);
+			// gates LS64
+			json_t *gatesLJ = json_object_get(rootJ, "gatesL");
+			uint64_t bank8intsL[8] = {0,0,0,0,0,0,0,0};
+			if (gatesLJ) {
+				for (int c = 0; c < 6; c++) {
+					for (int b = 0; b < 8; b++) {// bank to store is like to uint64_t to store, so go to 8
+						// first to get read is 16 lsbits of bank 0, then next 16 bits,... to 16 msbits of bank 1
+						json_t *gateLJ = json_array_get(gatesLJ, b + (c << 3));
+						if (gateLJ)
+							bank8intsL[b] = (uint64_t) json_integer_value(gateLJ);
+					}
+					gates[c][0][0] = bank8intsL[0] | (bank8intsL[1] << (uint64_t)16) | (bank8intsL[2] << (uint64_t)32) | (bank8intsL[3] << (uint64_t)48);
+					gates[c][1][0] = bank8intsL[4] | (bank8intsL[5] << (uint64_t)16) | (bank8intsL[6] << (uint64_t)32) | (bank8intsL[7] << (uint64_t)48);
 				}
-				gates[c][0][0] = bank8intsL[0] | (bank8intsL[1] << (uint64_t)16) | (bank8intsL[2] << (uint64_t)32) | (bank8intsL[3] << (uint64_t)48);
-				gates[c][1][0] = bank8intsL[4] | (bank8intsL[5] << (uint64_t)16) | (bank8intsL[6] << (uint64_t)32) | (bank8intsL[7] << (uint64_t)48);
 			}
-		}
-		// gates MS64
-		json_t *gatesMJ = json_object_get(rootJ, "gatesM");
-		uint64_t bank8intsM[8] = {0,0,0,0,0,0,0,0};
-		if (gatesMJ) {
-			for (int c = 0; c < 6; c++) {
-				for (int b = 0; b < 8; b++) {// bank to store is like to uint64_t to store, so go to 8
-					// first to get read is 16 lsbits of bank 0, then next 16 bits,... to 16 msbits of bank 1
-					json_t *gateMJ = json_array_get(gatesMJ, b + (c << 3));
-					if (gateMJ)
-						bank8intsM[b] = (uint64_t) json_integer_value(gateMJ);
+			// gates MS64
+			json_t *gatesMJ = json_object_get(rootJ, "gatesM");
+			uint64_t bank8intsM[8] = {0,0,0,0,0,0,0,0};
+			if (gatesMJ) {
+				for (int c = 0; c < 6; c++) {
+					for (int b = 0; b < 8; b++) {// bank to store is like to uint64_t to store, so go to 8
+						// first to get read is 16 lsbits of bank 0, then next 16 bits,... to 16 msbits of bank 1
+						json_t *gateMJ = json_array_get(gatesMJ, b + (c << 3));
+						if (gateMJ)
+							bank8intsM[b] = (uint64_t) json_integer_value(gateMJ);
+					}
+					gates[c][0][1] = bank8intsM[0] | (bank8intsM[1] << (uint64_t)16) | (bank8intsM[2] << (uint64_t)32) | (bank8intsM[3] << (uint64_t)48);
+					gates[c][1][1] = bank8intsM[4] | (bank8intsM[5] << (uint64_t)16) | (bank8intsM[6] << (uint64_t)32) | (bank8intsM[7] << (uint64_t)48);
 				}
-				gates[c][0][1] = bank8intsM[0] | (bank8intsM[1] << (uint64_t)16) | (bank8intsM[2] << (uint64_t)32) | (bank8intsM[3] << (uint64_t)48);
-				gates[c][1][1] = bank8intsM[4] | (bank8intsM[5] << (uint64_t)16) | (bank8intsM[6] << (uint64_t)32) | (bank8intsM[7] << (uint64_t)48);
 			}
 		}
 		
-		// CV bank 0
-		json_t *cv0J = json_object_get(rootJ, "cv0");
-		if (cv0J) {
+		// cv2
+		json_t *cv2J = json_object_get(rootJ, "cv2");
+		if (cv2J) {
 			for (int c = 0; c < 6; c++)
-				for (int s = 0; s < 128; s++) {
-					json_t *cv0ArrayJ = json_array_get(cv0J, s + c * 128);
-					if (cv0ArrayJ)
-						cv[c][0][s] = json_number_value(cv0ArrayJ);
+				for (int b = 0; b < 2; b++) {
+					clearCVs(c, b);
+					for (int p = 0; p < NUM_WORDS; p++) {
+						json_t *pageJ = json_array_get(cv2J, (c * 2 + b) * NUM_WORDS + p);
+						if (pageJ && json_is_array(pageJ))
+							for (int s = 0; s < 64; s++) {
+								json_t *cv2ArrayJ = json_array_get(pageJ, s);
+								if (cv2ArrayJ)
+									writeCV(c, b, (p << 6) + s, json_number_value(cv2ArrayJ));
+							}
+					}
 				}
 		}
-		// CV bank 1
-		json_t *cv1J = json_object_get(rootJ, "cv1");
-		if (cv1J) {
+		else {// legacy 128 step memory, steps 128 and up are cleared
 			for (int c = 0; c < 6; c++)
-				for (int s = 0; s < 128; s++) {
-					json_t *cv1ArrayJ = json_array_get(cv1J, s + c * 128);
-					if (cv1ArrayJ)
-						cv[c][1][s] = json_number_value(cv1ArrayJ);
-				}
+				for (int b = 0; b < 2; b++)
+					clearCVs(c, b);
+			// CV bank 0
+			json_t *cv0J = json_object_get(rootJ, "cv0");
+			if (cv0J) {
+				for (int c = 0; c < 6; c++)
+					for (int s = 0; s < 128; s++) {
+						json_t *cv0ArrayJ = json_array_get(cv0J, s + c * 128);
+						if (cv0ArrayJ)
+							writeCV(c, 0, s, json_number_value(cv0ArrayJ));
+					}
+			}
+			// CV bank 1
+			json_t *cv1J = json_object_get(rootJ, "cv1");
+			if (cv1J) {
+				for (int c = 0; c < 6; c++)
+					for (int s = 0; s < 128; s++) {
+						json_t *cv1ArrayJ = json_array_get(cv1J, s + c * 128);
+						if (cv1ArrayJ)
+							writeCV(c, 1, s, json_number_value(cv1ArrayJ));
+					}
+			}
 		}
 		
 		// panelTheme
@@ -323,6 +407,18 @@ struct BigButtonSeq2 : Module {
 		json_t *sampleAndHoldJ = json_object_get(rootJ, "sampleAndHold");
 		if (sampleAndHoldJ)
 			sampleAndHold = json_is_true(sampleAndHoldJ);
+
+		// snapPoint
+		json_t *snapPointJ = json_object_get(rootJ, "snapPoint");
+		if (snapPointJ)
+			snapPoint = clamp((int)json_integer_value(snapPointJ), 1, 99);
+
+		// snapSwing
+		json_t *snapSwingJ = json_object_get(rootJ, "snapSwing");
+		if (snapSwingJ)
+			snapSwing = clamp((int)json_integer_value(snapSwingJ), 50, 75);
+		
+		updateGateMask();
 }
 
 	
@@ -334,39 +430,61 @@ struct BigButtonSeq2 : Module {
 		//********** Buttons, knobs, switches and inputs **********
 		
 		// Length
-		length = (int) clamp(roundf( params[LEN_PARAM].value + ( inputs[LEN_INPUT].active ? (inputs[LEN_INPUT].value / 10.0f * (128.0f - 1.0f)) : 0.0f ) ), 0.0f, (128.0f - 1.0f)) + 1;	
+		length = (int) clamp(roundf( params[LEN_PARAM].value + ( inputs[LEN_INPUT].active ? (inputs[LEN_INPUT].value / 10.0f * ((float)NUM_CV_STEPS - 1.0f)) : 0.0f ) ), 0.0f, ((float)MAX_STEPS - 1.0f)) + 1;	
 
 		// Channel
 		channel = calcChan();		
 		
-		if ((lightRefreshCounter & userInputsStepSkipMask) == 0) {		
+		// Pattern operation from the menu
+		if (pendingGateOp != -1) {
+			gateOp(pendingGateOp);
+			pendingGateOp = -1;
+		}
 		
-			// Big button
-			if (bigTrigger.process(params[BIG_PARAM].value + inputs[BIG_INPUT].value)) {
-				bigLight = 1.0f;
-				if (quantizeBig && (clockTime > (lastPeriod / 2.0)) && (clockTime <= (lastPeriod * 1.01))) {// allow for 1% clock jitter
-					pendingOp = 1;
-					pendingCV = inputs[CV_INPUT].value;
-				}
-				else {
-					if (!getGate(channel)) {
-						setGate(channel);// bank and indexStep are global
-						bigPulse.trigger(0.001f);
-					}
-					writeCV(channel, inputs[CV_INPUT].value);
-					bigLightPulse.trigger(lightTime);
-				}
+		
+		//********** Recording (every sample, so that fast presses are neither dropped nor late) **********
+		
+		float stepLength = calcStepLength();
+		float timeInStep = (float)(clockTrigger.samplesSinceEdge + 1ul) + clockTrigger.getEdgeOffset();// samples since the last clock edge, the clock input is processed further below
+		bool snapToNext = quantizeBig && stepLength != 0.0f && timeInStep > stepLength * (float)snapPoint / 100.0f && timeInStep <= stepLength * 1.01f;// allow for 1% clock jitter
+		
+		// Big button
+		if (bigTrigger.process(params[BIG_PARAM].value + inputs[BIG_INPUT].value)) {
+			bigLight = 1.0f;
+			if (snapToNext)
+				queuePending(channel, true, inputs[CV_INPUT].value);
+			else
+				performWrite(channel, inputs[CV_INPUT].value, lightTime);
+		}
+		
+		// Del button
+		if (params[DEL_PARAM].value + inputs[DEL_INPUT].value > 0.5f) {
+			if (snapToNext)
+				queuePending(channel, false, 0.0f);// overrides the pending write on this channel if it exists
+			else {
+				clearGate(channel);// bank and indexStep are global
+				writeCV(channel, 0.0f);
 			}
+		}
 
+		// Pending timeout (write/del current step when the clock is late or stopped)
+		if (numPending != 0 && (stepLength == 0.0f || timeInStep > stepLength * 1.01f)) 
+			performPending(lightTime);
+		
+		
+		if ((lightRefreshCounter & userInputsStepSkipMask) == 0) {		
+		
 			// Bank button
-			if (bankTrigger.process(params[BANK_PARAM].value + inputs[BANK_INPUT].value))
+			if (bankTrigger.process(params[BANK_PARAM].value + inputs[BANK_INPUT].value)) {
 				bank[channel] = 1 - bank[channel];
+				updateGateMask();
+			}
 			
 			// Clear button
 			if (clearTrigger.process(params[CLEAR_PARAM].value + inputs[CLEAR_INPUT].value)) {
 				clearGates(channel, bank[channel]);
-				for (int s = 0; s < 128; s++)
-					cv[channel][bank[channel]][s] = 0.0f;
+				clearCVs(channel, bank[channel]);
+				gateMask &= ~(1u << channel);
 			}
 			
 			// Write fill to memory
@@ -381,20 +499,6 @@ struct BigButtonSeq2 : Module {
 			if (sampleHoldTrigger.process(params[SAMPLEHOLD_PARAM].value))
 				sampleAndHold = !sampleAndHold;
 			
-			// Del button
-			if (params[DEL_PARAM].value + inputs[DEL_INPUT].value > 0.5f) {
-				if (quantizeBig && (clockTime > (lastPeriod / 2.0)) && (clockTime <= (lastPeriod * 1.01)))// allow for 1% clock jitter
-					pendingOp = -1;// overrides the pending write if it exists
-				else {
-					clearGate(channel);// bank and indexStep are global
-					cv[channel][bank[channel]][indexStep] = 0.0f;
-				}
-			}
-
-			// Pending timeout (write/del current step)
-			if (pendingOp != 0 && clockTime > (lastPeriod * 1.01) ) 
-				performPending(channel, lightTime);
-			
 		}// userInputs refresh
 		
 		
@@ -403,8 +507,12 @@ struct BigButtonSeq2 : Module {
 		
 		// Clock
 		if (clockIgnoreOnReset == 0l) {			
+			bool firstEdge = (clockTrigger.getPeriod() == 0.0f);// first edge after a reset, its interval is not a clock period
 			if (clockTrigger.process(inputs[CLK_INPUT].value + params[CLOCK_PARAM].value)) {
+				updatePairPeriod(firstEdge);
+				oddStep = !oddStep;
 				if ((++indexStep) >= length) indexStep = 0;
+				updateGateMask();
 				
 				// Fill button
 				fillPressed = (params[FILL_PARAM].value + inputs[FILL_INPUT].value) > 0.5f;// used in clock block and others
@@ -416,8 +524,8 @@ struct BigButtonSeq2 : Module {
 				//outPulse.trigger(0.001f);
 				outLightPulse.trigger(lightTime);
 				
-				if (pendingOp != 0)
-					performPending(channel, lightTime);// Proper pending write/del to next step which is now reached
+				if (numPending != 0)
+					performPending(lightTime);// Proper pending writes/dels to next step which is now reached
 				
 				if (indexStep == 0)
 					metronomeLightStart = 1.0f;
@@ -429,8 +537,6 @@ struct BigButtonSeq2 : Module {
 					if (randomUniform() < rnd01)// randomUniform is [0.0, 1.0), see include/util/common.hpp
 						toggleGate(channel);
 				}
-				lastPeriod = clockTime > 2.0 ? 2.0 : clockTime;
-				clockTime = 0.0;
 			}
 		}
 			
@@ -438,6 +544,8 @@ struct BigButtonSeq2 : Module {
 		// Reset
 		if (resetTrigger.process(params[RESET_PARAM].value + inputs[RESET_INPUT].value)) {
 			indexStep = 0;
+			oddStep = false;
+			updateGateMask();
 			//outPulse.trigger(0.001f);
 			outLightPulse.trigger(0.02f);
 			metronomeLightStart = 1.0f;
@@ -455,15 +563,21 @@ struct BigButtonSeq2 : Module {
 		bool bigPulseState = bigPulse.process((float)sampleTime);
 		bool outPulseState = clockTrigger.isHigh();
 		bool retriggingOnReset = (clockIgnoreOnReset != 0l && retrigGatesOnReset);
+		unsigned int outMask = calcOutMask(outPulseState, bigPulseState);
+		unsigned int risingMask = outMask & ~lastOutMask;// S&H samples on the rising edges of the gates (clock edges and big button writes), as a whole mask instead of six Schmitt triggers
+		lastOutMask = outMask;
+		if (risingMask != 0) {
+			for (int i = 0; i < 6; i++)
+				if ((risingMask >> i) & 0x1)
+					sampleOutput(i);
+		}
+		outMask &= (0u - (unsigned int)!retriggingOnReset);
 		for (int i = 0; i < 6; i++) {
-			bool gate = getGate(i);
-			bool outSignal = ( ((gate || (i == channel && fillPressed)) && outPulseState) || (gate && bigPulseState && i == channel) );
-			float outGateValue = outSignal ? 10.0f : 0.0f;
-			if (internalSHTriggers[i].process(outGateValue))
-				sampleOutput(i);
-			outputs[CHAN_OUTPUTS + i].value = (retriggingOnReset ? 0.0f : outGateValue);
-			outputs[CV_OUTPUTS + i].value = (i == channel && fillPressed && !writeFillsToMemory && inputs[CV_INPUT].active) ? inputs[CV_INPUT].value : (sampleAndHold ? sampleHoldBuf[i] : cv[i][bank[i]][indexStep]);
+			outputs[CHAN_OUTPUTS + i].value = (float)((outMask >> i) & 0x1) * 10.0f;
+			outputs[CV_OUTPUTS + i].value = sampleAndHold ? sampleHoldBuf[i] : readCV(i, bank[i], indexStep);
 		}
+		if (fillPressed && !writeFillsToMemory && inputs[CV_INPUT].active)
+			outputs[CV_OUTPUTS + channel].value = inputs[CV_INPUT].value;
 
 		
 		lightRefreshCounter++;
@@ -473,51 +587,166 @@ struct BigButtonSeq2 : Module {
 			// Gate light outputs
 			bool bigLightPulseState = bigLightPulse.process((float)sampleTime * displayRefreshStepSkips);
 			bool outLightPulseState = outLightPulse.process((float)sampleTime * displayRefreshStepSkips);
+			unsigned int outLightMask = calcOutMask(outLightPulseState, bigLightPulseState);
 			for (int i = 0; i < 6; i++) {
-				bool gate = getGate(i);
-				bool outLight  = (((gate || (i == channel && fillPressed)) && outLightPulseState) || (gate && bigLightPulseState && i == channel));
-				lights[(CHAN_LIGHTS + i) * 2 + 1].setBrightnessSmooth(outLight ? 1.0f : 0.0f, displayRefreshStepSkips);
-				lights[(CHAN_LIGHTS + i) * 2 + 0].value = (i == channel ? (1.0f - lights[(CHAN_LIGHTS + i) * 2 + 1].value) / 2.0f : 0.0f);
+				lightState.setBrightnessSmooth((CHAN_LIGHTS + i) * 2 + 1, (float)((outLightMask >> i) & 0x1), displayRefreshStepSkips);
+				lightState.set((CHAN_LIGHTS + i) * 2 + 0, (i == channel ? (1.0f - lights[(CHAN_LIGHTS + i) * 2 + 1].value) / 2.0f : 0.0f));
 			}
 
 			// Big button lights
-			lights[BIG_LIGHT].value = bank[channel] == 1 ? 1.0f : 0.0f;
-			lights[BIGC_LIGHT].value = bigLight;
+			lightState.set(BIG_LIGHT, bank[channel] == 1 ? 1.0f : 0.0f);
+			lightState.set(BIGC_LIGHT, bigLight);
 			
 			// Metronome light
-			lights[METRONOME_LIGHT + 1].value = metronomeLightStart;
-			lights[METRONOME_LIGHT + 0].value = metronomeLightDiv;
+			lightState.set(METRONOME_LIGHT + 1, metronomeLightStart);
+			lightState.set(METRONOME_LIGHT + 0, metronomeLightDiv);
 		
 			// Other push button lights
-			lights[WRITEFILL_LIGHT].value = writeFillsToMemory ? 1.0f : 0.0f;
-			lights[QUANTIZEBIG_LIGHT].value = quantizeBig ? 1.0f : 0.0f;
-			lights[SAMPLEHOLD_LIGHT].value = sampleAndHold ? 1.0f : 0.0f;
+			lightState.set(WRITEFILL_LIGHT, writeFillsToMemory ? 1.0f : 0.0f);
+			lightState.set(QUANTIZEBIG_LIGHT, quantizeBig ? 1.0f : 0.0f);
+			lightState.set(SAMPLEHOLD_LIGHT, sampleAndHold ? 1.0f : 0.0f);
 		
 			bigLight -= (bigLight / lightLambda) * (float)sampleTime * displayRefreshStepSkips;	
 			metronomeLightStart -= (metronomeLightStart / lightLambda) * (float)sampleTime * displayRefreshStepSkips;	
 			metronomeLightDiv -= (metronomeLightDiv / lightLambda) * (float)sampleTime * displayRefreshStepSkips;
 		}
 		
-		clockTime += sampleTime;
-		
 		if (clockIgnoreOnReset > 0l)
 			clockIgnoreOnReset--;
 	}// step()
 	
 	
-	inline void performPending(int chan, float lightTime) {
-		if (pendingOp == 1) {
-			if (!getGate(chan)) {
-				setGate(chan);// bank and indexStep are global
+	inline unsigned int calcOutMask(bool pulseState, bool bigPulseState) {
+		// one bit per channel: a gate (or the fill on the current channel) during the clock pulse, or a gate on the current channel during the big button pulse
+		unsigned int chanBit = 1u << channel;
+		unsigned int fillMask = chanBit & (0u - (unsigned int)fillPressed);
+		return ((gateMask | fillMask) & (0u - (unsigned int)pulseState)) | (gateMask & chanBit & (0u - (unsigned int)bigPulseState));
+	}
+	
+	inline float calcStepLength() {
+		// expected length of the current step in samples, 0.0f when presses can't be quantized (clock not seen yet, or too slow)
+		// even steps take snapSwing percent of a step pair, odd steps take the rest
+		// until a pair has been measured, the last clock interval is used as a straight step (the first one is the time since the reset)
+		if (pairPeriod == 0.0f)
+			return clockTrigger.lastInterval > maxSnapPeriod * engineGetSampleRate() ? 0.0f : clockTrigger.lastInterval;
+		float swing = (float)snapSwing / 100.0f;
+		float stepLength = pairPeriod * (oddStep ? (1.0f - swing) : swing);
+		return stepLength > maxSnapPeriod * engineGetSampleRate() ? 0.0f : stepLength;
+	}
+	
+	inline void updatePairPeriod(bool firstEdge) {
+		// the sum of two consecutive intervals is the same for straight and swung clocks, so it can be filtered like ClockInput does with single intervals
+		float interval = firstEdge ? 0.0f : clockTrigger.lastInterval;
+		if (interval != 0.0f && lastInterval != 0.0f) {
+			float pair = interval + lastInterval;
+			if (pairPeriod == 0.0f || fabsf(pair - pairPeriod) > pairPeriod * 0.5f)// first pair or tempo change
+				pairPeriod = pair;
+			else
+				pairPeriod += (pair - pairPeriod) * 0.125f;
+		}
+		lastInterval = interval;
+	}
+	
+	inline void queuePending(int chan, bool write, float cvValue) {
+		int i = 0;
+		for (; i < numPending; i++) {
+			if (pending[i].chan == chan)
+				break;// a later event on a channel replaces the earlier one, since both go to the same step
+		}
+		if (i == numPending)
+			numPending++;
+		pending[i].chan = chan;
+		pending[i].write = write;
+		pending[i].cv = cvValue;
+	}
+	
+	inline void performWrite(int chan, float cvValue, float lightTime) {
+		if (!getGate(chan)) {
+			setGate(chan);// bank and indexStep are global
+			if (chan == channel)
 				bigPulse.trigger(0.001f);
+		}
+		writeCV(chan, cvValue);
+		bigLightPulse.trigger(lightTime);
+	}
+	
+	inline uint64_t randomDensityWord(int density256) {
+		// each bit is set with a probability of density256/256, using one random word per bit of density (bit-sliced comparison)
+		if (density256 >= 256)
+			return ~((uint64_t)0);
+		uint64_t word = 0;
+		for (int i = 0; i < 8; i++)
+			word = ((density256 >> i) & 0x1) != 0 ? (word | randomu64()) : (word & randomu64());
+		return word;
+	}
+	
+	void gateOp(int op) {
+		// whole pattern operations on the current channel and bank, within the current length, one word (64 steps) at a time
+		// steps past the length are left untouched, so that a longer length finds them again
+		int chan = channel;
+		int bnk = bank[chan];
+		uint64_t *g = gates[chan][bnk];
+		int numWords = (length + 63) >> 6;
+		int lastBit = (length - 1) & 0x3F;
+		
+		if (op == OP_ROTATE_LATER || op == OP_SHIFT_LATER) {
+			bool wrap = (op == OP_ROTATE_LATER);
+			uint64_t carry = wrap ? ((g[numWords - 1] >> (uint64_t)lastBit) & 0x1) : 0;
+			for (int w = 0; w < numWords; w++) {
+				uint64_t mask = lengthMask(w);
+				uint64_t moved = ((g[w] & mask) << 1) | carry;
+				carry = (g[w] >> 63) & 0x1;
+				g[w] = (moved & mask) | (g[w] & ~mask);
+			}
+			float carryCV = wrap ? readCV(chan, bnk, length - 1) : 0.0f;
+			for (int s = 0; s < length; s++) {
+				float cvValue = readCV(chan, bnk, s);
+				writeCV(chan, bnk, s, carryCV);
+				carryCV = cvValue;
+			}
+		}
+		else if (op == OP_ROTATE_EARLIER || op == OP_SHIFT_EARLIER) {
+			bool wrap = (op == OP_ROTATE_EARLIER);
+			uint64_t carry = wrap ? (g[0] & 0x1) : 0;
+			for (int w = numWords - 1; w >= 0; w--) {
+				uint64_t mask = lengthMask(w);
+				uint64_t moved = ((g[w] & mask) >> 1) | (carry << (uint64_t)(w == numWords - 1 ? lastBit : 63));
+				carry = g[w] & 0x1;
+				g[w] = (moved & mask) | (g[w] & ~mask);
 			}
-			writeCV(chan, pendingCV);
-			bigLightPulse.trigger(lightTime);
+			float carryCV = wrap ? readCV(chan, bnk, 0) : 0.0f;
+			for (int s = length - 1; s >= 0; s--) {
+				float cvValue = readCV(chan, bnk, s);
+				writeCV(chan, bnk, s, carryCV);
+				carryCV = cvValue;
+			}
+		}
+		else if (op == OP_INVERT) {
+			for (int w = 0; w < numWords; w++)
+				g[w] ^= lengthMask(w);
 		}
-		else {
-			clearGate(chan);// bank and indexStep are global
+		else if (op == OP_COPY_BANK) {
+			int dest = 1 - bnk;
+			memcpy(gates[chan][dest], g, sizeof(gates[chan][dest]));
+			memcpy(cv[chan][dest], cv[chan][bnk], sizeof(cv[chan][dest]));
 		}
-		pendingOp = 0;
+		else if (op == OP_RANDOM_DENSITY) {// toggles each step with the probability of the RND knob and input, like the clock does for the current step
+			float rnd01 = params[RND_PARAM].value / 100.0f + inputs[RND_INPUT].value / 10.0f;
+			int density256 = (int) clamp(roundf(rnd01 * 256.0f), 0.0f, 256.0f);
+			for (int w = 0; w < numWords; w++)
+				g[w] ^= (randomDensityWord(density256) & lengthMask(w));
+		}
+		updateGateMask();
+	}
+	
+	inline void performPending(float lightTime) {
+		for (int i = 0; i < numPending; i++) {
+			if (pending[i].write)
+				performWrite(pending[i].chan, pending[i].cv, lightTime);
+			else
+				clearGate(pending[i].chan);// bank and indexStep are global
+		}
+		numPending = 0;
 	}
 };
 
@@ -530,7 +759,7 @@ struct BigButtonSeq2Widget : ModuleWidget {
 		std::shared_ptr<Font> font;
 		
 		ChanDisplayWidget() {
-			font = Font::load(assetPlugin(plugin, "res/fonts/Segment14.ttf"));
+			font = imAssets.getFont();
 		}
 
 		void draw(NVGcontext *vg) override {
@@ -553,7 +782,7 @@ struct BigButtonSeq2Widget : ModuleWidget {
 		std::shared_ptr<Font> font;
 		
 		StepsDisplayWidget() {
-			font = Font::load(assetPlugin(plugin, "res/fonts/Segment14.ttf"));
+			font = imAssets.getFont();
 		}
 
 		void draw(NVGcontext *vg) override {
@@ -563,11 +792,11 @@ struct BigButtonSeq2Widget : ModuleWidget {
 
 			Vec textPos = Vec(6, 24);
 			nvgFillColor(vg, nvgTransRGBA(textColor, displayAlpha));
-			nvgText(vg, textPos.x, textPos.y, "~~~", NULL);
+			nvgText(vg, textPos.x, textPos.y, "~~~~", NULL);
 			nvgFillColor(vg, textColor);
-			char displayStr[4];
+			char displayStr[5];
 			unsigned dispVal = (unsigned)(module->params[BigButtonSeq2::DISPMODE_PARAM].value < 0.5f ?  module->length : module->indexStep + 1);  
-			snprintf(displayStr, 4, "%3u",  dispVal);
+			snprintf(displayStr, 5, "%4u",  dispVal);
 			nvgText(vg, textPos.x, textPos.y, displayStr, NULL);
 		}
 	};
@@ -592,6 +821,33 @@ struct BigButtonSeq2Widget : ModuleWidget {
 			rightText = (module->metronomeDiv == div) ? "✔" : "";
 		}
 	};
+	struct GateOpItem : MenuItem {
+		BigButtonSeq2 *module;
+		int op;
+		void onAction(EventAction &e) override {
+			module->pendingGateOp = op;// done by step()
+		}
+	};
+	struct SnapPointItem : MenuItem {
+		BigButtonSeq2 *module;
+		int point;
+		void onAction(EventAction &e) override {
+			module->snapPoint = point;
+		}
+		void step() override {
+			rightText = (module->snapPoint == point) ? "✔" : "";
+		}
+	};
+	struct SnapSwingItem : MenuItem {
+		BigButtonSeq2 *module;
+		int swing;
+		void onAction(EventAction &e) override {
+			module->snapSwing = swing;
+		}
+		void step() override {
+			rightText = (module->snapSwing == swing) ? "✔" : "";
+		}
+	};
 	Menu *createContextMenu() override {
 		Menu *menu = ModuleWidget::createContextMenu();
 
@@ -650,11 +906,54 @@ struct BigButtonSeq2Widget : ModuleWidget {
 		met1000Item->div = 1000;
 		menu->addChild(met1000Item);
 
+		menu->addChild(new MenuLabel());// empty line
+		
+		MenuLabel *snapPointLabel = new MenuLabel();
+		snapPointLabel->text = "Big button snap to next step after";
+		menu->addChild(snapPointLabel);
+
+		static const int snapPoints[5] = {25, 33, 50, 67, 75};
+		for (int i = 0; i < 5; i++) {
+			SnapPointItem *snapPointItem = MenuItem::create<SnapPointItem>(stringf("%i%% of step", snapPoints[i]), CHECKMARK(module->snapPoint == snapPoints[i]));
+			snapPointItem->module = module;
+			snapPointItem->point = snapPoints[i];
+			menu->addChild(snapPointItem);
+		}
+
+		MenuLabel *snapSwingLabel = new MenuLabel();
+		snapSwingLabel->text = "Big button snap swing";
+		menu->addChild(snapSwingLabel);
+
+		static const int snapSwings[6] = {50, 54, 58, 63, 67, 71};
+		for (int i = 0; i < 6; i++) {
+			SnapSwingItem *snapSwingItem = MenuItem::create<SnapSwingItem>(i == 0 ? std::string("Off") : stringf("%i%%", snapSwings[i]), CHECKMARK(module->snapSwing == snapSwings[i]));
+			snapSwingItem->module = module;
+			snapSwingItem->swing = snapSwings[i];
+			menu->addChild(snapSwingItem);
+		}
+
+		menu->addChild(new MenuLabel());// empty line
+		
+		MenuLabel *gateOpLabel = new MenuLabel();
+		gateOpLabel->text = "Current channel and bank";
+		menu->addChild(gateOpLabel);
+
+		static const char *gateOpNames[7] = {"Rotate earlier", "Rotate later", "Shift earlier", "Shift later", "Invert gates", "Copy to other bank", "Random toggle (RND density)"};
+		static const int gateOps[7] = {BigButtonSeq2::OP_ROTATE_EARLIER, BigButtonSeq2::OP_ROTATE_LATER, BigButtonSeq2::OP_SHIFT_EARLIER, BigButtonSeq2::OP_SHIFT_LATER, 
+			BigButtonSeq2::OP_INVERT, BigButtonSeq2::OP_COPY_BANK, BigButtonSeq2::OP_RANDOM_DENSITY};
+		for (int i = 0; i < 7; i++) {
+			GateOpItem *gateOpItem = MenuItem::create<GateOpItem>(gateOpNames[i]);
+			gateOpItem->module = module;
+			gateOpItem->op = gateOps[i];
+			menu->addChild(gateOpItem);
+		}
+
 		return menu;
 	}	
 	
 	
 	BigButtonSeq2Widget(BigButtonSeq2 *module) : ModuleWidget(module) {
+		IM_TIME_SCOPE("BigButtonSeq2", TIMING_WIDGET);
 		// Main panel from Inkscape
         DynamicSVGPanel *panel = new DynamicSVGPanel();
         panel->addPanel(SVG::load(assetPlugin(plugin, "res/light/BigButtonSeq2.svg")));
@@ -664,10 +963,10 @@ struct BigButtonSeq2Widget : ModuleWidget {
         addChild(panel);
 
 		// Screws
-		addChild(createDynamicScrew<IMScrew>(Vec(15, 0), &module->panelTheme));
-		addChild(createDynamicScrew<IMScrew>(Vec(box.size.x-30, 0), &module->panelTheme));
-		addChild(createDynamicScrew<IMScrew>(Vec(15, 365), &module->panelTheme));
-		addChild(createDynamicScrew<IMScrew>(Vec(box.size.x-30, 365), &module->panelTheme));
+		panel->addChild(createDynamicScrew<IMScrew>(Vec(15, 0), &module->panelTheme));
+		panel->addChild(createDynamicScrew<IMScrew>(Vec(box.size.x-30, 0), &module->panelTheme));
+		panel->addChild(createDynamicScrew<IMScrew>(Vec(15, 365), &module->panelTheme));
+		panel->addChild(createDynamicScrew<IMScrew>(Vec(box.size.x-30, 365), &module->panelTheme));
 
 		
 		
@@ -703,11 +1002,11 @@ struct BigButtonSeq2Widget : ModuleWidget {
 		displayChan->channel = &module->channel;
 		addChild(displayChan);	
 		// Len knob
-		addParam(createDynamicParamCentered<IMBigSnapKnob>(Vec(colRulerCenter + clearAndDelButtonOffsetX, rowRuler0), module, BigButtonSeq2::LEN_PARAM, 0.0f, 128.0f - 1.0f, 32.0f - 1.0f, &module->panelTheme));
+		addParam(createDynamicParamCentered<IMBigSnapKnob>(Vec(colRulerCenter + clearAndDelButtonOffsetX, rowRuler0), module, BigButtonSeq2::LEN_PARAM, 0.0f, (float)BigButtonSeq2::MAX_STEPS - 1.0f, 32.0f - 1.0f, &module->panelTheme));
 		// Length display
 		StepsDisplayWidget *displaySteps = new StepsDisplayWidget();
-		displaySteps->box.pos = Vec(colRulerT5 - 27 + lengthDisplayOffsetX, rowRuler0 - 15);
-		displaySteps->box.size = Vec(55, 30);// 3 characters
+		displaySteps->box.pos = Vec(colRulerT5 - 36 + lengthDisplayOffsetX, rowRuler0 - 15);
+		displaySteps->box.size = Vec(73, 30);// 4 characters
 		displaySteps->module = module;
 		addChild(displaySteps);
 		
@@ -796,6 +1095,15 @@ Model *modelBigButtonSeq2 = Model::create<BigButtonSeq2, BigButtonSeq2Widget>("I
 
 /*CHANGE LOG
 
+0.6.17:
+display font taken from the plugin asset cache
+lights are written through LightState, so that only changed lights are written
+screws are drawn in the panel's framebuffer
+optional timing instrumentation (IM_TIMING)
+big button and del recorded every sample and quantized against a filtered (swing aware) step length, with one pending event per channel
+memory extended to 1024 steps (LEN CV still spans lengths 1 to 128), CV saved in pages of 64 steps (null for all 0V pages), whole pattern rotate/shift/invert/copy/random density operations in the context menu (applied by step())
+gate outputs and lights computed from a per-step gate mask, S&H triggered from the mask's rising edges
+
 0.6.12:
 input refresh optimization
 
@@ -16,12 +16,14 @@ struct BlankPanel : Module {
 	}
 
 	void onReset() override {
+		IM_TIME_SCOPE("BlankPanel", TIMING_RESET);
 	}
 
 	void onRandomize() override {
 	}
 
 	json_t *toJson() override {
+		IM_TIME_SCOPE("BlankPanel", TIMING_TOJSON);
 		json_t *rootJ = json_object();
 
 		// panelTheme
@@ -31,6 +33,7 @@ struct BlankPanel : Module {
 	}
 
 	void fromJson(json_t *rootJ) override {
+		IM_TIME_SCOPE("BlankPanel", TIMING_FROMJSON);
 		// panelTheme
 		// json_t *panelThemeJ = json_object_get(rootJ, "panelTheme");
 		// if (panelThemeJ)
@@ -86,6 +89,7 @@ struct BlankPanelWidget : ModuleWidget {
 
 
 	BlankPanelWidget(BlankPanel *module) : ModuleWidget(module) {
+		IM_TIME_SCOPE("BlankPanel", TIMING_WIDGET);
 		// Main panel from Inkscape
         DynamicSVGPanel *panel = new DynamicSVGPanel();
         //panel->addPanel(SVG::load(assetPlugin(plugin, "res/light/BlankPanel.svg")));
@@ -96,10 +100,10 @@ struct BlankPanelWidget : ModuleWidget {
 
 
 		// Screws
-		addChild(createDynamicScrew<IMScrew>(Vec(15, 0), &module->panelTheme));
-		addChild(createDynamicScrew<IMScrew>(Vec(box.size.x-30, 0), &module->panelTheme));
-		addChild(createDynamicScrew<IMScrew>(Vec(15, 365), &module->panelTheme));
-		addChild(createDynamicScrew<IMScrew>(Vec(box.size.x-30, 365), &module->panelTheme));
+		panel->addChild(createDynamicScrew<IMScrew>(Vec(15, 0), &module->panelTheme));
+		panel->addChild(createDynamicScrew<IMScrew>(Vec(box.size.x-30, 0), &module->panelTheme));
+		panel->addChild(createDynamicScrew<IMScrew>(Vec(15, 365), &module->panelTheme));
+		panel->addChild(createDynamicScrew<IMScrew>(Vec(box.size.x-30, 365), &module->panelTheme));
 		
 	}
 };
@@ -270,6 +270,7 @@ struct Clocked : Module {
 	long notifyInfo[4] = {0l, 0l, 0l, 0l};// downward step counter when swing to be displayed, 0 when normal display
 	long cantRunWarning = 0l;// 0 when no warning, positive downward step counter timer when warning
 	unsigned int lightRefreshCounter = 0;
+	LightState lightState;
 	float resetLight = 0.0f;
 	Trigger resetTrigger;
 	Trigger runTrigger;
@@ -339,6 +340,7 @@ struct Clocked : Module {
 	
 	// called from the main thread (step() can not be called until all modules created)
 	Clocked() : Module(NUM_PARAMS, NUM_INPUTS, NUM_OUTPUTS, NUM_LIGHTS) {
+		lightState.init(&lights);
 		for (int i = 1; i < 4; i++) {
 			clk[i].setup(&clk[0], &resetClockOutputsHigh);		
 		}
@@ -347,6 +349,7 @@ struct Clocked : Module {
 	
 
 	void onReset() override {
+		IM_TIME_SCOPE("Clocked", TIMING_RESET);
 		sampleRate = (double)engineGetSampleRate();
 		sampleTime = 1.0 / sampleRate;
 		displayDelayNoteMode = true;
@@ -395,6 +398,8 @@ struct Clocked : Module {
 	
 	
 	json_t *toJson() override {
+		IM_TIME_SCOPE("Clocked", TIMING_TOJSON);
+		IM_LOG_LIGHTS("Clocked", lightState);
 		json_t *rootJ = json_object();
 		
 		// running
@@ -426,6 +431,7 @@ struct Clocked : Module {
 
 
 	void fromJson(json_t *rootJ) override {
+		IM_TIME_SCOPE("Clocked", TIMING_FROMJSON);
 		// running
 		json_t *runningJ = json_object_get(rootJ, "running");
 		if (runningJ)
@@ -665,22 +671,22 @@ struct Clocked : Module {
 			lightRefreshCounter = 0;
 
 			// Reset light
-			lights[RESET_LIGHT].value =	resetLight;	
+			lightState.set(RESET_LIGHT, resetLight);	
 			resetLight -= (resetLight / lightLambda) * (float)sampleTime * displayRefreshStepSkips;
 			
 			// Run light
-			lights[RUN_LIGHT].value = running ? 1.0f : 0.0f;
+			lightState.set(RUN_LIGHT, running ? 1.0f : 0.0f);
 			
 			// BPM light
 			bool warningFlashState = true;
 			if (cantRunWarning > 0l) 
 				warningFlashState = calcWarningFlash(cantRunWarning, (long) (0.7 * sampleRate / displayRefreshStepSkips));
-			lights[BPMSYNC_LIGHT + 0].value = (bpmDetectionMode && warningFlashState) ? 1.0f : 0.0f;
-			lights[BPMSYNC_LIGHT + 1].value = (bpmDetectionMode && warningFlashState) ? (float)((ppqn - 2)*(ppqn - 2))/440.0f : 0.0f;			
+			lightState.set(BPMSYNC_LIGHT + 0, (bpmDetectionMode && warningFlashState) ? 1.0f : 0.0f);
+			lightState.set(BPMSYNC_LIGHT + 1, (bpmDetectionMode && warningFlashState) ? (float)((ppqn - 2)*(ppqn - 2))/440.0f : 0.0f);			
 			
 			// ratios synched lights
 			for (int i = 1; i < 4; i++)
-				lights[CLK_LIGHTS + i].value = (syncRatios[i] && running) ? 1.0f: 0.0f;
+				lightState.set(CLK_LIGHTS + i, (syncRatios[i] && running) ? 1.0f: 0.0f);
 
 			// info notification counters
 			for (int i = 0; i < 4; i++) {
@@ -706,28 +712,14 @@ struct ClockedWidget : ModuleWidget {
 	IMPort* expPorts[6];
 
 
-	struct RatioDisplayWidget : TransparentWidget {
+	struct RatioDisplayWidget : CachedDisplayWidget {
 		Clocked *module;
 		int knobIndex;
-		std::shared_ptr<Font> font;
-		char displayStr[4];
 		const std::string delayLabelsClock[8] = {"D 0", "/16",   "1/8",  "1/4", "1/3",     "1/2", "2/3",     "3/4"};
 		const std::string delayLabelsNote[8]  = {"D 0", "/64",   "/32",  "/16", "/8t",     "1/8", "/4t",     "/8d"};
 
 		
-		RatioDisplayWidget() {
-			font = Font::load(assetPlugin(plugin, "res/fonts/Segment14.ttf"));
-		}
-		
-		void draw(NVGcontext *vg) override {
-			NVGcolor textColor = prepareDisplay(vg, &box, 18);
-			nvgFontFaceId(vg, font->handle);
-			//nvgTextLetterSpacing(vg, 2.5);
-
-			Vec textPos = Vec(6, 24);
-			nvgFillColor(vg, nvgTransRGBA(textColor, displayAlpha));
-			nvgText(vg, textPos.x, textPos.y, "~~~", NULL);
-			nvgFillColor(vg, textColor);
+		void printContent() override {
 			if (module->notifyInfo[knobIndex] > 0l)
 			{
 				int srcParam = module->notifyingSource[knobIndex];
@@ -781,6 +773,17 @@ struct ClockedWidget : ModuleWidget {
 				}
 			}
 			displayStr[3] = 0;// more safety
+		}
+
+		void drawContent(NVGcontext *vg) override {
+			NVGcolor textColor = prepareDisplay(vg, &box, 18);
+			nvgFontFaceId(vg, getFontHandle(vg));
+			//nvgTextLetterSpacing(vg, 2.5);
+
+			Vec textPos = Vec(6, 24);
+			nvgFillColor(vg, nvgTransRGBA(textColor, displayAlpha));
+			nvgText(vg, textPos.x, textPos.y, "~~~", NULL);
+			nvgFillColor(vg, textColor);
 			nvgText(vg, textPos.x, textPos.y, displayStr, NULL);
 		}
 	};		
@@ -926,6 +929,7 @@ struct ClockedWidget : ModuleWidget {
 
 	
 	ClockedWidget(Clocked *module) : ModuleWidget(module) {
+		IM_TIME_SCOPE("Clocked", TIMING_WIDGET);
  		this->module = module;
 		oldExpansion = -1;
 		
@@ -940,12 +944,12 @@ struct ClockedWidget : ModuleWidget {
         addChild(panel);		
 		
 		// Screws
-		addChild(createDynamicScrew<IMScrew>(Vec(15, 0), &module->panelTheme));
-		addChild(createDynamicScrew<IMScrew>(Vec(15, 365), &module->panelTheme));
-		addChild(createDynamicScrew<IMScrew>(Vec(panel->box.size.x-30, 0), &module->panelTheme));
-		addChild(createDynamicScrew<IMScrew>(Vec(panel->box.size.x-30, 365), &module->panelTheme));
-		addChild(createDynamicScrew<IMScrew>(Vec(panel->box.size.x-30-expWidth, 0), &module->panelTheme));
-		addChild(createDynamicScrew<IMScrew>(Vec(panel->box.size.x-30-expWidth, 365), &module->panelTheme));
+		panel->addChild(createDynamicScrew<IMScrew>(Vec(15, 0), &module->panelTheme));
+		panel->addChild(createDynamicScrew<IMScrew>(Vec(15, 365), &module->panelTheme));
+		panel->addChild(createDynamicScrew<IMScrew>(Vec(panel->box.size.x-30, 0), &module->panelTheme));
+		panel->addChild(createDynamicScrew<IMScrew>(Vec(panel->box.size.x-30, 365), &module->panelTheme));
+		panel->addChild(createDynamicScrew<IMScrew>(Vec(panel->box.size.x-30-expWidth, 0), &module->panelTheme));
+		panel->addChild(createDynamicScrew<IMScrew>(Vec(panel->box.size.x-30-expWidth, 365), &module->panelTheme));
 
 
 		static const int rowRuler0 = 50;//reset,run inputs, master knob and bpm display
@@ -1060,6 +1064,12 @@ Model *modelClocked = Model::create<Clocked, ClockedWidget>("Impromptu Modular",
 
 /*CHANGE LOG
 
+0.6.17:
+segment displays are framebuffer cached and only redrawn when their text changes
+lights are written through LightState, so that only changed lights are written
+screws are drawn in the panel's framebuffer
+optional timing instrumentation (IM_TIMING)
+
 0.6.15:
 add right click menu option for outputs reset high/low when not running
 add P2 and P16 pulses per step modes
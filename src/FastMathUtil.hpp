@@ -0,0 +1,186 @@
+//***********************************************************************************************
+//Impromptu Modular: Modules for VCV Rack by Marc Boulé
+//***********************************************************************************************
+
+#ifndef FAST_MATH_UTIL_HPP
+#define FAST_MATH_UTIL_HPP
+
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+
+// Compile-time switch for per-sample math in FundamentalUtil and SemiModularSynth:
+//   1 = use the approximations below, 0 = use the standard library functions
+#ifndef IM_FAST_MATH
+#define IM_FAST_MATH 1
+#endif
+
+
+// Accuracy-bounded approximations
+// Error bounds are maximum errors measured over the given input ranges against double precision libm
+
+// exp2: relative error < 3e-7 for x in [-126.0f : 126.0f], input is clamped to that range
+inline float fastExp2(float x) {
+	x = fminf(fmaxf(x, -126.0f), 126.0f);
+	float xi = floorf(x);
+	float f = x - xi;// [0.0f : 1.0f)
+	float p = 0.9999999269f + f * (0.6931529682f + f * (0.2401545299f + f * (0.05582360446f + f * (0.008992584029f + f * 0.001876232946f))));
+	int32_t bits = ((int32_t)xi + 127) << 23;
+	float scale;
+	memcpy(&scale, &bits, sizeof(float));
+	return p * scale;
+}
+
+// tanh: absolute error < 3e-7 for all x, relative error < 1e-6 for all x
+//   odd Taylor polynomial for |x| < 0.35f, where 1 - 2 / (e + 1) cancels and would lose the small-signal linearity
+inline float fastTanh(float x) {
+	if (fabsf(x) < 0.35f) {
+		float x2 = x * x;
+		return x * (1.0f + x2 * (-0.3333333333f + x2 * (0.1333333333f + x2 * (-0.05396825397f + x2 * (0.02186948854f + x2 * -0.008863235530f)))));
+	}
+	x = fminf(fmaxf(x, -9.0f), 9.0f);// tanh is 1.0f to float precision beyond this
+	return 1.0f - 2.0f / (fastExp2(x * 2.885390082f) + 1.0f);// 2.885390082 = 2 / ln(2)
+}
+
+// sin(2*pi*phase): absolute error < 3e-7 for phase in [-100.0f : 100.0f], any phase is accepted (period is 1.0f)
+inline float fastSin2Pi(float phase) {
+	float x = phase - roundf(phase);// [-0.5f : 0.5f]
+	float ax = fabsf(x);
+	float fx = fminf(ax, 0.5f - ax);// fold into [0.0f : 0.25f] using sin(pi - a) = sin(a)
+	float x2 = fx * fx;
+	float s = fx * (6.28318516f + x2 * (-41.34165493f + x2 * (81.60099819f + x2 * (-76.54965682f + x2 * 39.5358137f))));
+	return x < 0.0f ? -s : s;
+}
+
+// log2: absolute error < 5e-6 for x in [FLT_MIN : FLT_MAX], x must be positive and normal
+inline float fastLog2(float x) {
+	int32_t bits;
+	memcpy(&bits, &x, sizeof(float));
+	float e = (float)(((bits >> 23) & 0xFF) - 127);
+	bits = (bits & 0x007FFFFF) | 0x3F800000;
+	float m;
+	memcpy(&m, &bits, sizeof(float));
+	float t = m - 1.0f;// [0.0f : 1.0f)
+	return e + t * (1.442664046f + t * (-0.7205155143f + t * (0.4731133461f + t * (-0.3246163867f + t * (0.1923850595f + t * (-0.07815821162f + t * 0.015127917f))))));
+}
+
+
+#ifdef __SSE2__
+// SSE versions (4 lanes), same error bounds as the scalar versions above
+
+inline __m128 fastExp2(__m128 x) {
+	x = _mm_min_ps(_mm_max_ps(x, _mm_set1_ps(-126.0f)), _mm_set1_ps(126.0f));
+	__m128i xi = _mm_cvttps_epi32(x);
+	__m128 xf = _mm_cvtepi32_ps(xi);
+	__m128 adj = _mm_and_ps(_mm_cmpgt_ps(xf, x), _mm_set1_ps(1.0f));// truncation to floor for negative inputs
+	xf = _mm_sub_ps(xf, adj);
+	xi = _mm_cvtps_epi32(xf);
+	__m128 f = _mm_sub_ps(x, xf);
+	__m128 p = _mm_set1_ps(0.001876232946f);
+	p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(0.008992584029f));
+	p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(0.05582360446f));
+	p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(0.2401545299f));
+	p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(0.6931529682f));
+	p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(0.9999999269f));
+	__m128 scale = _mm_castsi128_ps(_mm_slli_epi32(_mm_add_epi32(xi, _mm_set1_epi32(127)), 23));
+	return _mm_mul_ps(p, scale);
+}
+
+inline __m128 fastTanh(__m128 x) {
+	__m128 small = _mm_cmplt_ps(_mm_andnot_ps(_mm_set1_ps(-0.0f), x), _mm_set1_ps(0.35f));// lanes that use the polynomial
+	__m128 x2 = _mm_mul_ps(x, x);
+	__m128 p = _mm_set1_ps(-0.008863235530f);
+	p = _mm_add_ps(_mm_mul_ps(p, x2), _mm_set1_ps(0.02186948854f));
+	p = _mm_add_ps(_mm_mul_ps(p, x2), _mm_set1_ps(-0.05396825397f));
+	p = _mm_add_ps(_mm_mul_ps(p, x2), _mm_set1_ps(0.1333333333f));
+	p = _mm_add_ps(_mm_mul_ps(p, x2), _mm_set1_ps(-0.3333333333f));
+	p = _mm_add_ps(_mm_mul_ps(p, x2), _mm_set1_ps(1.0f));
+	p = _mm_mul_ps(p, x);
+	__m128 xc = _mm_min_ps(_mm_max_ps(x, _mm_set1_ps(-9.0f)), _mm_set1_ps(9.0f));
+	__m128 e = fastExp2(_mm_mul_ps(xc, _mm_set1_ps(2.885390082f)));
+	__m128 t = _mm_sub_ps(_mm_set1_ps(1.0f), _mm_div_ps(_mm_set1_ps(2.0f), _mm_add_ps(e, _mm_set1_ps(1.0f))));
+	return _mm_or_ps(_mm_and_ps(small, p), _mm_andnot_ps(small, t));
+}
+
+inline __m128 fastSin2Pi(__m128 phase) {
+	const __m128 signMask = _mm_set1_ps(-0.0f);
+	__m128 x = _mm_sub_ps(phase, _mm_cvtepi32_ps(_mm_cvtps_epi32(phase)));// round to nearest (default MXCSR rounding)
+	__m128 sign = _mm_and_ps(x, signMask);
+	__m128 ax = _mm_andnot_ps(signMask, x);
+	__m128 fx = _mm_min_ps(ax, _mm_sub_ps(_mm_set1_ps(0.5f), ax));
+	__m128 x2 = _mm_mul_ps(fx, fx);
+	__m128 p = _mm_set1_ps(39.5358137f);
+	p = _mm_add_ps(_mm_mul_ps(p, x2), _mm_set1_ps(-76.54965682f));
+	p = _mm_add_ps(_mm_mul_ps(p, x2), _mm_set1_ps(81.60099819f));
+	p = _mm_add_ps(_mm_mul_ps(p, x2), _mm_set1_ps(-41.34165493f));
+	p = _mm_add_ps(_mm_mul_ps(p, x2), _mm_set1_ps(6.28318516f));
+	return _mm_xor_ps(_mm_mul_ps(p, fx), sign);
+}
+
+inline __m128 fastLog2(__m128 x) {
+	__m128i bits = _mm_castps_si128(x);
+	__m128 e = _mm_cvtepi32_ps(_mm_sub_epi32(_mm_and_si128(_mm_srli_epi32(bits, 23), _mm_set1_epi32(0xFF)), _mm_set1_epi32(127)));
+	__m128 m = _mm_castsi128_ps(_mm_or_si128(_mm_and_si128(bits, _mm_set1_epi32(0x007FFFFF)), _mm_set1_epi32(0x3F800000)));
+	__m128 t = _mm_sub_ps(m, _mm_set1_ps(1.0f));
+	__m128 p = _mm_set1_ps(0.015127917f);
+	p = _mm_add_ps(_mm_mul_ps(p, t), _mm_set1_ps(-0.07815821162f));
+	p = _mm_add_ps(_mm_mul_ps(p, t), _mm_set1_ps(0.1923850595f));
+	p = _mm_add_ps(_mm_mul_ps(p, t), _mm_set1_ps(-0.3246163867f));
+	p = _mm_add_ps(_mm_mul_ps(p, t), _mm_set1_ps(0.4731133461f));
+	p = _mm_add_ps(_mm_mul_ps(p, t), _mm_set1_ps(-0.7205155143f));
+	p = _mm_add_ps(_mm_mul_ps(p, t), _mm_set1_ps(1.442664046f));
+	return _mm_add_ps(e, _mm_mul_ps(p, t));
+}
+#endif
+
+
+// Switched versions for call sites (see IM_FAST_MATH above)
+
+inline float imExp2(float x) {
+#if IM_FAST_MATH
+	return fastExp2(x);
+#else
+	return powf(2.0f, x);
+#endif
+}
+
+inline float imTanh(float x) {
+#if IM_FAST_MATH
+	return fastTanh(x);
+#else
+	return tanhf(x);
+#endif
+}
+
+inline void imTanh4(const float* in, float* out) {// four values at once, in and out can be the same array
+#if IM_FAST_MATH && defined(__SSE2__)
+	_mm_storeu_ps(out, fastTanh(_mm_loadu_ps(in)));
+#else
+	for (int i = 0; i < 4; i++)
+		out[i] = imTanh(in[i]);
+#endif
+}
+
+inline float imSin2Pi(float phase) {
+#if IM_FAST_MATH
+	return fastSin2Pi(phase);
+#else
+	return sinf(2.0f * M_PI * phase);
+#endif
+}
+
+inline float imLog2(float x) {
+#if IM_FAST_MATH
+	return fastLog2(x);
+#else
+	return log2f(x);
+#endif
+}
+
+
+#endif
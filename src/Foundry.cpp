@@ -129,6 +129,33 @@ struct Foundry : Module {
 	
 
 	unsigned int lightRefreshCounter = 0;
+	LightState lightState;
+	struct DisplaySnapshot {// what the displays show, published in the light refresh so that the widgets don't read the live sequencer
+		int displayState;
+		bool editingSequence;
+		bool attached;
+		bool running;
+		bool multiTracks;
+		bool velocityBipol;
+		int velEditMode;
+		int velocityMode;
+		StepAttributes attribute;
+		int trackIndexEdit;
+		int seqIndexEdit;
+		int phraseIndexEdit;
+		int phraseSeq;
+		int phraseReps;
+		int length;
+		int transposeOffset;
+		int rotateOffset;
+		int runModeSeq;
+		int runModeSong;
+		int pulsesPerStep;
+		int delay;
+		int begin;
+		int end;
+	};
+	SeqLock<DisplaySnapshot> displaySnapshot;
 	float resetLight = 0.0f;
 	int sequenceKnob = 0;
 	int velocityKnob = 0;
@@ -137,7 +164,7 @@ struct Foundry : Module {
 	Trigger leftTrigger;
 	Trigger rightTrigger;
 	Trigger runningTrigger;
-	Trigger clockTriggers[SequencerKernel::MAX_STEPS];
+	ClockInput clockTriggers[SequencerKernel::MAX_STEPS];
 	Trigger keyTriggers[12];
 	Trigger octTriggers[7];
 	Trigger gate1Trigger;
@@ -175,14 +202,17 @@ struct Foundry : Module {
 
 	
 	Foundry() : Module(NUM_PARAMS, NUM_INPUTS, NUM_OUTPUTS, NUM_LIGHTS) {
+		lightState.init(&lights);
 		seq.construct(&holdTiedNotes, &velocityMode);
 		onReset();
+		publishDisplaySnapshot();
 	}
 
 	
 	// widgets are not yet created when module is created (and when onReset() is called by constructor)
 	// onReset() is also called when right-click initialization of module
 	void onReset() override {
+		IM_TIME_SCOPE("Foundry", TIMING_RESET);
 		autoseq = false;
 		autostepLen = false;
 		showSharp = true;
@@ -217,6 +247,8 @@ struct Foundry : Module {
 	
 	
 	json_t *toJson() override {
+		IM_TIME_SCOPE("Foundry", TIMING_TOJSON);
+		IM_LOG_LIGHTS("Foundry", lightState);
 		json_t *rootJ = json_object();
 
 		// panelTheme
@@ -271,6 +303,7 @@ struct Foundry : Module {
 
 	
 	void fromJson(json_t *rootJ) override {
+		IM_TIME_SCOPE("Foundry", TIMING_FROMJSON);
 		// panelTheme
 		json_t *panelThemeJ = json_object_get(rootJ, "panelTheme");
 		if (panelThemeJ) {
@@ -875,7 +908,7 @@ struct Foundry : Module {
 			for (int trkn = 0; trkn < Sequencer::NUM_TRACKS; trkn++) {
 				clockTrigged[trkn] = clockTriggers[trkn].process(inputs[CLOCK_INPUTS + trkn].value);
 				if (clockTrigged[clkInSources[trkn]]) {
-					seq.clockStep(trkn, editingSequence);
+					seq.clockStep(trkn, editingSequence, clockTriggers[clkInSources[trkn]].getPeriod());
 				}
 			}
 			seq.step();
@@ -893,6 +926,7 @@ struct Foundry : Module {
 					seq.setSeqIndexEdit(0, trkn);
 			}
 		}
+		seq.publishPendingRuns();// run state changes from the reset, the ui thread and the phrase edits, for lookahead()
 
 
 		
@@ -988,7 +1022,7 @@ struct Foundry : Module {
 				}
 
 				setGreenRed(STEP_PHRASE_LIGHTS + stepn * 3, green, red);
-				lights[STEP_PHRASE_LIGHTS + stepn * 3 + 2].value = white;
+				lightState.set(STEP_PHRASE_LIGHTS + stepn * 3 + 2, white);
 			}
 			
 			
@@ -1004,7 +1038,7 @@ struct Foundry : Module {
 					else				
 						red = (i == (6 - octLightIndex) ? 1.0f : 0.0f);// no lights when outside of range
 				}
-				lights[OCTAVE_LIGHTS + i].value = red;
+				lightState.set(OCTAVE_LIGHTS + i, red);
 			}
 			
 			// Keyboard lights
@@ -1063,54 +1097,54 @@ struct Foundry : Module {
 				setGreenRed(GATE_LIGHT, editingGates ? 1.0f : 0.0f, editingGates ? 0.2f : 1.0f);
 			if (tiedWarning > 0l) {
 				bool warningFlashState = calcWarningFlash(tiedWarning, (long) (warningTime * sampleRate / displayRefreshStepSkips));
-				lights[TIE_LIGHT].value = (warningFlashState) ? 1.0f : 0.0f;
+				lightState.set(TIE_LIGHT, (warningFlashState) ? 1.0f : 0.0f);
 			}
 			else
-				lights[TIE_LIGHT].value = attributesVisual.getTied() ? 1.0f : 0.0f;			
+				lightState.set(TIE_LIGHT, attributesVisual.getTied() ? 1.0f : 0.0f);			
 			if (attributesVisual.getGateP())
 				setGreenRed(GATE_PROB_LIGHT, 1.0f, 1.0f);
 			else 
 				setGreenRed(GATE_PROB_LIGHT, 0.0f, 0.0f);
-			lights[SLIDE_LIGHT].value = attributesVisual.getSlide() ? 1.0f : 0.0f;
+			lightState.set(SLIDE_LIGHT, attributesVisual.getSlide() ? 1.0f : 0.0f);
 			
 			// Reset light
-			lights[RESET_LIGHT].value =	resetLight;
+			lightState.set(RESET_LIGHT, resetLight);
 			resetLight -= (resetLight / lightLambda) * engineGetSampleTime() * displayRefreshStepSkips;
 			
 			// Run light
-			lights[RUN_LIGHT].value = (running ? 1.0f : 0.0f);
+			lightState.set(RUN_LIGHT, (running ? 1.0f : 0.0f));
 
 			// Attach light
 			if (attachedWarning > 0l) {
 				bool warningFlashState = calcWarningFlash(attachedWarning, (long) (warningTime * sampleRate / displayRefreshStepSkips));
-				lights[ATTACH_LIGHT].value = (warningFlashState) ? 1.0f : 0.0f;
+				lightState.set(ATTACH_LIGHT, (warningFlashState) ? 1.0f : 0.0f);
 			}
 			else
-				lights[ATTACH_LIGHT].value = (attached ? 1.0f : 0.0f);
+				lightState.set(ATTACH_LIGHT, (attached ? 1.0f : 0.0f));
 				
 			// Velocity edit mode lights
 			if (editingSequence || (attached && running)) {
 				setGreenRed(VEL_PROB_LIGHT, velEditMode == 1 ? 1.0f : 0.0f, velEditMode == 1 ? 1.0f : 0.0f);
-				lights[VEL_SLIDE_LIGHT].value = (velEditMode == 2 ? 1.0f : 0.0f);
+				lightState.set(VEL_SLIDE_LIGHT, (velEditMode == 2 ? 1.0f : 0.0f));
 			}
 			else {
 				setGreenRed(VEL_PROB_LIGHT, 0.0f, 0.0f);
-				lights[VEL_SLIDE_LIGHT].value = 0.0f;
+				lightState.set(VEL_SLIDE_LIGHT, 0.0f);
 			}
 			
 			// CV writing lights
 			for (int trkn = 0; trkn < Sequencer::NUM_TRACKS; trkn++) {
 				if (editingSequence) {
-					lights[WRITECV_LIGHTS + trkn].value = (((writeMode & 0x2) == 0) && (multiTracks || seq.getTrackIndexEdit() == trkn)) ? 1.0f : 0.0f;
-					lights[WRITECV2_LIGHTS + trkn].value = (((writeMode & 0x1) == 0) && (multiTracks || seq.getTrackIndexEdit() == trkn)) ? 1.0f : 0.0f;
+					lightState.set(WRITECV_LIGHTS + trkn, (((writeMode & 0x2) == 0) && (multiTracks || seq.getTrackIndexEdit() == trkn)) ? 1.0f : 0.0f);
+					lightState.set(WRITECV2_LIGHTS + trkn, (((writeMode & 0x1) == 0) && (multiTracks || seq.getTrackIndexEdit() == trkn)) ? 1.0f : 0.0f);
 				}
 				else {
-					lights[WRITECV_LIGHTS + trkn].value = 0.0f;
-					lights[WRITECV2_LIGHTS + trkn].value = 0.0f;
+					lightState.set(WRITECV_LIGHTS + trkn, 0.0f);
+					lightState.set(WRITECV2_LIGHTS + trkn, 0.0f);
 				}
 			}	
-			lights[WRITE_SEL_LIGHTS + 0].value = (((writeMode & 0x2) == 0) && editingSequence) ? 1.0f : 0.0f;
-			lights[WRITE_SEL_LIGHTS + 1].value = (((writeMode & 0x1) == 0) && editingSequence) ? 1.0f : 0.0f;
+			lightState.set(WRITE_SEL_LIGHTS + 0, (((writeMode & 0x2) == 0) && editingSequence) ? 1.0f : 0.0f);
+			lightState.set(WRITE_SEL_LIGHTS + 1, (((writeMode & 0x1) == 0) && editingSequence) ? 1.0f : 0.0f);
 				
 			seq.stepEditingGate();// also steps editingType
 			if (tiedWarning > 0l)
@@ -1122,6 +1156,8 @@ struct Foundry : Module {
 					displayState = DISP_NORMAL;
 				revertDisplay--;
 			}
+			
+			publishDisplaySnapshot();
 		}// lightRefreshCounter
 				
 		if (clockIgnoreOnReset > 0l)
@@ -1130,9 +1166,37 @@ struct Foundry : Module {
 	}// step()
 	
 
+	void publishDisplaySnapshot() {
+		DisplaySnapshot snap;
+		snap.displayState = displayState;
+		snap.editingSequence = isEditingSequence();
+		snap.attached = attached;
+		snap.running = running;
+		snap.multiTracks = multiTracks;
+		snap.velocityBipol = velocityBipol;
+		snap.velEditMode = velEditMode;
+		snap.velocityMode = velocityMode;
+		snap.attribute = seq.getAttribute(snap.editingSequence);
+		snap.trackIndexEdit = seq.getTrackIndexEdit();
+		snap.seqIndexEdit = seq.getSeqIndexEdit();
+		snap.phraseIndexEdit = seq.getPhraseIndexEdit();
+		snap.phraseSeq = seq.getPhraseSeq();
+		snap.phraseReps = seq.getPhraseReps();
+		snap.length = seq.getLength();
+		snap.transposeOffset = seq.getTransposeOffset();
+		snap.rotateOffset = seq.getRotateOffset();
+		snap.runModeSeq = seq.getRunModeSeq();
+		snap.runModeSong = seq.getRunModeSong();
+		snap.pulsesPerStep = seq.getPulsesPerStep();
+		snap.delay = seq.getDelay();
+		snap.begin = seq.getBegin();
+		snap.end = seq.getEnd();
+		displaySnapshot.write(snap);
+	}
+	
 	inline void setGreenRed(int id, float green, float red) {
-		lights[id + 0].value = green;
-		lights[id + 1].value = red;
+		lightState.set(id + 0, green);
+		lightState.set(id + 1, red);
 	}
 	
 	inline void calcClkInSources() {
@@ -1158,10 +1222,9 @@ struct FoundryWidget : ModuleWidget {
 	IMPort* expPorts[16];
 	
 	template <int NUMCHAR>
-	struct DisplayWidget : TransparentWidget {// a centered display, must derive from this
+	struct DisplayWidget : CachedDisplayWidget {// a centered display, must derive from this
 		Foundry *module;
-		std::shared_ptr<Font> font;
-		char displayStr[NUMCHAR + 1];
+		Foundry::DisplaySnapshot snap;// copy of the module's display snapshot, printText() reads this instead of the module
 		static const int textFontSize = 15;
 		static constexpr float textOffsetY = 19.9f; // 18.2f for 14 pt, 19.7f for 15pt
 		
@@ -1174,12 +1237,17 @@ struct FoundryWidget : ModuleWidget {
 			box.size = _size;
 			box.pos = _pos.minus(_size.div(2));
 			module = _module;
-			font = Font::load(assetPlugin(plugin, "res/fonts/Segment14.ttf"));
+			module->displaySnapshot.read(&snap);
 		}
 		
-		void draw(NVGcontext *vg) override {
+		void printContent() override {
+			if (module->displaySnapshot.read(&snap))
+				displayFlags = printText();// else keep what is shown, a consistent snapshot will be read next frame
+		}
+		
+		void drawContent(NVGcontext *vg) override {
 			NVGcolor textColor = prepareDisplay(vg, &box, textFontSize);
-			nvgFontFaceId(vg, font->handle);
+			nvgFontFaceId(vg, getFontHandle(vg));
 			nvgTextLetterSpacing(vg, -0.4);
 
 			Vec textPos = Vec(5.7f, textOffsetY);
@@ -1187,12 +1255,11 @@ struct FoundryWidget : ModuleWidget {
 			std::string initString(NUMCHAR,'~');
 			nvgText(vg, textPos.x, textPos.y, initString.c_str(), NULL);
 			nvgFillColor(vg, textColor);
-			char overlayChar = printText();
+			char overlayChar = (char)displayFlags;
 			nvgText(vg, textPos.x, textPos.y, displayStr, NULL);
 			if (overlayChar != 0) {
-				displayStr[0] = overlayChar;
-				displayStr[1] = 0;
-				nvgText(vg, textPos.x, textPos.y, displayStr, NULL);
+				char overlayStr[2] = {overlayChar, 0};
+				nvgText(vg, textPos.x, textPos.y, overlayStr, NULL);
 			}
 		}
 		
@@ -1202,14 +1269,14 @@ struct FoundryWidget : ModuleWidget {
 	struct VelocityDisplayWidget : DisplayWidget<4> {
 		VelocityDisplayWidget(Vec _pos, Vec _size, Foundry *_module) : DisplayWidget(_pos, _size, _module) {};
 
-		void draw(NVGcontext *vg) override {
+		void drawContent(NVGcontext *vg) override {
 			static const float offsetXfrac = 3.5f;
 			NVGcolor textColor = prepareDisplay(vg, &box, textFontSize);
-			nvgFontFaceId(vg, font->handle);
+			nvgFontFaceId(vg, getFontHandle(vg));
 			nvgTextLetterSpacing(vg, -0.4);
 
 			Vec textPos = Vec(6.3f, textOffsetY);
-			char useRed = printText();
+			char useRed = (char)displayFlags;
 			if (useRed == 1)
 				textColor = nvgRGB(0xE0, 0xD0, 0x30);
 			nvgFillColor(vg, nvgTransRGBA(textColor, displayAlpha));
@@ -1220,20 +1287,20 @@ struct FoundryWidget : ModuleWidget {
 				textColor = nvgRGB(0xFF, 0x2C, 0x20);
 			nvgFillColor(vg, textColor);
 			nvgText(vg, textPos.x + offsetXfrac, textPos.y, &displayStr[1], NULL);
-			displayStr[1] = 0;
-			nvgText(vg, textPos.x, textPos.y, displayStr, NULL);
+			char firstStr[2] = {displayStr[0], 0};// displayStr is not modified here, it is compared with the shown text in step()
+			nvgText(vg, textPos.x, textPos.y, firstStr, NULL);
 		}
 
 		char printText() override {
 			char ret = 0;// used for a color instead of overlay char. 0 = default (green), 1 = red
 			StepAttributes attributesVisual;
 			attributesVisual.clear();
-			bool editingSequence = module->isEditingSequence();
-			if (editingSequence || (module->attached && module->running)) {
-				attributesVisual = module->seq.getAttribute(editingSequence);
+			bool editingSequence = snap.editingSequence;
+			if (editingSequence || (snap.attached && snap.running)) {
+				attributesVisual = snap.attribute;
 			}
-			if (editingSequence || (module->attached && module->running)) {
-				if (module->velEditMode == 2) {
+			if (editingSequence || (snap.attached && snap.running)) {
+				if (snap.velEditMode == 2) {
 					int slide = attributesVisual.getSlideVal();						
 					if ( slide >= 100)
 						snprintf(displayStr, 5, "   1");
@@ -1242,7 +1309,7 @@ struct FoundryWidget : ModuleWidget {
 					else
 						snprintf(displayStr, 5, "   0");
 				}
-				else if (module->velEditMode == 1) {
+				else if (snap.velEditMode == 1) {
 					int prob = attributesVisual.getGatePVal();
 					if ( prob >= 100)
 						snprintf(displayStr, 5, "   1");
@@ -1253,9 +1320,9 @@ struct FoundryWidget : ModuleWidget {
 				}
 				else {
 					unsigned int velocityDisp = (unsigned)(attributesVisual.getVelocityVal());
-					if (module->velocityMode > 0) {// velocity is 0-127 or semitone
-						if (module->velocityMode == 2)// semitone
-							printNote(((float)velocityDisp)/12.0f - (module->velocityBipol ? 5.0f : 0.0f), &displayStr[1], true);// given str pointer must be 4 chars (3 display and one end of string)
+					if (snap.velocityMode > 0) {// velocity is 0-127 or semitone
+						if (snap.velocityMode == 2)// semitone
+							printNote(((float)velocityDisp)/12.0f - (snap.velocityBipol ? 5.0f : 0.0f), &displayStr[1], true);// given str pointer must be 4 chars (3 display and one end of string)
 						else// 0-127
 							snprintf(displayStr, 5, " %3u", min(velocityDisp, 127));
 						displayStr[0] = displayStr[1];
@@ -1264,7 +1331,7 @@ struct FoundryWidget : ModuleWidget {
 					else {// velocity is 0-10V
 						float cvValPrint = (float)velocityDisp;
 						cvValPrint /= 20.0f;
-						if (module->velocityBipol) {						
+						if (snap.velocityBipol) {						
 							if (cvValPrint < 5.0f)
 								ret = 1;
 							cvValPrint = fabsf(cvValPrint - 5.0f);
@@ -1291,14 +1358,14 @@ struct FoundryWidget : ModuleWidget {
 		SeqEditDisplayWidget(Vec _pos, Vec _size, Foundry *_module) : DisplayWidget(_pos, _size, _module) {};
 		
 		char printText() override {
-			switch (module->displayState) {
+			switch (snap.displayState) {
 			
 				case Foundry::DISP_PPQN :
 				case Foundry::DISP_DELAY :
 					snprintf(displayStr, 4, " - ");
 				break;
 				case Foundry::DISP_REPS :
-					snprintf(displayStr, 4, "R%2u", (unsigned) module->seq.getPhraseReps());
+					snprintf(displayStr, 4, "R%2u", (unsigned) snap.phraseReps);
 				break;
 				case Foundry::DISP_COPY_SEQ :
 					snprintf(displayStr, 4, "CPY");
@@ -1307,11 +1374,11 @@ struct FoundryWidget : ModuleWidget {
 					snprintf(displayStr, 4, "PST");
 				break;
 				case Foundry::DISP_LEN :
-					snprintf(displayStr, 4, "L%2u", (unsigned) module->seq.getLength());
+					snprintf(displayStr, 4, "L%2u", (unsigned) snap.length);
 				break;
 				case Foundry::DISP_TRANSPOSE :
 				{
-					int tranOffset = module->seq.getTransposeOffset();
+					int tranOffset = snap.transposeOffset;
 					snprintf(displayStr, 4, "+%2u", (unsigned) abs(tranOffset));
 					if (tranOffset < 0)
 						displayStr[0] = '-';
@@ -1319,7 +1386,7 @@ struct FoundryWidget : ModuleWidget {
 				break;
 				case Foundry::DISP_ROTATE :
 				{
-					int rotOffset = module->seq.getRotateOffset();
+					int rotOffset = snap.rotateOffset;
 					snprintf(displayStr, 4, ")%2u", (unsigned) abs(rotOffset));
 					if (rotOffset < 0)
 						displayStr[0] = '(';
@@ -1327,11 +1394,11 @@ struct FoundryWidget : ModuleWidget {
 				break;
 				default :
 				{
-					if (module->isEditingSequence()) {
-						snprintf(displayStr, 4, " %2u", (unsigned)(module->seq.getSeqIndexEdit() + 1) );
+					if (snap.editingSequence) {
+						snprintf(displayStr, 4, " %2u", (unsigned)(snap.seqIndexEdit + 1) );
 					}
 					else {
-						snprintf(displayStr, 4, " %2u", (unsigned)(module->seq.getPhraseSeq() + 1) );
+						snprintf(displayStr, 4, " %2u", (unsigned)(snap.phraseSeq + 1) );
 					}
 				}
 			}
@@ -1346,32 +1413,32 @@ struct FoundryWidget : ModuleWidget {
 		char printText() override {
 			char overlayChar = 0;// extra char to print an end symbol overlaped (begin symbol done in here)
 
-			if (module->displayState == Foundry::DISP_COPY_SONG) {
+			if (snap.displayState == Foundry::DISP_COPY_SONG) {
 				snprintf(displayStr, 4, "CPY");
 			}
-			else if (module->displayState == Foundry::DISP_PASTE_SONG) {
+			else if (snap.displayState == Foundry::DISP_PASTE_SONG) {
 				snprintf(displayStr, 4, "PST");
 			}
-			else if (module->displayState == Foundry::DISP_MODE_SONG) {
-				runModeToStr(module->seq.getRunModeSong());
+			else if (snap.displayState == Foundry::DISP_MODE_SONG) {
+				runModeToStr(snap.runModeSong);
 			}
-			else if (module->displayState == Foundry::DISP_PPQN) {
-				snprintf(displayStr, 4, "x%2u", (unsigned) module->seq.getPulsesPerStep());
+			else if (snap.displayState == Foundry::DISP_PPQN) {
+				snprintf(displayStr, 4, "x%2u", (unsigned) snap.pulsesPerStep);
 			}
-			else if (module->displayState == Foundry::DISP_DELAY) {
-				snprintf(displayStr, 4, "D%2u", (unsigned) module->seq.getDelay());
+			else if (snap.displayState == Foundry::DISP_DELAY) {
+				snprintf(displayStr, 4, "D%2u", (unsigned) snap.delay);
 			}
-			else if (module->displayState == Foundry::DISP_MODE_SEQ) {
-				runModeToStr(module->seq.getRunModeSeq());
+			else if (snap.displayState == Foundry::DISP_MODE_SEQ) {
+				runModeToStr(snap.runModeSeq);
 			}
 			else { 
-				if (module->isEditingSequence()) {
+				if (snap.editingSequence) {
 					snprintf(displayStr, 4, " - ");
 				}
 				else { // editing song
-					int phrn = module->seq.getPhraseIndexEdit(); // good whether attached or not
-					int phrBeg = module->seq.getBegin();
-					int phrEnd = module->seq.getEnd();
+					int phrn = snap.phraseIndexEdit; // good whether attached or not
+					int phrBeg = snap.begin;
+					int phrEnd = snap.end;
 					snprintf(displayStr, 4, " %2u", (unsigned)(phrn + 1));
 					bool begHere = (phrn == phrBeg);
 					bool endHere = (phrn == phrEnd);
@@ -1386,7 +1453,7 @@ struct FoundryWidget : ModuleWidget {
 					}
 					else if (phrn < phrEnd && phrn > phrBeg)
 						displayStr[0] = '_';
-					if (module->displayState == Foundry::DISP_COPY_SONG_CUST) {
+					if (snap.displayState == Foundry::DISP_COPY_SONG_CUST) {
 						overlayChar = 0;
 						displayStr[0] = (time(0) & 0x1) ? 'C' : ' ';
 					}
@@ -1400,9 +1467,9 @@ struct FoundryWidget : ModuleWidget {
 	struct TrackDisplayWidget : DisplayWidget<2> {
 		TrackDisplayWidget(Vec _pos, Vec _size, Foundry *_module) : DisplayWidget(_pos, _size, _module) {};
 		char printText() override {
-			int trkn = module->seq.getTrackIndexEdit();
-			if (module->multiTracks)
-				snprintf(displayStr, 3, "%c%c", (unsigned)(trkn + 0x41), ((module->multiTracks && (time(0) & 0x1)) ? '*' : ' '));
+			int trkn = snap.trackIndexEdit;
+			if (snap.multiTracks)
+				snprintf(displayStr, 3, "%c%c", (unsigned)(trkn + 0x41), ((snap.multiTracks && (time(0) & 0x1)) ? '*' : ' '));
 			else {
 				snprintf(displayStr, 3, " %c", (unsigned)(trkn + 0x41));
 			}
@@ -1705,6 +1772,7 @@ struct FoundryWidget : ModuleWidget {
 	};
 		
 	FoundryWidget(Foundry *module) : ModuleWidget(module) {
+		IM_TIME_SCOPE("Foundry", TIMING_WIDGET);
 		this->module = module;
 		oldExpansion = -1;
 		
@@ -1719,14 +1787,14 @@ struct FoundryWidget : ModuleWidget {
         addChild(panel);
 		
 		// Screws
-		addChild(createDynamicScrew<IMScrew>(Vec(15, 0), &module->panelTheme));
-		addChild(createDynamicScrew<IMScrew>(Vec(15, 365), &module->panelTheme));
-		addChild(createDynamicScrew<IMScrew>(Vec(panel->box.size.x-30, 0), &module->panelTheme));
-		addChild(createDynamicScrew<IMScrew>(Vec(panel->box.size.x-30, 365), &module->panelTheme));
-		addChild(createDynamicScrew<IMScrew>(Vec(panel->box.size.x-30-expWidth, 0), &module->panelTheme));
-		addChild(createDynamicScrew<IMScrew>(Vec(panel->box.size.x-30-expWidth, 365), &module->panelTheme));
-		addChild(createDynamicScrew<IMScrew>(Vec(panel->box.size.x-expWidth + 15, 0), &module->panelTheme));
-		addChild(createDynamicScrew<IMScrew>(Vec(panel->box.size.x-expWidth + 15, 365), &module->panelTheme));
+		panel->addChild(createDynamicScrew<IMScrew>(Vec(15, 0), &module->panelTheme));
+		panel->addChild(createDynamicScrew<IMScrew>(Vec(15, 365), &module->panelTheme));
+		panel->addChild(createDynamicScrew<IMScrew>(Vec(panel->box.size.x-30, 0), &module->panelTheme));
+		panel->addChild(createDynamicScrew<IMScrew>(Vec(panel->box.size.x-30, 365), &module->panelTheme));
+		panel->addChild(createDynamicScrew<IMScrew>(Vec(panel->box.size.x-30-expWidth, 0), &module->panelTheme));
+		panel->addChild(createDynamicScrew<IMScrew>(Vec(panel->box.size.x-30-expWidth, 365), &module->panelTheme));
+		panel->addChild(createDynamicScrew<IMScrew>(Vec(panel->box.size.x-expWidth + 15, 0), &module->panelTheme));
+		panel->addChild(createDynamicScrew<IMScrew>(Vec(panel->box.size.x-expWidth + 15, 365), &module->panelTheme));
 
 		
 		
@@ -2051,6 +2119,14 @@ Model *modelFoundry = Model::create<Foundry, FoundryWidget>("Impromptu Modular",
 make seq/song switch behave like in PS series
 remove metal panel theme
 reword expansion panel (add 4 SEQ CV inputs, and add sync mode for delayed change on end of sequence)
+track kernels can look ahead at the steps to come (random run modes and probabilities use each track's own generator)
+advanced gates come from the shared gate pattern table (AdvGateUtil), same gates as before for all pulses per step
+slides use a filtered clock period measured by the new ClockInput front end (sub-sample edge position and period)
+segment displays are framebuffer cached and only redrawn when their text changes
+lights are written through LightState, so that only changed lights are written
+screws are drawn in the panel's framebuffer
+displays read a snapshot of the display state published at light refresh rate (SeqLock)
+optional timing instrumentation (IM_TIMING)
 
 0.6.16:
 add gate status feedback in steps (white lights)
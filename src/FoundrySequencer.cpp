@@ -504,8 +504,8 @@ void Sequencer::reset(bool editingSequence) {
 }
 
 
-void Sequencer::clockStep(int trkn, bool editingSequence) {
-	bool phraseChange = sek[trkn].clockStep(editingSequence, delayedSeqNumberRequest[trkn]);
+void Sequencer::clockStep(int trkn, bool editingSequence, float filteredClockPeriod) {
+	bool phraseChange = sek[trkn].clockStep(editingSequence, delayedSeqNumberRequest[trkn], filteredClockPeriod);
 	
 	if (editingSequence) {
 		if (phraseChange) {
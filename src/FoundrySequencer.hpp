@@ -246,13 +246,23 @@ class Sequencer {
 			sek[trkn].initRun(editingSequence);
 	}
 
-	void clockStep(int trkn, bool editingSequence);
+	void clockStep(int trkn, bool editingSequence, float filteredClockPeriod);
 	
 	inline void step() {
 		for (int trkn = 0; trkn < NUM_TRACKS; trkn++)
 			sek[trkn].step();
 	}
 	
+	inline void publishPendingRuns() {// call once per sample from the module's step(), after the reset
+		bool masterPublished = sek[0].publishPendingRun();
+		for (int trkn = 1; trkn < NUM_TRACKS; trkn++) {
+			if (masterPublished)
+				sek[trkn].publishRun();// tracks B-D also publish track A's run state
+			else
+				sek[trkn].publishPendingRun();
+		}
+	}
+	
 };// class Sequencer 
 
 
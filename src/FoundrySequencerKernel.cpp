@@ -9,23 +9,14 @@
 const std::string SequencerKernel::modeLabels[NUM_MODES] = {"FWD", "REV", "PPG", "PEN", "BRN", "RND", "TKA"};
 
 
-const uint64_t SequencerKernel::advGateHitMaskLow[NUM_GATES] = 
-{0x0000000000FFFFFF, 0x0000FFFF0000FFFF, 0x0000FFFFFFFFFFFF, 0x0000FFFF00000000, 0xFFFFFFFFFFFFFFFF, 0xFFFFFFFFFFFFFFFF, 
-//				25%					TRI		  			50%					T23		  			75%					FUL		
- 0x000000000000FFFF, 0xFFFF000000FFFFFF, 0x0000FFFF00000000, 0xFFFF000000000000, 0x0000000000000000, 0};
-//  			TR1 				DUO		  			TR2 	     		D2		  			TR3  TRIG		
-const uint64_t SequencerKernel::advGateHitMaskHigh[NUM_GATES] = 
-{0x0000000000000000, 0x000000000000FFFF, 0x0000000000000000, 0x000000000000FFFF, 0x00000000000000FF, 0x00000000FFFFFFFF, 
-//				25%					TRI		  			50%					T23		  			75%					FUL		
- 0x0000000000000000, 0x00000000000000FF, 0x0000000000000000, 0x00000000000000FF, 0x000000000000FFFF, 0};
-//  			TR1 				DUO		  			TR2 	     		D2		  			TR3  TRIG		
-
-
 void SequencerKernel::construct(int _id, SequencerKernel *_masterKernel, bool* _holdTiedNotesPtr) {// don't want regaular constructor mechanism
 	id = _id;
 	ids = "id" + std::to_string(id) + "_";
 	masterKernel = _masterKernel;
 	holdTiedNotesPtr = _holdTiedNotesPtr;
+	run.stepRandom.seed(randomu64());
+	run.phraseRandom.seed(randomu64());
+	publishRun();// the module is not in the engine yet
 }
 
 
@@ -363,18 +354,20 @@ void SequencerKernel::fromJson(json_t *rootJ) {
 
 
 void SequencerKernel::initRun(bool editingSequence) {
-	movePhraseIndexRun(true);// true means init 
-	moveStepIndexRunIgnore = false;
-	moveStepIndexRun(true, editingSequence);// true means init 
+	movePhraseIndexRun(&run, getMasterRun(), true);// true means init 
+	run.moveStepIndexRunIgnore = false;
+	moveStepIndexRun(&run, getMasterRun(), true, editingSequence);// true means init 
 	
 	ppqnCount = 0;
 	ppqnLeftToSkip = delay;
 	calcGateCodeEx(editingSequence);// uses stepIndexRun as the step and {phraseIndexRun or seqIndexEdit} to determine the seq
 	slideStepsRemain = 0ul;
+	requestPublishRun();
 }
 
 
-bool SequencerKernel::clockStep(bool editingSequence, int delayedSeqNumberRequest) {// delayedSeqNumberRequest is only valid in seq mode (-1 means no request)
+bool SequencerKernel::clockStep(bool editingSequence, int delayedSeqNumberRequest, float filteredClockPeriod) {// delayedSeqNumberRequest is only valid in seq mode (-1 means no request)
+	// filteredClockPeriod is the clock period in samples from ClockInput::getPeriod(), slides use the last interval when it is 0.0f
 	bool phraseChange = false;
 	
 	if (ppqnLeftToSkip > 0) {
@@ -387,23 +380,20 @@ bool SequencerKernel::clockStep(bool editingSequence, int delayedSeqNumberReques
 			ppqnCount = 0;
 		if (ppqnCount == 0) {
 			float slideFromCV = getCV(editingSequence);
-			if (moveStepIndexRun(false, editingSequence)) {// false means normal (not init)
+			if (moveToNextStep(&run, getMasterRun(), editingSequence)) {
 				phraseChange = true;// used by first track for random slaving, and also by all tracks for delayed Seq CV request
 				if (editingSequence) {
 					if (delayedSeqNumberRequest >= 0) {
 						seqIndexEdit = delayedSeqNumberRequest;
 					}
 				}
-				else {
-					movePhraseIndexRun(false);// false means normal (not init)
-					moveStepIndexRun(true, editingSequence);// true means init; must always refresh after phraseIndexRun has changed
-				}
 			}
 
 			// Slide
 			StepAttributes attribRun = getAttribute(editingSequence);
 			if (attribRun.getSlide()) {
-				slideStepsRemain = (unsigned long) (((float)clockPeriod * ppsFiltered) * ((float)attribRun.getSlideVal() / 100.0f));
+				float slidePeriod = (filteredClockPeriod > 0.0f ? filteredClockPeriod : (float)clockPeriod);
+				slideStepsRemain = (unsigned long) ((slidePeriod * ppsFiltered) * ((float)attribRun.getSlideVal() / 100.0f));
 				if (slideStepsRemain != 0ul) {
 					float slideToCV = getCV(editingSequence);
 					slideCVdelta = (slideToCV - slideFromCV)/(float)slideStepsRemain;
@@ -415,11 +405,44 @@ bool SequencerKernel::clockStep(bool editingSequence, int delayedSeqNumberReques
 		calcGateCodeEx(editingSequence);// uses stepIndexRun as the step and {phraseIndexRun or seqIndexEdit} to determine the seq
 	}
 	clockPeriod = 0ul;
+	publishRun();
 	
 	return phraseChange;
 }
 
 
+int SequencerKernel::lookahead(LookaheadStep* steps, int numSteps, bool editingSequence) {
+	// fills steps[] with the next numSteps steps that will start, returns numSteps; the kernel's state is not changed
+	// exact as long as the sequences, the song and delayed sequence number requests are not changed in the meantime, and 
+	//   for TKA tracks, when track A has the same pulses per step and delay as this track
+	// returns 0 when the run state was being published, try again later (next frame when called from the ui thread)
+	PublishedRun published;
+	if (!runPublished.read(&published))
+		return 0;
+	RunState runAhead = published.run;
+	RunState masterAhead = published.masterRun;
+	for (int n = 0; n < numSteps; n++) {
+		if (masterKernel != nullptr) {// track A is clocked first, see Foundry::step() and Sequencer::clockStep()
+			bool masterPhraseChange = masterKernel->moveToNextStep(&masterAhead, nullptr, editingSequence);
+			masterKernel->calcGateAhead(&masterAhead, editingSequence);// keeps track A's generator in step
+			if (masterPhraseChange && !editingSequence && runModeSong == MODE_TKA) {
+				runAhead.phraseIndexRun = masterAhead.phraseIndexRun;
+				runAhead.moveStepIndexRunIgnore = true;
+			}
+		}
+		moveToNextStep(&runAhead, (masterKernel != nullptr ? &masterAhead : nullptr), editingSequence);
+		int seqn = (editingSequence ? seqIndexEdit : phrases[runAhead.phraseIndexRun].getSeqNum());
+		steps[n].phraseIndex = (editingSequence ? -1 : runAhead.phraseIndexRun);
+		steps[n].seq = seqn;
+		steps[n].stepIndex = runAhead.stepIndexRun;
+		steps[n].cv = cv[seqn][runAhead.stepIndexRun];
+		steps[n].gate = calcGateAhead(&runAhead, editingSequence);
+		steps[n].attribute = attributes[seqn][runAhead.stepIndexRun];
+	}
+	return numSteps;
+}
+
+
 int SequencerKernel::keyIndexToGateTypeEx(int keyIndex) {// return -1 when invalid gate type given current pps setting
 	int ppsFiltered = getPulsesPerStep();// must use method
 	int ret = keyIndex;
@@ -546,8 +569,8 @@ void SequencerKernel::deactivateTiedStep(int seqn, int stepn) {// caller sets di
 
 
 void SequencerKernel::calcGateCodeEx(bool editingSequence) {// uses stepIndexRun as the step and {phraseIndexRun or seqIndexEdit} to determine the seq
-	int seqn = editingSequence ? seqIndexEdit : phrases[phraseIndexRun].getSeqNum();
-	StepAttributes attribute = attributes[seqn][stepIndexRun];
+	int seqn = editingSequence ? seqIndexEdit : phrases[run.phraseIndexRun].getSeqNum();
+	StepAttributes attribute = attributes[seqn][run.stepIndexRun];
 	int ppsFiltered = getPulsesPerStep();// must use method
 	int gateType;
 
@@ -555,87 +578,105 @@ void SequencerKernel::calcGateCodeEx(bool editingSequence) {// uses stepIndexRun
 		gateType = attribute.getGateType();
 		
 		// -1 = gate off for whole step, 0 = gate off for current ppqn, 1 = gate on, 2 = clock high, 3 = trigger
-		if ( ppqnCount == 0 && attribute.getGateP() && !(randomUniform() < ((float)attribute.getGatePVal() / 100.0f)) ) {// randomUniform is [0.0, 1.0), see include/util/common.hpp
+		if ( ppqnCount == 0 && attribute.getGateP() && !(run.stepRandom.uniform() < ((float)attribute.getGatePVal() / 100.0f)) ) {// uniform() is [0.0, 1.0), same as randomUniform()
 			gateCode = -1;// must do this first in this method since it will kill all remaining pulses of the step if prob turns off the step
 		}
 		else if (!attribute.getGate()) {
 			gateCode = 0;
 		}
-		else if (ppsFiltered == 1 && gateType == 0) {
-			gateCode = 2;// clock high pulse
-		}
 		else {
-			if (gateType == 11) {
-				gateCode = (ppqnCount == 0 ? 3 : 0);// trig on first ppqnCount
-			}
-			else {
-				uint64_t shiftAmt = ppqnCount * (96 / ppsFiltered);
-				if (shiftAmt >= 64)
-					gateCode = (int)((advGateHitMaskHigh[gateType] >> (shiftAmt - (uint64_t)64)) & (uint64_t)0x1);
-				else
-					gateCode = (int)((advGateHitMaskLow[gateType] >> shiftAmt) & (uint64_t)0x1);
-			}
+			gateCode = advGates.getCode(gateType, ppqnCount, ppsFiltered);// gate types are the built-in patterns, see AdvGateUtil.hpp
 		}
 	}
 }
 	
 
-bool SequencerKernel::moveStepIndexRun(bool init, bool editingSequence) {	
-	if (moveStepIndexRunIgnore) {
-		moveStepIndexRunIgnore = false;
+void SequencerKernel::publishRun() {// tracks B-D are clocked after track A (see Sequencer::clockStep()), and published after it (see Sequencer::publishPendingRuns())
+	runPublishPending.store(false, std::memory_order_relaxed);
+	PublishedRun published;
+	published.run = run;
+	published.masterRun = (masterKernel != nullptr ? masterKernel->run : run);// not used by track A
+	runPublished.write(published);
+}
+
+
+bool SequencerKernel::calcGateAhead(RunState* rs, bool editingSequence) {// same draw as calcGateCodeEx() does on the first pulse of a step
+	int seqn = editingSequence ? seqIndexEdit : phrases[rs->phraseIndexRun].getSeqNum();
+	StepAttributes attribute = attributes[seqn][rs->stepIndexRun];
+	if (attribute.getGateP() && !(rs->stepRandom.uniform() < ((float)attribute.getGatePVal() / 100.0f)))
+		return false;
+	return attribute.getGate();
+}
+
+
+bool SequencerKernel::moveToNextStep(RunState* rs, const RunState* masterRs, bool editingSequence) {// returns true when the sequence was completed
+	if (moveStepIndexRun(rs, masterRs, false, editingSequence)) {// false means normal (not init)
+		if (!editingSequence) {
+			movePhraseIndexRun(rs, masterRs, false);// false means normal (not init)
+			moveStepIndexRun(rs, masterRs, true, editingSequence);// true means init; must always refresh after phraseIndexRun has changed
+		}
+		return true;
+	}
+	return false;
+}
+
+
+bool SequencerKernel::moveStepIndexRun(RunState* rs, const RunState* masterRs, bool init, bool editingSequence) {	
+	if (rs->moveStepIndexRunIgnore) {
+		rs->moveStepIndexRunIgnore = false;
 		return true;
 	}
 	
-	int reps = (editingSequence ? 1 : phrases[phraseIndexRun].getReps());// 0-rep seqs should be filtered elsewhere and should never happen here. If they do, they will be played (this can be the case when all of the song has 0-rep seqs, or the song is started (reset) into a first phrase that has 0 reps)
+	int reps = (editingSequence ? 1 : phrases[rs->phraseIndexRun].getReps());// 0-rep seqs should be filtered elsewhere and should never happen here. If they do, they will be played (this can be the case when all of the song has 0-rep seqs, or the song is started (reset) into a first phrase that has 0 reps)
 	// assert((reps * MAX_STEPS) <= 0xFFF); // for BRN and RND run modes, history is not a span count but a step count
-	int seqn = (editingSequence ? seqIndexEdit : phrases[phraseIndexRun].getSeqNum());
+	int seqn = (editingSequence ? seqIndexEdit : phrases[rs->phraseIndexRun].getSeqNum());
 	int runMode = sequences[seqn].getRunMode();
 	int endStep = sequences[seqn].getLength() - 1;
 	
 	bool crossBoundary = false;
 	
 	if (init)
-		stepIndexRunHistory = 0;
+		rs->stepIndexRunHistory = 0;
 	
 	switch (runMode) {
 	
 		// history 0x0000 is reserved for reset
 		
 		case MODE_REV :// reverse; history base is 0x2000
-			if (stepIndexRunHistory < 0x2001 || stepIndexRunHistory > 0x2FFF)
-				stepIndexRunHistory = 0x2000 + reps;
+			if (rs->stepIndexRunHistory < 0x2001 || rs->stepIndexRunHistory > 0x2FFF)
+				rs->stepIndexRunHistory = 0x2000 + reps;
 			if (init)
-				stepIndexRun = endStep;
+				rs->stepIndexRun = endStep;
 			else {
-				stepIndexRun--;
-				if (stepIndexRun < 0) {
-					stepIndexRun = endStep;
-					stepIndexRunHistory--;
-					if (stepIndexRunHistory <= 0x2000)
+				rs->stepIndexRun--;
+				if (rs->stepIndexRun < 0) {
+					rs->stepIndexRun = endStep;
+					rs->stepIndexRunHistory--;
+					if (rs->stepIndexRunHistory <= 0x2000)
 						crossBoundary = true;
 				}
 			}
 		break;
 		
 		case MODE_PPG :// forward-reverse; history base is 0x3000
-			if (stepIndexRunHistory < 0x3001 || stepIndexRunHistory > 0x3FFF) // even means going forward, odd means going reverse
-				stepIndexRunHistory = 0x3000 + reps * 2;
+			if (rs->stepIndexRunHistory < 0x3001 || rs->stepIndexRunHistory > 0x3FFF) // even means going forward, odd means going reverse
+				rs->stepIndexRunHistory = 0x3000 + reps * 2;
 			if (init)
-				stepIndexRun = 0;
+				rs->stepIndexRun = 0;
 			else {
-				if ((stepIndexRunHistory & 0x1) == 0) {// even so forward phase
-					stepIndexRun++;
-					if (stepIndexRun > endStep) {
-						stepIndexRun = endStep;
-						stepIndexRunHistory--;
+				if ((rs->stepIndexRunHistory & 0x1) == 0) {// even so forward phase
+					rs->stepIndexRun++;
+					if (rs->stepIndexRun > endStep) {
+						rs->stepIndexRun = endStep;
+						rs->stepIndexRunHistory--;
 					}
 				}
 				else {// odd so reverse phase
-					stepIndexRun--;
-					if (stepIndexRun < 0) {
-						stepIndexRun = 0;
-						stepIndexRunHistory--;
-						if (stepIndexRunHistory <= 0x3000)
+					rs->stepIndexRun--;
+					if (rs->stepIndexRun < 0) {
+						rs->stepIndexRun = 0;
+						rs->stepIndexRunHistory--;
+						if (rs->stepIndexRunHistory <= 0x3000)
 							crossBoundary = true;
 					}
 				}
@@ -643,32 +684,32 @@ bool SequencerKernel::moveStepIndexRun(bool init, bool editingSequence) {
 		break;
 
 		case MODE_PEN :// forward-reverse; history base is 0x4000
-			if (stepIndexRunHistory < 0x4001 || stepIndexRunHistory > 0x4FFF) // even means going forward, odd means going reverse
-				stepIndexRunHistory = 0x4000 + reps * 2;
+			if (rs->stepIndexRunHistory < 0x4001 || rs->stepIndexRunHistory > 0x4FFF) // even means going forward, odd means going reverse
+				rs->stepIndexRunHistory = 0x4000 + reps * 2;
 			if (init)
-				stepIndexRun = 0;
+				rs->stepIndexRun = 0;
 			else {			
-				if ((stepIndexRunHistory & 0x1) == 0) {// even so forward phase
-					stepIndexRun++;
-					if (stepIndexRun > endStep) {
-						stepIndexRun = endStep - 1;
-						stepIndexRunHistory--;
-						if (stepIndexRun <= 0) {// if back at start after turnaround, then no reverse phase needed
-							stepIndexRun = 0;
-							stepIndexRunHistory--;
-							if (stepIndexRunHistory <= 0x4000)
+				if ((rs->stepIndexRunHistory & 0x1) == 0) {// even so forward phase
+					rs->stepIndexRun++;
+					if (rs->stepIndexRun > endStep) {
+						rs->stepIndexRun = endStep - 1;
+						rs->stepIndexRunHistory--;
+						if (rs->stepIndexRun <= 0) {// if back at start after turnaround, then no reverse phase needed
+							rs->stepIndexRun = 0;
+							rs->stepIndexRunHistory--;
+							if (rs->stepIndexRunHistory <= 0x4000)
 								crossBoundary = true;
 						}
 					}
 				}
 				else {// odd so reverse phase
-					stepIndexRun--;
-					if (stepIndexRun > endStep)// handle song jumped
-						stepIndexRun = endStep;
-					if (stepIndexRun <= 0) {
-						stepIndexRun = 0;
-						stepIndexRunHistory--;
-						if (stepIndexRunHistory <= 0x4000)
+					rs->stepIndexRun--;
+					if (rs->stepIndexRun > endStep)// handle song jumped
+						rs->stepIndexRun = endStep;
+					if (rs->stepIndexRun <= 0) {
+						rs->stepIndexRun = 0;
+						rs->stepIndexRunHistory--;
+						if (rs->stepIndexRunHistory <= 0x4000)
 							crossBoundary = true;
 					}
 				}
@@ -676,53 +717,53 @@ bool SequencerKernel::moveStepIndexRun(bool init, bool editingSequence) {
 		break;
 		
 		case MODE_BRN :// brownian random; history base is 0x5000
-			if (stepIndexRunHistory < 0x5001 || stepIndexRunHistory > 0x5FFF) 
-				stepIndexRunHistory = 0x5000 + (endStep + 1) * reps;			
+			if (rs->stepIndexRunHistory < 0x5001 || rs->stepIndexRunHistory > 0x5FFF) 
+				rs->stepIndexRunHistory = 0x5000 + (endStep + 1) * reps;			
 			if (init)
-				stepIndexRun = 0;
+				rs->stepIndexRun = 0;
 			else {
-				stepIndexRun += (randomu32() % 3) - 1;
-				if (stepIndexRun > endStep)
-					stepIndexRun = 0;
-				if (stepIndexRun < 0)
-					stepIndexRun = endStep;
-				stepIndexRunHistory--;
-				if (stepIndexRunHistory <= 0x5000)
+				rs->stepIndexRun += (rs->stepRandom.u32() % 3) - 1;
+				if (rs->stepIndexRun > endStep)
+					rs->stepIndexRun = 0;
+				if (rs->stepIndexRun < 0)
+					rs->stepIndexRun = endStep;
+				rs->stepIndexRunHistory--;
+				if (rs->stepIndexRunHistory <= 0x5000)
 					crossBoundary = true;
 			}
 		break;
 		
 		case MODE_RND :// random; history base is 0x6000
-			if (stepIndexRunHistory < 0x6001 || stepIndexRunHistory > 0x6FFF)
-				stepIndexRunHistory = 0x6000 + (endStep + 1) * reps;
+			if (rs->stepIndexRunHistory < 0x6001 || rs->stepIndexRunHistory > 0x6FFF)
+				rs->stepIndexRunHistory = 0x6000 + (endStep + 1) * reps;
 			if (init)
-				stepIndexRun = 0;
+				rs->stepIndexRun = 0;
 			else {
-				stepIndexRun = (randomu32() % (endStep + 1));
-				stepIndexRunHistory--;
-				if (stepIndexRunHistory <= 0x6000)
+				rs->stepIndexRun = (rs->stepRandom.u32() % (endStep + 1));
+				rs->stepIndexRunHistory--;
+				if (rs->stepIndexRunHistory <= 0x6000)
 					crossBoundary = true;
 			}
 		break;
 		
 		case MODE_TKA :// use track A's stepIndexRun; base is 0x7000
-			if (masterKernel != nullptr) {
-				stepIndexRunHistory = 0x7000;
-				stepIndexRun = masterKernel->getStepIndexRun();
+			if (masterRs != nullptr) {
+				rs->stepIndexRunHistory = 0x7000;
+				rs->stepIndexRun = masterRs->stepIndexRun;
 				break;
 			}
 			[[fallthrough]];
 		default :// MODE_FWD  forward; history base is 0x1000
-			if (stepIndexRunHistory < 0x1001 || stepIndexRunHistory > 0x1FFF)
-				stepIndexRunHistory = 0x1000 + reps;
+			if (rs->stepIndexRunHistory < 0x1001 || rs->stepIndexRunHistory > 0x1FFF)
+				rs->stepIndexRunHistory = 0x1000 + reps;
 			if (init)
-				stepIndexRun = 0;
+				rs->stepIndexRun = 0;
 			else {			
-				stepIndexRun++;
-				if (stepIndexRun > endStep) {
-					stepIndexRun = 0;
-					stepIndexRunHistory--;
-					if (stepIndexRunHistory <= 0x1000)
+				rs->stepIndexRun++;
+				if (rs->stepIndexRun > endStep) {
+					rs->stepIndexRun = 0;
+					rs->stepIndexRunHistory--;
+					if (rs->stepIndexRunHistory <= 0x1000)
 						crossBoundary = true;
 				}
 			}
@@ -732,51 +773,52 @@ bool SequencerKernel::moveStepIndexRun(bool init, bool editingSequence) {
 }
 
 
-void SequencerKernel::moveSongIndexBackward(bool init, bool rollover) {
+void SequencerKernel::moveSongIndexBackward(RunState* rs, bool init, bool rollover) {
 	int phrn = 0;
 
 	// search backward for next non 0-rep seq, ends up in same phrase if all reps in the song are 0
 	if (init) {
-		phraseIndexRun = songEndIndex;
-		phrn = phraseIndexRun;
+		rs->phraseIndexRun = songEndIndex;
+		phrn = rs->phraseIndexRun;
 	}
 	else
-		phrn = min(phraseIndexRun - 1, songEndIndex);// handle song jumped
+		phrn = min(rs->phraseIndexRun - 1, songEndIndex);// handle song jumped
 	for (; phrn >= songBeginIndex && phrases[phrn].getReps() == 0; phrn--);
 	if (phrn < songBeginIndex) {
 		if (rollover)
-			for (phrn = songEndIndex; phrn > phraseIndexRun && phrases[phrn].getReps() == 0; phrn--);
+			for (phrn = songEndIndex; phrn > rs->phraseIndexRun && phrases[phrn].getReps() == 0; phrn--);
 		else
-			phrn = phraseIndexRun;
-		phraseIndexRunHistory--;
+			phrn = rs->phraseIndexRun;
+		rs->phraseIndexRunHistory--;
 	}
-	phraseIndexRun = phrn;
+	rs->phraseIndexRun = phrn;
 }
 
 
-void SequencerKernel::moveSongIndexForeward(bool init, bool rollover) {
+void SequencerKernel::moveSongIndexForeward(RunState* rs, bool init, bool rollover) {
 	int phrn = 0;
 	
 	// search fowrard for next non 0-rep seq, ends up in same phrase if all reps in the song are 0
 	if (init) {
-		phraseIndexRun = songBeginIndex;
-		phrn = phraseIndexRun;
+		rs->phraseIndexRun = songBeginIndex;
+		phrn = rs->phraseIndexRun;
 	}
 	else
-		phrn = max(phraseIndexRun + 1, songBeginIndex);// handle song jumped
+		phrn = max(rs->phraseIndexRun + 1, songBeginIndex);// handle song jumped
 	for (; phrn <= songEndIndex && phrases[phrn].getReps() == 0; phrn++);
 	if (phrn > songEndIndex) {
 		if (rollover)
-			for (phrn = songBeginIndex; phrn < phraseIndexRun && phrases[phrn].getReps() == 0; phrn++);
+			for (phrn = songBeginIndex; phrn < rs->phraseIndexRun && phrases[phrn].getReps() == 0; phrn++);
 		else
-			phrn = phraseIndexRun;
-		phraseIndexRunHistory--;
+			phrn = rs->phraseIndexRun;
+		rs->phraseIndexRunHistory--;
 	}
-	phraseIndexRun = phrn;
+	rs->phraseIndexRun = phrn;
 }
 
 
-void SequencerKernel::moveSongIndexRandom(bool init, uint32_t randomValue) {
+void SequencerKernel::moveSongIndexRandom(RunState* rs, bool init, uint32_t randomValue) {
+	int tempPhraseIndexes[MAX_PHRASES];// local so that lookahead() can run alongside the audio thread
 	int phrn = songBeginIndex;
 	int tpi = 0;
 	
@@ -789,93 +831,93 @@ void SequencerKernel::moveSongIndexRandom(bool init, uint32_t randomValue) {
 	}
 	
 	if (init) {
-		phraseIndexRun = (tpi == 0 ? songBeginIndex : tempPhraseIndexes[0]);
+		rs->phraseIndexRun = (tpi == 0 ? songBeginIndex : tempPhraseIndexes[0]);
 	}
 	else {
-		phraseIndexRun = tempPhraseIndexes[randomValue % tpi];
+		rs->phraseIndexRun = tempPhraseIndexes[randomValue % tpi];
 	}
 }
 
 
-void SequencerKernel::moveSongIndexBrownian(bool init, uint32_t randomValue) {	
+void SequencerKernel::moveSongIndexBrownian(RunState* rs, bool init, uint32_t randomValue) {	
 	randomValue = randomValue % 3;// 0 = left, 1 = stay, 2 = right
 	
 	if (init) {
-		moveSongIndexForeward(init, true);
+		moveSongIndexForeward(rs, init, true);
 	}
 	else if (randomValue == 1) {// stay
-		if (phraseIndexRun > songEndIndex || phraseIndexRun < songBeginIndex)
-			moveSongIndexForeward(false, true);	
+		if (rs->phraseIndexRun > songEndIndex || rs->phraseIndexRun < songBeginIndex)
+			moveSongIndexForeward(rs, false, true);	
 	}
 	else if (randomValue == 0) {// left
-		moveSongIndexBackward(false, true);
+		moveSongIndexBackward(rs, false, true);
 	}
 	else {// right
-		moveSongIndexForeward(false, true);
+		moveSongIndexForeward(rs, false, true);
 	}
 }
 
 
-void SequencerKernel::movePhraseIndexRun(bool init) {	
+void SequencerKernel::movePhraseIndexRun(RunState* rs, const RunState* masterRs, bool init) {	
 	if (init)
-		phraseIndexRunHistory = 0;
+		rs->phraseIndexRunHistory = 0;
 	
 	switch (runModeSong) {
 	
 		// history 0x0000 is reserved for reset
 		
 		case MODE_REV :// reverse; history base is 0x2000
-			phraseIndexRunHistory = 0x2000;
-			moveSongIndexBackward(init, true);
+			rs->phraseIndexRunHistory = 0x2000;
+			moveSongIndexBackward(rs, init, true);
 		break;
 		
 		case MODE_PPG :// forward-reverse; history base is 0x3000
-			if (phraseIndexRunHistory < 0x3001 || phraseIndexRunHistory > 0x3002) // even means going forward, odd means going reverse
-				phraseIndexRunHistory = 0x3002;
-			if (phraseIndexRunHistory == 0x3002) {// even so forward phase
-				moveSongIndexForeward(init, false);
+			if (rs->phraseIndexRunHistory < 0x3001 || rs->phraseIndexRunHistory > 0x3002) // even means going forward, odd means going reverse
+				rs->phraseIndexRunHistory = 0x3002;
+			if (rs->phraseIndexRunHistory == 0x3002) {// even so forward phase
+				moveSongIndexForeward(rs, init, false);
 			}
 			else {// odd so reverse phase
-				moveSongIndexBackward(false, false);
+				moveSongIndexBackward(rs, false, false);
 			}
 		break;
 
 		case MODE_PEN :// forward-reverse; history base is 0x4000
-			if (phraseIndexRunHistory < 0x4001 || phraseIndexRunHistory > 0x4002) // even means going forward, odd means going reverse
-				phraseIndexRunHistory = 0x4002;
-			if (phraseIndexRunHistory == 0x4002) {// even so forward phase	
-				moveSongIndexForeward(init, false);
-				if (phraseIndexRunHistory == 0x4001)
-					moveSongIndexBackward(false, false);
+			if (rs->phraseIndexRunHistory < 0x4001 || rs->phraseIndexRunHistory > 0x4002) // even means going forward, odd means going reverse
+				rs->phraseIndexRunHistory = 0x4002;
+			if (rs->phraseIndexRunHistory == 0x4002) {// even so forward phase	
+				moveSongIndexForeward(rs, init, false);
+				if (rs->phraseIndexRunHistory == 0x4001)
+					moveSongIndexBackward(rs, false, false);
 			}
 			else {// odd so reverse phase
-				moveSongIndexBackward(false, false);
-				if (phraseIndexRunHistory == 0x4000)
-					moveSongIndexForeward(false, false);
+				moveSongIndexBackward(rs, false, false);
+				if (rs->phraseIndexRunHistory == 0x4000)
+					moveSongIndexForeward(rs, false, false);
 			}			
 		break;
 		
 		case MODE_BRN :// brownian random; history base is 0x5000
-			phraseIndexRunHistory = 0x5000;
-			moveSongIndexBrownian(init, randomu32());
+			rs->phraseIndexRunHistory = 0x5000;
+			moveSongIndexBrownian(rs, init, rs->phraseRandom.u32());
 		break;
 		
 		case MODE_RND :// random; history base is 0x6000
-			phraseIndexRunHistory = 0x6000;
-			moveSongIndexRandom(init, randomu32());
+			rs->phraseIndexRunHistory = 0x6000;
+			moveSongIndexRandom(rs, init, rs->phraseRandom.u32());
 		break;
 		
 		case MODE_TKA:// use track A's phraseIndexRun; base is 0x7000
-			if (masterKernel != nullptr) {
-				phraseIndexRunHistory = 0x7000;
-				if (init)// only init to be done in here, rest is handled in Sequencer::clockStep()
-					phraseIndexRun = masterKernel->getPhraseIndexRun();
+			if (masterRs != nullptr) {
+				rs->phraseIndexRunHistory = 0x7000;
+				if (init)// only init to be done in here, rest is handled in Sequencer::clockStep() and lookahead()
+					rs->phraseIndexRun = masterRs->phraseIndexRun;
 				break;
 			}
 			[[fallthrough]];// TKA defaults to FWD for track A
 		default :// MODE_FWD  forward; history base is 0x1000
-			phraseIndexRunHistory = 0x1000;
-			moveSongIndexForeward(init, true);
+			rs->phraseIndexRunHistory = 0x1000;
+			moveSongIndexForeward(rs, init, true);
 	}
 }
 
@@ -7,6 +7,7 @@
 
 
 #include "ImpromptuModular.hpp"
+#include "AdvGateUtil.hpp"
 
 
 class StepAttributes {
@@ -143,6 +144,12 @@ class SeqAttributes {
 // SequencerKernel
 //*****************************************************************************
 
+// Random run modes and gate probabilities draw from the kernel's own generators, so that lookahead() can predict what
+//   a track will play by advancing a copy of its run state (and of track A's, for TKA tracks), without changing anything
+// The run states are published through a SeqLock after every change, and lookahead() copies the published ones, so that
+//   it can be called from the ui thread as well as from the engine thread; the SeqLock is only written by the engine thread,
+//   changes that can come from the ui thread (initRun() from onReset() and fromJson()) are published by publishPendingRun()
+
 
 struct SeqCPbuffer;
 struct SongCPbuffer;
@@ -159,14 +166,18 @@ class SequencerKernel {
 	enum RunModeIds {MODE_FWD, MODE_REV, MODE_PPG, MODE_PEN, MODE_BRN, MODE_RND, MODE_TKA, NUM_MODES};
 	static const std::string modeLabels[NUM_MODES];
 	
+	struct LookaheadStep {// what a future step will play
+		int phraseIndex;// -1 when editing a sequence
+		int seq;
+		int stepIndex;
+		float cv;
+		bool gate;// false when the gate is off or its probability will turn it off
+		StepAttributes attribute;// slide, tied, gate type and velocity of the step
+	};
+	
 	
 	private:
 	
-	// Gate types
-	static const int NUM_GATES = 12;	
-	static const uint64_t advGateHitMaskLow[NUM_GATES];		
-	static const uint64_t advGateHitMaskHigh[NUM_GATES];
-
 	static constexpr float INIT_CV = 0.0f;
 
 	int id;
@@ -186,10 +197,22 @@ class SequencerKernel {
 	char dirty[MAX_SEQS];
 	
 	// No need to save
-	int stepIndexRun;
-	unsigned long stepIndexRunHistory;
-	int phraseIndexRun;
-	unsigned long phraseIndexRunHistory;
+	struct RunState {// everything that moving to the next step changes
+		int stepIndexRun;
+		unsigned long stepIndexRunHistory;
+		int phraseIndexRun;
+		unsigned long phraseIndexRunHistory;
+		bool moveStepIndexRunIgnore;
+		RandomState stepRandom;// random step run modes and gate probabilities
+		RandomState phraseRandom;// random song run modes
+	};
+	RunState run;
+	struct PublishedRun {// copy of run for lookahead(), along with track A's taken at the same time (for tracks B-D)
+		RunState run;
+		RunState masterRun;
+	};
+	SeqLock<PublishedRun> runPublished;// see publishRun()
+	std::atomic<bool> runPublishPending;// run was changed outside of clockStep(), see publishPendingRun()
 	int ppqnCount;
 	int ppqnLeftToSkip;// used in clock delay
 	int gateCode;// -1 = Killed for all pulses of step, 0 = Low for current pulse of step, 1 = High for current pulse of step, 2 = Clk high pulse, 3 = 1ms trig
@@ -198,7 +221,6 @@ class SequencerKernel {
 	SequencerKernel *masterKernel;// nullprt for track 0, used for grouped run modes (tracks B,C,D follow A when random, for example)
 	bool* holdTiedNotesPtr;
 	unsigned long clockPeriod;// counts number of step() calls upward from last clock (reset after clock processed)
-	bool moveStepIndexRunIgnore;
 	
 	
 	public: 
@@ -217,23 +239,24 @@ class SequencerKernel {
 	inline int getDelay() {return delay;}
 	inline int getTransposeOffset() {return sequences[seqIndexEdit].getTranspose();}
 	inline int getRotateOffset() {return sequences[seqIndexEdit].getRotate();}
-	inline int getStepIndexRun() {return stepIndexRun;}
-	inline int getPhraseIndexRun() {return phraseIndexRun;}
-	inline float getCV(bool editingSequence) {return getCV(editingSequence, stepIndexRun);}
+	inline int getStepIndexRun() {return run.stepIndexRun;}
+	inline int getPhraseIndexRun() {return run.phraseIndexRun;}
+	inline int getGateCode() {return gateCode;}
+	inline float getCV(bool editingSequence) {return getCV(editingSequence, run.stepIndexRun);}
 	inline float getCV(bool editingSequence, int stepn) {
 		if (editingSequence)
 			return cv[seqIndexEdit][stepn];
-		return cv[phrases[phraseIndexRun].getSeqNum()][stepn];
+		return cv[phrases[run.phraseIndexRun].getSeqNum()][stepn];
 	}
-	inline StepAttributes getAttribute(bool editingSequence) {return getAttribute(editingSequence, stepIndexRun);}
+	inline StepAttributes getAttribute(bool editingSequence) {return getAttribute(editingSequence, run.stepIndexRun);}
 	inline StepAttributes getAttribute(bool editingSequence, int stepn) {
 		if (editingSequence)
 			return attributes[seqIndexEdit][stepn];
-		return attributes[phrases[phraseIndexRun].getSeqNum()][stepn];
+		return attributes[phrases[run.phraseIndexRun].getSeqNum()][stepn];
 	}
 	
 	inline void setSeqIndexEdit(int _seqIndexEdit) {seqIndexEdit = _seqIndexEdit;}
-	inline void setPhraseIndexRun(int _phraseIndexRun) {phraseIndexRun = _phraseIndexRun;}
+	inline void setPhraseIndexRun(int _phraseIndexRun) {run.phraseIndexRun = _phraseIndexRun; requestPublishRun();}
 	inline void setPulsesPerStep(int _pps) {pulsesPerStep = _pps;}
 	inline void setDelay(int _delay) {delay = _delay;}
 	inline void setLength(int _length) {sequences[seqIndexEdit].setLength(_length);}
@@ -251,7 +274,7 @@ class SequencerKernel {
 	void setSlideVal(int stepn, int slideVal, int count);
 	void setVelocityVal(int stepn, int velocity, int count);
 	void setGateType(int stepn, int gateType, int count);
-	void setMoveStepIndexRunIgnore() {moveStepIndexRunIgnore = true;}
+	void setMoveStepIndexRunIgnore() {run.moveStepIndexRunIgnore = true; requestPublishRun();}
 	
 	inline int modRunModeSong(int delta) {
 		runModeSong = clamp(runModeSong += delta, 0, NUM_MODES - 1);
@@ -364,10 +387,18 @@ class SequencerKernel {
 	void toJson(json_t *rootJ);
 	void fromJson(json_t *rootJ);
 	void initRun(bool editingSequence);
-	bool clockStep(bool editingSequence, int delayedSeqNumberRequest);
+	bool clockStep(bool editingSequence, int delayedSeqNumberRequest, float filteredClockPeriod);
 	inline void step() {
 		clockPeriod++;
 	}
+	inline bool publishPendingRun() {// call once per sample from the engine thread, returns true when the run state was published
+		if (!runPublishPending.load(std::memory_order_acquire))
+			return false;
+		publishRun();
+		return true;
+	}
+	void publishRun();// engine thread only (or before the module is in the engine)
+	int lookahead(LookaheadStep* steps, int numSteps, bool editingSequence);
 	int keyIndexToGateTypeEx(int keyIndex);
 	void transposeSeq(int delta);
 	void unTransposeSeq() {
@@ -389,13 +420,16 @@ class SequencerKernel {
 	void activateTiedStep(int seqn, int stepn);
 	void deactivateTiedStep(int seqn, int stepn);
 	void calcGateCodeEx(bool editingSequence);
-	bool moveStepIndexRun(bool init, bool editingSequence);
-	void moveSongIndexBackward(bool init, bool rollover);
-	void moveSongIndexForeward(bool init, bool rollover);
-	int tempPhraseIndexes[MAX_PHRASES];// used only in next method	
-	void moveSongIndexRandom(bool init, uint32_t randomValue);	
-	void moveSongIndexBrownian(bool init, uint32_t randomValue);	
-	void movePhraseIndexRun(bool init);
+	bool calcGateAhead(RunState* rs, bool editingSequence);
+	inline const RunState* getMasterRun() {return (masterKernel != nullptr ? &masterKernel->run : nullptr);}
+	inline void requestPublishRun() {runPublishPending.store(true, std::memory_order_release);}// any thread, after a change to run
+	bool moveToNextStep(RunState* rs, const RunState* masterRs, bool editingSequence);
+	bool moveStepIndexRun(RunState* rs, const RunState* masterRs, bool init, bool editingSequence);
+	void moveSongIndexBackward(RunState* rs, bool init, bool rollover);
+	void moveSongIndexForeward(RunState* rs, bool init, bool rollover);
+	void moveSongIndexRandom(RunState* rs, bool init, uint32_t randomValue);	
+	void moveSongIndexBrownian(RunState* rs, bool init, uint32_t randomValue);	
+	void movePhraseIndexRun(RunState* rs, const RunState* masterRs, bool init);
 };// class SequencerKernel 
 
 
@@ -46,6 +46,7 @@ struct FourView : Module {
 	
 
 	void onReset() override {
+		IM_TIME_SCOPE("FourView", TIMING_RESET);
 	}
 
 	
@@ -54,6 +55,7 @@ struct FourView : Module {
 
 	
 	json_t *toJson() override {
+		IM_TIME_SCOPE("FourView", TIMING_TOJSON);
 		json_t *rootJ = json_object();
 
 		// panelTheme
@@ -66,6 +68,7 @@ struct FourView : Module {
 	}
 
 	void fromJson(json_t *rootJ) override {
+		IM_TIME_SCOPE("FourView", TIMING_FROMJSON);
 		// panelTheme
 		json_t *panelThemeJ = json_object_get(rootJ, "panelTheme");
 		if (panelThemeJ)
@@ -88,21 +91,19 @@ struct FourView : Module {
 struct FourViewWidget : ModuleWidget {
 	FourView* module;
 
-	struct NotesDisplayWidget : TransparentWidget {
+	struct NotesDisplayWidget : CachedDisplayWidget {
 		FourView* module;
 		int baseIndex;
-		std::shared_ptr<Font> font;
-		char text[4];
 
 		NotesDisplayWidget(Vec _pos, Vec _size, FourView* _module, int _baseIndex) {
 			box.size = _size;
 			box.pos = _pos.minus(_size.div(2));
 			module = _module;
 			baseIndex = _baseIndex;
-			font = Font::load(assetPlugin(plugin, "res/fonts/Segment14.ttf"));
 		}
 		
-		void cvToStr(int index2) {
+		void cvToStr(int index2) {// text of note index2 is at displayStr[index2 * 4]
+			char *text = &displayStr[index2 * 4];
 			if (module->inputs[FourView::CV_INPUTS + baseIndex + index2].active) {
 				float cvVal = module->inputs[FourView::CV_INPUTS + baseIndex + index2].value;
 				printNote(cvVal, text, module->showSharp);
@@ -111,19 +112,18 @@ struct FourViewWidget : ModuleWidget {
 				snprintf(text, 4," - ");
 		}
 
-		void draw(NVGcontext *vg) override {
+		void printContent() override {
+			for (int i = 0; i < 2; i++)
+				cvToStr(i);
+		}
+
+		void drawContent(NVGcontext *vg) override {
 			NVGcolor textColor = prepareDisplay(vg, &box, 17);
-			nvgFontFaceId(vg, font->handle);
+			nvgFontFaceId(vg, getFontHandle(vg));
 			nvgTextLetterSpacing(vg, -1.5);
 
-			for (int i = 0; i < 2; i++) {
-				Vec textPos = Vec(7.0f + i * 46.0f, 23.4f);
-				nvgFillColor(vg, nvgTransRGBA(textColor, displayAlpha));
-				nvgText(vg, textPos.x, textPos.y, "~~~", NULL);
-				nvgFillColor(vg, textColor);
-				cvToStr(i);
-				nvgText(vg, textPos.x, textPos.y, text, NULL);
-			}
+			static const float posX[2] = {7.0f, 7.0f + 46.0f};
+			drawGhostedTexts(vg, textColor, "~~~", posX, 23.4f, displayStr, 4, 2);
 		}
 	};
 
@@ -184,6 +184,7 @@ struct FourViewWidget : ModuleWidget {
 	
 	
 	FourViewWidget(FourView *module) : ModuleWidget(module) {
+		IM_TIME_SCOPE("FourView", TIMING_WIDGET);
 		this->module = module;
 		
 		// Main panel from Inkscape
@@ -195,10 +196,10 @@ struct FourViewWidget : ModuleWidget {
         addChild(panel);
 
 		// Screws
-		addChild(createDynamicScrew<IMScrew>(Vec(15, 0), &module->panelTheme));
-		addChild(createDynamicScrew<IMScrew>(Vec(box.size.x-30, 0), &module->panelTheme));
-		addChild(createDynamicScrew<IMScrew>(Vec(15, 365), &module->panelTheme));
-		addChild(createDynamicScrew<IMScrew>(Vec(box.size.x-30, 365), &module->panelTheme));
+		panel->addChild(createDynamicScrew<IMScrew>(Vec(15, 0), &module->panelTheme));
+		panel->addChild(createDynamicScrew<IMScrew>(Vec(box.size.x-30, 0), &module->panelTheme));
+		panel->addChild(createDynamicScrew<IMScrew>(Vec(15, 365), &module->panelTheme));
+		panel->addChild(createDynamicScrew<IMScrew>(Vec(box.size.x-30, 365), &module->panelTheme));
 
 		const int centerX = box.size.x / 2;
 
@@ -223,6 +224,12 @@ Model *modelFourView = Model::create<FourView, FourViewWidget>("Impromptu Modula
 
 /*CHANGE LOG
 
+0.6.17:
+segment displays are framebuffer cached and only redrawn when their text changes
+screws are drawn in the panel's framebuffer
+note display is framebuffer cached and drawn with drawGhostedTexts()
+optional timing instrumentation (IM_TIMING)
+
 0.6.13:
 created
 
@@ -12,21 +12,19 @@
 // From Fundamental VCF.cpp
 
 inline float clip(float x) {
-	return tanhf(x);
+	return imTanh(x);
 };
 
 void LadderFilter::process(float input, float dt) {
 	ode::stepRK4(0.f, dt, state, 4, [&](float t, const float x[], float dxdt[]) {
 		float inputc = clip(input - resonance * x[3]);
-		float yc0 = clip(x[0]);
-		float yc1 = clip(x[1]);
-		float yc2 = clip(x[2]);
-		float yc3 = clip(x[3]);
-
-		dxdt[0] = omega0 * (inputc - yc0);
-		dxdt[1] = omega0 * (yc0 - yc1);
-		dxdt[2] = omega0 * (yc1 - yc2);
-		dxdt[3] = omega0 * (yc2 - yc3);
+		float yc[4];
+		imTanh4(x, yc);// clip() of the four states at once
+
+		dxdt[0] = omega0 * (inputc - yc[0]);
+		dxdt[1] = omega0 * (yc[0] - yc[1]);
+		dxdt[2] = omega0 * (yc[1] - yc[2]);
+		dxdt[3] = omega0 * (yc[2] - yc[3]);
 	});
 
 	lowpass = state[3];
@@ -52,7 +50,7 @@ void VoltageControlledOscillator::setPitch(float pitchKnob, float pitchCv) {
 	}
 	pitch += pitchCv;
 	// Note C4
-	freq = 261.626f * powf(2.0f, pitch / 12.0f);
+	freq = 261.626f * imExp2(pitch / 12.0f);
 };
 
 void VoltageControlledOscillator::setPulseWidth(float pulseWidth) {
@@ -114,7 +112,7 @@ void VoltageControlledOscillator::process(float deltaTime, float syncValue) {
 			sinBuffer[i] *= 1.08f;
 		}
 		else {
-			sinBuffer[i] = sinf(2.f*M_PI * phase);
+			sinBuffer[i] = imSin2Pi(phase);
 		}
 		if (analog) {
 			triBuffer[i] = 1.25f * interpolateLinear(triTable, phase * 2047.f);
@@ -151,6 +149,18 @@ void VoltageControlledOscillator::process(float deltaTime, float syncValue) {
 
 	
 	
+// LFO sine table (one period plus the guard point), filled once at plugin load
+
+float lfoSinTable[LFO_TABLE_SIZE + 1];
+static struct LfoSinTableInit {
+	LfoSinTableInit() {
+		for (int i = 0; i <= LFO_TABLE_SIZE; i++)
+			lfoSinTable[i] = sinf(2.0f * M_PI * ((float)i) / ((float)LFO_TABLE_SIZE));
+	}
+} lfoSinTableInit;
+
+
+
 // From Fundamental VCO.cpp
 
 float sawTable[2048] = {
@@ -15,10 +15,13 @@
 #include "dsp/ode.hpp"
 #include "dsp/filter.hpp"
 #include "ImpromptuModular.hpp"
+#include "FastMathUtil.hpp"
 
 
 extern float sawTable[2048];// see end of file
 extern float triTable[2048];// see end of file
+static const int LFO_TABLE_SIZE = 256;
+extern float lfoSinTable[LFO_TABLE_SIZE + 1];// one guard point for interpolation, see FundamentalUtil.cpp
 
 
 // From Fundamental VCF
@@ -93,25 +96,29 @@ struct VoltageControlledOscillator {
 		return sqrDecimator.process(sqrBuffer);
 	}
 	float light() {
-		return sinf(2*M_PI * phase);
+		return imSin2Pi(phase);
 	}
 };
 
 
 
-// From Fundamental LFO.cpp
+// From Fundamental LFO.cpp (with sine from an interpolated wavetable, and random shapes)
 struct LowFrequencyOscillator {
+	enum ShapeIds {SHAPE_SIN, SHAPE_TRI, SHAPE_SAW, SHAPE_SQR, SHAPE_SH, SHAPE_SMOOTH_RND, NUM_SHAPES};
+	
 	float phase = 0.0f;
 	float pw = 0.5f;
 	float freq = 1.0f;
 	bool offset = false;
 	bool invert = false;
+	float randPrev = 0.0f;// random values are bipolar [-1.0f : 1.0f], a new one is drawn each cycle
+	float randNext = 0.0f;
 	Trigger resetTrigger;
 
 	LowFrequencyOscillator() {}
 	void setPitch(float pitch) {
 		pitch = fminf(pitch, 8.0f);
-		freq = powf(2.0f, pitch);
+		freq = imExp2(pitch);
 	}
 	void setPulseWidth(float pw_) {
 		const float pwMin = 0.01f;
@@ -122,20 +129,37 @@ struct LowFrequencyOscillator {
 			phase = 0.0f;
 		}
 	}
-	void step(float dt) {
+	void step(float dt) {// dt can be a whole control block when the LFO is evaluated at control rate
 		float deltaPhase = fminf(freq * dt, 0.5f);
 		phase += deltaPhase;
-		if (phase >= 1.0f)
+		if (phase >= 1.0f) {
 			phase -= 1.0f;
+			randPrev = randNext;
+			randNext = 2.0f * randomUniform() - 1.0f;
+		}
+	}
+	float sinTable(float x) {// x must be in [0.0f : 2.0f)
+		x *= (float)LFO_TABLE_SIZE;
+		int i = (int)x;
+		i &= (LFO_TABLE_SIZE - 1);// wraps [1.0f : 2.0f) and needs LFO_TABLE_SIZE to be a power of two
+		float f = x - floorf(x);
+		return lfoSinTable[i] + f * (lfoSinTable[i + 1] - lfoSinTable[i]);
 	}
 	float sin() {
 		if (offset)
-			return 1.0f - cosf(2*M_PI * phase) * (invert ? -1.0f : 1.0f);
+			return 1.0f - sinTable(phase + 0.25f) * (invert ? -1.0f : 1.0f);// cos
 		else
-			return sinf(2*M_PI * phase) * (invert ? -1.0f : 1.0f);
+			return sinTable(phase) * (invert ? -1.0f : 1.0f);
+	}
+	float wrapHalf(float x) {// wrap x from [-1.0f : 1.0f) into [-0.5f : 0.5f), without rounding
+		if (x >= 0.5f)
+			return x - 1.0f;
+		if (x < -0.5f)
+			return x + 1.0f;
+		return x;
 	}
 	float tri(float x) {
-		return 4.0f * fabsf(x - roundf(x));
+		return 4.0f * fabsf(wrapHalf(x));
 	}
 	float tri() {
 		if (offset)
@@ -144,7 +168,7 @@ struct LowFrequencyOscillator {
 			return -1.0f + tri(invert ? phase - 0.25f : phase - 0.75f);
 	}
 	float saw(float x) {
-		return 2.0f * (x - roundf(x));
+		return 2.0f * wrapHalf(x);
 	}
 	float saw() {
 		if (offset)
@@ -152,12 +176,134 @@ struct LowFrequencyOscillator {
 		else
 			return saw(phase) * (invert ? -1.0f : 1.0f);
 	}
+	bool crossedSawJump(float phaseBefore) {// true when the last step() went through the jump of saw(), phaseBefore is the phase before that step()
+		float jump = offset ? 1.0f : 0.5f;// the wrap when offset, else the middle of the phase (see wrapHalf())
+		float phaseAfter = phase < phaseBefore ? phase + 1.0f : phase;// unwrapped, step() moves by at most 0.5f
+		return phaseBefore < jump && phaseAfter >= jump;
+	}
 	float sqr() {
 		float sqr = (phase < pw) ^ invert ? 1.0f : -1.0f;
 		return offset ? sqr + 1.0f : sqr;
 	}
+	float sh() {
+		float sh = invert ? -randNext : randNext;
+		return offset ? sh + 1.0f : sh;
+	}
+	float smoothRnd() {
+		float t = phase * phase * (3.0f - 2.0f * phase);// smoothstep from the previous random value to the current one
+		float rnd = randPrev + t * (randNext - randPrev);
+		rnd = invert ? -rnd : rnd;
+		return offset ? rnd + 1.0f : rnd;
+	}
+	float shape(int shapeId) {
+		switch (shapeId) {
+			case SHAPE_SIN : return sin();
+			case SHAPE_TRI : return tri();
+			case SHAPE_SAW : return saw();
+			case SHAPE_SQR : return sqr();
+			case SHAPE_SH : return sh();
+			default : return smoothRnd();
+		}
+	}
 	float light() {
-		return sinf(2*M_PI * phase);
+		return sinTable(phase);
+	}
+};
+
+
+
+// From Fundamental ADSR.cpp (stage coefficients are computed at control rate in setParams())
+struct ADSREnvelope {
+	bool decaying = false;
+	float env = 0.0f;
+	float sustain = 0.0f;
+	float attackLambda = -1.0f;// negative means stage is instantaneous
+	float decayLambda = -1.0f;
+	float releaseLambda = -1.0f;
+	
+	static float calcLambda(float knob) {// knob must be in [0.0f : 1.0f]
+		const float base = 20000.0f;
+		const float maxTime = 10.0f;
+		return knob < 1e-4f ? -1.0f : powf(base, 1.0f - knob) / maxTime;
+	}
+	void setParams(float attack, float decay, float _sustain, float release) {
+		attackLambda = calcLambda(attack);
+		decayLambda = calcLambda(decay);
+		sustain = _sustain;
+		releaseLambda = calcLambda(release);
+	}
+	float process(bool gated, float dt) {
+		if (gated) {
+			if (decaying) {
+				// Decay
+				if (decayLambda < 0.0f)
+					env = sustain;
+				else
+					env += decayLambda * (sustain - env) * dt;
+			}
+			else {
+				// Attack
+				// Skip ahead if attack is all the way down (infinitely fast)
+				if (attackLambda < 0.0f)
+					env = 1.0f;
+				else
+					env += attackLambda * (1.01f - env) * dt;
+				if (env >= 1.0f) {
+					env = 1.0f;
+					decaying = true;
+				}
+			}
+		}
+		else {
+			// Release
+			if (releaseLambda < 0.0f)
+				env = 0.0f;
+			else
+				env += releaseLambda * (0.0f - env) * dt;
+			decaying = false;
+		}
+		return env;
+	}
+};
+
+
+// From Fundamental VCF.cpp (drive, resonance and cutoff mappings around the LadderFilter)
+struct VoltageControlledFilter {
+	LadderFilter filter;
+	float gain = 1.0f;
+	
+	void reset() {
+		filter.reset();
+	}
+	static float calcGain(float drive) {// drive must be in [0.0f : 1.0f]
+		return powf(1.f + drive, 5);
+	}
+	static float calcResonance(float res) {// res must be in [0.0f : 1.0f]
+		return powf(res, 2) * 10.f;
+	}
+	static float calcCutoff(float pitch) {
+		return clamp(261.626f * imExp2(pitch), 1.f, 8000.f);
+	}
+	void setDrive(float drive) {
+		gain = calcGain(drive);
+	}
+	void setResonance(float res) {
+		filter.resonance = calcResonance(res);
+	}
+	void setPitch(float pitch) {
+		filter.setCutoff(calcCutoff(pitch));
+	}
+	void process(float input, float dt) {
+		input *= gain;
+		// Add -60dB noise to bootstrap self-oscillation
+		input += 1e-6f * (2.f * randomUniform() - 1.f);
+		filter.process(input, dt);
+	}
+	float lowpass() {
+		return filter.lowpass;
+	}
+	float highpass() {
+		return filter.highpass;
 	}
 };
 
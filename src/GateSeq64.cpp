@@ -65,9 +65,13 @@ struct GateSeq64 : Module {
 	
 	// Constants
 	enum DisplayStateIds {DISP_GATE, DISP_LENGTH, DISP_MODES};
-	static const int MAX_SEQS = 32;
-	//										1/4		DUO			D2			TR1		TR2		TR3 		TR23	   TRI
-	const uint32_t advGateHitMaskGS[8] = {0x00003F, 0x03F03F, 0x03F000, 0x00000F, 0x000F00, 0x0F0000, 0x0F0F00, 0x0F0F0F};
+	enum StepsEditIds {ROW_FILL, ROW_CLEAR, ROW_INVERT, ROW_ROTATE_EARLIER, ROW_ROTATE_LATER, STEP_PROB_RESET, SEQ_RANDOMIZE};
+	static const int MAX_SEQS = 128;
+	static const int MAX_PHRASES = 256;
+	static const int NUM_CV_SEQS = 64;// a 0-10V SEQ# CV spans the first 64 sequences, as it did before MAX_SEQS was increased
+	// gate modes 1/4, DUO, D2, TR1, TR2, TR3, TR23 and TRI as built-in patterns of AdvGateUtil.hpp
+	const int advGatePatternGS[8] = {AdvGateTable::GATE_25, AdvGateTable::GATE_DUO, AdvGateTable::GATE_D2, AdvGateTable::GATE_TR1, 
+									 AdvGateTable::GATE_TR2, AdvGateTable::GATE_TR3, AdvGateTable::GATE_T23, AdvGateTable::GATE_TRI};
 	static const int blinkNumInit = 15;// init number of blink cycles for cursor
 	static constexpr float CONFIG_PARAM_INIT_VALUE = 0.0f;// so that module constructor is coherent with widget initialization, since module created before widget
 
@@ -81,9 +85,9 @@ struct GateSeq64 : Module {
 	SeqAttributesGS sequences[MAX_SEQS];
 	int runModeSong;
 	int sequence;
-	int phrase[64];// This is the song (series of phases; a phrase is a patten number)
-	int phrases;// 1 to 64
-	StepAttributesGS attributes[MAX_SEQS][64];
+	int phrase[MAX_PHRASES];// This is the song (series of phases; a phrase is a patten number)
+	int phrases;// 1 to MAX_PHRASES
+	SeqStoreGS<MAX_SEQS> attributes;// only sequences with non default steps have storage
 	bool resetOnRun;
 
 	// No need to save
@@ -97,13 +101,15 @@ struct GateSeq64 : Module {
 	StepAttributesGS attribCPbuffer[64];
 	SeqAttributesGS seqAttribCPbuffer;
 	bool seqCopied;
-	int phraseCPbuffer[64];
+	int phraseCPbuffer[MAX_PHRASES];
 	int countCP;// number of steps to paste (in case CPMODE_PARAM changes between copy and paste)
 	int startCP;
 	long infoCopyPaste;// 0 when no info, positive downward step counter timer when copy, negative upward when paste
 	long clockIgnoreOnReset;
 	long displayProbInfo;// downward step counter for displayProb feedback
 	int gateCode[4];
+	uint32_t gateHighRows;// bit i set when gateCode[i] is 1, for the output stage
+	uint32_t clockHighRows;// bit i set when gateCode[i] is 2
 	long revertDisplay;
 	long editingPpqn;// 0 when no info, positive downward step counter timer when editing ppqn
 	int ppqnCount;
@@ -111,10 +117,31 @@ struct GateSeq64 : Module {
 	int blinkNum;// number of blink cycles to do, downward counter
 	int stepConfig;
 	long editingPhraseSongRunning;// downward step counter
+	int pendingStepsEdit;// edit requested by the menu, right click or randomize, -1 when none; applied by step() so that the steps are only changed by the audio thread
 
 
 	int stepConfigSync = 0;// 0 means no sync requested, 1 means soft sync (no reset lengths), 2 means hard (reset lengths)
 	unsigned int lightRefreshCounter = 0;
+	LightState lightState;
+	struct DisplaySnapshot {// what the display shows, published in the light refresh so that the widget doesn't read the live sequencer
+		bool editingSequence;
+		long infoCopyPaste;
+		bool seqCopied;
+		float cpMode;
+		bool displayProbInfo;
+		int gatePVal;// of the step being edited
+		bool editingPpqn;
+		int pulsesPerStep;
+		int displayState;
+		int runMode;// of the sequence being edited, or of the song
+		int length;// of the sequence being edited, or number of phrases in the song
+		int sequence;
+		bool editingPhraseSongRunning;
+		bool running;
+		int phraseEdit;// sequence of the phrase being edited
+		int phraseRun;// sequence of the phrase being played
+	};
+	SeqLock<DisplaySnapshot> displaySnapshot;
 	float resetLight = 0.0f;
 	int sequenceKnob = 0;
 	Trigger modesTrigger;
@@ -143,19 +170,29 @@ struct GateSeq64 : Module {
 		return 4;
 	}
 	
-	inline int getAdvGateGS(int ppqnCount, int pulsesPerStep, int gateMode) { 
-		uint32_t shiftAmt = ppqnCount * (24 / pulsesPerStep);
-		return (int)((advGateHitMaskGS[gateMode] >> shiftAmt) & (uint32_t)0x1);
-	}	
-	inline int calcGateCode(StepAttributesGS attribute, int ppqnCount, int pulsesPerStep) {
-		// -1 = gate off for whole step, 0 = gate off for current ppqn, 1 = gate on, 2 = clock high
-		if (ppqnCount == 0 && attribute.getGateP() && !(randomUniform() < ((float)(attribute.getGatePVal())/100.0f)))// randomUniform is [0.0, 1.0), see include/util/common.hpp
-			return -1;
-		if (!attribute.getGate())
-			return 0;
-		if (pulsesPerStep == 1)
-			return 2;// clock high
-		return getAdvGateGS(ppqnCount, pulsesPerStep, attribute.getGateMode());
+	inline void calcGateCodes(int seq) {// all rows at once, uses ppqnCount and stepIndexRun[]
+		// gateCode: -1 = gate off for whole step, 0 = gate off for current ppqn, 1 = gate on, 2 = clock high
+		uint32_t rowGates = attributes.getSteps(seq).gatherRowGates(stepIndexRun, stepConfig);
+		uint32_t rowGatePs = (ppqnCount == 0 ? (rowGates & attributes.getSteps(seq).gatherRowGatePs(stepIndexRun, stepConfig)) : 0);
+		gateHighRows = 0;
+		clockHighRows = 0;
+		for (int i = 0; i < 4; i += stepConfig) {
+			if (gateCode[i] == -1 && ppqnCount != 0)
+				continue;// step was killed by its probability
+			int step = (i << 4) + stepIndexRun[i];
+			if ( ((rowGatePs >> i) & 0x1) != 0 && !(randomUniform() < ((float)(attributes.getSteps(seq).getGatePVal(step))/100.0f)) )// randomUniform is [0.0, 1.0), see include/util/common.hpp
+				gateCode[i] = -1;
+			else if (((rowGates >> i) & 0x1) == 0)
+				gateCode[i] = 0;
+			else if (pulsesPerStep == 1)
+				gateCode[i] = 2;// clock high
+			else 
+				gateCode[i] = advGates.getCode(advGatePatternGS[attributes.getSteps(seq).getGateMode(step)], ppqnCount, pulsesPerStep);
+			if (gateCode[i] == 1)
+				gateHighRows |= (0x1 << i);
+			else if (gateCode[i] == 2)
+				clockHighRows |= (0x1 << i);
+		}
 	}		
 	inline void fillStepIndexRunVector(int runMode, int len) {
 		if (runMode != MODE_RN2) {
@@ -169,18 +206,27 @@ struct GateSeq64 : Module {
 			stepIndexRun[3] = randomu32() % len;
 		}
 	}
+	inline int getSongPageStart() {// the 64 step buttons show the song one page of 64 phrases at a time, this is the first phrase of the page shown
+		int phraseIndex = (displayState == DISP_LENGTH ? phrases - 1 : ((running && editingPhraseSongRunning == 0l) ? phraseIndexRun : phraseIndexEdit));
+		return phraseIndex & ~0x3F;
+	}
 	inline bool ppsRequirementMet(int gateButtonIndex) {
 		return !( (pulsesPerStep < 2) || (pulsesPerStep == 4 && gateButtonIndex > 2) || (pulsesPerStep == 6 && gateButtonIndex <= 2) ); 
 	}
 		
 	GateSeq64() : Module(NUM_PARAMS, NUM_INPUTS, NUM_OUTPUTS, NUM_LIGHTS) {
+		lightState.init(&lights);
 		for (int i = 0; i < MAX_SEQS; i++)
 			seqAttribBuffer[i].init(16, MODE_FWD);
+		for (int i = 0; i < 4; i++)
+			gateCode[i] = 0;
 		onReset();
+		publishDisplaySnapshot();
 	}
 
 	
 	void onReset() override {
+		IM_TIME_SCOPE("GateSeq64", TIMING_RESET);
 		stepConfig = getStepConfig(CONFIG_PARAM_INIT_VALUE);
 		autoseq = false;
 		seqCVmethod = 0;
@@ -188,20 +234,19 @@ struct GateSeq64 : Module {
 		running = true;
 		runModeSong = MODE_FWD;
 		stepIndexEdit = 0;
+		pendingStepsEdit = -1;
 		phraseIndexEdit = 0;
 		sequence = 0;
 		phrases = 4;
-		for (int i = 0; i < MAX_SEQS; i++) {
-			for (int s = 0; s < 64; s++) {
-				attributes[i][s].init();
-			}
+		attributes.init();
+		for (int i = 0; i < MAX_SEQS; i++)
 			sequences[i].init(16 * stepConfig, MODE_FWD);
-		}
-		for (int i = 0; i < 64; i++) {
+		for (int i = 0; i < MAX_PHRASES; i++) {
 			phrase[i] = 0;
-			attribCPbuffer[i].init();
 			phraseCPbuffer[i] = 0;
 		}
+		for (int i = 0; i < 64; i++)
+			attribCPbuffer[i].init();
 		initRun();
 		seqAttribCPbuffer.init(16, MODE_FWD);
 		seqCopied = true;
@@ -226,22 +271,16 @@ struct GateSeq64 : Module {
 		// stepIndexEdit = 0;
 		// phraseIndexEdit = 0;
 		// sequence = randomu32() % MAX_SEQS;
-		// phrases = 1 + (randomu32() % 64);
+		// phrases = 1 + (randomu32() % MAX_PHRASES);
 		// for (int i = 0; i < MAX_SEQS; i++) {
-			// for (int s = 0; s < 64; s++) {
-				// attributes[i][s].randomize();
-			// }
+			// attributes.editSteps(i).randomize();
 			// sequences[i].randomize(16 * stepConfig, NUM_MODES);
 		// }
-		// for (int i = 0; i < 64; i++)
+		// for (int i = 0; i < MAX_PHRASES; i++)
 			// phrase[i] = randomu32() % MAX_SEQS;
 		// initRun();
-		if (isEditingSequence()) {
-			for (int s = 0; s < 64; s++) {
-				attributes[sequence][s].randomize();
-			}
-			sequences[sequence].randomize(16 * stepConfig, NUM_MODES);// ok to use stepConfig since CONFIG_PARAM is not randomizable		
-		}
+		if (isEditingSequence())
+			pendingStepsEdit = SEQ_RANDOMIZE;// done by step()
 	}
 
 
@@ -255,12 +294,13 @@ struct GateSeq64 : Module {
 		stepIndexRunHistory = 0;
 
 		ppqnCount = 0;
-		for (int i = 0; i < 4; i += stepConfig)
-			gateCode[i] = calcGateCode(attributes[seq][(i * 16) + stepIndexRun[i]], 0, pulsesPerStep);
+		calcGateCodes(seq);
 	}
 	
 	
 	json_t *toJson() override {
+		IM_TIME_SCOPE("GateSeq64", TIMING_TOJSON);
+		IM_LOG_LIGHTS("GateSeq64", lightState);
 		json_t *rootJ = json_object();
 
 		// panelTheme
@@ -289,20 +329,25 @@ struct GateSeq64 : Module {
 
 		// phrase 
 		json_t *phraseJ = json_array();
-		for (int i = 0; i < 64; i++)
+		for (int i = 0; i < MAX_PHRASES; i++)
 			json_array_insert_new(phraseJ, i, json_integer(phrase[i]));
 		json_object_set_new(rootJ, "phrase2", phraseJ);// "2" appended so no break patches
 
 		// phrases
 		json_object_set_new(rootJ, "phrases", json_integer(phrases));
 
-		// attributes
+		// attributes (only sequences with non default steps, each as an array with the sequence number followed by its 64 step attributes)
 		json_t *attributesJ = json_array();
-		for (int i = 0; i < MAX_SEQS; i++)
-			for (int s = 0; s < 64; s++) {
-				json_array_insert_new(attributesJ, s + (i * 64), json_integer(attributes[i][s].getAttribute()));
-			}
-		json_object_set_new(rootJ, "attributes2", attributesJ);// "2" appended so no break patches
+		for (int i = 0; i < MAX_SEQS; i++) {
+			if (!attributes.isAllocated(i) || attributes.getSteps(i).isInit())
+				continue;
+			json_t *seqStepsJ = json_array();
+			json_array_append_new(seqStepsJ, json_integer(i));
+			for (int s = 0; s < 64; s++)
+				json_array_append_new(seqStepsJ, json_integer(attributes.getSteps(i).getAttribute(s).getAttribute()));
+			json_array_append_new(attributesJ, seqStepsJ);
+		}
+		json_object_set_new(rootJ, "attributes3", attributesJ);// "3" appended so no break patches
 		
 		// resetOnRun
 		json_object_set_new(rootJ, "resetOnRun", json_boolean(resetOnRun));
@@ -324,6 +369,7 @@ struct GateSeq64 : Module {
 
 	
 	void fromJson(json_t *rootJ) override {
+		IM_TIME_SCOPE("GateSeq64", TIMING_FROMJSON);
 		// panelTheme
 		json_t *panelThemeJ = json_object_get(rootJ, "panelTheme");
 		if (panelThemeJ)
@@ -363,6 +409,8 @@ struct GateSeq64 : Module {
 				json_t *sequencesArrayJ = json_array_get(sequencesJ, i);
 				if (sequencesArrayJ)
 					seqAttribBuffer[i].setSeqAttrib(json_integer_value(sequencesArrayJ));
+				else// patches from before MAX_SEQS was increased
+					seqAttribBuffer[i].init(16, MODE_FWD);
 			}			
 		}
 		else {// legacy
@@ -433,11 +481,13 @@ struct GateSeq64 : Module {
 		// phrase
 		json_t *phraseJ = json_object_get(rootJ, "phrase2");// "2" appended so no break patches
 		if (phraseJ) {
-			for (int i = 0; i < 64; i++)
+			for (int i = 0; i < MAX_PHRASES; i++)
 			{
 				json_t *phraseArrayJ = json_array_get(phraseJ, i);
 				if (phraseArrayJ)
 					phrase[i] = json_integer_value(phraseArrayJ);
+				else// patches from before MAX_PHRASES was increased
+					phrase[i] = 0;
 			}
 		}
 		else {// legacy
@@ -449,7 +499,7 @@ struct GateSeq64 : Module {
 					if (phraseArrayJ)
 						phrase[i] = json_integer_value(phraseArrayJ);
 				}
-				for (int i = 16; i < 64; i++)
+				for (int i = 16; i < MAX_PHRASES; i++)
 					phrase[i] = 0;
 			}
 		}
@@ -460,29 +510,41 @@ struct GateSeq64 : Module {
 			phrases = json_integer_value(phrasesJ);
 	
 		// attributes
-		json_t *attributesJ = json_object_get(rootJ, "attributes2");
+		json_t *attributesJ = json_object_get(rootJ, "attributes3");
 		if (attributesJ) {
-			for (int i = 0; i < MAX_SEQS; i++)
+			attributes.init();
+			for (size_t j = 0; j < json_array_size(attributesJ); j++) {
+				json_t *seqStepsJ = json_array_get(attributesJ, j);
+				json_t *seqNumJ = json_array_get(seqStepsJ, 0);
+				if (!seqNumJ)
+					continue;
+				int i = json_integer_value(seqNumJ);
+				if (i < 0 || i >= MAX_SEQS)
+					continue;
 				for (int s = 0; s < 64; s++) {
-					json_t *attributesArrayJ = json_array_get(attributesJ, s + (i * 64));
+					json_t *attributesArrayJ = json_array_get(seqStepsJ, s + 1);
 					if (attributesArrayJ)
-						attributes[i][s].setAttribute((unsigned short)json_integer_value(attributesArrayJ));
+						attributes.editSteps(i).setAttribute(s, (unsigned short)json_integer_value(attributesArrayJ));
 				}
+			}
 		}
-		else {
-			attributesJ = json_object_get(rootJ, "attributes");
+		else {// legacy
+			attributesJ = json_object_get(rootJ, "attributes2");
+			int numSeqs = 32;// number of sequences in patches before "attributes3"
+			if (!attributesJ) {
+				attributesJ = json_object_get(rootJ, "attributes");
+				numSeqs = 16;
+			}
 			if (attributesJ) {
-				for (int i = 0; i < 16; i++) {
+				attributes.init();
+				for (int i = 0; i < numSeqs; i++) {
 					for (int s = 0; s < 64; s++) {
 						json_t *attributesArrayJ = json_array_get(attributesJ, s + (i * 64));
 						if (attributesArrayJ)
-							attributes[i][s].setAttribute((unsigned short)json_integer_value(attributesArrayJ));
+							attributes.editSteps(i).setAttribute(s, (unsigned short)json_integer_value(attributesArrayJ));
 					}
 				}
-				for (int i = 16; i < MAX_SEQS; i++) {
-					for (int s = 0; s < 64; s++)
-						attributes[i][s].init();
-				}
+				attributes.compact();// legacy patches have all their sequences, most are default
 			}
 		}
 		
@@ -539,6 +601,15 @@ struct GateSeq64 : Module {
 			// Edit mode blink when change
 			if (editingSequenceTrigger.process(editingSequence))
 				blinkNum = blinkNumInit;
+			
+			// Steps edit from the menu, right click or randomize
+			if (pendingStepsEdit != -1) {
+				if (editingSequence) {
+					stepsEdit(pendingStepsEdit);
+					blinkNum = blinkNumInit;
+				}
+				pendingStepsEdit = -1;
+			}
 
 			// Config switch
 			if (stepConfigSync != 0) {
@@ -558,8 +629,8 @@ struct GateSeq64 : Module {
 			// Seq CV input
 			if (inputs[SEQCV_INPUT].active) {
 				if (seqCVmethod == 0) {// 0-10 V
-					int newSeq = (int)( inputs[SEQCV_INPUT].value * (((float)MAX_SEQS) - 1.0f) / 10.0f + 0.5f );
-					sequence = clamp(newSeq, 0, MAX_SEQS - 1);
+					int newSeq = (int)( inputs[SEQCV_INPUT].value * (((float)NUM_CV_SEQS) - 1.0f) / 10.0f + 0.5f );
+					sequence = clamp(newSeq, 0, NUM_CV_SEQS - 1);
 				}
 				else if (seqCVmethod == 1) {// C4-G6
 					int newSeq = (int)( (inputs[SEQCV_INPUT].value) * 12.0f + 0.5f );
@@ -574,16 +645,17 @@ struct GateSeq64 : Module {
 			// Copy button
 			if (copyTrigger.process(params[COPY_PARAM].value)) {
 				startCP = editingSequence ? stepIndexEdit : phraseIndexEdit;
-				countCP = 64;
+				int maxCP = editingSequence ? 64 : MAX_PHRASES;
+				countCP = maxCP;
 				if (params[CPMODE_PARAM].value > 1.5f)// ALL
 					startCP = 0;			
 				else if (params[CPMODE_PARAM].value < 0.5f)// 4
-					countCP = min(4, 64 - startCP);
+					countCP = min(4, maxCP - startCP);
 				else// 8
-					countCP = min(8, 64 - startCP);
+					countCP = min(8, maxCP - startCP);
 				if (editingSequence) {	
 					for (int i = 0, s = startCP; i < countCP; i++, s++)
-						attribCPbuffer[i] = attributes[sequence][s];
+						attribCPbuffer[i] = attributes.getSteps(sequence).getAttribute(s);
 					seqAttribCPbuffer.setSeqAttrib(sequences[sequence].getSeqAttrib());
 					seqCopied = true;
 				}
@@ -602,14 +674,14 @@ struct GateSeq64 : Module {
 				startCP = 0;
 				if (countCP <= 8) {
 					startCP = editingSequence ? stepIndexEdit : phraseIndexEdit;
-					countCP = min(countCP, 64 - startCP);
+					countCP = min(countCP, (editingSequence ? 64 : MAX_PHRASES) - startCP);
 				}
 				// else nothing to do for ALL
 					
 				if (editingSequence) {
 					if (seqCopied) {// non-crossed paste (seq vs song)
 						for (int i = 0, s = startCP; i < countCP; i++, s++)
-							attributes[sequence][s] = attribCPbuffer[i];
+							attributes.editSteps(sequence).setAttribute(s, attribCPbuffer[i]);
 						if (params[CPMODE_PARAM].value > 1.5f) {// all
 							sequences[sequence].setSeqAttrib(seqAttribCPbuffer.getSeqAttrib());
 							if (sequences[sequence].getLength() > 16 * stepConfig)
@@ -618,19 +690,14 @@ struct GateSeq64 : Module {
 					}
 					else {// crossed paste to seq (seq vs song)
 						if (params[CPMODE_PARAM].value > 1.5f) { // ALL (init steps)
-							for (int s = 0; s < 64; s++)
-								attributes[sequence][s].init();
+							attributes.init(sequence);
 						}
 						else if (params[CPMODE_PARAM].value < 0.5f) {// 4 (randomize gates)
-							for (int s = 0; s < 64; s++)
-								if ( (randomu32() & 0x1) != 0)
-									attributes[sequence][s].toggleGate();
+							attributes.editSteps(sequence).toggleGates(randomu64());
 						}
 						else {// 8 (randomize probs)
-							for (int s = 0; s < 64; s++) {
-								attributes[sequence][s].setGateP((randomu32() & 0x1) != 0);
-								attributes[sequence][s].setGatePVal(randomu32() % 101);
-							}
+							attributes.editSteps(sequence).setGatePs(randomu64());
+							attributes.editSteps(sequence).randomizeGatePVals();
 						}
 						startCP = 0;
 						countCP = 64;
@@ -640,23 +707,23 @@ struct GateSeq64 : Module {
 				else {// song
 					if (!seqCopied) {// non-crossed paste (seq vs song)
 						for (int i = 0, p = startCP; i < countCP; i++, p++)
-							phrase[p] = phraseCPbuffer[i] & 0xF;
+							phrase[p] = phraseCPbuffer[i];
 					}
 					else {// crossed paste to song (seq vs song)
 						if (params[CPMODE_PARAM].value > 1.5f) { // ALL (init phrases)
-							for (int p = 0; p < 64; p++)
+							for (int p = 0; p < MAX_PHRASES; p++)
 								phrase[p] = 0;
 						}
-						else if (params[CPMODE_PARAM].value < 0.5f) {// 4 (phrases increase from 1 to 64)
-							for (int p = 0; p < 64; p++)
-								phrase[p] = p;						
+						else if (params[CPMODE_PARAM].value < 0.5f) {// 4 (phrases increase from 1 to MAX_SEQS)
+							for (int p = 0; p < MAX_PHRASES; p++)
+								phrase[p] = p % MAX_SEQS;						
 						}
 						else {// 8 (randomize phrases)
-							for (int p = 0; p < 64; p++)
-								phrase[p] = randomu32() % 64;
+							for (int p = 0; p < MAX_PHRASES; p++)
+								phrase[p] = randomu32() % MAX_SEQS;
 						}
 						startCP = 0;
-						countCP = 64;
+						countCP = MAX_PHRASES;
 						infoCopyPaste *= 2l;
 					}
 				}
@@ -673,17 +740,17 @@ struct GateSeq64 : Module {
 					blinkNum = blinkNumInit;
 					if (writeTrig) {// higher priority than write0 and write1
 						if (inputs[PROB_INPUT].active) {
-							attributes[sequence][stepIndexEdit].setGatePVal(clamp( (int)round(inputs[PROB_INPUT].value * 10.0f), 0, 100) );
-							attributes[sequence][stepIndexEdit].setGateP(true);
+							attributes.editSteps(sequence).setGatePVal(stepIndexEdit, clamp( (int)round(inputs[PROB_INPUT].value * 10.0f), 0, 100) );
+							attributes.editSteps(sequence).setGateP(stepIndexEdit, true);
 						}
 						else{
-							attributes[sequence][stepIndexEdit].setGateP(false);
+							attributes.editSteps(sequence).setGateP(stepIndexEdit, false);
 						}
 						if (inputs[GATE_INPUT].active)
-							attributes[sequence][stepIndexEdit].setGate(inputs[GATE_INPUT].value >= 1.0f);
+							attributes.editSteps(sequence).setGate(stepIndexEdit, inputs[GATE_INPUT].value >= 1.0f);
 					}
 					else {// write1 or write0			
-						attributes[sequence][stepIndexEdit].setGate(write1Trig);
+						attributes.editSteps(sequence).setGate(stepIndexEdit, write1Trig);
 					}
 					// Autostep (after grab all active inputs)
 					stepIndexEdit = moveIndex(stepIndexEdit, stepIndexEdit + 1, 64);
@@ -716,23 +783,23 @@ struct GateSeq64 : Module {
 					}
 					else {
 						if (params[STEP_PARAMS + stepPressed].value > 1.5f) {// right button click
-							attributes[sequence][stepPressed].setGate(false);
+							attributes.editSteps(sequence).setGate(stepPressed, false);
 							displayProbInfo = 0l;
-						}
-						else if (!attributes[sequence][stepPressed].getGate()) {// clicked inactive, so turn gate on
-							attributes[sequence][stepPressed].setGate(true);
-							if (attributes[sequence][stepPressed].getGateP())
+						}
+						else if (!attributes.getSteps(sequence).getGate(stepPressed)) {// clicked inactive, so turn gate on
+							attributes.editSteps(sequence).setGate(stepPressed, true);
+							if (attributes.getSteps(sequence).getGateP(stepPressed))
 								displayProbInfo = (long) (displayProbInfoTime * sampleRate / displayRefreshStepSkips);
 							else
 								displayProbInfo = 0l;
 						}
 						else {// clicked active
 							if (stepIndexEdit == stepPressed && blinkNum != 0) {// only if coming from current step, turn off
-								attributes[sequence][stepPressed].setGate(false);
+								attributes.editSteps(sequence).setGate(stepPressed, false);
 								displayProbInfo = 0l;
 							}
 							else {
-								if (attributes[sequence][stepPressed].getGateP())
+								if (attributes.getSteps(sequence).getGateP(stepPressed))
 									displayProbInfo = (long) (displayProbInfoTime * sampleRate / displayRefreshStepSkips);
 								else
 									displayProbInfo = 0l;
@@ -743,20 +810,23 @@ struct GateSeq64 : Module {
 					blinkNum = blinkNumInit;
 				}
 				else {// editing song
+					int phrasePressed = getSongPageStart() + stepPressed;
+					if (params[STEP_PARAMS + stepPressed].value > 1.5f)// right button click, same button in next page
+						phrasePressed = (phrasePressed + 64) % MAX_PHRASES;
 					if (displayState == DISP_LENGTH) {
-						phrases = stepPressed + 1;
-						if (phrases > 64) phrases = 64;
+						phrases = phrasePressed + 1;
+						if (phrases > MAX_PHRASES) phrases = MAX_PHRASES;
 						if (phrases < 1 ) phrases = 1;
 						revertDisplay = (long) (revertDisplayTime * sampleRate / displayRefreshStepSkips);
 					}
 					else if (displayState == DISP_MODES) {
 					}
 					else {
-						phraseIndexEdit = stepPressed;
+						phraseIndexEdit = phrasePressed;
 						if (running)
 							editingPhraseSongRunning = (long) (editingPhraseSongRunningTime * sampleRate / displayRefreshStepSkips);
 						else
-							phraseIndexRun = stepPressed;
+							phraseIndexRun = phrasePressed;
 					}
 				}
 			}
@@ -778,14 +848,14 @@ struct GateSeq64 : Module {
 			// Prob button
 			if (probTrigger.process(params[PROB_PARAM].value)) {
 				blinkNum = blinkNumInit;
-				if (editingSequence && attributes[sequence][stepIndexEdit].getGate()) {
-					if (attributes[sequence][stepIndexEdit].getGateP()) {
+				if (editingSequence && attributes.getSteps(sequence).getGate(stepIndexEdit)) {
+					if (attributes.getSteps(sequence).getGateP(stepIndexEdit)) {
 						displayProbInfo = 0l;
-						attributes[sequence][stepIndexEdit].setGateP(false);
+						attributes.editSteps(sequence).setGateP(stepIndexEdit, false);
 					}
 					else {
 						displayProbInfo = (long) (displayProbInfoTime * sampleRate / displayRefreshStepSkips);
-						attributes[sequence][stepIndexEdit].setGateP(true);
+						attributes.editSteps(sequence).setGateP(stepIndexEdit, true);
 					}
 				}
 			}
@@ -794,10 +864,10 @@ struct GateSeq64 : Module {
 			for (int i = 0; i < 8; i++) {
 				if (gModeTriggers[i].process(params[GMODE_PARAMS + i].value)) {
 					blinkNum = blinkNumInit;
-					if (editingSequence && attributes[sequence][stepIndexEdit].getGate()) {
+					if (editingSequence && attributes.getSteps(sequence).getGate(stepIndexEdit)) {
 						if (ppsRequirementMet(i)) {
 							editingPpqn = 0l;
-							attributes[sequence][stepIndexEdit].setGateMode(i);
+							attributes.editSteps(sequence).setGateMode(stepIndexEdit, i);
 						}
 						else {
 							editingPpqn = (long) (editingPpqnTime * sampleRate / displayRefreshStepSkips);
@@ -817,13 +887,13 @@ struct GateSeq64 : Module {
 				if (abs(deltaKnob) <= 3) {// avoid discontinuous step (initialize for example)
 					if (displayProbInfo != 0l && editingSequence) {
 						blinkNum = blinkNumInit;
-						int pval = attributes[sequence][stepIndexEdit].getGatePVal();
+						int pval = attributes.getSteps(sequence).getGatePVal(stepIndexEdit);
 						pval += deltaKnob * 2;
 						if (pval > 100)
 							pval = 100;
 						if (pval < 0)
 							pval = 0;
-						attributes[sequence][stepIndexEdit].setGatePVal(pval);
+						attributes.editSteps(sequence).setGatePVal(stepIndexEdit, pval);
 						displayProbInfo = (long) (displayProbInfoTime * sampleRate / displayRefreshStepSkips);
 					}
 					else if (editingPpqn != 0) {
@@ -843,7 +913,7 @@ struct GateSeq64 : Module {
 							sequences[sequence].setLength(clamp(sequences[sequence].getLength() + deltaKnob, 1, (16 * stepConfig)));
 						}
 						else {
-							phrases = clamp(phrases + deltaKnob, 1, 64);
+							phrases = clamp(phrases + deltaKnob, 1, MAX_PHRASES);
 						}
 					}
 					else {
@@ -900,10 +970,7 @@ struct GateSeq64 : Module {
 					if (!editingSequence)
 						newSeq = phrase[phraseIndexRun];
 				}
-				for (int i = 0; i < 4; i += stepConfig) { 
-					if (gateCode[i] != -1 || ppqnCount == 0)
-						gateCode[i] = calcGateCode(attributes[newSeq][(i * 16) + stepIndexRun[i]], ppqnCount, pulsesPerStep);
-				}
+				calcGateCodes(newSeq);
 			}
 		}	
 		
@@ -924,8 +991,9 @@ struct GateSeq64 : Module {
 		// Gate outputs
 		if (running) {
 			bool retriggingOnReset = (clockIgnoreOnReset != 0l && retrigGatesOnReset);
+			uint32_t highRows = retriggingOnReset ? 0 : (gateHighRows | (clockTrigger.isHigh() ? clockHighRows : 0));
 			for (int i = 0; i < 4; i++)
-				outputs[GATE_OUTPUTS + i].value = (calcGate(gateCode[i], clockTrigger) && !retriggingOnReset)  ? 10.0f : 0.0f;
+				outputs[GATE_OUTPUTS + i].value = ((highRows >> i) & 0x1) != 0 ? 10.0f : 0.0f;
 		}
 		else {// not running (no gates, no need to hear anything)
 			for (int i = 0; i < 4; i++)
@@ -938,8 +1006,9 @@ struct GateSeq64 : Module {
 
 			// Step LED button lights
 			if (infoCopyPaste != 0l) {
+				int cpOffset = (editingSequence ? 0 : getSongPageStart());
 				for (int i = 0; i < 64; i++) {
-					if (i >= startCP && i < (startCP + countCP))
+					if ((cpOffset + i) >= startCP && (cpOffset + i) < (startCP + countCP))
 						setGreenRed3(STEP_LIGHTS + i * 3, 0.5f, 0.0f);
 					else
 						setGreenRed3(STEP_LIGHTS + i * 3, 0.0f, 0.0f);
@@ -948,6 +1017,7 @@ struct GateSeq64 : Module {
 			else {
 				int row = -1;
 				int col = -1;
+				int songPageStart = getSongPageStart();
 				for (int i = 0; i < 64; i++) {
 					row = i >> (3 + stepConfig);//i / (16 * stepConfig);// optimized (not equivalent code, but in this case has same effect)
 					if (stepConfig == 2 && row == 1) 
@@ -965,9 +1035,9 @@ struct GateSeq64 : Module {
 						else {
 							float stepHereOffset = ((stepIndexRun[row] == col) && running) ? 0.5f : 1.0f;
 							long blinkCountMarker = (long) (0.67f * sampleRate / displayRefreshStepSkips);							
-							if (attributes[sequence][i].getGate()) {
+							if (attributes.getSteps(sequence).getGate(i)) {
 								bool blinkEnableOn = (displayState != DISP_MODES) && (blinkCount < blinkCountMarker);
-								if (attributes[sequence][i].getGateP()) {
+								if (attributes.getSteps(sequence).getGateP(i)) {
 									if (i == stepIndexEdit)// more orange than yellow
 										setGreenRed3(STEP_LIGHTS + i * 3, blinkEnableOn ? 1.0f : 0.0f, blinkEnableOn ? 1.0f : 0.0f);
 									else// more yellow
@@ -989,31 +1059,33 @@ struct GateSeq64 : Module {
 						}
 					}
 					else {// editing Song
+						int p = songPageStart + i;
 						if (displayState == DISP_LENGTH) {
 							col = i & 0xF;//i % 16;// optimized
-							if (i < (phrases - 1))
+							if (p < (phrases - 1))
 								setGreenRed3(STEP_LIGHTS + i * 3, 0.1f, 0.0f);
-							else if (i == (phrases - 1))
+							else if (p == (phrases - 1))
 								setGreenRed3(STEP_LIGHTS + i * 3, 1.0f, 0.0f);
 							else 
 								setGreenRed3(STEP_LIGHTS + i * 3, 0.0f, 0.0f);
 						}
 						else {
-							float green = (i == (phraseIndexRun) && running) ? 1.0f : 0.0f;
-							float red = (i == (phraseIndexEdit) && ((editingPhraseSongRunning > 0l) || !running)) ? 1.0f : 0.0f;
-							green += ((running && (col == stepIndexRun[row]) && i != (phraseIndexEdit)) ? 0.1f : 0.0f);
-							setGreenRed3(STEP_LIGHTS + i * 3, clamp(green, 0.0f, 1.0f), red);
+							float green = (p == (phraseIndexRun) && running) ? 1.0f : 0.0f;
+							float red = (p == (phraseIndexEdit) && ((editingPhraseSongRunning > 0l) || !running)) ? 1.0f : 0.0f;
+							green += ((running && (col == stepIndexRun[row]) && p != (phraseIndexEdit)) ? 0.1f : 0.0f);
+							float white = 0.0f;
 							if (green == 0.0f && red == 0.0f && displayState != DISP_MODES){
-								lights[STEP_LIGHTS + i * 3 + 2].value = (attributes[phrase[phraseIndexRun]][i].getGate() ? 0.2f : 0.0f);
-								lights[STEP_LIGHTS + i * 3 + 2].value -= (attributes[phrase[phraseIndexRun]][i].getGateP() ? 0.18f : 0.0f);
+								white = (attributes.getSteps(phrase[phraseIndexRun]).getGate(i) ? 0.2f : 0.0f);
+								white -= (attributes.getSteps(phrase[phraseIndexRun]).getGateP(i) ? 0.18f : 0.0f);
 							}
+							setGreenRed3(STEP_LIGHTS + i * 3, clamp(green, 0.0f, 1.0f), red, white);
 						}				
 					}
 				}
 			}
 			
 			// GateType lights
-			if (pulsesPerStep != 1 && editingSequence && attributes[sequence][stepIndexEdit].getGate()) {
+			if (pulsesPerStep != 1 && editingSequence && attributes.getSteps(sequence).getGate(stepIndexEdit)) {
 				if (editingPpqn != 0) {
 					for (int i = 0; i < 8; i++) {
 						if (ppsRequirementMet(i))
@@ -1023,7 +1095,7 @@ struct GateSeq64 : Module {
 					}
 				}
 				else {		
-					int gmode = attributes[sequence][stepIndexEdit].getGateMode();
+					int gmode = attributes.getSteps(sequence).getGateMode(stepIndexEdit);
 					for (int i = 0; i < 8; i++) {
 						if (i == gmode) {
 							if ( (pulsesPerStep == 4 && i > 2) || (pulsesPerStep == 6 && i <= 2) ) // pps requirement not met
@@ -1042,11 +1114,11 @@ struct GateSeq64 : Module {
 			}
 		
 			// Reset light
-			lights[RESET_LIGHT].value =	resetLight;	
+			lightState.set(RESET_LIGHT, resetLight);	
 			resetLight -= (resetLight / lightLambda) * engineGetSampleTime() * displayRefreshStepSkips;
 
 			// Run lights
-			lights[RUN_LIGHT].value = running ? 1.0f : 0.0f;
+			lightState.set(RUN_LIGHT, running ? 1.0f : 0.0f);
 		
 			if (infoCopyPaste != 0l) {
 				if (infoCopyPaste > 0l)
@@ -1076,6 +1148,8 @@ struct GateSeq64 : Module {
 					blinkNum--;
 				}
 			}
+			
+			publishDisplaySnapshot();
 		}// lightRefreshCounter
 
 		if (clockIgnoreOnReset > 0l)
@@ -1083,13 +1157,59 @@ struct GateSeq64 : Module {
 
 	}// step()
 	
+
+	void stepsEdit(int editId) {// row edits are on the row of the edit cursor, limited to the sequence length
+		if (editId == STEP_PROB_RESET) {
+			attributes.editSteps(sequence).setGatePVal(stepIndexEdit, 50);
+			return;
+		}
+		if (editId == SEQ_RANDOMIZE) {
+			attributes.editSteps(sequence).randomize();
+			sequences[sequence].randomize(16 * stepConfig, NUM_MODES);// ok to use stepConfig since CONFIG_PARAM is not randomizable
+			return;
+		}
+		int rowLength = 16 * stepConfig;
+		int first = (stepIndexEdit / rowLength) * rowLength;
+		int count = sequences[sequence].getLength();
+		uint64_t mask = SeqStepsGS::stepsMask(first, count);
+		if (editId == ROW_FILL)
+			attributes.editSteps(sequence).setGates(mask, true);
+		else if (editId == ROW_CLEAR)
+			attributes.editSteps(sequence).setGates(mask, false);
+		else if (editId == ROW_INVERT)
+			attributes.editSteps(sequence).toggleGates(mask);
+		else if (count > 1)
+			attributes.editSteps(sequence).rotateSteps(first, count, editId == ROW_ROTATE_LATER);
+	}
+	
+	void publishDisplaySnapshot() {
+		DisplaySnapshot snap;
+		snap.editingSequence = isEditingSequence();
+		snap.infoCopyPaste = infoCopyPaste;
+		snap.seqCopied = seqCopied;
+		snap.cpMode = params[CPMODE_PARAM].value;
+		snap.displayProbInfo = displayProbInfo != 0l;
+		snap.gatePVal = attributes.getSteps(sequence).getGatePVal(stepIndexEdit);
+		snap.editingPpqn = editingPpqn != 0ul;
+		snap.pulsesPerStep = pulsesPerStep;
+		snap.displayState = displayState;
+		snap.runMode = snap.editingSequence ? sequences[sequence].getRunMode() : runModeSong;
+		snap.length = snap.editingSequence ? sequences[sequence].getLength() : phrases;
+		snap.sequence = sequence;
+		snap.editingPhraseSongRunning = editingPhraseSongRunning > 0l;
+		snap.running = running;
+		snap.phraseEdit = phrase[phraseIndexEdit];
+		snap.phraseRun = phrase[phraseIndexRun];
+		displaySnapshot.write(snap);
+	}
+	
 	inline void setGreenRed(int id, float green, float red) {
-		lights[id + 0].value = green;
-		lights[id + 1].value = red;
+		lightState.set(id + 0, green);
+		lightState.set(id + 1, red);
 	}
-	inline void setGreenRed3(int id, float green, float red) {
+	inline void setGreenRed3(int id, float green, float red, float white = 0.0f) {
 		setGreenRed(id, green, red);
-		lights[id + 2].value = 0.0f;
+		lightState.set(id + 2, white);
 	}
 
 };// GateSeq64 : module
@@ -1101,35 +1221,25 @@ struct GateSeq64Widget : ModuleWidget {
 	int expWidth = 60;
 	IMPort* expPorts[6];
 		
-	struct SequenceDisplayWidget : TransparentWidget {
+	struct SequenceDisplayWidget : CachedDisplayWidget {
 		GateSeq64 *module;
-		std::shared_ptr<Font> font;
-		char displayStr[4];
-		
-		SequenceDisplayWidget() {
-			font = Font::load(assetPlugin(plugin, "res/fonts/Segment14.ttf"));
-		}
+		GateSeq64::DisplaySnapshot snap;// copy of the module's display snapshot, printContent() reads this instead of the module
 		
 		void runModeToStr(int num) {
 			if (num >= 0 && num < NUM_MODES)
 				snprintf(displayStr, 4, "%s", modeLabels[num].c_str());
 		}
 
-		void draw(NVGcontext *vg) override {
-			NVGcolor textColor = prepareDisplay(vg, &box, 18);
-			nvgFontFaceId(vg, font->handle);
-			bool editingSequence = module->isEditingSequence();
-
-			Vec textPos = Vec(6, 24);
-			nvgFillColor(vg, nvgTransRGBA(textColor, displayAlpha));
-			nvgText(vg, textPos.x, textPos.y, "~~~", NULL);
-			nvgFillColor(vg, textColor);				
-			if (module->infoCopyPaste != 0l) {
-				if (module->infoCopyPaste > 0l)// if copy display "CPY"
+		void printContent() override {
+			if (!module->displaySnapshot.read(&snap))
+				return;// keep what is shown, a consistent snapshot will be read next frame
+			bool editingSequence = snap.editingSequence;
+			if (snap.infoCopyPaste != 0l) {
+				if (snap.infoCopyPaste > 0l)// if copy display "CPY"
 					snprintf(displayStr, 4, "CPY");
 				else {
-					float cpMode = module->params[GateSeq64::CPMODE_PARAM].value;
-					if (editingSequence && !module->seqCopied) {// cross paste to seq
+					float cpMode = snap.cpMode;
+					if (editingSequence && !snap.seqCopied) {// cross paste to seq
 						if (cpMode > 1.5f)// All = init
 							snprintf(displayStr, 4, "CLR");
 						else if (cpMode < 0.5f)// 4 = random gate
@@ -1137,7 +1247,7 @@ struct GateSeq64Widget : ModuleWidget {
 						else// 8 = random probs
 							snprintf(displayStr, 4, "RPR");
 					}
-					else if (!editingSequence && module->seqCopied) {// cross paste to song
+					else if (!editingSequence && snap.seqCopied) {// cross paste to song
 						if (cpMode > 1.5f)// All = init
 							snprintf(displayStr, 4, "CLR");
 						else if (cpMode < 0.5f)// 4 = increase by 1
@@ -1149,8 +1259,8 @@ struct GateSeq64Widget : ModuleWidget {
 						snprintf(displayStr, 4, "PST");
 				}
 			}
-			else if (module->displayProbInfo != 0l) {
-				int prob = module->attributes[module->sequence][module->stepIndexEdit].getGatePVal();
+			else if (snap.displayProbInfo) {
+				int prob = snap.gatePVal;
 				if ( prob>= 100)
 					snprintf(displayStr, 4, "1,0");
 				else if (prob >= 1)
@@ -1158,37 +1268,47 @@ struct GateSeq64Widget : ModuleWidget {
 				else
 					snprintf(displayStr, 4, "  0");
 			}
-			else if (module->editingPpqn != 0ul) {
-				snprintf(displayStr, 4, "x%2u", (unsigned) module->pulsesPerStep);
+			else if (snap.editingPpqn) {
+				snprintf(displayStr, 4, "x%2u", (unsigned) snap.pulsesPerStep);
 			}
-			else if (module->displayState == GateSeq64::DISP_LENGTH) {
-				if (editingSequence)
-					snprintf(displayStr, 4, "L%2u", (unsigned) module->sequences[module->sequence].getLength());
+			else if (snap.displayState == GateSeq64::DISP_LENGTH) {
+				if (snap.length < 100)// of the sequence or of the song
+					snprintf(displayStr, 4, "L%2u", (unsigned) snap.length);
 				else
-					snprintf(displayStr, 4, "L%2u", (unsigned) module->phrases);
+					snprintf(displayStr, 4, "%3u", (unsigned) snap.length);
 			}
-			else if (module->displayState == GateSeq64::DISP_MODES) {
-				if (editingSequence)
-					runModeToStr(module->sequences[module->sequence].getRunMode());
-				else
-					runModeToStr(module->runModeSong);
+			else if (snap.displayState == GateSeq64::DISP_MODES) {
+				runModeToStr(snap.runMode);// of the sequence or of the song
 			}
 			else {
 				int dispVal = 0;
 				char specialCode = ' ';
 				if (editingSequence)
-					dispVal = module->sequence;
+					dispVal = snap.sequence;
 				else {
-					if (module->editingPhraseSongRunning > 0l || !module->running) {
-						dispVal = module->phrase[module->phraseIndexEdit];
-						if (module->editingPhraseSongRunning > 0l)
+					if (snap.editingPhraseSongRunning || !snap.running) {
+						dispVal = snap.phraseEdit;
+						if (snap.editingPhraseSongRunning)
 							specialCode = '*';
 					}
 					else
-						dispVal = module->phrase[module->phraseIndexRun];
+						dispVal = snap.phraseRun;
 				}
-				snprintf(displayStr, 4, "%c%2u", specialCode, (unsigned)(dispVal) + 1 );
+				if (dispVal < 99)
+					snprintf(displayStr, 4, "%c%2u", specialCode, (unsigned)(dispVal) + 1 );
+				else
+					snprintf(displayStr, 4, "%3u", (unsigned)(dispVal) + 1 );
 			}
+		}
+
+		void drawContent(NVGcontext *vg) override {
+			NVGcolor textColor = prepareDisplay(vg, &box, 18);
+			nvgFontFaceId(vg, getFontHandle(vg));
+
+			Vec textPos = Vec(6, 24);
+			nvgFillColor(vg, nvgTransRGBA(textColor, displayAlpha));
+			nvgText(vg, textPos.x, textPos.y, "~~~", NULL);
+			nvgFillColor(vg, textColor);				
 			nvgText(vg, textPos.x, textPos.y, displayStr, NULL);
 		}
 	};	
@@ -1221,6 +1341,13 @@ struct GateSeq64Widget : ModuleWidget {
 			module->autoseq = !module->autoseq;
 		}
 	};
+	struct RowEditItem : MenuItem {
+		GateSeq64 *module;
+		int editId;
+		void onAction(EventAction &e) override {
+			module->pendingStepsEdit = editId;// applied by step()
+		}
+	};
 	struct SeqCVmethodItem : MenuItem {
 		GateSeq64 *module;
 		void onAction(EventAction &e) override {
@@ -1282,6 +1409,20 @@ struct GateSeq64Widget : ModuleWidget {
 		
 		menu->addChild(new MenuLabel());// empty line
 		
+		MenuLabel *rowEditLabel = new MenuLabel();
+		rowEditLabel->text = "Row of the edit cursor (SEQ mode)";
+		menu->addChild(rowEditLabel);
+		
+		static const char *rowEditNames[5] = {"Fill gates", "Clear gates", "Invert gates", "Shift steps left", "Shift steps right"};
+		for (int i = 0; i < 5; i++) {
+			RowEditItem *rowEditItem = MenuItem::create<RowEditItem>(rowEditNames[i], "");
+			rowEditItem->module = module;
+			rowEditItem->editId = i;
+			menu->addChild(rowEditItem);
+		}
+		
+		menu->addChild(new MenuLabel());// empty line
+		
 		MenuLabel *expansionLabel = new MenuLabel();
 		expansionLabel->text = "Expansion module";
 		menu->addChild(expansionLabel);
@@ -1322,7 +1463,7 @@ struct GateSeq64Widget : ModuleWidget {
 				bool editingSequence = module->isEditingSequence();
 				if (module->displayProbInfo != 0l && editingSequence) {
 					//blinkNum = blinkNumInit;
-					module->attributes[module->sequence][module->stepIndexEdit].setGatePVal(50);
+					module->pendingStepsEdit = GateSeq64::STEP_PROB_RESET;// done by step()
 					//displayProbInfo = (long) (displayProbInfoTime * sampleRate / displayRefreshStepSkips);
 				}
 				else if (module->editingPpqn != 0) {
@@ -1366,6 +1507,7 @@ struct GateSeq64Widget : ModuleWidget {
 	};			
 
 	GateSeq64Widget(GateSeq64 *module) : ModuleWidget(module) {		
+		IM_TIME_SCOPE("GateSeq64", TIMING_WIDGET);
 		this->module = module;
 		oldExpansion = -1;
 		
@@ -1380,12 +1522,12 @@ struct GateSeq64Widget : ModuleWidget {
         addChild(panel);		
 		
 		// Screws
-		addChild(createDynamicScrew<IMScrew>(Vec(15, 0), &module->panelTheme));
-		addChild(createDynamicScrew<IMScrew>(Vec(15, 365), &module->panelTheme));
-		addChild(createDynamicScrew<IMScrew>(Vec(panel->box.size.x-30, 0), &module->panelTheme));
-		addChild(createDynamicScrew<IMScrew>(Vec(panel->box.size.x-30, 365), &module->panelTheme));
-		addChild(createDynamicScrew<IMScrew>(Vec(panel->box.size.x-30-expWidth, 0), &module->panelTheme));
-		addChild(createDynamicScrew<IMScrew>(Vec(panel->box.size.x-30-expWidth, 365), &module->panelTheme));
+		panel->addChild(createDynamicScrew<IMScrew>(Vec(15, 0), &module->panelTheme));
+		panel->addChild(createDynamicScrew<IMScrew>(Vec(15, 365), &module->panelTheme));
+		panel->addChild(createDynamicScrew<IMScrew>(Vec(panel->box.size.x-30, 0), &module->panelTheme));
+		panel->addChild(createDynamicScrew<IMScrew>(Vec(panel->box.size.x-30, 365), &module->panelTheme));
+		panel->addChild(createDynamicScrew<IMScrew>(Vec(panel->box.size.x-30-expWidth, 0), &module->panelTheme));
+		panel->addChild(createDynamicScrew<IMScrew>(Vec(panel->box.size.x-30-expWidth, 365), &module->panelTheme));
 		
 		
 		// ****** Top portion (LED button array and gate type LED buttons) ******
@@ -1508,6 +1650,18 @@ Model *modelGateSeq64 = Model::create<GateSeq64, GateSeq64Widget>("Impromptu Mod
 
 /*CHANGE LOG
 
+0.6.17:
+steps stored as 64-bit bitplanes per sequence, with word operations for row edits and gate codes of all rows evaluated together
+128 sequences and 256 phrases, sequence steps sparse in the patch (only sequences with non default steps are saved), right click a step in song mode for the next page of 64 phrases
+advanced gates come from the shared gate pattern table (AdvGateUtil), same gates as before for all pulses per step
+segment displays are framebuffer cached and only redrawn when their text changes
+lights are written through LightState, so that only changed lights are written
+screws are drawn in the panel's framebuffer
+optional timing instrumentation (IM_TIMING)
+preallocate the steps of all sequences, keep 0-10V SEQ# CV scaling over 64 sequences
+display reads a snapshot of the display state published at light refresh rate (SeqLock)
+row edits in the menu (fill, clear, invert and shift of the row of the edit cursor)
+
 0.6.16:
 support for 32 sequences instead of 16
 add step indication in song mode (white lights), and add right-click initialization on main knob
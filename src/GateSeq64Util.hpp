@@ -42,6 +42,185 @@ class StepAttributesGS {
 
 
 
+//*****************************************************************************
+
+
+class SeqStepsGS {// the 64 steps of a sequence, as bitplanes where bit s is step s (row r is bits 16*r to 16*r+15 in 4x16 config)
+	uint64_t gates;
+	uint64_t gatePs;
+	uint64_t gateModes[3];// bit 0, 1 and 2 of the gate mode of each step
+	uint8_t gatePVals[64];
+	
+	public:
+	
+	static const int INIT_PROB = StepAttributesGS::ATT_MSK_INITSTATE;
+	
+	inline void init() {
+		gates = 0;
+		gatePs = 0;
+		gateModes[0] = gateModes[1] = gateModes[2] = 0;
+		memset(gatePVals, INIT_PROB, 64);
+	}
+	inline void randomize() {
+		gates = randomu64();
+		gatePs = randomu64();
+		for (int b = 0; b < 3; b++)
+			gateModes[b] = randomu64();
+		randomizeGatePVals();
+	}
+	inline void randomizeGatePVals() {
+		for (int s = 0; s < 64; s++)
+			gatePVals[s] = randomu32() % 101;
+	}
+	
+	inline bool getGate(int s) const {return ((gates >> s) & 0x1) != 0;}
+	inline bool getGateP(int s) const {return ((gatePs >> s) & 0x1) != 0;}
+	inline int getGatePVal(int s) const {return gatePVals[s];}
+	inline int getGateMode(int s) const {return (int)(((gateModes[0] >> s) & 0x1) | (((gateModes[1] >> s) & 0x1) << 1) | (((gateModes[2] >> s) & 0x1) << 2));}
+	inline StepAttributesGS getAttribute(int s) const {
+		StepAttributesGS attribute;
+		attribute.init();
+		attribute.setGatePVal(gatePVals[s]);
+		attribute.setGateP(getGateP(s));
+		attribute.setGate(getGate(s));
+		attribute.setGateMode(getGateMode(s));
+		return attribute;
+	}
+	inline uint64_t getGates() const {return gates;}
+	inline uint64_t getGatePs() const {return gatePs;}
+	inline bool isInit() const {// true when all steps are as set by init()
+		if ((gates | gatePs | gateModes[0] | gateModes[1] | gateModes[2]) != 0)
+			return false;
+		for (int s = 0; s < 64; s++)
+			if (gatePVals[s] != INIT_PROB)
+				return false;
+		return true;
+	}
+	
+	inline void setGate(int s, bool gateState) {gates = setBit(gates, s, gateState);}
+	inline void setGateP(int s, bool gatePState) {gatePs = setBit(gatePs, s, gatePState);}
+	inline void setGatePVal(int s, int pVal) {gatePVals[s] = (uint8_t)(pVal & StepAttributesGS::ATT_MSK_PROB);}
+	inline void setGateMode(int s, int gateMode) {
+		for (int b = 0; b < 3; b++)
+			gateModes[b] = setBit(gateModes[b], s, ((gateMode >> b) & 0x1) != 0);
+	}
+	inline void setAttribute(int s, unsigned short attribute) {
+		StepAttributesGS stepAttribute;
+		stepAttribute.setAttribute(attribute);
+		setAttribute(s, stepAttribute);
+	}
+	inline void setAttribute(int s, StepAttributesGS attribute) {
+		setGatePVal(s, attribute.getGatePVal());
+		setGateP(s, attribute.getGateP());
+		setGate(s, attribute.getGate());
+		setGateMode(s, attribute.getGateMode());
+	}
+	
+	// Row edits as word operations, mask selects the steps
+	inline void toggleGate(int s) {gates ^= (((uint64_t)0x1) << s);}
+	inline void toggleGates(uint64_t mask) {gates ^= mask;}
+	inline void setGates(uint64_t mask, bool gateState) {gates = (gateState ? (gates | mask) : (gates & ~mask));}
+	inline void setGatePs(uint64_t newGatePs) {gatePs = newGatePs;}
+	inline void rotateSteps(int first, int count, bool later) {// rotates steps [first : first + count) by one step, along with their probabilities and gate modes
+		gates = rotatePlane(gates, first, count, later);
+		gatePs = rotatePlane(gatePs, first, count, later);
+		for (int b = 0; b < 3; b++)
+			gateModes[b] = rotatePlane(gateModes[b], first, count, later);
+		if (later) {
+			uint8_t carry = gatePVals[first + count - 1];
+			memmove(&gatePVals[first + 1], &gatePVals[first], count - 1);
+			gatePVals[first] = carry;
+		}
+		else {
+			uint8_t carry = gatePVals[first];
+			memmove(&gatePVals[first], &gatePVals[first + 1], count - 1);
+			gatePVals[first + count - 1] = carry;
+		}
+	}
+	static inline uint64_t stepsMask(int first, int count) {// mask of steps [first : first + count)
+		return (count >= 64 ? ~((uint64_t)0) : ((((uint64_t)1) << count) - 1)) << first;
+	}
+	
+	// Gathers one bit of a plane for each of the 4 rows (bit r of the result is row r), at step stepIndexes[r] of each row
+	inline uint32_t gatherRows(uint64_t plane, const int* stepIndexes, int stepConfig) const {
+		uint32_t rowBits = 0;
+		for (int r = 0; r < 4; r += stepConfig)
+			rowBits |= ((uint32_t)((plane >> ((r << 4) + stepIndexes[r])) & 0x1)) << r;
+		return rowBits;
+	}
+	inline uint32_t gatherRowGates(const int* stepIndexes, int stepConfig) const {return gatherRows(gates, stepIndexes, stepConfig);}
+	inline uint32_t gatherRowGatePs(const int* stepIndexes, int stepConfig) const {return gatherRows(gatePs, stepIndexes, stepConfig);}
+	
+	private:
+	
+	static inline uint64_t setBit(uint64_t plane, int s, bool state) {
+		uint64_t bit = ((uint64_t)0x1) << s;
+		return state ? (plane | bit) : (plane & ~bit);
+	}
+	static inline uint64_t rotatePlane(uint64_t plane, int first, int count, bool later) {
+		uint64_t mask = stepsMask(first, count);
+		uint64_t bits = (plane & mask) >> first;
+		if (later)
+			bits = (bits << 1) | (bits >> (count - 1));
+		else
+			bits = (bits >> 1) | ((bits & 0x1) << (count - 1));
+		return (plane & ~mask) | ((bits << first) & mask);
+	}
+};// class SeqStepsGS 
+
+
+
+//*****************************************************************************
+
+
+// Store for the steps of NUM_SEQS sequences, sparse in the patch
+//   a sequence that was never written to is not in use and reads as init() steps (see getSteps() and editSteps())
+//   each sequence has its own preallocated slot, so editSteps() and init() only touch that sequence and can be
+//   called from the ui thread (onReset(), fromJson()) while the audio thread edits other sequences
+
+template<int NUM_SEQS>
+class SeqStoreGS {
+	bool inUse[NUM_SEQS];// false when sequence has default steps
+	SeqStepsGS storage[NUM_SEQS];
+	SeqStepsGS defaultSteps;
+	
+	public:
+	
+	SeqStoreGS() {
+		for (int i = 0; i < NUM_SEQS; i++)
+			inUse[i] = false;
+		defaultSteps.init();
+	}
+	
+	inline const SeqStepsGS& getSteps(int seq) {return inUse[seq] ? storage[seq] : defaultSteps;}
+	inline SeqStepsGS& editSteps(int seq) {// use for any write, puts the sequence in use if needed
+		if (!inUse[seq]) {
+			storage[seq].init();
+			inUse[seq] = true;
+		}
+		return storage[seq];
+	}
+	inline bool isAllocated(int seq) {return inUse[seq];}
+	
+	inline void init(int seq) {inUse[seq] = false;}
+	inline void init() {
+		for (int i = 0; i < NUM_SEQS; i++)
+			init(i);
+	}
+	inline void compact() {// releases sequences that are back to their init() state
+		for (int i = 0; i < NUM_SEQS; i++)
+			if (inUse[i] && storage[i].isInit())
+				init(i);
+	}
+	
+	private:
+	
+	SeqStoreGS(const SeqStoreGS&);// not copyable, getSteps() returns references into storage
+	SeqStoreGS& operator=(const SeqStoreGS&);
+};// class SeqStoreGS
+
+
+
 //*****************************************************************************
 
 
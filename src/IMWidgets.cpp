@@ -6,7 +6,7 @@
 //***********************************************************************************************
 
 
-#include "IMWidgets.hpp"
+#include "ImpromptuModular.hpp"// IMWidgets.hpp, and imAssets for the shared SVGs
 
 
 
@@ -49,7 +49,7 @@ DynamicSVGScrew::DynamicSVGScrew() {
 	sw = new SVGWidget();
 	tw->addChild(sw);
 	//sw->setSVG(SVG::load(assetPlugin(plugin, "res/Screw.svg")));
-	sw->setSVG(SVG::load(assetGlobal("res/ComponentLibrary/ScrewSilver.svg")));
+	sw->setSVG(imAssets.screwSilverGlobal);
 	
 	sc = new ScrewCircle(angle0_90);
 	sc->box.size = sw->box.size;
@@ -77,11 +77,7 @@ void DynamicSVGScrew::addSVGalt(std::shared_ptr<SVG> svg) {
     }
 }
 
-void DynamicSVGScrew::step() { // all code except middle if() from SVGPanel::step() in SVGPanel.cpp
-    if (isNear(gPixelRatio, 1.0)) {
-		// Small details draw poorly at low DPI, so oversample when drawing to the framebuffer
-        oversample = 2.f;
-    }
+void DynamicSVGScrew::themeChanged() {
     if(mode != nullptr && *mode != oldMode) {
         if ((*mode) == 0) {
 			sw->visible = true;
@@ -92,9 +88,7 @@ void DynamicSVGScrew::step() { // all code except middle if() from SVGPanel::ste
 			swAlt->visible = true;
 		}
         oldMode = *mode;
-        dirty = true;
     }
-	FramebufferWidget::step();
 }
 
 
@@ -150,10 +144,22 @@ void DynamicSVGPanel::step() { // all code except middle if() from SVGPanel::ste
         visiblePanel->setSVG(panels[*mode]);
         oldMode = *mode;
         dirty = true;
+		// notify the dynamic widgets of the module, this is the only place where the theme is polled
+		notifyThemeObservers(this);// screws drawn in the panel's framebuffer
+		if (parent != nullptr)
+			notifyThemeObservers(parent);// ports, params and screws of the module widget
     }
 	FramebufferWidget::step();
 }
 
+void DynamicSVGPanel::notifyThemeObservers(Widget *container) {
+	for (Widget *child : container->children) {
+		ThemeObserver *observer = dynamic_cast<ThemeObserver*>(child);
+		if (observer != nullptr)
+			observer->themeChanged();
+	}
+}
+
 
 
 // Dynamic SVGPort
@@ -175,12 +181,15 @@ void DynamicSVGPort::step() {
 		// Small details draw poorly at low DPI, so oversample when drawing to the framebuffer
         oversample = 2.f;
     }
+	Port::step();
+}
+
+void DynamicSVGPort::themeChanged() {
     if(mode != nullptr && *mode != oldMode) {
         background->setSVG(frames[min(*mode, frames.size() - 1)]);
         oldMode = *mode;
         dirty = true;
     }
-	Port::step();
 }
 
 
@@ -206,6 +215,9 @@ void DynamicSVGSwitch::step() {
 		// Small details draw poorly at low DPI, so oversample when drawing to the framebuffer
         oversample = 2.f;
     }
+}
+
+void DynamicSVGSwitch::themeChanged() {
     if(mode != nullptr && *mode != oldMode) {
         if ((*mode) == 0) {
 			frames[0]=framesAll[0];
@@ -216,7 +228,8 @@ void DynamicSVGSwitch::step() {
 			frames[1]=framesAll[3];
 		}
         oldMode = *mode;
-		onChange(*(new EventChange()));// required because of the way SVGSwitch changes images, we only change the frames above.
+		EventChange e;
+		onChange(e);// required because of the way SVGSwitch changes images, we only change the frames above.
 		//dirty = true;// dirty is not sufficient when changing via frames assignments above (i.e. onChange() is required)
     }
 }
@@ -249,6 +262,10 @@ void DynamicSVGKnob::step() {
 		// Small details draw poorly at low DPI, so oversample when drawing to the framebuffer
         oversample = 2.f;
     }
+	SVGKnob::step();
+}
+
+void DynamicSVGKnob::themeChanged() {
     if(mode != nullptr && *mode != oldMode) {
         if ((*mode) == 0) {
 			setSVG(framesAll[0]);
@@ -261,7 +278,6 @@ void DynamicSVGKnob::step() {
         oldMode = *mode;
 		dirty = true;
     }
-	SVGKnob::step();
 }
 
 
@@ -16,6 +16,16 @@ using namespace rack;
 
 
 
+// Theme observer: the dynamic widgets below don't poll their mode, the DynamicSVGPanel of the module 
+// checks it once per frame and calls themeChanged() on its children and sibling widgets when the theme changes
+
+struct ThemeObserver {
+	virtual ~ThemeObserver() {}
+	virtual void themeChanged() = 0;
+};
+
+
+
 // Dynamic SVGScrew
 
 // General Dynamic Screw creation
@@ -23,6 +33,7 @@ template <class TWidget>
 TWidget* createDynamicScrew(Vec pos, int* mode) {
 	TWidget *dynScrew = createWidget<TWidget>(pos);
 	dynScrew->mode = mode;
+	dynScrew->themeChanged();// initial theme, the panel only notifies when its own mode changes
 	return dynScrew;
 }
 
@@ -32,7 +43,7 @@ struct ScrewCircle : TransparentWidget {
 	ScrewCircle(float _angle);
 	void draw(NVGcontext *vg) override;
 };
-struct DynamicSVGScrew : FramebufferWidget {
+struct DynamicSVGScrew : TransparentWidget, ThemeObserver {// not a framebuffer, add it to the DynamicSVGPanel so that it is drawn in the panel's framebuffer
     int* mode;
     int oldMode;
 	// for random rotated screw used in primary mode
@@ -44,7 +55,7 @@ struct DynamicSVGScrew : FramebufferWidget {
 	
     DynamicSVGScrew();
     void addSVGalt(std::shared_ptr<SVG> svg);
-    void step() override;
+	void themeChanged() override;
 };
 
 
@@ -57,6 +68,8 @@ struct PanelBorderWidget : TransparentWidget { // from SVGPanel.cpp
 };
 
 struct DynamicSVGPanel : FramebufferWidget { // like SVGPanel (in app.hpp and SVGPanel.cpp) but with dynmically assignable panel
+	// static decoration such as screws should be added as children of the panel (addChild()), so that it is drawn once into 
+	// the panel's framebuffer along with the panel and border, instead of on every frame
     int* mode;
     int oldMode;
 	int* expWidth;
@@ -67,6 +80,7 @@ struct DynamicSVGPanel : FramebufferWidget { // like SVGPanel (in app.hpp and SV
     void addPanel(std::shared_ptr<SVG> svg);
     void dupPanel();
     void step() override;
+	void notifyThemeObservers(Widget *container);
 };
 
 
@@ -81,6 +95,7 @@ TDynamicPort* createDynamicPort(Vec pos, Port::PortType type, Module *module, in
 		createInput<TDynamicPort>(pos, module, portId) :
 		createOutput<TDynamicPort>(pos, module, portId);
 	dynPort->mode = mode;
+	dynPort->themeChanged();// initial theme, the panel only notifies when its own mode changes
 	return dynPort;
 }
 template <class TDynamicPort>
@@ -90,12 +105,13 @@ TDynamicPort* createDynamicPortCentered(Vec pos, Port::PortType type, Module *mo
 		createInput<TDynamicPort>(pos, module, portId) :
 		createOutput<TDynamicPort>(pos, module, portId);
 	dynPort->mode = mode;
+	dynPort->themeChanged();// initial theme, the panel only notifies when its own mode changes
 	dynPort->box.pos = dynPort->box.pos.minus(dynPort->box.size.div(2));// centering
 	return dynPort;
 }
 
 // Dynamic SVGPort (see SVGPort in app.hpp and SVGPort.cpp)
-struct DynamicSVGPort : SVGPort {
+struct DynamicSVGPort : SVGPort, ThemeObserver {
     int* mode;
     int oldMode;
     std::vector<std::shared_ptr<SVG>> frames;
@@ -103,6 +119,7 @@ struct DynamicSVGPort : SVGPort {
     DynamicSVGPort();
     void addFrame(std::shared_ptr<SVG> svg);
     void step() override;
+	void themeChanged() override;
 };
 
 
@@ -115,6 +132,7 @@ TDynamicParam* createDynamicParam(Vec pos, Module *module, int paramId, float mi
                                                int* mode) {
 	TDynamicParam *dynParam = createParam<TDynamicParam>(pos, module, paramId, minValue, maxValue, defaultValue);
 	dynParam->mode = mode;
+	dynParam->themeChanged();// initial theme, the panel only notifies when its own mode changes
 	return dynParam;
 }
 template <class TDynamicParam>
@@ -122,12 +140,13 @@ TDynamicParam* createDynamicParamCentered(Vec pos, Module *module, int paramId,
                                                int* mode) {
 	TDynamicParam *dynParam = createParam<TDynamicParam>(pos, module, paramId, minValue, maxValue, defaultValue);
 	dynParam->mode = mode;
+	dynParam->themeChanged();// initial theme, the panel only notifies when its own mode changes
 	dynParam->box.pos = dynParam->box.pos.minus(dynParam->box.size.div(2));// centering
 	return dynParam;
 }
 
 // Dynamic SVGSwitch (see SVGSwitch in app.hpp and SVGSwitch.cpp)
-struct DynamicSVGSwitch : SVGSwitch {
+struct DynamicSVGSwitch : SVGSwitch, ThemeObserver {
     int* mode;
     int oldMode;
 	std::vector<std::shared_ptr<SVG>> framesAll;
@@ -135,10 +154,11 @@ struct DynamicSVGSwitch : SVGSwitch {
     DynamicSVGSwitch();
 	void addFrameAll(std::shared_ptr<SVG> svg);
     void step() override;
+	void themeChanged() override;
 };
 
 // Dynamic SVGKnob (see SVGKnob in app.hpp and SVGKnob.cpp)
-struct DynamicSVGKnob : SVGKnob {
+struct DynamicSVGKnob : SVGKnob, ThemeObserver {
     int* mode;
     int oldMode;
 	std::vector<std::shared_ptr<SVG>> framesAll;
@@ -148,6 +168,7 @@ struct DynamicSVGKnob : SVGKnob {
 	void addFrameAll(std::shared_ptr<SVG> svg);
 	void addEffect(std::shared_ptr<SVG> svg);// do this last
     void step() override;
+	void themeChanged() override;
 };
 
 
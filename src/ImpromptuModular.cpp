@@ -12,11 +12,15 @@
 
 
 Plugin *plugin;
+IMAssets imAssets;
+TimingStats timingStats;
 
 void init(rack::Plugin *p) {
 	plugin = p;
 	p->slug = TOSTRING(SLUG);
 	p->version = TOSTRING(VERSION);
+	
+	imAssets.loadSVGs();
 
 	p->addModel(modelTact);
 	p->addModel(modelTact1);
@@ -36,6 +40,84 @@ void init(rack::Plugin *p) {
 }
 
 
+TimingStats::TimingStats() {
+	numModels = 0;
+	for (int m = 0; m < MAX_MODELS; m++) {
+		modelNames[m] = nullptr;
+		for (int k = 0; k < NUM_TIMING_KINDS; k++) {
+			counts[m][k] = 0ul;
+			totals[m][k] = 0.0;
+		}
+	}
+}
+
+void TimingStats::add(const char* modelName, int kind, double seconds) {// called from the UI thread only
+	static const char* kindNames[NUM_TIMING_KINDS] = {"widget", "toJson", "fromJson", "onReset"};
+	int m = 0;
+	for (; m < numModels; m++) {
+		if (strcmp(modelNames[m], modelName) == 0)
+			break;
+	}
+	if (m == numModels) {
+		if (numModels >= MAX_MODELS)
+			return;
+		modelNames[numModels++] = modelName;
+	}
+	counts[m][kind]++;
+	totals[m][kind] += seconds;
+	
+	info("Impromptu timing: %s %s %.3f ms (totals for %s: widget %lu/%.1f ms, toJson %lu/%.1f ms, fromJson %lu/%.1f ms, onReset %lu/%.1f ms)",
+		modelName, kindNames[kind], seconds * 1000.0, modelName,
+		counts[m][TIMING_WIDGET], totals[m][TIMING_WIDGET] * 1000.0, counts[m][TIMING_TOJSON], totals[m][TIMING_TOJSON] * 1000.0,
+		counts[m][TIMING_FROMJSON], totals[m][TIMING_FROMJSON] * 1000.0, counts[m][TIMING_RESET], totals[m][TIMING_RESET] * 1000.0);
+}
+
+
+void IMAssets::loadSVGs() {
+	screwDark = SVG::load(assetPlugin(plugin, "res/dark/comp/ScrewSilver.svg"));
+	screwSilverGlobal = SVG::load(assetGlobal("res/ComponentLibrary/ScrewSilver.svg"));
+	port[0] = SVG::load(assetPlugin(plugin, "res/light/comp/PJ301M.svg"));
+	port[1] = SVG::load(assetPlugin(plugin, "res/dark/comp/PJ301M.svg"));
+	for (int i = 0; i < 2; i++)
+		ckssh[i] = SVG::load(assetPlugin(plugin, stringf("res/comp/CKSSH_%i.svg", i)));
+	for (int i = 0; i < 3; i++) {
+		cksshThree[i] = SVG::load(assetPlugin(plugin, stringf("res/comp/CKSSHThree_%i.svg", i)));
+		ckssThreeGlobal[i] = SVG::load(assetGlobal(stringf("res/ComponentLibrary/CKSSThree_%i.svg", i)));
+	}
+	ledBezelGlobal = SVG::load(assetGlobal("res/ComponentLibrary/LEDBezel.svg"));
+	for (int i = 0; i < 2; i++) {
+		bigPushButton[0][i] = SVG::load(assetPlugin(plugin, stringf("res/light/comp/CKD6b_%i.svg", i)));
+		bigPushButton[1][i] = SVG::load(assetPlugin(plugin, stringf("res/dark/comp/CKD6b_%i.svg", i)));
+		pushButton[0][i] = SVG::load(assetPlugin(plugin, stringf("res/light/comp/TL1105_%i.svg", i)));
+		pushButton[1][i] = SVG::load(assetPlugin(plugin, stringf("res/dark/comp/TL1105_%i.svg", i)));
+	}
+	bigKnob[0] = SVG::load(assetPlugin(plugin, "res/light/comp/BlackKnobLargeWithMark.svg"));
+	bigKnob[1] = SVG::load(assetPlugin(plugin, "res/dark/comp/BlackKnobLargeWithMark.svg"));
+	bigKnobEffect = SVG::load(assetPlugin(plugin, "res/dark/comp/BlackKnobLargeWithMarkEffects.svg"));
+	bigKnobInf[0] = SVG::load(assetPlugin(plugin, "res/light/comp/BlackKnobLarge.svg"));
+	bigKnobInf[1] = SVG::load(assetPlugin(plugin, "res/dark/comp/BlackKnobLarge.svg"));
+	bigKnobInfEffect = SVG::load(assetPlugin(plugin, "res/dark/comp/BlackKnobLargeEffects.svg"));
+	smallKnob[0] = SVG::load(assetPlugin(plugin, "res/light/comp/RoundSmallBlackKnob.svg"));
+	smallKnob[1] = SVG::load(assetPlugin(plugin, "res/dark/comp/RoundSmallBlackKnob.svg"));
+	smallKnobEffect = SVG::load(assetPlugin(plugin, "res/dark/comp/RoundSmallBlackKnobEffects.svg"));
+	mediumKnobInf[0] = SVG::load(assetPlugin(plugin, "res/light/comp/RoundMediumBlackKnobNoMark.svg"));
+	mediumKnobInf[1] = SVG::load(assetPlugin(plugin, "res/dark/comp/RoundMediumBlackKnobNoMark.svg"));
+	mediumKnobInfEffect = SVG::load(assetPlugin(plugin, "res/dark/comp/RoundMediumBlackKnobNoMarkEffects.svg"));
+}
+
+
+int IMAssets::getFramebufferFont() {
+	// FramebufferWidget draws its children with gFramebufferVg, but Font::load() creates the font in gVg only
+	if (segment14Framebuffer == -1) {
+		std::string filename = assetPlugin(plugin, "res/fonts/Segment14.ttf");
+		segment14Framebuffer = nvgFindFont(gFramebufferVg, filename.c_str());// named by its file, as Font::load() does in gVg
+		if (segment14Framebuffer == -1)
+			segment14Framebuffer = nvgCreateFont(gFramebufferVg, filename.c_str(), filename.c_str());
+	}
+	return segment14Framebuffer;
+}
+
+
 void IMBigPushButtonWithRClick::onMouseDown(EventMouseDown &e)  {
 	if (e.button == 1) {// if right button (see events.hpp)
 		maxValue = 2.0f;
@@ -61,7 +143,7 @@ void IMBigPushButtonWithRClick::onMouseUp(EventMouseUp &e) {
 
 LEDBezelBig::LEDBezelBig() {
 	float ratio = 2.13f;
-	addFrame(SVG::load(assetGlobal("res/ComponentLibrary/LEDBezel.svg")));
+	addFrame(imAssets.ledBezelGlobal);
 	sw->box.size = sw->box.size.mult(ratio);
 	box.size = sw->box.size;
 	tw = new TransformWidget();
@@ -132,7 +214,7 @@ ScrewSilverRandomRot::ScrewSilverRandomRot() {
 	sw = new SVGWidget();
 	tw->addChild(sw);
 	//sw->setSVG(SVG::load(assetPlugin(plugin, "res/Screw0.svg")));
-	sw->setSVG(SVG::load(assetGlobal("res/ComponentLibrary/ScrewSilver.svg")));
+	sw->setSVG(imAssets.screwSilverGlobal);
 	
 	sc = new ScrewCircle(angle0_90);
 	sc->box.size = sw->box.size;
@@ -166,6 +248,28 @@ void ScrewHole::draw(NVGcontext *vg) {
 }
 
 
+CachedDisplayWidget::CachedDisplayWidget() {
+	memset(displayStr, 0, MAX_TEXT);
+	displayFlags = 0;
+	memset(shownStr, 0, MAX_TEXT);
+	shownFlags = -1;// so that the first frame is drawn
+	font = imAssets.getFont();
+	content = new ContentWidget();
+	content->display = this;
+	addChild(content);
+}
+void CachedDisplayWidget::step() {
+	printContent();
+	if (displayFlags != shownFlags || memcmp(displayStr, shownStr, MAX_TEXT) != 0) {// whole buffer, a display can hold more than one string
+		memcpy(shownStr, displayStr, MAX_TEXT);
+		shownFlags = displayFlags;
+		dirty = true;
+	}
+	content->box.size = box.size;
+	FramebufferWidget::step();
+}
+
+
 NVGcolor prepareDisplay(NVGcontext *vg, Rect *box, int fontSize) {
 	NVGcolor backgroundColor = nvgRGB(0x38, 0x38, 0x38); 
 	NVGcolor borderColor = nvgRGB(0x10, 0x10, 0x10);
@@ -181,7 +285,19 @@ NVGcolor prepareDisplay(NVGcontext *vg, Rect *box, int fontSize) {
 	return textColor;
 }
 
-void printNote(float cvVal, char* text, bool sharp) {// text must be at least 4 chars long (three displayed chars plus end of string)
+void drawGhostedTexts(NVGcontext *vg, NVGcolor textColor, const char* ghost, const float* posX, float posY, const char* texts, int textStride, int numTexts) {
+	// draws the ghost segments of all texts of a display and then all texts, so that the fill color is only set twice
+	// text i is at texts[i * textStride] and is drawn at (posX[i], posY)
+	nvgFillColor(vg, nvgTransRGBA(textColor, displayAlpha));
+	for (int i = 0; i < numTexts; i++)
+		nvgText(vg, posX[i], posY, ghost, NULL);
+	nvgFillColor(vg, textColor);
+	for (int i = 0; i < numTexts; i++)
+		nvgText(vg, posX[i], posY, &texts[i * textStride], NULL);
+}
+
+
+static void calcNote(float cvVal, char* text, bool sharp) {// text must be at least 4 chars long (three displayed chars plus end of string)
 	static const char noteLettersSharp[12] = {'C', 'C', 'D', 'D', 'E', 'F', 'F', 'G', 'G', 'A', 'A', 'B'};
 	static const char noteLettersFlat [12] = {'C', 'D', 'D', 'E', 'E', 'F', 'G', 'G', 'A', 'A', 'B', 'B'};
 	static const char isBlackKey      [12] = { 0,   1,   0,   1,   0,   0,   1,   0,   1,   0,   1,   0 };
@@ -207,6 +323,28 @@ void printNote(float cvVal, char* text, bool sharp) {// text must be at least 4
 	text[3] = 0;
 }
 
+struct NoteTable {// note names of the quantized CVs (semitone n is n/12 V) from -10V to 10V, filled with calcNote() at load time
+	static const int NUM_SEMIS = 241;
+	static const int OFFSET = 120;// table index of 0V
+	char names[2][NUM_SEMIS][4];// [flat, sharp][semitone][chars]
+	
+	NoteTable() {
+		for (int s = 0; s < 2; s++)
+			for (int n = 0; n < NUM_SEMIS; n++)
+				calcNote(((float)(n - OFFSET)) / 12.0f, names[s][n], s == 1);
+	}
+};
+static const NoteTable noteTable;
+
+void printNote(float cvVal, char* text, bool sharp) {// text must be at least 4 chars long (three displayed chars plus end of string)
+	// quantized CVs are read from the table, any other CV is calculated
+	int n = (int)lroundf(cvVal * 12.0f);
+	if (n >= -NoteTable::OFFSET && n <= NoteTable::OFFSET && ((float)n) / 12.0f == cvVal)
+		memcpy(text, noteTable.names[sharp ? 1 : 0][n + NoteTable::OFFSET], 4);
+	else
+		calcNote(cvVal, text, sharp);
+}
+
 int moveIndex(int index, int indexNext, int numSteps) {
 	if (indexNext < 0)
 		index = numSteps - 1;
@@ -11,6 +11,8 @@
 #define IMPROMPU_MODULAR_HPP
 
 
+#include <atomic>
+#include <chrono>
 #include "rack.hpp"
 #include "IMWidgets.hpp"
 #include "dsp/digital.hpp"
@@ -50,6 +52,87 @@ static const unsigned int userInputsStepSkipMask = 0xF;// sub interval of displa
 // above value should make it such that inputs are sampled > 1kHz so as to not miss 1ms triggers
 
 
+// Plugin-wide asset cache
+// SVGs of the components below are parsed once in init() and shared by all widgets, [0] = light panel, [1] = dark panel
+// The font is loaded on first use, since there is no NanoVG context yet when init() is called
+
+struct IMAssets {
+	std::shared_ptr<SVG> screwDark;
+	std::shared_ptr<SVG> screwSilverGlobal;
+	std::shared_ptr<SVG> port[2];
+	std::shared_ptr<SVG> ckssh[2];// positions
+	std::shared_ptr<SVG> cksshThree[3];// positions
+	std::shared_ptr<SVG> ckssThreeGlobal[3];// positions
+	std::shared_ptr<SVG> ledBezelGlobal;
+	std::shared_ptr<SVG> bigPushButton[2][2];// [theme][position]
+	std::shared_ptr<SVG> pushButton[2][2];// [theme][position]
+	std::shared_ptr<SVG> bigKnob[2];
+	std::shared_ptr<SVG> bigKnobEffect;
+	std::shared_ptr<SVG> bigKnobInf[2];
+	std::shared_ptr<SVG> bigKnobInfEffect;
+	std::shared_ptr<SVG> smallKnob[2];
+	std::shared_ptr<SVG> smallKnobEffect;
+	std::shared_ptr<SVG> mediumKnobInf[2];
+	std::shared_ptr<SVG> mediumKnobInfEffect;
+	
+	void loadSVGs();
+	std::shared_ptr<Font> getFont() {
+		if (!segment14)
+			segment14 = Font::load(assetPlugin(plugin, "res/fonts/Segment14.ttf"));
+		return segment14;
+	}
+	int getFramebufferFont();// the same font in gFramebufferVg, see CachedDisplayWidget::getFontHandle()
+	
+	private:
+	std::shared_ptr<Font> segment14;
+	int segment14Framebuffer = -1;
+};
+
+extern IMAssets imAssets;
+
+
+// Timing instrumentation (opt-in, compile with -DIM_TIMING=1)
+// Wall-clock time of widget construction, toJson(), fromJson() and onReset() is accumulated per model,
+// and every measurement is written to the Rack log along with the totals of its model;
+// modules with a LightState also log their written and skipped light counts when saved (IM_LOG_LIGHTS)
+
+#ifndef IM_TIMING
+#define IM_TIMING 0
+#endif
+
+struct TimingStats {
+	enum TimingKinds {TIMING_WIDGET, TIMING_TOJSON, TIMING_FROMJSON, TIMING_RESET, NUM_TIMING_KINDS};
+	static const int MAX_MODELS = 32;
+	
+	const char* modelNames[MAX_MODELS];
+	unsigned long counts[MAX_MODELS][NUM_TIMING_KINDS];
+	double totals[MAX_MODELS][NUM_TIMING_KINDS];// seconds
+	int numModels;
+	
+	TimingStats();
+	void add(const char* modelName, int kind, double seconds);
+};
+
+extern TimingStats timingStats;
+
+struct ScopedTiming {// measures the time until it goes out of scope
+	const char* modelName;
+	int kind;
+	std::chrono::steady_clock::time_point start;
+	
+	ScopedTiming(const char* _modelName, int _kind) : modelName(_modelName), kind(_kind), start(std::chrono::steady_clock::now()) {}
+	~ScopedTiming() {
+		timingStats.add(modelName, kind, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+	}
+};
+
+#if IM_TIMING
+#define IM_TIME_SCOPE(modelName, kind) ScopedTiming imScopedTiming(modelName, TimingStats::kind)
+#else
+#define IM_TIME_SCOPE(modelName, kind)
+#endif
+
+
 // Component offset constants
 
 static const int hOffsetCKSS = 5;
@@ -80,7 +163,7 @@ static const int offsetTrimpot = 3;//does both h and v
 
 struct IMScrew : DynamicSVGScrew {
 	IMScrew() {
-		addSVGalt(SVG::load(assetPlugin(plugin, "res/dark/comp/ScrewSilver.svg")));
+		addSVGalt(imAssets.screwDark);
 	}
 };
 
@@ -90,8 +173,8 @@ struct IMScrew : DynamicSVGScrew {
 struct IMPort : DynamicSVGPort {
 	IMPort() {
 		//addFrame(SVG::load(assetGlobal("res/ComponentLibrary/PJ301M.svg")));
-		addFrame(SVG::load(assetPlugin(plugin, "res/light/comp/PJ301M.svg")));
-		addFrame(SVG::load(assetPlugin(plugin, "res/dark/comp/PJ301M.svg")));
+		addFrame(imAssets.port[0]);
+		addFrame(imAssets.port[1]);
 		shadow->blurRadius = 10.0;
 		shadow->opacity = 0.8;
 	}
@@ -107,8 +190,8 @@ struct CKSSNoRandom : CKSS {
 
 struct CKSSH : SVGSwitch, ToggleSwitch {
 	CKSSH() {
-		addFrame(SVG::load(assetPlugin(plugin, "res/comp/CKSSH_0.svg")));
-		addFrame(SVG::load(assetPlugin(plugin, "res/comp/CKSSH_1.svg")));
+		addFrame(imAssets.ckssh[0]);
+		addFrame(imAssets.ckssh[1]);
 		sw->wrap();
 		box.size = sw->box.size;
 	}
@@ -121,9 +204,9 @@ struct CKSSHNoRandom : CKSSH {
 
 struct CKSSHThree : SVGSwitch, ToggleSwitch {
 	CKSSHThree() {
-		addFrame(SVG::load(assetPlugin(plugin, "res/comp/CKSSHThree_0.svg")));
-		addFrame(SVG::load(assetPlugin(plugin, "res/comp/CKSSHThree_1.svg")));
-		addFrame(SVG::load(assetPlugin(plugin, "res/comp/CKSSHThree_2.svg")));
+		addFrame(imAssets.cksshThree[0]);
+		addFrame(imAssets.cksshThree[1]);
+		addFrame(imAssets.cksshThree[2]);
 		sw->wrap();
 		box.size = sw->box.size;
 	}
@@ -131,9 +214,9 @@ struct CKSSHThree : SVGSwitch, ToggleSwitch {
 
 struct CKSSThreeInv : SVGSwitch, ToggleSwitch {
 	CKSSThreeInv() {
-		addFrame(SVG::load(assetGlobal("res/ComponentLibrary/CKSSThree_2.svg")));
-		addFrame(SVG::load(assetGlobal("res/ComponentLibrary/CKSSThree_1.svg")));
-		addFrame(SVG::load(assetGlobal("res/ComponentLibrary/CKSSThree_0.svg")));
+		addFrame(imAssets.ckssThreeGlobal[2]);
+		addFrame(imAssets.ckssThreeGlobal[1]);
+		addFrame(imAssets.ckssThreeGlobal[0]);
 	}
 };
 
@@ -144,10 +227,10 @@ struct CKSSThreeInvNoRandom : CKSSThreeInv {
 
 struct IMBigPushButton : DynamicSVGSwitch, MomentarySwitch {
 	IMBigPushButton() {
-		addFrameAll(SVG::load(assetPlugin(plugin, "res/light/comp/CKD6b_0.svg")));
-		addFrameAll(SVG::load(assetPlugin(plugin, "res/light/comp/CKD6b_1.svg")));
-		addFrameAll(SVG::load(assetPlugin(plugin, "res/dark/comp/CKD6b_0.svg")));
-		addFrameAll(SVG::load(assetPlugin(plugin, "res/dark/comp/CKD6b_1.svg")));	
+		addFrameAll(imAssets.bigPushButton[0][0]);
+		addFrameAll(imAssets.bigPushButton[0][1]);
+		addFrameAll(imAssets.bigPushButton[1][0]);
+		addFrameAll(imAssets.bigPushButton[1][1]);
 	}
 };
 
@@ -158,10 +241,10 @@ struct IMBigPushButtonWithRClick : IMBigPushButton {// with right click that set
 
 struct IMPushButton : DynamicSVGSwitch, MomentarySwitch {
 	IMPushButton() {
-		addFrameAll(SVG::load(assetPlugin(plugin, "res/light/comp/TL1105_0.svg")));
-		addFrameAll(SVG::load(assetPlugin(plugin, "res/light/comp/TL1105_1.svg")));
-		addFrameAll(SVG::load(assetPlugin(plugin, "res/dark/comp/TL1105_0.svg")));
-		addFrameAll(SVG::load(assetPlugin(plugin, "res/dark/comp/TL1105_1.svg")));	
+		addFrameAll(imAssets.pushButton[0][0]);
+		addFrameAll(imAssets.pushButton[0][1]);
+		addFrameAll(imAssets.pushButton[1][0]);
+		addFrameAll(imAssets.pushButton[1][1]);
 	}
 };
 
@@ -184,9 +267,9 @@ struct IMKnob : DynamicSVGKnob {
 
 struct IMBigKnob : IMKnob {
 	IMBigKnob() {
-		addFrameAll(SVG::load(assetPlugin(plugin, "res/light/comp/BlackKnobLargeWithMark.svg")));
-		addFrameAll(SVG::load(assetPlugin(plugin, "res/dark/comp/BlackKnobLargeWithMark.svg")));
-		addEffect(SVG::load(assetPlugin(plugin, "res/dark/comp/BlackKnobLargeWithMarkEffects.svg")));
+		addFrameAll(imAssets.bigKnob[0]);
+		addFrameAll(imAssets.bigKnob[1]);
+		addEffect(imAssets.bigKnobEffect);
 	}
 };
 struct IMBigSnapKnob : IMBigKnob {
@@ -199,9 +282,9 @@ struct IMBigSnapKnob : IMBigKnob {
 
 struct IMBigKnobInf : IMKnob {
 	IMBigKnobInf() {
-		addFrameAll(SVG::load(assetPlugin(plugin, "res/light/comp/BlackKnobLarge.svg")));
-		addFrameAll(SVG::load(assetPlugin(plugin, "res/dark/comp/BlackKnobLarge.svg")));
-		addEffect(SVG::load(assetPlugin(plugin, "res/dark/comp/BlackKnobLargeEffects.svg")));
+		addFrameAll(imAssets.bigKnobInf[0]);
+		addFrameAll(imAssets.bigKnobInf[1]);
+		addEffect(imAssets.bigKnobInfEffect);
 		speed = 0.9f;				
 		//smooth = false;
 	}
@@ -209,9 +292,9 @@ struct IMBigKnobInf : IMKnob {
 
 struct IMSmallKnob : IMKnob {
 	IMSmallKnob() {
-		addFrameAll(SVG::load(assetPlugin(plugin, "res/light/comp/RoundSmallBlackKnob.svg")));
-		addFrameAll(SVG::load(assetPlugin(plugin, "res/dark/comp/RoundSmallBlackKnob.svg")));
-		addEffect(SVG::load(assetPlugin(plugin, "res/dark/comp/RoundSmallBlackKnobEffects.svg")));		
+		addFrameAll(imAssets.smallKnob[0]);
+		addFrameAll(imAssets.smallKnob[1]);
+		addEffect(imAssets.smallKnobEffect);
 		shadow->box.pos = Vec(0.0, box.size.y * 0.15);
 	}
 };
@@ -225,9 +308,9 @@ struct IMSmallSnapKnob : IMSmallKnob {
 
 struct IMMediumKnobInf : IMKnob {
 	IMMediumKnobInf() {
-		addFrameAll(SVG::load(assetPlugin(plugin, "res/light/comp/RoundMediumBlackKnobNoMark.svg")));
-		addFrameAll(SVG::load(assetPlugin(plugin, "res/dark/comp/RoundMediumBlackKnobNoMark.svg")));
-		addEffect(SVG::load(assetPlugin(plugin, "res/dark/comp/RoundMediumBlackKnobNoMarkEffects.svg")));
+		addFrameAll(imAssets.mediumKnobInf[0]);
+		addFrameAll(imAssets.mediumKnobInf[1]);
+		addEffect(imAssets.mediumKnobInfEffect);
 		shadow->box.pos = Vec(0.0, box.size.y * 0.15);
 		speed = 0.9f;				
 		//smooth = false;
@@ -327,6 +410,29 @@ struct ScrewHole : TransparentWidget {
 	void draw(NVGcontext *vg) override;
 };	
 
+struct CachedDisplayWidget : FramebufferWidget {// segment display that is drawn into a framebuffer, and drawn again only when its text changes
+	// printContent() is called every frame and must put everything that changes the look of the display in displayStr and displayFlags
+	//   (for example an overlay char or a color), drawContent() then draws from those; displayStr can hold more than one string
+	static const int MAX_TEXT = 32;
+	char displayStr[MAX_TEXT];
+	int displayFlags;
+	char shownStr[MAX_TEXT];// what the framebuffer holds
+	int shownFlags;
+	std::shared_ptr<Font> font;
+
+	struct ContentWidget : TransparentWidget {
+		CachedDisplayWidget *display;
+		void draw(NVGcontext *vg) override {display->drawContent(vg);}
+	};
+	ContentWidget *content;
+	
+	CachedDisplayWidget();
+	void step() override;
+	inline int getFontHandle(NVGcontext *vg) {return vg == gFramebufferVg ? imAssets.getFramebufferFont() : font->handle;}// NanoVG fonts are per context
+	virtual void printContent() = 0;
+	virtual void drawContent(NVGcontext *vg) = 0;
+};
+
 
 
 // Other
@@ -360,6 +466,45 @@ struct Trigger : SchmittTrigger {
 	}	
 };	
 
+struct ClockInput : Trigger {
+	// clock input front end: a Trigger that also places each rising edge within its sample (by interpolating the 1.0V crossing)
+	//   and measures the clock period from edge to edge, filtered so that slides don't follow the jitter of each interval
+	// process() must be called once per sample while the clock is being followed, the period is in samples
+	float lastIn = 0.0f;
+	unsigned long samplesSinceEdge = 0ul;
+	float edgeOffset = 0.0f;// [0.0f : 1.0f), how long before the sample of the last edge the crossing happened, in samples
+	float lastInterval = 0.0f;// last raw edge to edge interval
+	float period = 0.0f;// filtered interval, 0.0f until the first edge after a reset
+	
+	void reset() {
+		Trigger::reset();
+		samplesSinceEdge = 0ul;
+		edgeOffset = 0.0f;
+		lastInterval = 0.0f;
+		period = 0.0f;
+	}
+	
+	bool process(float in) {
+		samplesSinceEdge++;
+		bool edge = Trigger::process(in);
+		if (edge) {
+			float offset = (in > lastIn && lastIn < 1.0f) ? clamp((in - 1.0f) / (in - lastIn), 0.0f, 0.999f) : 0.0f;
+			lastInterval = (float)samplesSinceEdge - offset + edgeOffset;
+			if (period == 0.0f || lastInterval >= period * 1.5f || lastInterval * 1.5f <= period)// first interval or tempo change (symmetric, so that halving and doubling are both caught)
+				period = lastInterval;
+			else
+				period += (lastInterval - period) * 0.125f;
+			edgeOffset = offset;
+			samplesSinceEdge = 0ul;
+		}
+		lastIn = in;
+		return edge;
+	}
+	
+	inline float getPeriod() {return period;}
+	inline float getEdgeOffset() {return edgeOffset;}
+};
+
 struct HoldDetect {
 	long modeHoldDetect;// 0 when not detecting, downward counter when detecting
 	
@@ -387,6 +532,122 @@ struct HoldDetect {
 	}
 };
 
+struct RandomState {// xorshift64* generator owned by a sequencer, so that a copy of it gives the same draws (used for lookahead)
+	uint64_t state;
+
+	void seed(uint64_t seedValue) {
+		state = (seedValue != 0ull ? seedValue : 0x9E3779B97F4A7C15ull);// state must not be 0
+	}
+
+	uint32_t u32() {
+		state ^= state >> 12;
+		state ^= state << 25;
+		state ^= state >> 27;
+		return (uint32_t)((state * 0x2545F4914F6CDD1Dull) >> 32);
+	}
+
+	float uniform() {// [0.0, 1.0), same as randomUniform()
+		return (float)(u32() >> 8) * (1.0f / 16777216.0f);
+	}
+};
+
+struct LightState {// changed-only light writes for the light refresh in step()
+	// a light is only written when its new value differs from the one it holds (i.e. from the previous refresh),
+	// or while it is still fading with setBrightnessSmooth(); with IM_TIMING, the writes and skips are counted (see IM_LOG_LIGHTS below)
+	std::vector<Light> *lights;
+#if IM_TIMING
+	unsigned long numWritten;
+	unsigned long numSkipped;
+#endif
+	
+	void init(std::vector<Light> *_lights) {
+		lights = _lights;
+#if IM_TIMING
+		numWritten = 0ul;
+		numSkipped = 0ul;
+#endif
+	}
+	
+	void set(int lightId, float value) {// same as lights[lightId].value = value
+		Light *light = &(*lights)[lightId];
+		bool changed = (light->value != value);
+		if (changed)
+			light->value = value;
+#if IM_TIMING
+		count(changed);
+#endif
+	}
+	
+	void setBrightness(int lightId, float brightness) {// same as lights[lightId].setBrightness(brightness)
+		set(lightId, brightness > 0.0f ? brightness * brightness : 0.0f);
+	}
+	
+	void setBrightnessSmooth(int lightId, float brightness, float frames = 1.0f) {// same as lights[lightId].setBrightnessSmooth(brightness, frames)
+		Light *light = &(*lights)[lightId];
+		float target = brightness > 0.0f ? brightness * brightness : 0.0f;
+		bool changed = (light->value != target);
+		if (changed) {
+			light->setBrightnessSmooth(brightness, frames);
+			if (fabsf(light->value - target) < 1e-4f)
+				light->value = target;// fade is done, so that the light is skipped from now on
+		}
+#if IM_TIMING
+		count(changed);
+#endif
+	}
+	
+#if IM_TIMING
+	void count(bool written) {
+		if (written)
+			numWritten++;
+		else
+			numSkipped++;
+	}
+	
+	void logCounts(const char* modelName) {// counts are written by the engine thread, the totals logged by the ui thread can be a refresh behind
+		unsigned long written = numWritten;
+		unsigned long skipped = numSkipped;
+		info("Impromptu lights: %s %lu written, %lu skipped (%.1f%% skipped)", modelName, written, skipped,
+			(written + skipped) == 0ul ? 0.0 : 100.0 * (double)skipped / (double)(written + skipped));
+	}
+#endif
+};
+
+#if IM_TIMING
+#define IM_LOG_LIGHTS(modelName, lightState) lightState.logCounts(modelName)// in toJson(), with the timing log
+#else
+#define IM_LOG_LIGHTS(modelName, lightState)
+#endif
+
+template <typename T>
+struct SeqLock {// a small struct (T must be trivially copyable) written by the engine thread and read by the UI thread without locking
+	// the writer makes the sequence number odd while it writes, the reader retries when the number was odd or changed during its copy
+	std::atomic<unsigned int> sequence;
+	T data;
+	
+	SeqLock() : sequence(0u) {}
+	
+	void write(const T &value) {// single writer: the engine thread, or the module's constructor before the module is in the engine
+		sequence.fetch_add(1u, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+		data = value;
+		sequence.fetch_add(1u, std::memory_order_release);
+	}
+	
+	bool read(T *value) {// returns false when no consistent copy could be made, *value is then not to be trusted and should be read again next frame
+		for (int tries = 0; tries < 4; tries++) {
+			unsigned int seqNum = sequence.load(std::memory_order_acquire);
+			if ((seqNum & 0x1) != 0)
+				continue;
+			*value = data;
+			std::atomic_thread_fence(std::memory_order_acquire);
+			if (sequence.load(std::memory_order_relaxed) == seqNum)
+				return true;
+		}
+		return false;
+	}
+};
+
 inline bool calcWarningFlash(long count, long countInit) {
 	if ( (count > (countInit * 2l / 4l) && count < (countInit * 3l / 4l)) || (count < (countInit * 1l / 4l)) )
 		return false;
@@ -396,6 +657,7 @@ inline bool calcWarningFlash(long count, long countInit) {
 
 
 NVGcolor prepareDisplay(NVGcontext *vg, Rect *box, int fontSize);
+void drawGhostedTexts(NVGcontext *vg, NVGcolor textColor, const char* ghost, const float* posX, float posY, const char* texts, int textStride, int numTexts);
 void printNote(float cvVal, char* text, bool sharp);
 int moveIndex(int index, int indexNext, int numSteps);
 
@@ -12,7 +12,7 @@
 //***********************************************************************************************
 
 
-#include "PhraseSeqUtil.hpp"
+#include "PhraseSeqKernel.hpp"
 
 
 struct PhraseSeq16 : Module {
@@ -122,20 +122,15 @@ struct PhraseSeq16 : Module {
 	bool attached;
 
 	// No need to save
+	PhraseSeqKernel<16, 1> psk;// run engine (clock, run modes, phrases, slides and gates)
 	int stepIndexEdit;
-	int stepIndexRun;
 	int phraseIndexEdit;
-	int phraseIndexRun;
 	long infoCopyPaste;// 0 when no info, positive downward step counter timer when copy, negative upward when paste
 	unsigned long editingGate;// 0 when no edit gate, downward step counter timer when edit gate
 	float editingGateCV;// no need to initialize, this is a companion to editingGate (output this only when editingGate > 0)
 	int editingGateKeyLight;// no need to initialize, this is a companion to editingGate (use this only when editingGate > 0)
 	unsigned long editingType;// similar to editingGate, but just for showing remanent gate type (nothing played); uses editingGateKeyLight
-	unsigned long stepIndexRunHistory;
-	unsigned long phraseIndexRunHistory;
 	int displayState;
-	unsigned long slideStepsRemain;// 0 when no slide under way, downward step counter when sliding
-	float slideCVdelta;// no need to initialize, this is a companion to slideStepsRemain
 	float cvCPbuffer[16];// copy paste buffer for CVs
 	StepAttributes attribCPbuffer[16];
 	SeqAttributes seqAttribCPbuffer;
@@ -144,26 +139,38 @@ struct PhraseSeq16 : Module {
 	int countCP;// number of steps to paste (in case CPMODE_PARAM changes between copy and paste)
 	int startCP;
 	long clockIgnoreOnReset;
-	unsigned long clockPeriod;// counts number of step() calls upward from last clock (reset after clock processed)
 	long tiedWarning;// 0 when no warning, positive downward step counter timer when warning
 	long attachedWarning;// 0 when no warning, positive downward step counter timer when warning
-	int gate1Code;
-	int gate2Code;
 	long revertDisplay;
 	long editingGateLength;// 0 when no info, positive when gate1, negative when gate2
 	long lastGateEdit;
 	long editingPpqn;// 0 when no info, positive downward step counter timer when editing ppqn
-	int ppqnCount;
 
 	
 	unsigned int lightRefreshCounter = 0;
+	LightState lightState;
+	struct DisplaySnapshot {// what the display shows, published in the light refresh so that the widget doesn't read the live sequencer
+		bool editingSequence;
+		long infoCopyPaste;
+		bool seqCopied;
+		float cpMode;
+		bool editingPpqn;
+		int pulsesPerStep;
+		int displayState;
+		int runMode;// of the sequence being edited, or of the song
+		int length;// of the sequence being edited, or number of phrases in the song
+		int transpose;
+		int rotate;
+		int seqNum;// sequence being edited, or sequence of the phrase being edited
+	};
+	SeqLock<DisplaySnapshot> displaySnapshot;
 	float resetLight = 0.0f;
 	int sequenceKnob = 0;
 	Trigger resetTrigger;
 	Trigger leftTrigger;
 	Trigger rightTrigger;
 	Trigger runningTrigger;
-	Trigger clockTrigger;
+	ClockInput clockTrigger;
 	Trigger octTriggers[7];
 	Trigger octmTrigger;
 	Trigger gate1Trigger;
@@ -190,11 +197,15 @@ struct PhraseSeq16 : Module {
 	
 	
 	PhraseSeq16() : Module(NUM_PARAMS, NUM_INPUTS, NUM_OUTPUTS, NUM_LIGHTS) {
+		lightState.init(&lights);
+		psk.construct(cv, attributes, sequences, phrase, &phrases, &runModeSong, &pulsesPerStep, nullptr, nullptr);
 		onReset();
+		publishDisplaySnapshot();
 	}
 	
 
 	void onReset() override {
+		IM_TIME_SCOPE("PhraseSeq16", TIMING_RESET);
 		autoseq = false;
 		autostepLen = false;
 		holdTiedNotes = true;
@@ -226,9 +237,8 @@ struct PhraseSeq16 : Module {
 		editingType = 0ul;
 		infoCopyPaste = 0l;
 		displayState = DISP_NORMAL;
-		slideStepsRemain = 0ul;
 		attached = false;
-		clockPeriod = 0ul;
+		psk.initClockPeriod();
 		tiedWarning = 0ul;
 		attachedWarning = 0l;
 		revertDisplay = 0l;
@@ -255,21 +265,13 @@ struct PhraseSeq16 : Module {
 	
 	
 	void initRun() {// run button activated or run edge in run input jack
-		phraseIndexRun = (runModeSong == MODE_REV ? phrases - 1 : 0);
-		phraseIndexRunHistory = 0;
-
-		int seq = (isEditingSequence() ? seqIndexEdit : phrase[phraseIndexRun]);
-		stepIndexRun = (sequences[seq].getRunMode() == MODE_REV ? sequences[seq].getLength() - 1 : 0);
-		stepIndexRunHistory = 0;
-
-		ppqnCount = 0;
-		gate1Code = calcGate1Code(attributes[seq][stepIndexRun], 0, pulsesPerStep, params[GATE1_KNOB_PARAM].value);
-		gate2Code = calcGate2Code(attributes[seq][stepIndexRun], 0, pulsesPerStep);
-		slideStepsRemain = 0ul;
+		psk.initRun(isEditingSequence(), seqIndexEdit, params[GATE1_KNOB_PARAM].value);
 	}
 	
 	
 	json_t *toJson() override {
+		IM_TIME_SCOPE("PhraseSeq16", TIMING_TOJSON);
+		IM_LOG_LIGHTS("PhraseSeq16", lightState);
 		json_t *rootJ = json_object();
 
 		// panelTheme
@@ -349,6 +351,7 @@ struct PhraseSeq16 : Module {
 	}
 
 	void fromJson(json_t *rootJ) override {
+		IM_TIME_SCOPE("PhraseSeq16", TIMING_FROMJSON);
 		// panelTheme
 		json_t *panelThemeJ = json_object_get(rootJ, "panelTheme");
 		if (panelThemeJ)
@@ -505,6 +508,7 @@ struct PhraseSeq16 : Module {
 				if (phraseArrayJ)
 					phrase[i] = json_integer_value(phraseArrayJ);
 			}
+		psk.invalidateSeqRun();
 			
 		// phrases
 		json_t *phrasesJ = json_object_get(rootJ, "phrases");
@@ -694,9 +698,9 @@ struct PhraseSeq16 : Module {
 			}
 			if (running && attached) {
 				if (editingSequence)
-					stepIndexEdit = stepIndexRun;
+					stepIndexEdit = psk.getStepIndexRun(0);
 				else
-					phraseIndexEdit = phraseIndexRun;
+					phraseIndexEdit = psk.getPhraseIndexRun();
 			}
 			
 			// Copy button
@@ -798,6 +802,7 @@ struct PhraseSeq16 : Module {
 							countCP = 16;
 							infoCopyPaste *= 2l;
 						}					
+						psk.invalidateSeqRun();
 					}
 					displayState = DISP_NORMAL;
 				}
@@ -853,7 +858,7 @@ struct PhraseSeq16 : Module {
 					else {
 						phraseIndexEdit = moveIndex(phraseIndexEdit, phraseIndexEdit + delta, 16);
 						if (!running)
-							phraseIndexRun = phraseIndexEdit;
+							psk.setPhraseIndexRun(phraseIndexEdit);
 					}
 				}
 			}
@@ -885,7 +890,7 @@ struct PhraseSeq16 : Module {
 						else {
 							phraseIndexEdit = stepPressed;
 							if (!running)
-								phraseIndexRun = phraseIndexEdit;
+								psk.setPhraseIndexRun(phraseIndexEdit);
 						}
 					}
 					else if (attached)
@@ -994,8 +999,10 @@ struct PhraseSeq16 : Module {
 							}
 						}
 						else {
-							if (!attached || (attached && !running))
+							if (!attached || (attached && !running)) {
 								phrase[phraseIndexEdit] = clamp(phrase[phraseIndexEdit] + deltaKnob, 0, 16 - 1);
+								psk.invalidateSeqRun();
+							}
 							else
 								attachedWarning = (long) (warningTime * sampleRate / displayRefreshStepSkips);
 							
@@ -1134,47 +1141,9 @@ struct PhraseSeq16 : Module {
 		// Clock
 		if (running && clockIgnoreOnReset == 0l) {
 			if (clockTrigger.process(inputs[CLOCK_INPUT].value)) {
-				ppqnCount++;
-				if (ppqnCount >= pulsesPerStep)
-					ppqnCount = 0;
-
-				int newSeq = seqIndexEdit;// good value when editingSequence, overwrite if not editingSequence
-				if (ppqnCount == 0) {
-					float slideFromCV = 0.0f;
-					if (editingSequence) {
-						slideFromCV = cv[seqIndexEdit][stepIndexRun];
-						moveIndexRunMode(&stepIndexRun, sequences[seqIndexEdit].getLength(), sequences[seqIndexEdit].getRunMode(), &stepIndexRunHistory);
-					}
-					else {
-						slideFromCV = cv[phrase[phraseIndexRun]][stepIndexRun];
-						if (moveIndexRunMode(&stepIndexRun, sequences[phrase[phraseIndexRun]].getLength(), sequences[phrase[phraseIndexRun]].getRunMode(), &stepIndexRunHistory)) {
-							moveIndexRunMode(&phraseIndexRun, phrases, runModeSong, &phraseIndexRunHistory);
-							stepIndexRun = (sequences[phrase[phraseIndexRun]].getRunMode() == MODE_REV ? sequences[phrase[phraseIndexRun]].getLength() - 1 : 0);// must always refresh after phraseIndexRun has changed
-						}
-						newSeq = phrase[phraseIndexRun];
-					}
-					
-					// Slide
-					if (attributes[newSeq][stepIndexRun].getSlide()) {
-						slideStepsRemain =   (unsigned long) (((float)clockPeriod * pulsesPerStep) * params[SLIDE_KNOB_PARAM].value / 2.0f);
-						if (slideStepsRemain != 0ul) {
-							float slideToCV = cv[newSeq][stepIndexRun];
-							slideCVdelta = (slideToCV - slideFromCV)/(float)slideStepsRemain;
-						}
-					}
-					else
-						slideStepsRemain = 0ul;
-				}
-				else {
-					if (!editingSequence)
-						newSeq = phrase[phraseIndexRun];
-				}
-				if (gate1Code != -1 || ppqnCount == 0)
-					gate1Code = calcGate1Code(attributes[newSeq][stepIndexRun], ppqnCount, pulsesPerStep, params[GATE1_KNOB_PARAM].value);
-				gate2Code = calcGate2Code(attributes[newSeq][stepIndexRun], ppqnCount, pulsesPerStep);
-				clockPeriod = 0ul;				
+				psk.clockStep(editingSequence, seqIndexEdit, params[GATE1_KNOB_PARAM].value, params[SLIDE_KNOB_PARAM].value, clockTrigger.getPeriod());
 			}
-			clockPeriod++;
+			psk.step();
 		}	
 		
 		// Reset
@@ -1187,29 +1156,28 @@ struct PhraseSeq16 : Module {
 			if (inputs[SEQCV_INPUT].active && seqCVmethod == 2)
 				seqIndexEdit = 0;
 		}
+		psk.publishPendingRun();// run state changes from the reset, the ui thread and the phrase edits, for lookahead()
 		
 		
 		//********** Outputs and lights **********
 				
 		// CV and gates outputs
-		int seq = editingSequence ? (seqIndexEdit) : (running ? phrase[phraseIndexRun] : phrase[phraseIndexEdit]);
-		int step = editingSequence ? (running ? stepIndexRun : stepIndexEdit) : (stepIndexRun);
+		int seq = running ? psk.getSeqRun(editingSequence, seqIndexEdit) : (editingSequence ? seqIndexEdit : phrase[phraseIndexEdit]);
+		int step = editingSequence ? (running ? psk.getStepIndexRun(0) : stepIndexEdit) : (psk.getStepIndexRun(0));
 		if (running) {
 			bool muteGate1 = !editingSequence && ((params[GATE1_PARAM].value + inputs[GATE1CV_INPUT].value) > 0.5f);// live mute
 			bool muteGate2 = !editingSequence && ((params[GATE2_PARAM].value + inputs[GATE2CV_INPUT].value) > 0.5f);// live mute
-			float slideOffset = (slideStepsRemain > 0ul ? (slideCVdelta * (float)slideStepsRemain) : 0.0f);
-			outputs[CV_OUTPUT].value = cv[seq][step] - slideOffset;
+			outputs[CV_OUTPUT].value = cv[seq][step] - psk.calcSlideOffset(0);
 			bool retriggingOnReset = (clockIgnoreOnReset != 0l && retrigGatesOnReset);
-			outputs[GATE1_OUTPUT].value = (calcGate(gate1Code, clockTrigger, clockPeriod, sampleRate) && !muteGate1 && !retriggingOnReset) ? 10.0f : 0.0f;
-			outputs[GATE2_OUTPUT].value = (calcGate(gate2Code, clockTrigger, clockPeriod, sampleRate) && !muteGate2 && !retriggingOnReset) ? 10.0f : 0.0f;
+			outputs[GATE1_OUTPUT].value = (psk.calcGate1(0, clockTrigger, sampleRate) && !muteGate1 && !retriggingOnReset) ? 10.0f : 0.0f;
+			outputs[GATE2_OUTPUT].value = (psk.calcGate2(0, clockTrigger, sampleRate) && !muteGate2 && !retriggingOnReset) ? 10.0f : 0.0f;
 		}
 		else {// not running
 			outputs[CV_OUTPUT].value = (editingGate > 0ul) ? editingGateCV : cv[seq][step];
 			outputs[GATE1_OUTPUT].value = (editingGate > 0ul) ? 10.0f : 0.0f;
 			outputs[GATE2_OUTPUT].value = (editingGate > 0ul) ? 10.0f : 0.0f;
 		}
-		if (slideStepsRemain > 0ul)
-			slideStepsRemain--;
+		psk.decSlideStepsRemain();
 		
 		lightRefreshCounter++;
 		if (lightRefreshCounter >= displayRefreshStepSkips) {
@@ -1247,10 +1215,10 @@ struct PhraseSeq16 : Module {
 				else {// normal led display (i.e. not length)
 					// Run cursor (green)
 					if (editingSequence)
-						green = ((running && (i == stepIndexRun)) ? 1.0f : 0.0f);
+						green = ((running && (i == psk.getStepIndexRun(0))) ? 1.0f : 0.0f);
 					else {
-						green = ((running && (i == phraseIndexRun)) ? 1.0f : 0.0f);
-						green += ((running && (i == stepIndexRun) && i != phraseIndexEdit) ? 0.1f : 0.0f);
+						green = ((running && (i == psk.getPhraseIndexRun())) ? 1.0f : 0.0f);
+						green += ((running && (i == psk.getStepIndexRun(0)) && i != phraseIndexEdit) ? 0.1f : 0.0f);
 						green = clamp(green, 0.0f, 1.0f);
 					}
 					// Edit cursor (red)
@@ -1262,14 +1230,14 @@ struct PhraseSeq16 : Module {
 					if (editingSequence)
 						gate = attributes[seqIndexEdit][i].getGate1();
 					else if (!editingSequence && (attached && running))
-						gate = attributes[phrase[phraseIndexRun]][i].getGate1();
+						gate = attributes[phrase[psk.getPhraseIndexRun()]][i].getGate1();
 					white = ((green == 0.0f && red == 0.0f && gate && displayState != DISP_MODE) ? 0.04f : 0.0f);
 					if (editingSequence && white != 0.0f) {
 						green = 0.02f; white = 0.0f;
 					}
 				}
 				setGreenRed(STEP_PHRASE_LIGHTS + i * 3, green, red);
-				lights[STEP_PHRASE_LIGHTS + i * 3 + 2].value = white;
+				lightState.set(STEP_PHRASE_LIGHTS + i * 3 + 2, white);
 			}
 		
 			// Octave lights
@@ -1277,20 +1245,20 @@ struct PhraseSeq16 : Module {
 			if (editingSequence)
 				octCV = cv[seqIndexEdit][stepIndexEdit];
 			else
-				octCV = cv[phrase[phraseIndexEdit]][stepIndexRun];
+				octCV = cv[phrase[phraseIndexEdit]][psk.getStepIndexRun(0)];
 			int octLightIndex = (int) floor(octCV + 3.0f);
 			for (int i = 0; i < 7; i++) {
 				if (!editingSequence && (!attached || !running))// no oct lights when song mode and either (detached [1] or stopped [2])
 												// [1] makes no sense, can't mod steps and stepping though seq that may not be playing
 												// [2] CV is set to 0V when not running and in song mode, so cv[][] makes no sense to display
-					lights[OCTAVE_LIGHTS + i].value = 0.0f;
+					lightState.set(OCTAVE_LIGHTS + i, 0.0f);
 				else {
 					if (tiedWarning > 0l) {
 						bool warningFlashState = calcWarningFlash(tiedWarning, (long) (warningTime * sampleRate / displayRefreshStepSkips));
-						lights[OCTAVE_LIGHTS + i].value = (warningFlashState && (i == (6 - octLightIndex))) ? 1.0f : 0.0f;
+						lightState.set(OCTAVE_LIGHTS + i, (warningFlashState && (i == (6 - octLightIndex))) ? 1.0f : 0.0f);
 					}
 					else				
-						lights[OCTAVE_LIGHTS + i].value = (i == (6 - octLightIndex) ? 1.0f : 0.0f);
+						lightState.set(OCTAVE_LIGHTS + i, (i == (6 - octLightIndex) ? 1.0f : 0.0f));
 				}
 			}
 			
@@ -1299,7 +1267,7 @@ struct PhraseSeq16 : Module {
 			if (editingSequence) 
 				cvValOffset = cv[seqIndexEdit][stepIndexEdit] + 10.0f;//to properly handle negative note voltages
 			else	
-				cvValOffset = cv[phrase[phraseIndexEdit]][stepIndexRun] + 10.0f;//to properly handle negative note voltages
+				cvValOffset = cv[phrase[phraseIndexEdit]][psk.getStepIndexRun(0)] + 10.0f;//to properly handle negative note voltages
 			int keyLightIndex = clamp( (int)((cvValOffset-floor(cvValOffset)) * 12.0f + 0.5f),  0,  11);
 			if (editingPpqn != 0) {
 				for (int i = 0; i < 12; i++) {
@@ -1336,28 +1304,28 @@ struct PhraseSeq16 : Module {
 			}
 			else {
 				for (int i = 0; i < 12; i++) {
-					lights[KEY_LIGHTS + i * 2 + 0].value = 0.0f;
+					lightState.set(KEY_LIGHTS + i * 2 + 0, 0.0f);
 					if (!editingSequence && (!attached || !running))// no keyboard lights when song mode and either (detached [1] or stopped [2])
 													// [1] makes no sense, can't mod steps and stepping though seq that may not be playing
 													// [2] CV is set to 0V when not running and in song mode, so cv[][] makes no sense to display
-						lights[KEY_LIGHTS + i * 2 + 1].value = 0.0f;
+						lightState.set(KEY_LIGHTS + i * 2 + 1, 0.0f);
 					else {
 						if (tiedWarning > 0l) {
 							bool warningFlashState = calcWarningFlash(tiedWarning, (long) (warningTime * sampleRate / displayRefreshStepSkips));
-							lights[KEY_LIGHTS + i * 2 + 1].value = (warningFlashState && i == keyLightIndex) ? 1.0f : 0.0f;
+							lightState.set(KEY_LIGHTS + i * 2 + 1, (warningFlashState && i == keyLightIndex) ? 1.0f : 0.0f);
 						}
 						else {
 							if (editingGate > 0ul && editingGateKeyLight != -1)
-								lights[KEY_LIGHTS + i * 2 + 1].value = (i == editingGateKeyLight ? ((float) editingGate / (float)(gateTime * sampleRate / displayRefreshStepSkips)) : 0.0f);
+								lightState.set(KEY_LIGHTS + i * 2 + 1, (i == editingGateKeyLight ? ((float) editingGate / (float)(gateTime * sampleRate / displayRefreshStepSkips)) : 0.0f));
 							else
-								lights[KEY_LIGHTS + i * 2 + 1].value = (i == keyLightIndex ? 1.0f : 0.0f);
+								lightState.set(KEY_LIGHTS + i * 2 + 1, (i == keyLightIndex ? 1.0f : 0.0f));
 						}
 					}
 				}	
 			}			
 			
 			// Key mode light (note or gate type)
-			lights[KEYNOTE_LIGHT].value = editingGateLength == 0l ? 10.0f : 0.0f;
+			lightState.set(KEYNOTE_LIGHT, editingGateLength == 0l ? 10.0f : 0.0f);
 			if (editingGateLength == 0l)
 				setGreenRed(KEYGATE_LIGHT, 0.0f, 0.0f);
 			else if (editingGateLength > 0l)
@@ -1372,40 +1340,40 @@ struct PhraseSeq16 : Module {
 				setGateLight(false, GATE1_LIGHT);
 				setGateLight(false, GATE2_LIGHT);
 				setGreenRed(GATE1_PROB_LIGHT, 0.0f, 0.0f);
-				lights[SLIDE_LIGHT].value = 0.0f;
-				lights[TIE_LIGHT].value = 0.0f;
+				lightState.set(SLIDE_LIGHT, 0.0f);
+				lightState.set(TIE_LIGHT, 0.0f);
 			}
 			else {
 				StepAttributes attributesVal = attributes[seqIndexEdit][stepIndexEdit];
 				if (!editingSequence)
-					attributesVal = attributes[phrase[phraseIndexEdit]][stepIndexRun];
+					attributesVal = attributes[phrase[phraseIndexEdit]][psk.getStepIndexRun(0)];
 				//
 				setGateLight(attributesVal.getGate1(), GATE1_LIGHT);
 				setGateLight(attributesVal.getGate2(), GATE2_LIGHT);
 				setGreenRed(GATE1_PROB_LIGHT, attributesVal.getGate1P() ? 1.0f : 0.0f, attributesVal.getGate1P() ? 1.0f : 0.0f);
-				lights[SLIDE_LIGHT].value = attributesVal.getSlide() ? 1.0f : 0.0f;
+				lightState.set(SLIDE_LIGHT, attributesVal.getSlide() ? 1.0f : 0.0f);
 				if (tiedWarning > 0l) {
 					bool warningFlashState = calcWarningFlash(tiedWarning, (long) (warningTime * sampleRate / displayRefreshStepSkips));
-					lights[TIE_LIGHT].value = (warningFlashState) ? 1.0f : 0.0f;
+					lightState.set(TIE_LIGHT, (warningFlashState) ? 1.0f : 0.0f);
 				}
 				else
-					lights[TIE_LIGHT].value = attributesVal.getTied() ? 1.0f : 0.0f;
+					lightState.set(TIE_LIGHT, attributesVal.getTied() ? 1.0f : 0.0f);
 			}
 			
 			// Attach light
 			if (attachedWarning > 0l) {
 				bool warningFlashState = calcWarningFlash(attachedWarning, (long) (warningTime * sampleRate / displayRefreshStepSkips));
-				lights[ATTACH_LIGHT].value = (warningFlashState) ? 1.0f : 0.0f;
+				lightState.set(ATTACH_LIGHT, (warningFlashState) ? 1.0f : 0.0f);
 			}
 			else
-				lights[ATTACH_LIGHT].value = (attached ? 1.0f : 0.0f);
+				lightState.set(ATTACH_LIGHT, (attached ? 1.0f : 0.0f));
 			
 			// Reset light
-			lights[RESET_LIGHT].value =	resetLight;	
+			lightState.set(RESET_LIGHT, resetLight);	
 			resetLight -= (resetLight / lightLambda) * engineGetSampleTime() * displayRefreshStepSkips;
 			
 			// Run light
-			lights[RUN_LIGHT].value = running ? 1.0f : 0.0f;
+			lightState.set(RUN_LIGHT, running ? 1.0f : 0.0f);
 			
 			if (editingGate > 0ul)
 				editingGate--;
@@ -1432,6 +1400,8 @@ struct PhraseSeq16 : Module {
 					displayState = DISP_NORMAL;
 				revertDisplay--;
 			}
+			
+			publishDisplaySnapshot();
 		}// lightRefreshCounter
 		
 		if (clockIgnoreOnReset > 0l)
@@ -1440,9 +1410,27 @@ struct PhraseSeq16 : Module {
 	}// step()
 	
 
+	void publishDisplaySnapshot() {
+		DisplaySnapshot snap;
+		snap.editingSequence = isEditingSequence();
+		snap.infoCopyPaste = infoCopyPaste;
+		snap.seqCopied = seqCopied;
+		snap.cpMode = params[CPMODE_PARAM].value;
+		snap.editingPpqn = editingPpqn != 0ul;
+		snap.pulsesPerStep = pulsesPerStep;
+		snap.displayState = displayState;
+		snap.runMode = snap.editingSequence ? sequences[seqIndexEdit].getRunMode() : runModeSong;
+		snap.length = snap.editingSequence ? sequences[seqIndexEdit].getLength() : phrases;
+		snap.transpose = sequences[seqIndexEdit].getTranspose();
+		snap.rotate = sequences[seqIndexEdit].getRotate();
+		snap.seqNum = snap.editingSequence ? seqIndexEdit : phrase[phraseIndexEdit];
+		displaySnapshot.write(snap);
+	}
+	
+
 	inline void setGreenRed(int id, float green, float red) {
-		lights[id + 0].value = green;
-		lights[id + 1].value = red;
+		lightState.set(id + 0, green);
+		lightState.set(id + 1, red);
 	}
 
 	inline void propagateCVtoTied(int seqn, int stepn) {
@@ -1488,16 +1476,16 @@ struct PhraseSeq16 : Module {
 	
 	inline void setGateLight(bool gateOn, int lightIndex) {
 		if (!gateOn) {
-			lights[lightIndex + 0].value = 0.0f;
-			lights[lightIndex + 1].value = 0.0f;
+			lightState.set(lightIndex + 0, 0.0f);
+			lightState.set(lightIndex + 1, 0.0f);
 		}
 		else if (editingGateLength == 0l) {
-			lights[lightIndex + 0].value = 0.0f;
-			lights[lightIndex + 1].value = 1.0f;
+			lightState.set(lightIndex + 0, 0.0f);
+			lightState.set(lightIndex + 1, 1.0f);
 		}
 		else {
-			lights[lightIndex + 0].value = lightIndex == GATE1_LIGHT ? 1.0f : 0.2f;
-			lights[lightIndex + 1].value = lightIndex == GATE1_LIGHT ? 0.2f : 1.0f;
+			lightState.set(lightIndex + 0, lightIndex == GATE1_LIGHT ? 1.0f : 0.2f);
+			lightState.set(lightIndex + 1, lightIndex == GATE1_LIGHT ? 0.2f : 1.0f);
 		}
 	}
 	
@@ -1512,35 +1500,25 @@ struct PhraseSeq16Widget : ModuleWidget {
 	int expWidth = 60;
 	IMPort* expPorts[5];
 
-	struct SequenceDisplayWidget : TransparentWidget {
+	struct SequenceDisplayWidget : CachedDisplayWidget {
 		PhraseSeq16 *module;
-		std::shared_ptr<Font> font;
-		char displayStr[4];
-		
-		SequenceDisplayWidget() {
-			font = Font::load(assetPlugin(plugin, "res/fonts/Segment14.ttf"));
-		}
+		PhraseSeq16::DisplaySnapshot snap;// copy of the module's display snapshot, printContent() reads this instead of the module
 		
 		void runModeToStr(int num) {
 			if (num >= 0 && num < (NUM_MODES - 1))
 				snprintf(displayStr, 4, "%s", modeLabels[num].c_str());
 		}
 
-		void draw(NVGcontext *vg) override {
-			NVGcolor textColor = prepareDisplay(vg, &box, 18);
-			nvgFontFaceId(vg, font->handle);
-			bool editingSequence = module->isEditingSequence();
-
-			Vec textPos = Vec(6, 24);
-			nvgFillColor(vg, nvgTransRGBA(textColor, displayAlpha));
-			nvgText(vg, textPos.x, textPos.y, "~~~", NULL);
-			nvgFillColor(vg, textColor);
-			if (module->infoCopyPaste != 0l) {
-				if (module->infoCopyPaste > 0l)
+		void printContent() override {
+			if (!module->displaySnapshot.read(&snap))
+				return;// keep what is shown, a consistent snapshot will be read next frame
+			bool editingSequence = snap.editingSequence;
+			if (snap.infoCopyPaste != 0l) {
+				if (snap.infoCopyPaste > 0l)
 					snprintf(displayStr, 4, "CPY");
 				else {
-					float cpMode = module->params[PhraseSeq16::CPMODE_PARAM].value;
-					if (editingSequence && !module->seqCopied) {// cross paste to seq
+					float cpMode = snap.cpMode;
+					if (editingSequence && !snap.seqCopied) {// cross paste to seq
 						if (cpMode > 1.5f)// All = toggle gate 1
 							snprintf(displayStr, 4, "TG1");
 						else if (cpMode < 0.5f)// 4 = random CV
@@ -1548,7 +1526,7 @@ struct PhraseSeq16Widget : ModuleWidget {
 						else// 8 = random gate 1
 							snprintf(displayStr, 4, "RG1");
 					}
-					else if (!editingSequence && module->seqCopied) {// cross paste to song
+					else if (!editingSequence && snap.seqCopied) {// cross paste to song
 						if (cpMode > 1.5f)// All = init
 							snprintf(displayStr, 4, "CLR");
 						else if (cpMode < 0.5f)// 4 = increase by 1
@@ -1560,35 +1538,38 @@ struct PhraseSeq16Widget : ModuleWidget {
 						snprintf(displayStr, 4, "PST");
 				}
 			}
-			else if (module->editingPpqn != 0ul) {
-				snprintf(displayStr, 4, "x%2u", (unsigned) module->pulsesPerStep);
+			else if (snap.editingPpqn) {
+				snprintf(displayStr, 4, "x%2u", (unsigned) snap.pulsesPerStep);
 			}
-			else if (module->displayState == PhraseSeq16::DISP_MODE) {
-				if (editingSequence)
-					runModeToStr(module->sequences[module->seqIndexEdit].getRunMode());
-				else
-					runModeToStr(module->runModeSong);
+			else if (snap.displayState == PhraseSeq16::DISP_MODE) {
+				runModeToStr(snap.runMode);// of the sequence or of the song
 			}
-			else if (module->displayState == PhraseSeq16::DISP_LENGTH) {
-				if (editingSequence)
-					snprintf(displayStr, 4, "L%2u", (unsigned) module->sequences[module->seqIndexEdit].getLength());
-				else
-					snprintf(displayStr, 4, "L%2u", (unsigned) module->phrases);
+			else if (snap.displayState == PhraseSeq16::DISP_LENGTH) {
+				snprintf(displayStr, 4, "L%2u", (unsigned) snap.length);// of the sequence or of the song
 			}
-			else if (module->displayState == PhraseSeq16::DISP_TRANSPOSE) {
-				snprintf(displayStr, 4, "+%2u", (unsigned) abs(module->sequences[module->seqIndexEdit].getTranspose()));
-				if (module->sequences[module->seqIndexEdit].getTranspose() < 0)
+			else if (snap.displayState == PhraseSeq16::DISP_TRANSPOSE) {
+				snprintf(displayStr, 4, "+%2u", (unsigned) abs(snap.transpose));
+				if (snap.transpose < 0)
 					displayStr[0] = '-';
 			}
-			else if (module->displayState == PhraseSeq16::DISP_ROTATE) {
-				snprintf(displayStr, 4, ")%2u", (unsigned) abs(module->sequences[module->seqIndexEdit].getRotate()));
-				if (module->sequences[module->seqIndexEdit].getRotate() < 0)
+			else if (snap.displayState == PhraseSeq16::DISP_ROTATE) {
+				snprintf(displayStr, 4, ")%2u", (unsigned) abs(snap.rotate));
+				if (snap.rotate < 0)
 					displayStr[0] = '(';
 			}
 			else {// DISP_NORMAL
-				snprintf(displayStr, 4, " %2u", (unsigned) (editingSequence ? 
-					module->seqIndexEdit : module->phrase[module->phraseIndexEdit]) + 1 );
+				snprintf(displayStr, 4, " %2u", (unsigned) snap.seqNum + 1 );
 			}
+		}
+
+		void drawContent(NVGcontext *vg) override {
+			NVGcolor textColor = prepareDisplay(vg, &box, 18);
+			nvgFontFaceId(vg, getFontHandle(vg));
+
+			Vec textPos = Vec(6, 24);
+			nvgFillColor(vg, nvgTransRGBA(textColor, displayAlpha));
+			nvgText(vg, textPos.x, textPos.y, "~~~", NULL);
+			nvgFillColor(vg, textColor);
 			nvgText(vg, textPos.x, textPos.y, displayStr, NULL);
 		}
 	};		
@@ -1767,6 +1748,7 @@ struct PhraseSeq16Widget : ModuleWidget {
 					}
 					else {
 						module->phrase[module->phraseIndexEdit] = 0;
+						module->psk.invalidateSeqRun();
 					}
 				}
 			}
@@ -1787,6 +1769,7 @@ struct PhraseSeq16Widget : ModuleWidget {
 	// }
 	
 	PhraseSeq16Widget(PhraseSeq16 *module) : ModuleWidget(module) {
+		IM_TIME_SCOPE("PhraseSeq16", TIMING_WIDGET);
 		this->module = module;
 		oldExpansion = -1;
 		
@@ -1801,12 +1784,12 @@ struct PhraseSeq16Widget : ModuleWidget {
         addChild(panel);		
 		
 		// Screws
-		addChild(createDynamicScrew<IMScrew>(Vec(15, 0), &module->panelTheme));
-		addChild(createDynamicScrew<IMScrew>(Vec(15, 365), &module->panelTheme));
-		addChild(createDynamicScrew<IMScrew>(Vec(panel->box.size.x-30, 0), &module->panelTheme));
-		addChild(createDynamicScrew<IMScrew>(Vec(panel->box.size.x-30, 365), &module->panelTheme));
-		addChild(createDynamicScrew<IMScrew>(Vec(panel->box.size.x-30-expWidth, 0), &module->panelTheme));
-		addChild(createDynamicScrew<IMScrew>(Vec(panel->box.size.x-30-expWidth, 365), &module->panelTheme));
+		panel->addChild(createDynamicScrew<IMScrew>(Vec(15, 0), &module->panelTheme));
+		panel->addChild(createDynamicScrew<IMScrew>(Vec(15, 365), &module->panelTheme));
+		panel->addChild(createDynamicScrew<IMScrew>(Vec(panel->box.size.x-30, 0), &module->panelTheme));
+		panel->addChild(createDynamicScrew<IMScrew>(Vec(panel->box.size.x-30, 365), &module->panelTheme));
+		panel->addChild(createDynamicScrew<IMScrew>(Vec(panel->box.size.x-30-expWidth, 0), &module->panelTheme));
+		panel->addChild(createDynamicScrew<IMScrew>(Vec(panel->box.size.x-30-expWidth, 365), &module->panelTheme));
 
 		
 		
@@ -2014,6 +1997,18 @@ Model *modelPhraseSeq16 = Model::create<PhraseSeq16, PhraseSeq16Widget>("Impromp
 
 /*CHANGE LOG
 
+0.6.17:
+move clock, run mode, phrase, slide and gate logic into shared PhraseSeqKernel (see PhraseSeqKernel.hpp)
+sequencer kernel can look ahead at the steps and phrases to come (random run modes and probabilities use the kernel's own generator)
+advanced gates come from the shared gate pattern table (AdvGateUtil), same gates as before for all pulses per step
+running sequence is cached in the kernel so that pulses and outputs don't look up the song each time
+slides use a filtered clock period measured by the new ClockInput front end (sub-sample edge position and period)
+segment displays are framebuffer cached and only redrawn when their text changes
+lights are written through LightState, so that only changed lights are written
+screws are drawn in the panel's framebuffer
+optional timing instrumentation (IM_TIMING)
+display reads a snapshot of the display state published at light refresh rate (SeqLock)
+
 0.6.16:
 add gate status feedback in steps (white lights)
 
@@ -12,7 +12,7 @@
 //***********************************************************************************************
 
 
-#include "PhraseSeqUtil.hpp"
+#include "PhraseSeqKernel.hpp"
 
 
 struct PhraseSeq32 : Module {
@@ -104,6 +104,7 @@ struct PhraseSeq32 : Module {
 	int pulsesPerStep;// 1 means normal gate mode, alt choices are 4, 6, 12, 24 PPS (Pulses per step)
 	bool running;
 	SeqAttributes sequences[32];
+	SeqAttributes sequencesB[32];// length and run mode of channel B in 2x16 config, channel B is in lockstep with channel A when they are the same as in sequences[]
 	int runModeSong;
 	int seqIndexEdit;
 	int phrase[32];// This is the song (series of phases; a phrase is a patten number)
@@ -114,52 +115,60 @@ struct PhraseSeq32 : Module {
 	bool attached;
 
 	// No need to save
+	PhraseSeqKernel<32, 2> psk;// run engine (clock, run modes, phrases, slides and gates)
 	int stepIndexEdit;
-	int stepIndexRun[2];
 	int phraseIndexEdit;
-	int phraseIndexRun;
 	long infoCopyPaste;// 0 when no info, positive downward step counter timer when copy, negative upward when paste
 	unsigned long editingGate;// 0 when no edit gate, downward step counter timer when edit gate
 	float editingGateCV;// no need to initialize, this is a companion to editingGate (output this only when editingGate > 0)
 	int editingGateKeyLight;// no need to initialize, this is a companion to editingGate (use this only when editingGate > 0)
 	int editingChannel;// 0 means channel A, 1 means channel B. no need to initialize, this is a companion to editingGate
 	unsigned long editingType;// similar to editingGate, but just for showing remanent gate type (nothing played); uses editingGateKeyLight
-	unsigned long stepIndexRunHistory;
-	unsigned long phraseIndexRunHistory;
 	int displayState;
-	unsigned long slideStepsRemain[2];// 0 when no slide under way, downward step counter when sliding
-	float slideCVdelta[2];// no need to initialize, this is a companion to slideStepsRemain
 	float cvCPbuffer[32];// copy paste buffer for CVs
 	StepAttributes attribCPbuffer[32];
 	SeqAttributes seqAttribCPbuffer;
+	SeqAttributes seqAttribCPbufferB;
 	bool seqCopied;
 	int phraseCPbuffer[32];
 	int countCP;// number of steps to paste (in case CPMODE_PARAM changes between copy and paste)
 	int startCP;
 	long clockIgnoreOnReset;
-	unsigned long clockPeriod;// counts number of step() calls upward from last clock (reset after clock processed)
 	long tiedWarning;// 0 when no warning, positive downward step counter timer when warning
 	long attachedWarning;// 0 when no warning, positive downward step counter timer when warning
-	int gate1Code[2];
-	int gate2Code[2];
 	bool attachedChanB;
 	long revertDisplay;
 	long editingGateLength;// 0 when no info, positive when gate1, negative when gate2
 	long lastGateEdit;
 	long editingPpqn;// 0 when no info, positive downward step counter timer when editing ppqn
-	int ppqnCount;
 	int stepConfig;
 	
 
 	int stepConfigSync = 0;// 0 means no sync requested, 1 means soft sync (no reset lengths), 2 means hard (reset lengths)
 	unsigned int lightRefreshCounter = 0;
+	LightState lightState;
+	struct DisplaySnapshot {// what the display shows, published in the light refresh so that the widget doesn't read the live sequencer
+		bool editingSequence;
+		long infoCopyPaste;
+		bool seqCopied;
+		float cpMode;
+		bool editingPpqn;
+		int pulsesPerStep;
+		int displayState;
+		int runMode;// of the sequence being edited, or of the song
+		int length;// of the sequence being edited, or number of phrases in the song
+		int transpose;
+		int rotate;
+		int seqNum;// sequence being edited, or sequence of the phrase being edited
+	};
+	SeqLock<DisplaySnapshot> displaySnapshot;
 	float resetLight = 0.0f;
 	int sequenceKnob = 0;
 	Trigger resetTrigger;
 	Trigger leftTrigger;
 	Trigger rightTrigger;
 	Trigger runningTrigger;
-	Trigger clockTrigger;
+	ClockInput clockTrigger;
 	Trigger octTriggers[7];
 	Trigger octmTrigger;
 	Trigger gate1Trigger;
@@ -181,20 +190,30 @@ struct PhraseSeq32 : Module {
 	Trigger seqCVTrigger;
 	HoldDetect modeHoldDetect;
 	SeqAttributes seqAttribBuffer[32];// buffer from Json for thread safety
+	SeqAttributes seqAttribBufferB[32];// buffer from Json for thread safety
 
 
 	inline bool isEditingSequence(void) {return params[EDIT_PARAM].value > 0.5f;}
 	inline int getStepConfig(float paramValue) {// 1 = 2x16 = 1.0f,  2 = 1x32 = 0.0f
 		return (paramValue > 0.5f) ? 1 : 2;
 	}
+	inline int getEditChan() {return (stepConfig == 1 && stepIndexEdit >= 16) ? 1 : 0;}// channel of the row where stepIndexEdit is located
+	inline SeqAttributes* getSeqAttribChan(int seq, int chan) {return (stepConfig == 1 && chan == 1) ? &sequencesB[seq] : &sequences[seq];}
+	inline bool isChanBLinked(int seq) {return sequencesB[seq].getLength() == sequences[seq].getLength() && sequencesB[seq].getRunMode() == sequences[seq].getRunMode();}
+	inline void setLengthChan(int seq, int chan, int length) {// a change to channel A also changes channel B when they are linked (lockstep)
+		if (stepConfig != 1 || chan == 0 || isChanBLinked(seq))
+			sequencesB[seq].setLength(length);
+		if (stepConfig != 1 || chan == 0)
+			sequences[seq].setLength(length);
+	}
+	inline void setRunModeChan(int seq, int chan, int runMode) {// same linking as setLengthChan()
+		if (stepConfig != 1 || chan == 0 || isChanBLinked(seq))
+			sequencesB[seq].setRunMode(runMode);
+		if (stepConfig != 1 || chan == 0)
+			sequences[seq].setRunMode(runMode);
+	}
 
 	
-	inline void fillStepIndexRunVector(int runMode, int len) {
-		if (runMode != MODE_RN2) 
-			stepIndexRun[1] = stepIndexRun[0];
-		else
-			stepIndexRun[1] = randomu32() % len;
-	}
 	
 	inline void moveStepIndexEdit(int delta, bool _autostepLen) {// 2nd param is for rotate that uses this method also
 		if (stepConfig == 2 || !_autostepLen) // 32
@@ -205,21 +224,27 @@ struct PhraseSeq32 : Module {
 				if (stepIndexEdit == 0) stepIndexEdit = 16;
 			}
 			else
-				stepIndexEdit = moveIndex(stepIndexEdit, stepIndexEdit + delta, sequences[seqIndexEdit].getLength() + 16);
+				stepIndexEdit = moveIndex(stepIndexEdit, stepIndexEdit + delta, sequencesB[seqIndexEdit].getLength() + 16);
 		}
 	}
 	
 		
 	PhraseSeq32() : Module(NUM_PARAMS, NUM_INPUTS, NUM_OUTPUTS, NUM_LIGHTS) {
-		for (int i = 0; i < 32; i++)
+		lightState.init(&lights);
+		psk.construct(cv, attributes, sequences, phrase, &phrases, &runModeSong, &pulsesPerStep, &stepConfig, sequencesB);
+		for (int i = 0; i < 32; i++) {
 			seqAttribBuffer[i].init(16, MODE_FWD);
+			seqAttribBufferB[i].init(16, MODE_FWD);
+		}
 		onReset();
+		publishDisplaySnapshot();
 	}
 
 	
 	// widgets are not yet created when module is created (and when onReset() is called by constructor)
 	// onReset() is also called when right-click initialization of module
 	void onReset() override {
+		IM_TIME_SCOPE("PhraseSeq32", TIMING_RESET);
 		stepConfig = getStepConfig(CONFIG_PARAM_INIT_VALUE);
 		autoseq = false;
 		autostepLen = false;
@@ -238,6 +263,7 @@ struct PhraseSeq32 : Module {
 				attributes[i][s].init();
 			}
 			sequences[i].init(16 * stepConfig, MODE_FWD);
+			sequencesB[i].init(16 * stepConfig, MODE_FWD);
 			phrase[i] = 0;
 			cvCPbuffer[i] = 0.0f;
 			attribCPbuffer[i].init();
@@ -245,6 +271,7 @@ struct PhraseSeq32 : Module {
 		}
 		initRun();
 		seqAttribCPbuffer.init(32, MODE_FWD);
+		seqAttribCPbufferB.init(32, MODE_FWD);
 		seqCopied = true;
 		countCP = 32;
 		startCP = 0;
@@ -252,10 +279,8 @@ struct PhraseSeq32 : Module {
 		editingType = 0ul;
 		infoCopyPaste = 0l;
 		displayState = DISP_NORMAL;
-		slideStepsRemain[0] = 0ul;
-		slideStepsRemain[1] = 0ul;
 		attached = false;
-		clockPeriod = 0ul;
+		psk.initClockPeriod();
 		tiedWarning = 0ul;
 		attachedWarning = 0l;
 		attachedChanB = false;
@@ -278,30 +303,19 @@ struct PhraseSeq32 : Module {
 				// }
 			}
 			sequences[seqIndexEdit].randomize(16 * stepConfig, NUM_MODES);// ok to use stepConfig since CONFIG_PARAM is not randomizable		
+			sequencesB[seqIndexEdit].init(sequences[seqIndexEdit].getLength(), sequences[seqIndexEdit].getRunMode());
 		}
 	}
 	
 	
 	void initRun() {// run button activated or run edge in run input jack
-		phraseIndexRun = (runModeSong == MODE_REV ? phrases - 1 : 0);
-		phraseIndexRunHistory = 0;
-
-		int seq = (isEditingSequence() ? seqIndexEdit : phrase[phraseIndexRun]);
-		stepIndexRun[0] = (sequences[seq].getRunMode() == MODE_REV ? sequences[seq].getLength() - 1 : 0);
-		fillStepIndexRunVector(sequences[seq].getRunMode(), sequences[seq].getLength());
-		stepIndexRunHistory = 0;
-
-		ppqnCount = 0;
-		for (int i = 0; i < 2; i += stepConfig) {
-			gate1Code[i] = calcGate1Code(attributes[seq][(i * 16) + stepIndexRun[i]], 0, pulsesPerStep, params[GATE1_KNOB_PARAM].value);
-			gate2Code[i] = calcGate2Code(attributes[seq][(i * 16) + stepIndexRun[i]], 0, pulsesPerStep);
-		}
-		slideStepsRemain[0] = 0ul;
-		slideStepsRemain[1] = 0ul;
+		psk.initRun(isEditingSequence(), seqIndexEdit, params[GATE1_KNOB_PARAM].value);
 	}	
 
 	
 	json_t *toJson() override {
+		IM_TIME_SCOPE("PhraseSeq32", TIMING_TOJSON);
+		IM_LOG_LIGHTS("PhraseSeq32", lightState);
 		json_t *rootJ = json_object();
 
 		// panelTheme
@@ -377,11 +391,18 @@ struct PhraseSeq32 : Module {
 			json_array_insert_new(sequencesJ, i, json_integer(sequences[i].getSeqAttrib()));
 		json_object_set_new(rootJ, "sequences", sequencesJ);
 
+		// sequencesB
+		json_t *sequencesBJ = json_array();
+		for (int i = 0; i < 32; i++)
+			json_array_insert_new(sequencesBJ, i, json_integer(sequencesB[i].getSeqAttrib()));
+		json_object_set_new(rootJ, "sequencesB", sequencesBJ);
+
 		return rootJ;
 	}
 
 	
 	void fromJson(json_t *rootJ) override {
+		IM_TIME_SCOPE("PhraseSeq32", TIMING_FROMJSON);
 		// panelTheme
 		json_t *panelThemeJ = json_object_get(rootJ, "panelTheme");
 		if (panelThemeJ)
@@ -490,6 +511,16 @@ struct PhraseSeq32 : Module {
 			}
 		}
 		
+		// sequencesB
+		json_t *sequencesBJ = json_object_get(rootJ, "sequencesB");
+		for (int i = 0; i < 32; i++) {
+			json_t *sequencesBArrayJ = json_array_get(sequencesBJ, i);
+			if (sequencesBArrayJ)
+				seqAttribBufferB[i].setSeqAttrib(json_integer_value(sequencesBArrayJ));
+			else// legacy, channel B in lockstep with channel A
+				seqAttribBufferB[i].init(seqAttribBuffer[i].getLength(), seqAttribBuffer[i].getRunMode());
+		}
+		
 		// runModeSong
 		json_t *runModeSongJ = json_object_get(rootJ, "runModeSong3");
 		if (runModeSongJ)
@@ -517,6 +548,7 @@ struct PhraseSeq32 : Module {
 				if (phraseArrayJ)
 					phrase[i] = json_integer_value(phraseArrayJ);
 			}
+		psk.invalidateSeqRun();
 		
 		// phrases
 		json_t *phrasesJ = json_object_get(rootJ, "phrases");
@@ -627,12 +659,16 @@ struct PhraseSeq32 : Module {
 			if (stepConfigSync != 0) {
 				stepConfig = getStepConfig(params[CONFIG_PARAM].value);
 				if (stepConfigSync == 1) {// sync from fromJson, so read lengths from seqAttribBuffer
-					for (int i = 0; i < 32; i++)
+					for (int i = 0; i < 32; i++) {
 						sequences[i].setSeqAttrib(seqAttribBuffer[i].getSeqAttrib());
+						sequencesB[i].setSeqAttrib(seqAttribBufferB[i].getSeqAttrib());
+					}
 				}
 				else if (stepConfigSync == 2) {// sync from a real mouse drag event on the switch itself, so init lengths
-					for (int i = 0; i < 32; i++)
+					for (int i = 0; i < 32; i++) {
 						sequences[i].setLength(16 * stepConfig);
+						sequencesB[i].setLength(16 * stepConfig);
+					}
 				}
 				initRun();			
 				attachedChanB = false;
@@ -658,7 +694,7 @@ struct PhraseSeq32 : Module {
 			// Mode CV input
 			if (inputs[MODECV_INPUT].active) {
 				if (editingSequence)
-					sequences[seqIndexEdit].setRunMode((int) clamp( round(inputs[MODECV_INPUT].value * ((float)NUM_MODES - 1.0f) / 10.0f), 0.0f, (float)NUM_MODES - 1.0f ));
+					setRunModeChan(seqIndexEdit, getEditChan(), (int) clamp( round(inputs[MODECV_INPUT].value * ((float)NUM_MODES - 1.0f) / 10.0f), 0.0f, (float)NUM_MODES - 1.0f ));
 			}
 			
 			// Attach button
@@ -671,12 +707,12 @@ struct PhraseSeq32 : Module {
 			if (running && attached) {
 				if (editingSequence) {
 					if (attachedChanB && stepConfig == 1)
-						stepIndexEdit = stepIndexRun[1] + 16;
+						stepIndexEdit = psk.getStepIndexRun(1) + 16;
 					else
-						stepIndexEdit = stepIndexRun[0] + 0;
+						stepIndexEdit = psk.getStepIndexRun(0) + 0;
 				}
 				else
-					phraseIndexEdit = phraseIndexRun;
+					phraseIndexEdit = psk.getPhraseIndexRun();
 			}
 			
 			// Copy button
@@ -696,6 +732,7 @@ struct PhraseSeq32 : Module {
 							attribCPbuffer[i] = attributes[seqIndexEdit][s];
 						}
 						seqAttribCPbuffer.setSeqAttrib(sequences[seqIndexEdit].getSeqAttrib());
+						seqAttribCPbufferB.setSeqAttrib(sequencesB[seqIndexEdit].getSeqAttrib());
 						seqCopied = true;
 					}
 					else {
@@ -730,6 +767,9 @@ struct PhraseSeq32 : Module {
 								sequences[seqIndexEdit].setSeqAttrib(seqAttribCPbuffer.getSeqAttrib());
 								if (sequences[seqIndexEdit].getLength() > 16 * stepConfig)
 									sequences[seqIndexEdit].setLength(16 * stepConfig);
+								sequencesB[seqIndexEdit].setSeqAttrib(seqAttribCPbufferB.getSeqAttrib());
+								if (sequencesB[seqIndexEdit].getLength() > 16 * stepConfig)
+									sequencesB[seqIndexEdit].setLength(16 * stepConfig);
 							}
 						}
 						else {// crossed paste to seq (seq vs song)
@@ -780,6 +820,7 @@ struct PhraseSeq32 : Module {
 							countCP = 32;
 							infoCopyPaste *= 2l;
 						}					
+						psk.invalidateSeqRun();
 					}
 					displayState = DISP_NORMAL;
 				}
@@ -837,7 +878,7 @@ struct PhraseSeq32 : Module {
 					else {
 						phraseIndexEdit = moveIndex(phraseIndexEdit, phraseIndexEdit + delta, 32);
 						if (!running)
-							phraseIndexRun = phraseIndexEdit;	
+							psk.setPhraseIndexRun(phraseIndexEdit);	
 					}						
 				}
 			}
@@ -850,8 +891,12 @@ struct PhraseSeq32 : Module {
 			}
 			if (stepPressed != -1) {
 				if (displayState == DISP_LENGTH) {
-					if (editingSequence)
-						sequences[seqIndexEdit].setLength((stepPressed % (16 * stepConfig)) + 1);
+					if (editingSequence) {
+						int chan = (stepConfig == 1 && stepPressed >= 16) ? 1 : 0;
+						setLengthChan(seqIndexEdit, chan, (stepPressed % (16 * stepConfig)) + 1);
+						if (chan != getEditChan())// so that the display shows the length of the row that was pressed
+							stepIndexEdit = (stepIndexEdit & 0xF) + (chan << 4);
+					}
 					else
 						phrases = stepPressed + 1;
 					revertDisplay = (long) (revertDisplayTime * sampleRate / displayRefreshStepSkips);
@@ -870,7 +915,7 @@ struct PhraseSeq32 : Module {
 						else {
 							phraseIndexEdit = stepPressed;
 							if (!running)
-								phraseIndexRun = phraseIndexEdit;
+								psk.setPhraseIndexRun(phraseIndexEdit);
 						}
 					}
 					else {// attached and running
@@ -936,7 +981,8 @@ struct PhraseSeq32 : Module {
 					else if (displayState == DISP_MODE) {
 						if (editingSequence) {
 							if (!inputs[MODECV_INPUT].active) {
-								sequences[seqIndexEdit].setRunMode(clamp(sequences[seqIndexEdit].getRunMode() + deltaKnob, 0, NUM_MODES - 1));
+								int editChan = getEditChan();
+								setRunModeChan(seqIndexEdit, editChan, clamp(getSeqAttribChan(seqIndexEdit, editChan)->getRunMode() + deltaKnob, 0, NUM_MODES - 1));
 							}
 						}
 						else {
@@ -945,7 +991,8 @@ struct PhraseSeq32 : Module {
 					}
 					else if (displayState == DISP_LENGTH) {
 						if (editingSequence) {
-							sequences[seqIndexEdit].setLength(clamp(sequences[seqIndexEdit].getLength() + deltaKnob, 1, (16 * stepConfig)));
+							int editChan = getEditChan();
+							setLengthChan(seqIndexEdit, editChan, clamp(getSeqAttribChan(seqIndexEdit, editChan)->getLength() + deltaKnob, 1, (16 * stepConfig)));
 						}
 						else {
 							phrases = clamp(phrases + deltaKnob, 1, 32);
@@ -968,8 +1015,8 @@ struct PhraseSeq32 : Module {
 					}
 					else if (displayState == DISP_ROTATE) {
 						if (editingSequence) {
-							int slength = sequences[seqIndexEdit].getLength();
 							bool rotChanB = (stepConfig == 1 && stepIndexEdit >= 16);
+							int slength = getSeqAttribChan(seqIndexEdit, rotChanB ? 1 : 0)->getLength();
 							sequences[seqIndexEdit].setRotate(clamp(sequences[seqIndexEdit].getRotate() + deltaKnob, -99, 99));
 							if (deltaKnob > 0 && deltaKnob < 201) {// Rotate right, 201 is safety
 								for (int i = deltaKnob; i > 0; i--) {
@@ -1004,6 +1051,7 @@ struct PhraseSeq32 : Module {
 									newPhrase += (1 - newPhrase / 32) * 32;// newPhrase now positive
 								newPhrase = newPhrase % 32;
 								phrase[phraseIndexEdit] = newPhrase;
+								psk.invalidateSeqRun();
 							}
 							else 
 								attachedWarning = (long) (warningTime * sampleRate / displayRefreshStepSkips);
@@ -1144,54 +1192,9 @@ struct PhraseSeq32 : Module {
 		// Clock
 		if (running && clockIgnoreOnReset == 0l) {
 			if (clockTrigger.process(inputs[CLOCK_INPUT].value)) {
-				ppqnCount++;
-				if (ppqnCount >= pulsesPerStep)
-					ppqnCount = 0;
-
-				int newSeq = seqIndexEdit;// good value when editingSequence, overwrite if not editingSequence
-				if (ppqnCount == 0) {
-					float slideFromCV[2] = {0.0f, 0.0f};
-					if (editingSequence) {
-						for (int i = 0; i < 2; i += stepConfig)
-							slideFromCV[i] = cv[seqIndexEdit][(i * 16) + stepIndexRun[i]];
-						moveIndexRunMode(&stepIndexRun[0], sequences[seqIndexEdit].getLength(), sequences[seqIndexEdit].getRunMode(), &stepIndexRunHistory);
-					}
-					else {
-						for (int i = 0; i < 2; i += stepConfig)
-							slideFromCV[i] = cv[phrase[phraseIndexRun]][(i * 16) + stepIndexRun[i]];
-						if (moveIndexRunMode(&stepIndexRun[0], sequences[phrase[phraseIndexRun]].getLength(), sequences[phrase[phraseIndexRun]].getRunMode(), &stepIndexRunHistory)) {
-							moveIndexRunMode(&phraseIndexRun, phrases, runModeSong, &phraseIndexRunHistory);
-							stepIndexRun[0] = (sequences[phrase[phraseIndexRun]].getRunMode() == MODE_REV ? sequences[phrase[phraseIndexRun]].getLength() - 1 : 0);// must always refresh after phraseIndexRun has changed
-						}
-						newSeq = phrase[phraseIndexRun];
-					}
-					fillStepIndexRunVector(sequences[newSeq].getRunMode(), sequences[newSeq].getLength());
-
-					// Slide
-					for (int i = 0; i < 2; i += stepConfig) {
-						if (attributes[newSeq][(i * 16) + stepIndexRun[i]].getSlide()) {
-							slideStepsRemain[i] = (unsigned long) (((float)clockPeriod  * pulsesPerStep) * params[SLIDE_KNOB_PARAM].value / 2.0f);
-							if (slideStepsRemain[i] != 0ul) {
-								float slideToCV = cv[newSeq][(i * 16) + stepIndexRun[i]];
-								slideCVdelta[i] = (slideToCV - slideFromCV[i])/(float)slideStepsRemain[i];
-							}
-						}
-						else
-							slideStepsRemain[i] = 0ul;
-					}
-				}
-				else {
-					if (!editingSequence)
-						newSeq = phrase[phraseIndexRun];
-				}
-				for (int i = 0; i < 2; i += stepConfig) {
-					if (gate1Code[i] != -1 || ppqnCount == 0)
-						gate1Code[i] = calcGate1Code(attributes[newSeq][(i * 16) + stepIndexRun[i]], ppqnCount, pulsesPerStep, params[GATE1_KNOB_PARAM].value);
-					gate2Code[i] = calcGate2Code(attributes[newSeq][(i * 16) + stepIndexRun[i]], ppqnCount, pulsesPerStep);	
-				}
-				clockPeriod = 0ul;
+				psk.clockStep(editingSequence, seqIndexEdit, params[GATE1_KNOB_PARAM].value, params[SLIDE_KNOB_PARAM].value, clockTrigger.getPeriod());
 			}
-			clockPeriod++;
+			psk.step();
 		}
 		
 		// Reset
@@ -1204,13 +1207,14 @@ struct PhraseSeq32 : Module {
 			if (inputs[SEQCV_INPUT].active && seqCVmethod == 2)
 				seqIndexEdit = 0;
 		}
+		psk.publishPendingRun();// run state changes from the reset, the ui thread and the phrase edits, for lookahead()
 		
 		
 		//********** Outputs and lights **********
 				
 		// CV and gates outputs
-		int seq = editingSequence ? (seqIndexEdit) : (running ? phrase[phraseIndexRun] : phrase[phraseIndexEdit]);
-		int step0 = editingSequence ? (running ? stepIndexRun[0] : stepIndexEdit) : (stepIndexRun[0]);
+		int seq = running ? psk.getSeqRun(editingSequence, seqIndexEdit) : (editingSequence ? seqIndexEdit : phrase[phraseIndexEdit]);
+		int step0 = editingSequence ? (running ? psk.getStepIndexRun(0) : stepIndexEdit) : (psk.getStepIndexRun(0));
 		if (running) {
 			bool muteGate1A = !editingSequence && ((params[GATE1_PARAM].value + inputs[GATE1CV_INPUT].value) > 0.5f);// live mute
 			bool muteGate1B = muteGate1A;
@@ -1227,18 +1231,15 @@ struct PhraseSeq32 : Module {
 					muteGate2A = false;
 				}
 			}
-			float slideOffset[2];
-			for (int i = 0; i < 2; i += stepConfig)
-				slideOffset[i] = (slideStepsRemain[i] > 0ul ? (slideCVdelta[i] * (float)slideStepsRemain[i]) : 0.0f);
-			outputs[CVA_OUTPUT].value = cv[seq][step0] - slideOffset[0];
+			outputs[CVA_OUTPUT].value = cv[seq][step0] - psk.calcSlideOffset(0);
 			bool retriggingOnReset = (clockIgnoreOnReset != 0l && retrigGatesOnReset);
-			outputs[GATE1A_OUTPUT].value = (calcGate(gate1Code[0], clockTrigger, clockPeriod, sampleRate) && !muteGate1A && !retriggingOnReset) ? 10.0f : 0.0f;
-			outputs[GATE2A_OUTPUT].value = (calcGate(gate2Code[0], clockTrigger, clockPeriod, sampleRate) && !muteGate2A && !retriggingOnReset) ? 10.0f : 0.0f;
+			outputs[GATE1A_OUTPUT].value = (psk.calcGate1(0, clockTrigger, sampleRate) && !muteGate1A && !retriggingOnReset) ? 10.0f : 0.0f;
+			outputs[GATE2A_OUTPUT].value = (psk.calcGate2(0, clockTrigger, sampleRate) && !muteGate2A && !retriggingOnReset) ? 10.0f : 0.0f;
 			if (stepConfig == 1) {
-				int step1 = editingSequence ? (running ? stepIndexRun[1] : stepIndexEdit) : (stepIndexRun[1]);
-				outputs[CVB_OUTPUT].value = cv[seq][16 + step1] - slideOffset[1];
-				outputs[GATE1B_OUTPUT].value = (calcGate(gate1Code[1], clockTrigger, clockPeriod, sampleRate) && !muteGate1B && !retriggingOnReset) ? 10.0f : 0.0f;
-				outputs[GATE2B_OUTPUT].value = (calcGate(gate2Code[1], clockTrigger, clockPeriod, sampleRate) && !muteGate2B && !retriggingOnReset) ? 10.0f : 0.0f;
+				int step1 = editingSequence ? (running ? psk.getStepIndexRun(1) : stepIndexEdit) : (psk.getStepIndexRun(1));
+				outputs[CVB_OUTPUT].value = cv[seq][16 + step1] - psk.calcSlideOffset(1);
+				outputs[GATE1B_OUTPUT].value = (psk.calcGate1(1, clockTrigger, sampleRate) && !muteGate1B && !retriggingOnReset) ? 10.0f : 0.0f;
+				outputs[GATE2B_OUTPUT].value = (psk.calcGate2(1, clockTrigger, sampleRate) && !muteGate2B && !retriggingOnReset) ? 10.0f : 0.0f;
 			} 
 			else {
 				outputs[CVB_OUTPUT].value = 0.0f;
@@ -1276,9 +1277,7 @@ struct PhraseSeq32 : Module {
 				}
 			}	
 		}
-		for (int i = 0; i < 2; i++)
-			if (slideStepsRemain[i] > 0ul)
-				slideStepsRemain[i]--;
+		psk.decSlideStepsRemain();
 
 		
 		lightRefreshCounter++;
@@ -1297,9 +1296,10 @@ struct PhraseSeq32 : Module {
 				}
 				else if (displayState == DISP_LENGTH) {
 					if (editingSequence) {
-						if (col < (sequences[seqIndexEdit].getLength() - 1))
+						int length = getSeqAttribChan(seqIndexEdit, i >> 4)->getLength();
+						if (col < (length - 1))
 							green = 0.1f;
-						else if (col == (sequences[seqIndexEdit].getLength() - 1))
+						else if (col == (length - 1))
 							green = 1.0f;
 					}
 					else {
@@ -1313,16 +1313,16 @@ struct PhraseSeq32 : Module {
 					red = 0.5f;
 				}
 				else if (displayState == DISP_ROTATE) {
-					red = (i == stepIndexEdit ? 1.0f : (col < sequences[seqIndexEdit].getLength() ? 0.2f : 0.0f));
+					red = (i == stepIndexEdit ? 1.0f : (col < getSeqAttribChan(seqIndexEdit, i >> 4)->getLength() ? 0.2f : 0.0f));
 				}
 				else {// normal led display (i.e. not length)
 					int row = i >> (3 + stepConfig);//i / (16 * stepConfig);// optimized (not equivalent code, but in this case has same effect)
 					// Run cursor (green)
 					if (editingSequence)
-						green = ((running && (col == stepIndexRun[row])) ? 1.0f : 0.0f);
+						green = ((running && (col == psk.getStepIndexRun(row))) ? 1.0f : 0.0f);
 					else {
-						green = ((running && (i == phraseIndexRun)) ? 1.0f : 0.0f);
-						green += ((running && (col == stepIndexRun[row]) && i != phraseIndexEdit) ? 0.1f : 0.0f);
+						green = ((running && (i == psk.getPhraseIndexRun())) ? 1.0f : 0.0f);
+						green += ((running && (col == psk.getStepIndexRun(row)) && i != phraseIndexEdit) ? 0.1f : 0.0f);
 						green = clamp(green, 0.0f, 1.0f);
 					}
 					// Edit cursor (red)
@@ -1334,14 +1334,14 @@ struct PhraseSeq32 : Module {
 					if (editingSequence)
 						gate = attributes[seqIndexEdit][i].getGate1();
 					else if (!editingSequence && (attached && running))
-						gate = attributes[phrase[phraseIndexRun]][i].getGate1();
+						gate = attributes[phrase[psk.getPhraseIndexRun()]][i].getGate1();
 					white = ((green == 0.0f && red == 0.0f && gate && displayState != DISP_MODE) ? 0.04f : 0.0f);
 					if (editingSequence && white != 0.0f) {
 						green = 0.02f; white = 0.0f;
 					}
 				}
 				setGreenRed(STEP_PHRASE_LIGHTS + i * 3, green, red);
-				lights[STEP_PHRASE_LIGHTS + i * 3 + 2].value = white;
+				lightState.set(STEP_PHRASE_LIGHTS + i * 3 + 2, white);
 			}
 		
 			// Octave lights
@@ -1349,21 +1349,21 @@ struct PhraseSeq32 : Module {
 			if (editingSequence)
 				octCV = cv[seqIndexEdit][stepIndexEdit];
 			else
-				octCV = cv[phrase[phraseIndexEdit]][stepIndexRun[0]];
+				octCV = cv[phrase[phraseIndexEdit]][psk.getStepIndexRun(0)];
 			int octLightIndex = (int) floor(octCV + 3.0f);
 			for (int i = 0; i < 7; i++) {
 				if (!editingSequence && (!attached || !running || (stepConfig == 1)))// no oct lights when song mode and either (detached [1] or stopped [2] or 2x16config [3])
 												// [1] makes no sense, can't mod steps and stepping though seq that may not be playing
 												// [2] CV is set to 0V when not running and in song mode, so cv[][] makes no sense to display
 												// [3] makes no sense, which sequence would be displayed, top or bottom row!
-					lights[OCTAVE_LIGHTS + i].value = 0.0f;
+					lightState.set(OCTAVE_LIGHTS + i, 0.0f);
 				else {
 					if (tiedWarning > 0l) {
 						bool warningFlashState = calcWarningFlash(tiedWarning, (long) (warningTime * sampleRate / displayRefreshStepSkips));
-						lights[OCTAVE_LIGHTS + i].value = (warningFlashState && (i == (6 - octLightIndex))) ? 1.0f : 0.0f;
+						lightState.set(OCTAVE_LIGHTS + i, (warningFlashState && (i == (6 - octLightIndex))) ? 1.0f : 0.0f);
 					}
 					else				
-						lights[OCTAVE_LIGHTS + i].value = (i == (6 - octLightIndex) ? 1.0f : 0.0f);
+						lightState.set(OCTAVE_LIGHTS + i, (i == (6 - octLightIndex) ? 1.0f : 0.0f));
 				}
 			}
 			
@@ -1372,7 +1372,7 @@ struct PhraseSeq32 : Module {
 			if (editingSequence) 
 				cvValOffset = cv[seqIndexEdit][stepIndexEdit] + 10.0f;//to properly handle negative note voltages
 			else	
-				cvValOffset = cv[phrase[phraseIndexEdit]][stepIndexRun[0]] + 10.0f;//to properly handle negative note voltages
+				cvValOffset = cv[phrase[phraseIndexEdit]][psk.getStepIndexRun(0)] + 10.0f;//to properly handle negative note voltages
 			int keyLightIndex = clamp( (int)((cvValOffset-floor(cvValOffset)) * 12.0f + 0.5f),  0,  11);
 			if (editingPpqn != 0) {
 				for (int i = 0; i < 12; i++) {
@@ -1409,29 +1409,29 @@ struct PhraseSeq32 : Module {
 			}
 			else {
 				for (int i = 0; i < 12; i++) {
-					lights[KEY_LIGHTS + i * 2 + 0].value = 0.0f;
+					lightState.set(KEY_LIGHTS + i * 2 + 0, 0.0f);
 					if (!editingSequence && (!attached || !running || (stepConfig == 1)))// no oct lights when song mode and either (detached [1] or stopped [2] or 2x16config [3])
 													// [1] makes no sense, can't mod steps and stepping though seq that may not be playing
 													// [2] CV is set to 0V when not running and in song mode, so cv[][] makes no sense to display
 													// [3] makes no sense, which sequence would be displayed, top or bottom row!
-						lights[KEY_LIGHTS + i * 2 + 1].value = 0.0f;
+						lightState.set(KEY_LIGHTS + i * 2 + 1, 0.0f);
 					else {
 						if (tiedWarning > 0l) {
 							bool warningFlashState = calcWarningFlash(tiedWarning, (long) (warningTime * sampleRate / displayRefreshStepSkips));
-							lights[KEY_LIGHTS + i * 2 + 1].value = (warningFlashState && i == keyLightIndex) ? 1.0f : 0.0f;
+							lightState.set(KEY_LIGHTS + i * 2 + 1, (warningFlashState && i == keyLightIndex) ? 1.0f : 0.0f);
 						}
 						else {
 							if (editingGate > 0ul && editingGateKeyLight != -1)
-								lights[KEY_LIGHTS + i * 2 + 1].value = (i == editingGateKeyLight ? ((float) editingGate / (float)(gateTime * sampleRate / displayRefreshStepSkips)) : 0.0f);
+								lightState.set(KEY_LIGHTS + i * 2 + 1, (i == editingGateKeyLight ? ((float) editingGate / (float)(gateTime * sampleRate / displayRefreshStepSkips)) : 0.0f));
 							else
-								lights[KEY_LIGHTS + i * 2 + 1].value = (i == keyLightIndex ? 1.0f : 0.0f);
+								lightState.set(KEY_LIGHTS + i * 2 + 1, (i == keyLightIndex ? 1.0f : 0.0f));
 						}
 					}
 				}
 			}		
 
 			// Key mode light (note or gate type)
-			lights[KEYNOTE_LIGHT].value = editingGateLength == 0l ? 10.0f : 0.0f;
+			lightState.set(KEYNOTE_LIGHT, editingGateLength == 0l ? 10.0f : 0.0f);
 			if (editingGateLength == 0l)
 				setGreenRed(KEYGATE_LIGHT, 0.0f, 0.0f);
 			else if (editingGateLength > 0l)
@@ -1447,40 +1447,40 @@ struct PhraseSeq32 : Module {
 				setGateLight(false, GATE1_LIGHT);
 				setGateLight(false, GATE2_LIGHT);
 				setGreenRed(GATE1_PROB_LIGHT, 0.0f, 0.0f);
-				lights[SLIDE_LIGHT].value = 0.0f;
-				lights[TIE_LIGHT].value = 0.0f;
+				lightState.set(SLIDE_LIGHT, 0.0f);
+				lightState.set(TIE_LIGHT, 0.0f);
 			}
 			else {
 				StepAttributes attributesVal = attributes[seqIndexEdit][stepIndexEdit];
 				if (!editingSequence)
-					attributesVal = attributes[phrase[phraseIndexEdit]][stepIndexRun[0]];
+					attributesVal = attributes[phrase[phraseIndexEdit]][psk.getStepIndexRun(0)];
 				//
 				setGateLight(attributesVal.getGate1(), GATE1_LIGHT);
 				setGateLight(attributesVal.getGate2(), GATE2_LIGHT);
 				setGreenRed(GATE1_PROB_LIGHT, attributesVal.getGate1P() ? 1.0f : 0.0f, attributesVal.getGate1P() ? 1.0f : 0.0f);
-				lights[SLIDE_LIGHT].value = attributesVal.getSlide() ? 1.0f : 0.0f;
+				lightState.set(SLIDE_LIGHT, attributesVal.getSlide() ? 1.0f : 0.0f);
 				if (tiedWarning > 0l) {
 					bool warningFlashState = calcWarningFlash(tiedWarning, (long) (warningTime * sampleRate / displayRefreshStepSkips));
-					lights[TIE_LIGHT].value = (warningFlashState) ? 1.0f : 0.0f;
+					lightState.set(TIE_LIGHT, (warningFlashState) ? 1.0f : 0.0f);
 				}
 				else
-					lights[TIE_LIGHT].value = attributesVal.getTied() ? 1.0f : 0.0f;
+					lightState.set(TIE_LIGHT, attributesVal.getTied() ? 1.0f : 0.0f);
 			}
 			
 			// Attach light
 			if (attachedWarning > 0l) {
 				bool warningFlashState = calcWarningFlash(attachedWarning, (long) (warningTime * sampleRate / displayRefreshStepSkips));
-				lights[ATTACH_LIGHT].value = (warningFlashState) ? 1.0f : 0.0f;
+				lightState.set(ATTACH_LIGHT, (warningFlashState) ? 1.0f : 0.0f);
 			}
 			else
-				lights[ATTACH_LIGHT].value = (attached ? 1.0f : 0.0f);
+				lightState.set(ATTACH_LIGHT, (attached ? 1.0f : 0.0f));
 			
 			// Reset light
-			lights[RESET_LIGHT].value =	resetLight;
+			lightState.set(RESET_LIGHT, resetLight);
 			resetLight -= (resetLight / lightLambda) * engineGetSampleTime() * displayRefreshStepSkips;
 			
 			// Run light
-			lights[RUN_LIGHT].value = running ? 1.0f : 0.0f;
+			lightState.set(RUN_LIGHT, running ? 1.0f : 0.0f);
 
 			if (editingGate > 0ul)
 				editingGate--;
@@ -1507,6 +1507,8 @@ struct PhraseSeq32 : Module {
 					displayState = DISP_NORMAL;
 				revertDisplay--;
 			}
+			
+			publishDisplaySnapshot();
 		}// lightRefreshCounter
 				
 		if (clockIgnoreOnReset > 0l)
@@ -1514,9 +1516,27 @@ struct PhraseSeq32 : Module {
 	}// step()
 	
 
+	void publishDisplaySnapshot() {
+		DisplaySnapshot snap;
+		snap.editingSequence = isEditingSequence();
+		snap.infoCopyPaste = infoCopyPaste;
+		snap.seqCopied = seqCopied;
+		snap.cpMode = params[CPMODE_PARAM].value;
+		snap.editingPpqn = editingPpqn != 0ul;
+		snap.pulsesPerStep = pulsesPerStep;
+		snap.displayState = displayState;
+		snap.runMode = snap.editingSequence ? getSeqAttribChan(seqIndexEdit, getEditChan())->getRunMode() : runModeSong;
+		snap.length = snap.editingSequence ? getSeqAttribChan(seqIndexEdit, getEditChan())->getLength() : phrases;
+		snap.transpose = sequences[seqIndexEdit].getTranspose();
+		snap.rotate = sequences[seqIndexEdit].getRotate();
+		snap.seqNum = snap.editingSequence ? seqIndexEdit : phrase[phraseIndexEdit];
+		displaySnapshot.write(snap);
+	}
+	
+
 	inline void setGreenRed(int id, float green, float red) {
-		lights[id + 0].value = green;
-		lights[id + 1].value = red;
+		lightState.set(id + 0, green);
+		lightState.set(id + 1, red);
 	}
 
 	inline void propagateCVtoTied(int seqn, int stepn) {
@@ -1562,16 +1582,16 @@ struct PhraseSeq32 : Module {
 	
 	inline void setGateLight(bool gateOn, int lightIndex) {
 		if (!gateOn) {
-			lights[lightIndex + 0].value = 0.0f;
-			lights[lightIndex + 1].value = 0.0f;
+			lightState.set(lightIndex + 0, 0.0f);
+			lightState.set(lightIndex + 1, 0.0f);
 		}
 		else if (editingGateLength == 0l) {
-			lights[lightIndex + 0].value = 0.0f;
-			lights[lightIndex + 1].value = 1.0f;
+			lightState.set(lightIndex + 0, 0.0f);
+			lightState.set(lightIndex + 1, 1.0f);
 		}
 		else {
-			lights[lightIndex + 0].value = lightIndex == GATE1_LIGHT ? 1.0f : 0.2f;
-			lights[lightIndex + 1].value = lightIndex == GATE1_LIGHT ? 0.2f : 1.0f;
+			lightState.set(lightIndex + 0, lightIndex == GATE1_LIGHT ? 1.0f : 0.2f);
+			lightState.set(lightIndex + 1, lightIndex == GATE1_LIGHT ? 0.2f : 1.0f);
 		}
 	}
 
@@ -1586,35 +1606,25 @@ struct PhraseSeq32Widget : ModuleWidget {
 	int expWidth = 60;
 	IMPort* expPorts[5];
 	
-	struct SequenceDisplayWidget : TransparentWidget {
+	struct SequenceDisplayWidget : CachedDisplayWidget {
 		PhraseSeq32 *module;
-		std::shared_ptr<Font> font;
-		char displayStr[4];
-		
-		SequenceDisplayWidget() {
-			font = Font::load(assetPlugin(plugin, "res/fonts/Segment14.ttf"));
-		}
+		PhraseSeq32::DisplaySnapshot snap;// copy of the module's display snapshot, printContent() reads this instead of the module
 		
 		void runModeToStr(int num) {
 			if (num >= 0 && num < NUM_MODES)
 				snprintf(displayStr, 4, "%s", modeLabels[num].c_str());
 		}
 
-		void draw(NVGcontext *vg) override {
-			NVGcolor textColor = prepareDisplay(vg, &box, 18);
-			nvgFontFaceId(vg, font->handle);
-			bool editingSequence = module->isEditingSequence();
-
-			Vec textPos = Vec(6, 24);
-			nvgFillColor(vg, nvgTransRGBA(textColor, displayAlpha));
-			nvgText(vg, textPos.x, textPos.y, "~~~", NULL);
-			nvgFillColor(vg, textColor);
-			if (module->infoCopyPaste != 0l) {
-				if (module->infoCopyPaste > 0l)
+		void printContent() override {
+			if (!module->displaySnapshot.read(&snap))
+				return;// keep what is shown, a consistent snapshot will be read next frame
+			bool editingSequence = snap.editingSequence;
+			if (snap.infoCopyPaste != 0l) {
+				if (snap.infoCopyPaste > 0l)
 					snprintf(displayStr, 4, "CPY");
 				else {
-					float cpMode = module->params[PhraseSeq32::CPMODE_PARAM].value;
-					if (editingSequence && !module->seqCopied) {// cross paste to seq
+					float cpMode = snap.cpMode;
+					if (editingSequence && !snap.seqCopied) {// cross paste to seq
 						if (cpMode > 1.5f)// All = toggle gate 1
 							snprintf(displayStr, 4, "TG1");
 						else if (cpMode < 0.5f)// 4 = random CV
@@ -1622,7 +1632,7 @@ struct PhraseSeq32Widget : ModuleWidget {
 						else// 8 = random gate 1
 							snprintf(displayStr, 4, "RG1");
 					}
-					else if (!editingSequence && module->seqCopied) {// cross paste to song
+					else if (!editingSequence && snap.seqCopied) {// cross paste to song
 						if (cpMode > 1.5f)// All = init
 							snprintf(displayStr, 4, "CLR");
 						else if (cpMode < 0.5f)// 4 = increase by 1
@@ -1634,35 +1644,38 @@ struct PhraseSeq32Widget : ModuleWidget {
 						snprintf(displayStr, 4, "PST");
 				}
 			}
-			else if (module->editingPpqn != 0ul) {
-				snprintf(displayStr, 4, "x%2u", (unsigned) module->pulsesPerStep);
+			else if (snap.editingPpqn) {
+				snprintf(displayStr, 4, "x%2u", (unsigned) snap.pulsesPerStep);
 			}
-			else if (module->displayState == PhraseSeq32::DISP_MODE) {
-				if (editingSequence)
-					runModeToStr(module->sequences[module->seqIndexEdit].getRunMode());
-				else
-					runModeToStr(module->runModeSong);
+			else if (snap.displayState == PhraseSeq32::DISP_MODE) {
+				runModeToStr(snap.runMode);// of the sequence or of the song
 			}
-			else if (module->displayState == PhraseSeq32::DISP_LENGTH) {
-				if (editingSequence)
-					snprintf(displayStr, 4, "L%2u", (unsigned) module->sequences[module->seqIndexEdit].getLength());
-				else
-					snprintf(displayStr, 4, "L%2u", (unsigned) module->phrases);
+			else if (snap.displayState == PhraseSeq32::DISP_LENGTH) {
+				snprintf(displayStr, 4, "L%2u", (unsigned) snap.length);// of the sequence or of the song
 			}
-			else if (module->displayState == PhraseSeq32::DISP_TRANSPOSE) {
-				snprintf(displayStr, 4, "+%2u", (unsigned) abs(module->sequences[module->seqIndexEdit].getTranspose()));
-				if (module->sequences[module->seqIndexEdit].getTranspose() < 0)
+			else if (snap.displayState == PhraseSeq32::DISP_TRANSPOSE) {
+				snprintf(displayStr, 4, "+%2u", (unsigned) abs(snap.transpose));
+				if (snap.transpose < 0)
 					displayStr[0] = '-';
 			}
-			else if (module->displayState == PhraseSeq32::DISP_ROTATE) {
-				snprintf(displayStr, 4, ")%2u", (unsigned) abs(module->sequences[module->seqIndexEdit].getRotate()));
-				if (module->sequences[module->seqIndexEdit].getRotate() < 0)
+			else if (snap.displayState == PhraseSeq32::DISP_ROTATE) {
+				snprintf(displayStr, 4, ")%2u", (unsigned) abs(snap.rotate));
+				if (snap.rotate < 0)
 					displayStr[0] = '(';
 			}
 			else {// DISP_NORMAL
-				snprintf(displayStr, 4, " %2u", (unsigned) (editingSequence ? 
-					module->seqIndexEdit : module->phrase[module->phraseIndexEdit]) + 1 );
+				snprintf(displayStr, 4, " %2u", (unsigned) snap.seqNum + 1 );
 			}
+		}
+
+		void drawContent(NVGcontext *vg) override {
+			NVGcolor textColor = prepareDisplay(vg, &box, 18);
+			nvgFontFaceId(vg, getFontHandle(vg));
+
+			Vec textPos = Vec(6, 24);
+			nvgFillColor(vg, nvgTransRGBA(textColor, displayAlpha));
+			nvgText(vg, textPos.x, textPos.y, "~~~", NULL);
+			nvgFillColor(vg, textColor);
 			nvgText(vg, textPos.x, textPos.y, displayStr, NULL);
 		}
 	};		
@@ -1821,7 +1834,7 @@ struct PhraseSeq32Widget : ModuleWidget {
 				else if (module->displayState == PhraseSeq32::DISP_MODE) {
 					if (module->isEditingSequence()) {
 						if (!module->inputs[PhraseSeq32::MODECV_INPUT].active) {
-							module->sequences[module->seqIndexEdit].setRunMode(MODE_FWD);
+							module->setRunModeChan(module->seqIndexEdit, module->getEditChan(), MODE_FWD);
 						}
 					}
 					else {
@@ -1830,7 +1843,7 @@ struct PhraseSeq32Widget : ModuleWidget {
 				}
 				else if (module->displayState == PhraseSeq32::DISP_LENGTH) {
 					if (module->isEditingSequence()) {
-						module->sequences[module->seqIndexEdit].setLength(16 * module->stepConfig);
+						module->setLengthChan(module->seqIndexEdit, module->getEditChan(), 16 * module->stepConfig);
 					}
 					else {
 						module->phrases = 4;
@@ -1850,6 +1863,7 @@ struct PhraseSeq32Widget : ModuleWidget {
 					}
 					else {
 						module->phrase[module->phraseIndexEdit] = 0;
+						module->psk.invalidateSeqRun();
 					}
 				}
 			}
@@ -1870,6 +1884,7 @@ struct PhraseSeq32Widget : ModuleWidget {
 	// }
 	
 	PhraseSeq32Widget(PhraseSeq32 *module) : ModuleWidget(module) {
+		IM_TIME_SCOPE("PhraseSeq32", TIMING_WIDGET);
 		this->module = module;
 		oldExpansion = -1;
 		
@@ -1884,12 +1899,12 @@ struct PhraseSeq32Widget : ModuleWidget {
         addChild(panel);
 		
 		// Screws
-		addChild(createDynamicScrew<IMScrew>(Vec(15, 0), &module->panelTheme));
-		addChild(createDynamicScrew<IMScrew>(Vec(15, 365), &module->panelTheme));
-		addChild(createDynamicScrew<IMScrew>(Vec(panel->box.size.x-30, 0), &module->panelTheme));
-		addChild(createDynamicScrew<IMScrew>(Vec(panel->box.size.x-30, 365), &module->panelTheme));
-		addChild(createDynamicScrew<IMScrew>(Vec(panel->box.size.x-30-expWidth, 0), &module->panelTheme));
-		addChild(createDynamicScrew<IMScrew>(Vec(panel->box.size.x-30-expWidth, 365), &module->panelTheme));
+		panel->addChild(createDynamicScrew<IMScrew>(Vec(15, 0), &module->panelTheme));
+		panel->addChild(createDynamicScrew<IMScrew>(Vec(15, 365), &module->panelTheme));
+		panel->addChild(createDynamicScrew<IMScrew>(Vec(panel->box.size.x-30, 0), &module->panelTheme));
+		panel->addChild(createDynamicScrew<IMScrew>(Vec(panel->box.size.x-30, 365), &module->panelTheme));
+		panel->addChild(createDynamicScrew<IMScrew>(Vec(panel->box.size.x-30-expWidth, 0), &module->panelTheme));
+		panel->addChild(createDynamicScrew<IMScrew>(Vec(panel->box.size.x-30-expWidth, 365), &module->panelTheme));
 
 		
 		
@@ -2103,6 +2118,19 @@ Model *modelPhraseSeq32 = Model::create<PhraseSeq32, PhraseSeq32Widget>("Impromp
 
 /*CHANGE LOG
 
+0.6.17:
+move clock, run mode, phrase, slide and gate logic into shared PhraseSeqKernel (see PhraseSeqKernel.hpp)
+channel B has its own run mode and length in 2x16 config (polymetric), and stays in lockstep with channel A while they are the same
+sequencer kernel can look ahead at the steps and phrases to come (random run modes and probabilities use the kernel's own generator)
+advanced gates come from the shared gate pattern table (AdvGateUtil), same gates as before for all pulses per step
+running sequence is cached in the kernel so that pulses and outputs don't look up the song each time
+slides use a filtered clock period measured by the new ClockInput front end (sub-sample edge position and period)
+segment displays are framebuffer cached and only redrawn when their text changes
+lights are written through LightState, so that only changed lights are written
+screws are drawn in the panel's framebuffer
+optional timing instrumentation (IM_TIMING)
+display reads a snapshot of the display state published at light refresh rate (SeqLock)
+
 0.6.16:
 add gate status feedback in steps (white lights)
 
@@ -0,0 +1,333 @@
+//***********************************************************************************************
+//Impromptu Modular: Modules for VCV Rack by Marc Boulé
+//***********************************************************************************************
+
+#ifndef PHRASE_SEQ_KERNEL_HPP
+#define PHRASE_SEQ_KERNEL_HPP
+
+
+#include "PhraseSeqUtil.hpp"
+
+
+// Run engine shared by PhraseSeq16, PhraseSeq32 and SemiModularSynth (clock, reset, run modes, phrases, slides and gates)
+//   MAX_STEPS is the number of steps in a sequence (16 or 32)
+//   NUM_CHAN is the number of channels a sequence can be split into (1 or 2), each channel has MAX_STEPS / NUM_CHAN steps
+// The sequence and song data stay in the module (for json and ui code), the kernel only holds pointers to it
+// When a module gives channel B (index 1) its own run mode and length (sequencesB), channel B runs in lockstep with channel A
+//   while they are the same as channel A's, and otherwise advances independently on the same clock (polymetric)
+// Random run modes and gate 1 probabilities draw from the kernel's own generators, so that lookahead() can predict what will
+//   play by advancing a copy of the run state, without changing anything
+// The run state is published through a SeqLock after every change, and lookahead() copies the published one, so that it can
+//   be called from the ui thread as well as from the engine thread; the SeqLock is only written by the engine thread, changes
+//   that can come from the ui thread (initRun() from onReset() and fromJson()) are published by publishPendingRun()
+
+template<int MAX_STEPS, int NUM_CHAN>
+class PhraseSeqKernel {
+
+	public:
+
+	static const int CHAN_STEPS = MAX_STEPS / NUM_CHAN;// offset of channel i's steps in a sequence is i * CHAN_STEPS
+
+	struct LookaheadStep {// what a future step will play
+		int phraseIndex;// -1 when editing a sequence
+		int seq;
+		int stepIndex[NUM_CHAN];
+		float cv[NUM_CHAN];
+		bool gate1[NUM_CHAN];// false when gate 1 is off or its probability will turn it off
+		bool gate2[NUM_CHAN];
+		bool slide[NUM_CHAN];
+	};
+
+
+	private:
+
+	// Need to save, in module
+	float (*cv)[MAX_STEPS];
+	StepAttributes (*attributes)[MAX_STEPS];
+	SeqAttributes *sequences;
+	int *phrase;
+	int *phrases;
+	int *runModeSong;
+	int *pulsesPerStep;
+	int *chanStridePtr;// nullptr when all channels always run, else 1 = all channels, NUM_CHAN = only channel 0 over MAX_STEPS steps
+	SeqAttributes *sequencesB;// nullptr when channel B always follows channel A, else only length and run mode are used
+
+	// No need to save
+	struct RunState {// everything that moving to the next step changes
+		int stepIndexRun[NUM_CHAN];
+		unsigned long stepIndexRunHistory[NUM_CHAN];// only channel 0's is used when the channels are in lockstep
+		int phraseIndexRun;
+		unsigned long phraseIndexRunHistory;
+		RandomState stepRandom;// random step run modes, RN2 and gate 1 probabilities
+		RandomState phraseRandom;// random song run modes (separate so that phrase lookahead does not depend on steps)
+	};
+	RunState run;
+	SeqLock<RunState> runPublished;// copy of run for lookahead(), see publishRun()
+	std::atomic<bool> runPublishPending;// run was changed outside of clockStep(), see publishPendingRun()
+	int ppqnCount;
+	int gate1Code[NUM_CHAN];// -1 = gate off for whole step, 0 = gate off for current ppqn, 1 = gate on, 2 = clock high, 3 = trigger
+	int gate2Code[NUM_CHAN];
+	unsigned long slideStepsRemain[NUM_CHAN];// 0 when no slide under way, downward step counter when sliding
+	float slideCVdelta[NUM_CHAN];// no need to initialize, this is a companion to slideStepsRemain
+	unsigned long clockPeriod;// counts number of step() calls upward from last clock (reset after clock processed)
+	
+	// Sequence the run is in, so that the per pulse and per sample paths don't go through phrase[] every time
+	int seqRun;
+	bool seqRunEditing;// seqRun is seqIndexEdit rather than the sequence of the run's phrase
+	bool seqRunValid;// false when the song has been edited, refreshed on next use
+	float *cvRun;// cv[seqRun]
+	StepAttributes *attributesRun;// attributes[seqRun]
+
+
+	public:
+
+	void construct(float (*_cv)[MAX_STEPS], StepAttributes (*_attributes)[MAX_STEPS], SeqAttributes *_sequences, int *_phrase, int *_phrases, int *_runModeSong, int *_pulsesPerStep, int *_chanStridePtr, SeqAttributes *_sequencesB) {// don't want regaular constructor mechanism
+		cv = _cv;
+		attributes = _attributes;
+		sequences = _sequences;
+		phrase = _phrase;
+		phrases = _phrases;
+		runModeSong = _runModeSong;
+		pulsesPerStep = _pulsesPerStep;
+		chanStridePtr = _chanStridePtr;
+		sequencesB = _sequencesB;
+		for (int i = 0; i < NUM_CHAN; i++) {
+			run.stepIndexRun[i] = 0;
+			run.stepIndexRunHistory[i] = 0;
+			gate1Code[i] = 0;
+			gate2Code[i] = 0;
+			slideStepsRemain[i] = 0ul;
+		}
+		run.phraseIndexRun = 0;
+		run.phraseIndexRunHistory = 0;
+		run.stepRandom.seed(randomu64());
+		run.phraseRandom.seed(randomu64());
+		ppqnCount = 0;
+		clockPeriod = 0ul;
+		setSeqRun(0, true);
+		seqRunValid = false;
+		publishRun();// the module is not in the engine yet
+	}
+
+	inline int getStepIndexRun(int chan) {return run.stepIndexRun[chan];}
+	inline int getPhraseIndexRun() {return run.phraseIndexRun;}
+	inline int getGate1Code(int chan) {return gate1Code[chan];}
+
+	inline void setPhraseIndexRun(int _phraseIndexRun) {run.phraseIndexRun = _phraseIndexRun; seqRunValid = false; requestPublishRun();}
+	inline void invalidateSeqRun() {seqRunValid = false;}// call when phrase[] is edited
+	inline int getSeqRun(bool editingSequence, int seqIndexEdit) {// sequence the run is in
+		if (editingSequence) {
+			if (!seqRunEditing || seqRun != seqIndexEdit)
+				setSeqRun(seqIndexEdit, true);
+		}
+		else if (seqRunEditing || !seqRunValid)
+			setSeqRun(phrase[run.phraseIndexRun], false);
+		return seqRun;
+	}
+
+	inline void initClockPeriod() {clockPeriod = 0ul;}
+	inline void decSlideStepsRemain() {
+		for (int i = 0; i < NUM_CHAN; i++)
+			if (slideStepsRemain[i] > 0ul)
+				slideStepsRemain[i]--;
+	}
+	inline float calcSlideOffset(int chan) {return (slideStepsRemain[chan] > 0ul ? (slideCVdelta[chan] * (float)slideStepsRemain[chan]) : 0.0f);}
+	inline bool calcGate1(int chan, Trigger clockTrigger, float sampleRate) {return calcGate(gate1Code[chan], clockTrigger, clockPeriod, sampleRate);}
+	inline bool calcGate2(int chan, Trigger clockTrigger, float sampleRate) {return calcGate(gate2Code[chan], clockTrigger, clockPeriod, sampleRate);}
+
+	void initRun(bool editingSequence, int seqIndexEdit, float gate1Prob) {// run button activated or run edge in run input jack
+		run.phraseIndexRun = ((*runModeSong) == MODE_REV ? (*phrases) - 1 : 0);
+		run.phraseIndexRunHistory = 0;
+
+		int seq = (editingSequence ? seqIndexEdit : phrase[run.phraseIndexRun]);
+		setSeqRun(seq, editingSequence);
+		run.stepIndexRun[0] = (sequences[seq].getRunMode() == MODE_REV ? sequences[seq].getLength() - 1 : 0);
+		for (int i = 0; i < NUM_CHAN; i++)
+			run.stepIndexRunHistory[i] = 0;
+		moveChanStepIndexes(&run, seq, true);
+
+		ppqnCount = 0;
+		int chanStride = getChanStride();
+		int stepOffsets[NUM_CHAN];
+		fillStepOffsets(stepOffsets, &run, chanStride);
+		for (int i = 0; i < NUM_CHAN; i += chanStride) {
+			gate1Code[i] = calcGate1Code(attributesRun[stepOffsets[i]], 0, *pulsesPerStep, gate1Prob, &run.stepRandom);
+			gate2Code[i] = calcGate2Code(attributesRun[stepOffsets[i]], 0, *pulsesPerStep);
+		}
+		for (int i = 0; i < NUM_CHAN; i++)
+			slideStepsRemain[i] = 0ul;
+		requestPublishRun();
+	}
+
+	void clockStep(bool editingSequence, int seqIndexEdit, float gate1Prob, float slideKnob, float filteredClockPeriod) {// call on each clock edge when running
+		// filteredClockPeriod is the clock period in samples from ClockInput::getPeriod(), slides use the last interval when it is 0.0f
+		int pps = *pulsesPerStep;
+		int chanStride = getChanStride();
+		ppqnCount++;
+		if (ppqnCount >= pps)
+			ppqnCount = 0;
+
+		getSeqRun(editingSequence, seqIndexEdit);
+		int stepOffsets[NUM_CHAN];// the channels' current steps laid out together, so that each evaluation below is one pass over the channels
+		if (ppqnCount == 0) {
+			float slideFromCV[NUM_CHAN];
+			fillStepOffsets(stepOffsets, &run, chanStride);
+			for (int i = 0; i < NUM_CHAN; i += chanStride)
+				slideFromCV[i] = cvRun[stepOffsets[i]];
+			setSeqRun(moveToNextStep(&run, editingSequence, seqIndexEdit), editingSequence);
+			fillStepOffsets(stepOffsets, &run, chanStride);
+			float slidePeriod = (filteredClockPeriod > 0.0f ? filteredClockPeriod : (float)clockPeriod);
+
+			// Slide
+			for (int i = 0; i < NUM_CHAN; i += chanStride) {
+				if (attributesRun[stepOffsets[i]].getSlide()) {
+					slideStepsRemain[i] = (unsigned long) ((slidePeriod * pps) * slideKnob / 2.0f);
+					if (slideStepsRemain[i] != 0ul) {
+						float slideToCV = cvRun[stepOffsets[i]];
+						slideCVdelta[i] = (slideToCV - slideFromCV[i])/(float)slideStepsRemain[i];
+					}
+				}
+				else
+					slideStepsRemain[i] = 0ul;
+			}
+		}
+		else {
+			fillStepOffsets(stepOffsets, &run, chanStride);
+		}
+		for (int i = 0; i < NUM_CHAN; i += chanStride) {
+			if (gate1Code[i] != -1 || ppqnCount == 0)
+				gate1Code[i] = calcGate1Code(attributesRun[stepOffsets[i]], ppqnCount, pps, gate1Prob, &run.stepRandom);
+			gate2Code[i] = calcGate2Code(attributesRun[stepOffsets[i]], ppqnCount, pps);
+		}
+		clockPeriod = 0ul;
+		publishRun();
+	}
+
+	inline void step() {// call once per sample when running and clock not ignored, after clockStep() if there was a clock edge
+		clockPeriod++;
+	}
+	
+	inline void publishPendingRun() {// call once per sample from the module's step(), after the reset
+		if (runPublishPending.load(std::memory_order_acquire))
+			publishRun();
+	}
+	
+	int lookahead(LookaheadStep* steps, int numSteps, bool editingSequence, int seqIndexEdit, float gate1Prob) {
+		// fills steps[] with the next numSteps steps that will start, returns numSteps; the kernel's state is not changed
+		// exact as long as the sequences, the song and the arguments given here are not changed in the meantime
+		// returns 0 when the run state was being published, try again later (next frame when called from the ui thread)
+		RunState runAhead;
+		if (!runPublished.read(&runAhead))
+			return 0;
+		int chanStride = getChanStride();
+		int stepOffsets[NUM_CHAN];
+		for (int n = 0; n < numSteps; n++) {
+			int seq = moveToNextStep(&runAhead, editingSequence, seqIndexEdit);
+			fillStepOffsets(stepOffsets, &runAhead, chanStride);
+			steps[n].phraseIndex = (editingSequence ? -1 : runAhead.phraseIndexRun);
+			steps[n].seq = seq;
+			for (int i = 0; i < NUM_CHAN; i++) {
+				if (i % chanStride != 0) {
+					steps[n].stepIndex[i] = -1;
+					steps[n].gate1[i] = steps[n].gate2[i] = steps[n].slide[i] = false;
+					steps[n].cv[i] = 0.0f;
+					continue;
+				}
+				StepAttributes attribute = attributes[seq][stepOffsets[i]];
+				steps[n].stepIndex[i] = stepOffsets[i];
+				steps[n].cv[i] = cv[seq][stepOffsets[i]];
+				steps[n].gate1[i] = attribute.getGate1() && !(attribute.getGate1P() && !(runAhead.stepRandom.uniform() < gate1Prob));// same draw as calcGate1Code() in clockStep()
+				steps[n].gate2[i] = attribute.getGate2();
+				steps[n].slide[i] = attribute.getSlide();
+			}
+		}
+		return numSteps;
+	}
+	
+	int lookaheadPhrases(int* phraseIndexes, int numPhrases) {// next numPhrases phrase indexes the song will move to, kernel's state is not changed
+		// returns 0 when the run state was being published, like lookahead()
+		RunState runAhead;
+		if (!runPublished.read(&runAhead))
+			return 0;
+		int phraseIndex = runAhead.phraseIndexRun;
+		unsigned long phraseIndexHistory = runAhead.phraseIndexRunHistory;
+		RandomState phraseRandom = runAhead.phraseRandom;
+		for (int n = 0; n < numPhrases; n++) {
+			moveIndexRunMode(&phraseIndex, *phrases, *runModeSong, &phraseIndexHistory, &phraseRandom);
+			phraseIndexes[n] = phraseIndex;
+		}
+		return numPhrases;
+	}
+
+
+	private:
+
+	inline int getChanStride() {return (chanStridePtr == nullptr ? 1 : *chanStridePtr);}
+	inline void publishRun() {// engine thread only (or before the module is in the engine)
+		runPublishPending.store(false, std::memory_order_relaxed);
+		runPublished.write(run);
+	}
+	inline void requestPublishRun() {runPublishPending.store(true, std::memory_order_release);}// any thread, after a change to run
+	
+	inline void setSeqRun(int seq, bool editingSequence) {
+		seqRun = seq;
+		seqRunEditing = editingSequence;
+		seqRunValid = true;
+		cvRun = cv[seq];
+		attributesRun = attributes[seq];
+	}
+
+	inline void fillStepOffsets(int* stepOffsets, RunState* rs, int chanStride) {
+		for (int i = 0; i < NUM_CHAN; i += chanStride)
+			stepOffsets[i] = (i * CHAN_STEPS) + rs->stepIndexRun[i];
+	}
+	
+	int moveToNextStep(RunState* rs, bool editingSequence, int seqIndexEdit) {// returns the sequence of the new step
+		int newSeq = seqIndexEdit;
+		bool phraseChanged = false;
+		if (editingSequence) {
+			moveIndexRunMode(&rs->stepIndexRun[0], sequences[seqIndexEdit].getLength(), sequences[seqIndexEdit].getRunMode(), &rs->stepIndexRunHistory[0], &rs->stepRandom);
+		}
+		else {
+			if (moveIndexRunMode(&rs->stepIndexRun[0], sequences[phrase[rs->phraseIndexRun]].getLength(), sequences[phrase[rs->phraseIndexRun]].getRunMode(), &rs->stepIndexRunHistory[0], &rs->stepRandom)) {
+				moveIndexRunMode(&rs->phraseIndexRun, *phrases, *runModeSong, &rs->phraseIndexRunHistory, &rs->phraseRandom);
+				rs->stepIndexRun[0] = (sequences[phrase[rs->phraseIndexRun]].getRunMode() == MODE_REV ? sequences[phrase[rs->phraseIndexRun]].getLength() - 1 : 0);// must always refresh after phraseIndexRun has changed
+				phraseChanged = true;
+			}
+			newSeq = phrase[rs->phraseIndexRun];
+		}
+		moveChanStepIndexes(rs, newSeq, phraseChanged);
+		return newSeq;
+	}
+	
+	inline bool isLockstep(int seq) {// true when channels other than 0 follow channel 0
+		if (sequencesB == nullptr || getChanStride() != 1)
+			return true;
+		return sequencesB[seq].getLength() == sequences[seq].getLength() && sequencesB[seq].getRunMode() == sequences[seq].getRunMode();
+	}
+	
+	inline void moveChanStepIndexes(RunState* rs, int seq, bool restart) {// call after channel 0 has moved, restart is for when seq has just started
+		if (isLockstep(seq)) {
+			fillStepIndexRunVector(rs, sequences[seq].getRunMode(), sequences[seq].getLength());
+			return;
+		}
+		for (int i = 1; i < NUM_CHAN; i++) {
+			if (restart)
+				rs->stepIndexRun[i] = (sequencesB[seq].getRunMode() == MODE_REV ? sequencesB[seq].getLength() - 1 : 0);
+			else
+				moveIndexRunMode(&rs->stepIndexRun[i], sequencesB[seq].getLength(), sequencesB[seq].getRunMode(), &rs->stepIndexRunHistory[i], &rs->stepRandom);
+		}
+	}
+	
+	inline void fillStepIndexRunVector(RunState* rs, int runMode, int len) {// channels other than 0 follow channel 0, except in RN2 where they are independently random
+		for (int i = 1; i < NUM_CHAN; i++) {
+			if (runMode != MODE_RN2)
+				rs->stepIndexRun[i] = rs->stepIndexRun[0];
+			else
+				rs->stepIndexRun[i] = rs->stepRandom.u32() % len;
+		}
+	}
+};// class PhraseSeqKernel
+
+
+#endif
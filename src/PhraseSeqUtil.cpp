@@ -6,45 +6,12 @@
 #include "PhraseSeqUtil.hpp"
 
 
-static const uint32_t advGateHitMask[NUM_GATES] = 
-{0x00003F, 0x0F0F0F, 0x000FFF, 0x0F0F00, 0x03FFFF, 0xFFFFFF, 0x00000F, 0x03F03F, 0x000F00, 0x03F000, 0x0F0000, 0};
-//	  25%		TRI		  50%		T23		  75%		FUL		  TR1 		DUO		  TR2 	     D2		  TR3  TRIG		
-
-
-int getAdvGate(int ppqnCount, int pulsesPerStep, int gateMode) { 
-	if (gateMode == 11)
-		return ppqnCount == 0 ? 3 : 0;
-	uint32_t shiftAmt = ppqnCount * (24 / pulsesPerStep);
-	return (int)((advGateHitMask[gateMode] >> shiftAmt) & (uint32_t)0x1);
+static inline uint32_t runRandom(RandomState* randomState) {// sequencer's own generator when given, else the global one
+	return randomState != nullptr ? randomState->u32() : randomu32();
 }
 
-int calcGate1Code(StepAttributes attribute, int ppqnCount, int pulsesPerStep, float randKnob) {
-	// -1 = gate off for whole step, 0 = gate off for current ppqn, 1 = gate on, 2 = clock high, 3 = trigger
-	if (ppqnCount == 0 && attribute.getGate1P() && !(randomUniform() < randKnob))// randomUniform is [0.0, 1.0), see include/util/common.hpp
-		return -1;// must do this first in this method since it will kill rest of step if prob turns off the step
-	if (!attribute.getGate1())
-		return 0;
-	int gateType = attribute.getGate1Mode();
-	if (pulsesPerStep == 1 && gateType == 0)
-		return 2;// clock high
-	if (gateType == 11)
-		return (ppqnCount == 0 ? 3 : 0);
-	return getAdvGate(ppqnCount, pulsesPerStep, gateType);
-}
 
-int calcGate2Code(StepAttributes attribute, int ppqnCount, int pulsesPerStep) {
-	// 0 = gate off, 1 = clock high, 2 = trigger, 3 = gate on
-	if (!attribute.getGate2())
-		return 0;
-	int gateType = attribute.getGate2Mode();
-	if (pulsesPerStep == 1 && gateType == 0)
-		return 2;// clock high
-	if (gateType == 11)
-		return (ppqnCount == 0 ? 3 : 0);
-	return getAdvGate(ppqnCount, pulsesPerStep, gateType);
-}
-
-bool moveIndexRunMode(int* index, int numSteps, int runMode, unsigned long* history) {// some of this code if from PS32EX)
+static bool moveIndexRunModeNoTable(int* index, int numSteps, int runMode, unsigned long* history, RandomState* randomState) {// some of this code if from PS32EX)
 	int reps = 1;
 	// assert((reps * numSteps) <= 0xFFF); // for BRN and RND run modes, history is not a span count but a step count
 	
@@ -117,7 +84,7 @@ bool moveIndexRunMode(int* index, int numSteps, int runMode, unsigned long* hist
 		case MODE_BRN :// brownian random; history base is 0x5000
 			if ((*history) < 0x5001 || (*history) > 0x5FFF) 
 				(*history) = 0x5000 + numSteps * reps;
-			(*index) += (randomu32() % 3) - 1;
+			(*index) += (runRandom(randomState) % 3) - 1;
 			if ((*index) >= numSteps) {
 				(*index) = 0;
 			}
@@ -134,7 +101,7 @@ bool moveIndexRunMode(int* index, int numSteps, int runMode, unsigned long* hist
 		case MODE_RN2 :
 			if ((*history) < 0x6001 || (*history) > 0x6FFF) 
 				(*history) = 0x6000 + numSteps * reps;
-			(*index) = (randomu32() % numSteps) ;
+			(*index) = (runRandom(randomState) % numSteps) ;
 			(*history)--;
 			if ((*history) <= 0x6000) {
 				crossBoundary = true;
@@ -163,6 +130,110 @@ bool moveIndexRunMode(int* index, int numSteps, int runMode, unsigned long* hist
 }
 
 
+// Run order tables for the deterministic run modes (FWD, REV, PPG, PEN, FW2, FW3, FW4): for each mode and length, the step
+// indexes visited in one full pass including repeats, the pass crosses its boundary when wrapping back to position 0.
+// Tables are generated once at plugin load by running moveIndexRunModeNoTable() from a reset state, so both always agree.
+// Each position also keeps the history that moveIndexRunModeNoTable() has there, so that a table position can be converted
+// back to a switch state (and vice versa) when the mode or length change live; stepping is then exactly that of the switch.
+// When a table is used, history holds runOrderHistBase + (runMode << 16) + (numSteps << 9) + position in the pass.
+
+static const int RUN_ORDER_MAX_STEPS = 64;// longest sequence or song in PS16, PS32, SMS and GS64
+static const int RUN_ORDER_TOTAL = 15 * RUN_ORDER_MAX_STEPS * (RUN_ORDER_MAX_STEPS + 1) / 2;// max pass length is at most 15 * numSteps summed over all modes
+static const unsigned long runOrderHistBase = 0x100000;// above the 0x1000-0x6FFF range used by moveIndexRunModeNoTable()
+
+static uint8_t runOrders[RUN_ORDER_TOTAL];
+static uint16_t runOrderHistories[RUN_ORDER_TOTAL];// history of moveIndexRunModeNoTable() at each position, 0 for the start of a pass
+static uint16_t runOrderStart[NUM_MODES][RUN_ORDER_MAX_STEPS + 1];
+static uint16_t runOrderLength[NUM_MODES][RUN_ORDER_MAX_STEPS + 1];// 0 when mode has no table (random modes)
+
+static struct RunOrderInit {
+	RunOrderInit() {
+		static const int passFactor[NUM_MODES] = {1, 1, 2, 2, 0, 0, 2, 3, 4, 0};// max pass length per step, 0 for random modes
+		int start = 0;
+		for (int mode = 0; mode < NUM_MODES; mode++) {
+			for (int numSteps = 0; numSteps <= RUN_ORDER_MAX_STEPS; numSteps++) {
+				runOrderStart[mode][numSteps] = start;
+				runOrderLength[mode][numSteps] = 0;
+				if (numSteps == 0 || passFactor[mode] == 0)
+					continue;
+				int maxLength = passFactor[mode] * numSteps;
+				int index = (mode == MODE_REV ? numSteps - 1 : 0);// same as initRun() in the modules
+				unsigned long history = 0;
+				int length = 0;
+				runOrders[start + length] = index;
+				runOrderHistories[start + length++] = 0;
+				while (!moveIndexRunModeNoTable(&index, numSteps, mode, &history, nullptr) && length < maxLength) {
+					runOrders[start + length] = index;
+					runOrderHistories[start + length++] = (uint16_t)history;
+				}
+				runOrderLength[mode][numSteps] = length;
+				start += length;
+			}
+		}
+	}
+} runOrderInit;
+
+
+static unsigned long normalizeRunHistory(int runMode, unsigned long history) {
+	// moveIndexRunModeNoTable() restarts a pass for any history outside of its mode's range, those are all equivalent to 0
+	unsigned long base;
+	switch (runMode) {
+		case MODE_REV : base = 0x2000; break;
+		case MODE_PPG : base = 0x3000; break;
+		case MODE_PEN : base = 0x4000; break;
+		default : base = 0x1000;// FWD, FW2, FW3, FW4
+	}
+	return (history > base && history <= base + 0xFFF) ? history : 0;
+}
+
+
+static unsigned long tableToSwitchHistory(unsigned long history) {
+	// converts a table history back to the history of moveIndexRunModeNoTable() at that position, other histories are unchanged
+	if (history < runOrderHistBase)
+		return history;
+	int mode = (int)((history - runOrderHistBase) >> 16);
+	int numSteps = (int)((history >> 9) & 0x7F);
+	int pos = (int)(history & 0x1FF);
+	if (mode >= NUM_MODES || numSteps < 1 || numSteps > RUN_ORDER_MAX_STEPS || pos >= runOrderLength[mode][numSteps])
+		return 0;
+	return runOrderHistories[runOrderStart[mode][numSteps] + pos];
+}
+
+
+static int getRunOrderPos(int index, int numSteps, int runMode, unsigned long history) {// -1 when no table or when the state is not on the table
+	if (numSteps < 1 || numSteps > RUN_ORDER_MAX_STEPS || runOrderLength[runMode][numSteps] == 0)
+		return -1;
+	const uint8_t* order = &runOrders[runOrderStart[runMode][numSteps]];
+	int length = runOrderLength[runMode][numSteps];
+	unsigned long histBase = runOrderHistBase + (((unsigned long)runMode) << 16) + (((unsigned long)numSteps) << 9);
+	if (history >= histBase && history < histBase + length && order[history - histBase] == index)
+		return (int)(history - histBase);
+	// history was reset, or mode, length or index were changed externally: only the start of a pass is taken back onto the table,
+	// other states stay on the switch until it reaches the end of the pass (so that there is no search of the table in any step)
+	if (index == order[0] && normalizeRunHistory(runMode, tableToSwitchHistory(history)) == 0)
+		return 0;
+	return -1;
+}
+
+
+bool moveIndexRunMode(int* index, int numSteps, int runMode, unsigned long* history, RandomState* randomState) {
+	int pos = getRunOrderPos(*index, numSteps, runMode, *history);
+	if (pos < 0) {// random modes, and states off the tables (length changed mid-pass for example), the switch takes over until back on a table
+		*history = tableToSwitchHistory(*history);
+		return moveIndexRunModeNoTable(index, numSteps, runMode, history, randomState);
+	}
+	bool crossBoundary = false;
+	pos++;
+	if (pos >= runOrderLength[runMode][numSteps]) {
+		pos = 0;
+		crossBoundary = true;
+	}
+	*index = runOrders[runOrderStart[runMode][numSteps] + pos];
+	*history = runOrderHistBase + (((unsigned long)runMode) << 16) + (((unsigned long)numSteps) << 9) + pos;
+	return crossBoundary;
+}
+
+
 int keyIndexToGateMode(int keyIndex, int pulsesPerStep) {
 	int ret = keyIndex;
 	
@@ -189,6 +260,11 @@ int keyIndexToGateMode(int keyIndex, int pulsesPerStep) {
 
 /*CHANGE LOG
 
+0.6.17:
+run order tables for the deterministic run modes in moveIndexRunMode()
+gate codes from a table indexed by pulses per step and gate mode, with the probability draw made only for steps that have gate 1 on
+run order tables keep the exact switch stepping when the length or mode change in the middle of a pass
+
 0.6.12:
 revert PPG and add the new one as a run mode called PND (Pendulum); fix PS, SMS, GS toJson/fromJson to adjust old patches
 fix PPG run mode, so that it is a true PPG (ex: 1,2,3,2,1,2... instead of 1,2,3,3,2,1,1,2...)
@@ -7,6 +7,7 @@
 
 
 #include "ImpromptuModular.hpp"
+#include "AdvGateUtil.hpp"
 
 
 // General constants
@@ -14,7 +15,8 @@
 enum RunModeIds {MODE_FWD, MODE_REV, MODE_PPG, MODE_PEN, MODE_BRN, MODE_RND, MODE_FW2, MODE_FW3, MODE_FW4, MODE_RN2, NUM_MODES};
 static const std::string modeLabels[NUM_MODES] = {"FWD","REV","PPG","PEN","BRN","RND","FW2","FW3","FW4","RN2"};// PS16 and SMS16 use NUM_MODES - 1 since no RN2!!!
 
-static const int NUM_GATES = 12;// advanced gate types												
+static const int NUM_GATES = AdvGateTable::NUM_BUILTIN;// advanced gate types												
+static const int MAX_PPS = 24;// max pulses per step
 
 
 //*****************************************************************************
@@ -150,6 +152,29 @@ inline bool calcGate(int gateCode, Trigger clockTrigger, unsigned long clockStep
 	return clockStep < (unsigned long) (sampleRate * 0.01f);
 }
 
+inline int calcGateCode(int gateMode, int ppqnCount, int pulsesPerStep) {// 0 = gate off for current ppqn, 1 = gate on, 2 = clock high, 3 = trigger
+	// gate modes are the built-in patterns, see AdvGateUtil.hpp; PhraseSeq pulses have always been 24 / pulsesPerStep steps of the 24 step 
+	//   masks apart (rounded down), which for the pps that don't divide 24 (10, 14, 18, 20, 22) is the spacing of the next pps that does
+	return advGates.getCode(gateMode, ppqnCount, 24 / (24 / pulsesPerStep));
+}
+
+inline int calcGate1Code(StepAttributes attribute, int ppqnCount, int pulsesPerStep, float randKnob, RandomState* randomState = nullptr) {
+	// -1 = gate off for whole step, 0 = gate off for current ppqn, 1 = gate on, 2 = clock high, 3 = trigger
+	// probability is drawn from randomState when given (sequencer's own generator), else from the global generator
+	if (!attribute.getGate1())
+		return 0;
+	if (ppqnCount == 0 && attribute.getGate1P() && !((randomState != nullptr ? randomState->uniform() : randomUniform()) < randKnob))// randomUniform is [0.0, 1.0), see include/util/common.hpp
+		return -1;// only drawn on the first ppqn of a step, and callers don't recalculate the rest of a killed step
+	return calcGateCode(attribute.getGate1Mode(), ppqnCount, pulsesPerStep);
+}
+
+inline int calcGate2Code(StepAttributes attribute, int ppqnCount, int pulsesPerStep) {
+	// 0 = gate off, 1 = gate on, 2 = clock high, 3 = trigger
+	if (!attribute.getGate2())
+		return 0;
+	return calcGateCode(attribute.getGate2Mode(), ppqnCount, pulsesPerStep);
+}
+
 inline int gateModeToKeyLightIndex(StepAttributes attribute, bool isGate1) {// keyLight index now matches gate modes, so no mapping table needed anymore
 	return isGate1 ? attribute.getGate1Mode() : attribute.getGate2Mode();
 }
@@ -158,10 +183,7 @@ inline int gateModeToKeyLightIndex(StepAttributes attribute, bool isGate1) {// k
 
 // Other methods (code in PhraseSeqUtil.cpp)	
 
-int getAdvGate(int ppqnCount, int pulsesPerStep, int gateMode);
-int calcGate1Code(StepAttributes attribute, int ppqnCount, int pulsesPerStep, float randKnob);
-int calcGate2Code(StepAttributes attribute, int ppqnCount, int pulsesPerStep);
-bool moveIndexRunMode(int* index, int numSteps, int runMode, unsigned long* history);
+bool moveIndexRunMode(int* index, int numSteps, int runMode, unsigned long* history, RandomState* randomState = nullptr);// random modes draw from randomState when given
 int keyIndexToGateMode(int keyIndex, int pulsesPerStep);
 
 
@@ -14,7 +14,7 @@
 
 
 #include "FundamentalUtil.hpp"
-#include "PhraseSeqUtil.hpp"
+#include "PhraseSeqKernel.hpp"
 
 
 struct SemiModularSynth : Module {
@@ -196,22 +196,18 @@ struct SemiModularSynth : Module {
 	StepAttributes attributes[16][16];// First index is patten number, 2nd index is step (see enum AttributeBitMasks for details)
 	bool resetOnRun;
 	bool attached;
+	int lfoShape2;// shape of the LFO output labeled TRI, see LowFrequencyOscillator::ShapeIds
 
 	// No need to save
+	PhraseSeqKernel<16, 1> psk;// run engine (clock, run modes, phrases, slides and gates)
 	int stepIndexEdit;
-	int stepIndexRun;
 	int phraseIndexEdit;
-	int phraseIndexRun;
 	long infoCopyPaste;// 0 when no info, positive downward step counter timer when copy, negative upward when paste
 	unsigned long editingGate;// 0 when no edit gate, downward step counter timer when edit gate
 	float editingGateCV;// no need to initialize, this is a companion to editingGate (output this only when editingGate > 0)
 	int editingGateKeyLight;// no need to initialize, this is a companion to editingGate (use this only when editingGate > 0)
 	unsigned long editingType;// similar to editingGate, but just for showing remanent gate type (nothing played); uses editingGateKeyLight
-	unsigned long stepIndexRunHistory;
-	unsigned long phraseIndexRunHistory;
 	int displayState;
-	unsigned long slideStepsRemain;// 0 when no slide under way, downward step counter when sliding
-	float slideCVdelta;// no need to initialize, this is a companion to slideStepsRemain
 	float cvCPbuffer[16];// copy paste buffer for CVs
 	StepAttributes attribCPbuffer[16];
 	SeqAttributes seqAttribCPbuffer;
@@ -220,16 +216,12 @@ struct SemiModularSynth : Module {
 	int countCP;// number of steps to paste (in case CPMODE_PARAM changes between copy and paste)
 	int startCP;
 	long clockIgnoreOnReset;
-	unsigned long clockPeriod;// counts number of step() calls upward from last clock (reset after clock processed)
 	long tiedWarning;// 0 when no warning, positive downward step counter timer when warning
 	long attachedWarning;// 0 when no warning, positive downward step counter timer when warning
-	int gate1Code;
-	int gate2Code;
 	long revertDisplay;
 	long editingGateLength;// 0 when no info, positive when gate1, negative when gate2
 	long lastGateEdit;
 	long editingPpqn;// 0 when no info, positive downward step counter timer when editing ppqn
-	int ppqnCount;
 	
 	// VCO
 	// none
@@ -241,21 +233,67 @@ struct SemiModularSynth : Module {
 	// none
 	
 	// ADSR
-	bool decaying = false;
-	float env = 0.0f;
+	ADSREnvelope adsr;
 	
 	// VCF
-	LadderFilter filter;
+	VoltageControlledFilter vcf;
+	
+	// Synth section controls (no need to initialize, refreshed once per block of samples in refreshSynthControls())
+	float* vcoPitchSrc;// pre-patching sources, these are the edges of the synth's internal signal path
+	float* vcaInSrc;
+	float* vcaLinSrc;
+	float* adsrGateSrc;
+	float* vcfInSrc;
+	float vcoPitchKnob;
+	float vcoPitchOffset;// fine + octave
+	float vcoFmDepth;
+	bool vcoFmActive;
+	float vcoPw;
+	float vcoPwmDepth;
+	bool vcoSinActive;
+	bool vcoTriActive;
+	bool vcoSawActive;
+	float vcaLevel;
+	bool vcfActive;
+	bool vcfDriveActive;
+	bool vcfResActive;
+	bool vcfFreqActive;
+	float vcfFreqCvDepth;
+	float vcfPitchKnob;
+	bool lfoSinActive;
+	bool lfoShape2Active;
+	float lfoSinValue;
+	float lfoSinDelta;
+	float lfoShape2Value;
+	float lfoShape2Delta;
+	float lfoGain;
+	float lfoOffset;
 	
 
 	unsigned int lightRefreshCounter = 0;
+	LightState lightState;
+	struct DisplaySnapshot {// what the display shows, published in the light refresh so that the widget doesn't read the live sequencer
+		bool editingSequence;
+		long infoCopyPaste;
+		bool seqCopied;
+		float cpMode;
+		bool editingPpqn;
+		int pulsesPerStep;
+		int displayState;
+		int runMode;// of the sequence being edited, or of the song
+		int length;// of the sequence being edited, or number of phrases in the song
+		int transpose;
+		int rotate;
+		int seqNum;// sequence being edited, or sequence of the phrase being edited
+	};
+	SeqLock<DisplaySnapshot> displaySnapshot;
 	float resetLight = 0.0f;
 	int sequenceKnob = 0;
 	Trigger resetTrigger;
 	Trigger leftTrigger;
 	Trigger rightTrigger;
 	Trigger runningTrigger;
-	Trigger clockTrigger;
+	ClockInput clockTrigger;
 	Trigger octTriggers[7];
 	Trigger octmTrigger;
 	Trigger gate1Trigger;
@@ -286,7 +324,10 @@ struct SemiModularSynth : Module {
 
 
 	SemiModularSynth() : Module(NUM_PARAMS, NUM_INPUTS, NUM_OUTPUTS, NUM_LIGHTS) {
+		lightState.init(&lights);
+		psk.construct(cv, attributes, sequences, phrase, &phrases, &runModeSong, &pulsesPerStep, nullptr, nullptr);
 		onReset();
+		publishDisplaySnapshot();
 		
 		// VCO
 		oscillatorVco.soft = false;//params[VCO_SYNC_PARAM].value <= 0.0f;
@@ -299,10 +340,17 @@ struct SemiModularSynth : Module {
 		oscillatorLfo.setPulseWidth(0.5f);//params[PW_PARAM].value + params[PWM_PARAM].value * inputs[PW_INPUT].value / 10.0f);
 		oscillatorLfo.offset = false;//(params[OFFSET_PARAM].value > 0.0f);
 		oscillatorLfo.invert = false;//(params[INVERT_PARAM].value <= 0.0f);
+		lfoSinValue = 0.0f;
+		lfoSinDelta = 0.0f;
+		lfoShape2Value = 0.0f;
+		lfoShape2Delta = 0.0f;
+		
+		refreshSynthControls();
 	}
 	
 
 	void onReset() override {
+		IM_TIME_SCOPE("SemiModularSynth", TIMING_RESET);
 		// SEQUENCER
 		autoseq = false;
 		autostepLen = false;
@@ -334,13 +382,13 @@ struct SemiModularSynth : Module {
 		editingType = 0ul;
 		infoCopyPaste = 0l;
 		displayState = DISP_NORMAL;
-		slideStepsRemain = 0ul;
 		attached = false;
-		clockPeriod = 0ul;
+		psk.initClockPeriod();
 		tiedWarning = 0ul;
 		attachedWarning = 0l;
 		revertDisplay = 0l;
 		resetOnRun = false;
+		lfoShape2 = LowFrequencyOscillator::SHAPE_TRI;
 		editingGateLength = 0l;
 		lastGateEdit = 1l;
 		editingPpqn = 0l;
@@ -352,7 +400,7 @@ struct SemiModularSynth : Module {
 		clkValue = 0.0f;
 		
 		// VCF
-		filter.reset();
+		vcf.reset();
 	}
 
 	
@@ -371,22 +419,14 @@ struct SemiModularSynth : Module {
 	
 	
 	void initRun() {// run button activated or run edge in run input jack
-		phraseIndexRun = (runModeSong == MODE_REV ? phrases - 1 : 0);
-		phraseIndexRunHistory = 0;
-
-		int seq = (isEditingSequence() ? seqIndexEdit : phrase[phraseIndexRun]);
-		stepIndexRun = (sequences[seq].getRunMode() == MODE_REV ? sequences[seq].getLength() - 1 : 0);
-		stepIndexRunHistory = 0;
-
-		ppqnCount = 0;
-		gate1Code = calcGate1Code(attributes[seq][stepIndexRun], 0, pulsesPerStep, params[GATE1_KNOB_PARAM].value);
-		gate2Code = calcGate2Code(attributes[seq][stepIndexRun], 0, pulsesPerStep);
-		slideStepsRemain = 0ul;
+		psk.initRun(isEditingSequence(), seqIndexEdit, params[GATE1_KNOB_PARAM].value);
 		clockIgnoreOnReset = (long) (clockIgnoreOnResetDuration * engineGetSampleRate());
 	}
 	
 	
 	json_t *toJson() override {
+		IM_TIME_SCOPE("SemiModularSynth", TIMING_TOJSON);
+		IM_LOG_LIGHTS("SemiModularSynth", lightState);
 		json_t *rootJ = json_object();
 
 		// panelTheme
@@ -444,6 +484,9 @@ struct SemiModularSynth : Module {
 		// resetOnRun
 		json_object_set_new(rootJ, "resetOnRun", json_boolean(resetOnRun));
 		
+		// lfoShape2
+		json_object_set_new(rootJ, "lfoShape2", json_integer(lfoShape2));
+		
 		// stepIndexEdit
 		json_object_set_new(rootJ, "stepIndexEdit", json_integer(stepIndexEdit));
 	
@@ -460,6 +503,7 @@ struct SemiModularSynth : Module {
 	}
 
 	void fromJson(json_t *rootJ) override {
+		IM_TIME_SCOPE("SemiModularSynth", TIMING_FROMJSON);
 		// panelTheme
 		json_t *panelThemeJ = json_object_get(rootJ, "panelTheme");
 		if (panelThemeJ)
@@ -590,6 +634,7 @@ struct SemiModularSynth : Module {
 				if (phraseArrayJ)
 					phrase[i] = json_integer_value(phraseArrayJ);
 			}
+		psk.invalidateSeqRun();
 			
 		// phrases
 		json_t *phrasesJ = json_object_get(rootJ, "phrases");
@@ -628,6 +673,11 @@ struct SemiModularSynth : Module {
 		if (resetOnRunJ)
 			resetOnRun = json_is_true(resetOnRunJ);
 
+		// lfoShape2
+		json_t *lfoShape2J = json_object_get(rootJ, "lfoShape2");
+		if (lfoShape2J)
+			lfoShape2 = clamp((int)json_integer_value(lfoShape2J), 0, LowFrequencyOscillator::NUM_SHAPES - 1);
+
 		// stepIndexEdit
 		json_t *stepIndexEditJ = json_object_get(rootJ, "stepIndexEdit");
 		if (stepIndexEditJ)
@@ -710,9 +760,9 @@ struct SemiModularSynth : Module {
 			}
 			if (running && attached) {
 				if (editingSequence)
-					stepIndexEdit = stepIndexRun;
+					stepIndexEdit = psk.getStepIndexRun(0);
 				else
-					phraseIndexEdit = phraseIndexRun;
+					phraseIndexEdit = psk.getPhraseIndexRun();
 			}
 			
 			// Copy button
@@ -814,6 +864,7 @@ struct SemiModularSynth : Module {
 							countCP = 16;
 							infoCopyPaste *= 2l;
 						}					
+						psk.invalidateSeqRun();
 					}
 					displayState = DISP_NORMAL;
 				}
@@ -869,7 +920,7 @@ struct SemiModularSynth : Module {
 					else {
 						phraseIndexEdit = moveIndex(phraseIndexEdit, phraseIndexEdit + delta, 16);
 						if (!running)
-							phraseIndexRun = phraseIndexEdit;
+							psk.setPhraseIndexRun(phraseIndexEdit);
 					}
 				}
 			}
@@ -901,7 +952,7 @@ struct SemiModularSynth : Module {
 						else {
 							phraseIndexEdit = stepPressed;
 							if (!running)
-								phraseIndexRun = phraseIndexEdit;
+								psk.setPhraseIndexRun(phraseIndexEdit);
 						}
 					}
 					else if (attached)
@@ -1008,8 +1059,10 @@ struct SemiModularSynth : Module {
 							}
 						}
 						else {
-							if (!attached || (attached && !running))
+							if (!attached || (attached && !running)) {
 								phrase[phraseIndexEdit] = clamp(phrase[phraseIndexEdit] + deltaKnob, 0, 16 - 1);
+								psk.invalidateSeqRun();
+							}
 							else
 								attachedWarning = (long) (warningTime * sampleRate / displayRefreshStepSkips);
 						}
@@ -1148,47 +1201,9 @@ struct SemiModularSynth : Module {
 		float clockInput = inputs[CLOCK_INPUT].active ? inputs[CLOCK_INPUT].value : clkValue;// Pre-patching
 		if (running && clockIgnoreOnReset == 0l) {
 			if (clockTrigger.process(clockInput)) {
-				ppqnCount++;
-				if (ppqnCount >= pulsesPerStep)
-					ppqnCount = 0;
-
-				int newSeq = seqIndexEdit;// good value when editingSequence, overwrite if not editingSequence
-				if (ppqnCount == 0) {
-					float slideFromCV = 0.0f;
-					if (editingSequence) {
-						slideFromCV = cv[seqIndexEdit][stepIndexRun];
-						moveIndexRunMode(&stepIndexRun, sequences[seqIndexEdit].getLength(), sequences[seqIndexEdit].getRunMode(), &stepIndexRunHistory);
-					}
-					else {
-						slideFromCV = cv[phrase[phraseIndexRun]][stepIndexRun];
-						if (moveIndexRunMode(&stepIndexRun, sequences[phrase[phraseIndexRun]].getLength(), sequences[phrase[phraseIndexRun]].getRunMode(), &stepIndexRunHistory)) {
-							moveIndexRunMode(&phraseIndexRun, phrases, runModeSong, &phraseIndexRunHistory);
-							stepIndexRun = (sequences[phrase[phraseIndexRun]].getRunMode() == MODE_REV ? sequences[phrase[phraseIndexRun]].getLength() - 1 : 0);// must always refresh after phraseIndexRun has changed
-						}
-						newSeq = phrase[phraseIndexRun];
-					}
-					
-					// Slide
-					if (attributes[newSeq][stepIndexRun].getSlide()) {
-						slideStepsRemain =   (unsigned long) (((float)clockPeriod * pulsesPerStep) * params[SLIDE_KNOB_PARAM].value / 2.0f);
-						if (slideStepsRemain != 0ul) {
-							float slideToCV = cv[newSeq][stepIndexRun];
-							slideCVdelta = (slideToCV - slideFromCV)/(float)slideStepsRemain;
-						}
-					}
-					else 
-						slideStepsRemain = 0ul;
-				}
-				else {
-					if (!editingSequence)
-						newSeq = phrase[phraseIndexRun];
-				}
-				if (gate1Code != -1 || ppqnCount == 0)
-					gate1Code = calcGate1Code(attributes[newSeq][stepIndexRun], ppqnCount, pulsesPerStep, params[GATE1_KNOB_PARAM].value);
-				gate2Code = calcGate2Code(attributes[newSeq][stepIndexRun], ppqnCount, pulsesPerStep);
-				clockPeriod = 0ul;				
+				psk.clockStep(editingSequence, seqIndexEdit, params[GATE1_KNOB_PARAM].value, params[SLIDE_KNOB_PARAM].value, clockTrigger.getPeriod());
 			}
-			clockPeriod++;
+			psk.step();
 		}	
 		
 		// Reset
@@ -1196,30 +1211,31 @@ struct SemiModularSynth : Module {
 			initRun();// must be after sequence reset
 			resetLight = 1.0f;
 			displayState = DISP_NORMAL;
+			clockIgnoreOnReset = (long) (clockIgnoreOnResetDuration * sampleRate);
+			clockTrigger.reset();
 		}
+		psk.publishPendingRun();// run state changes from the reset, the ui thread and the phrase edits, for lookahead()
 		
 		
 		//********** Outputs and lights **********
 				
 		// CV and gates outputs
-		int seq = editingSequence ? (seqIndexEdit) : (running ? phrase[phraseIndexRun] : phrase[phraseIndexEdit]);
-		int step = editingSequence ? (running ? stepIndexRun : stepIndexEdit) : (stepIndexRun);
+		int seq = running ? psk.getSeqRun(editingSequence, seqIndexEdit) : (editingSequence ? seqIndexEdit : phrase[phraseIndexEdit]);
+		int step = editingSequence ? (running ? psk.getStepIndexRun(0) : stepIndexEdit) : (psk.getStepIndexRun(0));
 		if (running) {
 			bool muteGate1 = !editingSequence && (params[GATE1_PARAM].value > 0.5f);// live mute
 			bool muteGate2 = !editingSequence && (params[GATE2_PARAM].value > 0.5f);// live mute
-			float slideOffset = (slideStepsRemain > 0ul ? (slideCVdelta * (float)slideStepsRemain) : 0.0f);
-			outputs[CV_OUTPUT].value = cv[seq][step] - slideOffset;
+			outputs[CV_OUTPUT].value = cv[seq][step] - psk.calcSlideOffset(0);
 			bool retriggingOnReset = (clockIgnoreOnReset != 0l && retrigGatesOnReset);
-			outputs[GATE1_OUTPUT].value = (calcGate(gate1Code, clockTrigger, clockPeriod, sampleRate) && !muteGate1 && !retriggingOnReset) ? 10.0f : 0.0f;
-			outputs[GATE2_OUTPUT].value = (calcGate(gate2Code, clockTrigger, clockPeriod, sampleRate) && !muteGate2 && !retriggingOnReset) ? 10.0f : 0.0f;
+			outputs[GATE1_OUTPUT].value = (psk.calcGate1(0, clockTrigger, sampleRate) && !muteGate1 && !retriggingOnReset) ? 10.0f : 0.0f;
+			outputs[GATE2_OUTPUT].value = (psk.calcGate2(0, clockTrigger, sampleRate) && !muteGate2 && !retriggingOnReset) ? 10.0f : 0.0f;
 		}
 		else {// not running 
 			outputs[CV_OUTPUT].value = (editingGate > 0ul) ? editingGateCV : cv[seq][step];
 			outputs[GATE1_OUTPUT].value = (editingGate > 0ul) ? 10.0f : 0.0f;
 			outputs[GATE2_OUTPUT].value = (editingGate > 0ul) ? 10.0f : 0.0f;
 		}
-		if (slideStepsRemain > 0ul)
-			slideStepsRemain--;
+		psk.decSlideStepsRemain();
 		
 		lightRefreshCounter++;
 		if (lightRefreshCounter >= displayRefreshStepSkips) {
@@ -1257,10 +1273,10 @@ struct SemiModularSynth : Module {
 				else {// normal led display (i.e. not length)
 					// Run cursor (green)
 					if (editingSequence)
-						green = ((running && (i == stepIndexRun)) ? 1.0f : 0.0f);
+						green = ((running && (i == psk.getStepIndexRun(0))) ? 1.0f : 0.0f);
 					else {
-						green = ((running && (i == phraseIndexRun)) ? 1.0f : 0.0f);
-						green += ((running && (i == stepIndexRun) && i != phraseIndexEdit) ? 0.1f : 0.0f);
+						green = ((running && (i == psk.getPhraseIndexRun())) ? 1.0f : 0.0f);
+						green += ((running && (i == psk.getStepIndexRun(0)) && i != phraseIndexEdit) ? 0.1f : 0.0f);
 						green = clamp(green, 0.0f, 1.0f);
 					}
 					// Edit cursor (red)
@@ -1272,14 +1288,14 @@ struct SemiModularSynth : Module {
 					if (editingSequence)
 						gate = attributes[seqIndexEdit][i].getGate1();
 					else if (!editingSequence && (attached && running))
-						gate = attributes[phrase[phraseIndexRun]][i].getGate1();
+						gate = attributes[phrase[psk.getPhraseIndexRun()]][i].getGate1();
 					white = ((green == 0.0f && red == 0.0f && gate && displayState != DISP_MODE) ? 0.04f : 0.0f);
 					if (editingSequence && white != 0.0f) {
 						green = 0.02f; white = 0.0f;
 					}
 				}
 				setGreenRed(STEP_PHRASE_LIGHTS + i * 3, green, red);
-				lights[STEP_PHRASE_LIGHTS + i * 3 + 2].value = white;
+				lightState.set(STEP_PHRASE_LIGHTS + i * 3 + 2, white);
 			}
 		
 			// Octave lights
@@ -1287,20 +1303,20 @@ struct SemiModularSynth : Module {
 			if (editingSequence)
 				octCV = cv[seqIndexEdit][stepIndexEdit];
 			else
-				octCV = cv[phrase[phraseIndexEdit]][stepIndexRun];
+				octCV = cv[phrase[phraseIndexEdit]][psk.getStepIndexRun(0)];
 			int octLightIndex = (int) floor(octCV + 3.0f);
 			for (int i = 0; i < 7; i++) {
 				if (!editingSequence && (!attached || !running))// no oct lights when song mode and either (detached [1] or stopped [2])
 												// [1] makes no sense, can't mod steps and stepping though seq that may not be playing
 												// [2] CV is set to 0V when not running and in song mode, so cv[][] makes no sense to display
-					lights[OCTAVE_LIGHTS + i].value = 0.0f;
+					lightState.set(OCTAVE_LIGHTS + i, 0.0f);
 				else {
 					if (tiedWarning > 0l) {
 						bool warningFlashState = calcWarningFlash(tiedWarning, (long) (warningTime * sampleRate / displayRefreshStepSkips));
-						lights[OCTAVE_LIGHTS + i].value = (warningFlashState && (i == (6 - octLightIndex))) ? 1.0f : 0.0f;
+						lightState.set(OCTAVE_LIGHTS + i, (warningFlashState && (i == (6 - octLightIndex))) ? 1.0f : 0.0f);
 					}
 					else				
-						lights[OCTAVE_LIGHTS + i].value = (i == (6 - octLightIndex) ? 1.0f : 0.0f);
+						lightState.set(OCTAVE_LIGHTS + i, (i == (6 - octLightIndex) ? 1.0f : 0.0f));
 				}
 			}
 			
@@ -1309,7 +1325,7 @@ struct SemiModularSynth : Module {
 			if (editingSequence) 
 				cvValOffset = cv[seqIndexEdit][stepIndexEdit] + 10.0f;//to properly handle negative note voltages
 			else	
-				cvValOffset = cv[phrase[phraseIndexEdit]][stepIndexRun] + 10.0f;//to properly handle negative note voltages
+				cvValOffset = cv[phrase[phraseIndexEdit]][psk.getStepIndexRun(0)] + 10.0f;//to properly handle negative note voltages
 			int keyLightIndex = clamp( (int)((cvValOffset-floor(cvValOffset)) * 12.0f + 0.5f),  0,  11);
 			if (editingPpqn != 0) {
 				for (int i = 0; i < 12; i++) {
@@ -1346,28 +1362,28 @@ struct SemiModularSynth : Module {
 			}
 			else {
 				for (int i = 0; i < 12; i++) {
-					lights[KEY_LIGHTS + i * 2 + 0].value = 0.0f;
+					lightState.set(KEY_LIGHTS + i * 2 + 0, 0.0f);
 					if (!editingSequence && (!attached || !running))// no keyboard lights when song mode and either (detached [1] or stopped [2])
 													// [1] makes no sense, can't mod steps and stepping though seq that may not be playing
 													// [2] CV is set to 0V when not running and in song mode, so cv[][] makes no sense to display
-						lights[KEY_LIGHTS + i * 2 + 1].value = 0.0f;
+						lightState.set(KEY_LIGHTS + i * 2 + 1, 0.0f);
 					else {
 						if (tiedWarning > 0l) {
 							bool warningFlashState = calcWarningFlash(tiedWarning, (long) (warningTime * sampleRate / displayRefreshStepSkips));
-							lights[KEY_LIGHTS + i * 2 + 1].value = (warningFlashState && i == keyLightIndex) ? 1.0f : 0.0f;
+							lightState.set(KEY_LIGHTS + i * 2 + 1, (warningFlashState && i == keyLightIndex) ? 1.0f : 0.0f);
 						}
 						else {
 							if (editingGate > 0ul && editingGateKeyLight != -1)
-								lights[KEY_LIGHTS + i * 2 + 1].value = (i == editingGateKeyLight ? ((float) editingGate / (float)(gateTime * sampleRate / displayRefreshStepSkips)) : 0.0f);
+								lightState.set(KEY_LIGHTS + i * 2 + 1, (i == editingGateKeyLight ? ((float) editingGate / (float)(gateTime * sampleRate / displayRefreshStepSkips)) : 0.0f));
 							else
-								lights[KEY_LIGHTS + i * 2 + 1].value = (i == keyLightIndex ? 1.0f : 0.0f);
+								lightState.set(KEY_LIGHTS + i * 2 + 1, (i == keyLightIndex ? 1.0f : 0.0f));
 						}
 					}
 				}	
 			}	
 			
 			// Key mode light (note or gate type)
-			lights[KEYNOTE_LIGHT].value = editingGateLength == 0l ? 10.0f : 0.0f;
+			lightState.set(KEYNOTE_LIGHT, editingGateLength == 0l ? 10.0f : 0.0f);
 			if (editingGateLength == 0l)
 				setGreenRed(KEYGATE_LIGHT, 0.0f, 0.0f);
 			else if (editingGateLength > 0l)
@@ -1382,40 +1398,40 @@ struct SemiModularSynth : Module {
 				setGateLight(false, GATE1_LIGHT);
 				setGateLight(false, GATE2_LIGHT);
 				setGreenRed(GATE1_PROB_LIGHT, 0.0f, 0.0f);
-				lights[SLIDE_LIGHT].value = 0.0f;
-				lights[TIE_LIGHT].value = 0.0f;
+				lightState.set(SLIDE_LIGHT, 0.0f);
+				lightState.set(TIE_LIGHT, 0.0f);
 			}
 			else {
 				StepAttributes attributesVal = attributes[seqIndexEdit][stepIndexEdit];
 				if (!editingSequence)
-					attributesVal = attributes[phrase[phraseIndexEdit]][stepIndexRun];
+					attributesVal = attributes[phrase[phraseIndexEdit]][psk.getStepIndexRun(0)];
 				//
 				setGateLight(attributesVal.getGate1(), GATE1_LIGHT);
 				setGateLight(attributesVal.getGate2(), GATE2_LIGHT);
 				setGreenRed(GATE1_PROB_LIGHT, attributesVal.getGate1P() ? 1.0f : 0.0f, attributesVal.getGate1P() ? 1.0f : 0.0f);
-				lights[SLIDE_LIGHT].value = attributesVal.getSlide() ? 1.0f : 0.0f;
+				lightState.set(SLIDE_LIGHT, attributesVal.getSlide() ? 1.0f : 0.0f);
 				if (tiedWarning > 0l) {
 					bool warningFlashState = calcWarningFlash(tiedWarning, (long) (warningTime * sampleRate / displayRefreshStepSkips));
-					lights[TIE_LIGHT].value = (warningFlashState) ? 1.0f : 0.0f;
+					lightState.set(TIE_LIGHT, (warningFlashState) ? 1.0f : 0.0f);
 				}
 				else
-					lights[TIE_LIGHT].value = attributesVal.getTied() ? 1.0f : 0.0f;
+					lightState.set(TIE_LIGHT, attributesVal.getTied() ? 1.0f : 0.0f);
 			}
 
 			// Attach light
 			if (attachedWarning > 0l) {
 				bool warningFlashState = calcWarningFlash(attachedWarning, (long) (warningTime * sampleRate / displayRefreshStepSkips));
-				lights[ATTACH_LIGHT].value = (warningFlashState) ? 1.0f : 0.0f;
+				lightState.set(ATTACH_LIGHT, (warningFlashState) ? 1.0f : 0.0f);
 			}
 			else
-				lights[ATTACH_LIGHT].value = (attached ? 1.0f : 0.0f);
+				lightState.set(ATTACH_LIGHT, (attached ? 1.0f : 0.0f));
 			
 			// Reset light
-			lights[RESET_LIGHT].value =	resetLight;	
+			lightState.set(RESET_LIGHT, resetLight);	
 			resetLight -= (resetLight / lightLambda) * engineGetSampleTime() * displayRefreshStepSkips;
 			
 			// Run light
-			lights[RUN_LIGHT].value = running ? 1.0f : 0.0f;
+			lightState.set(RUN_LIGHT, running ? 1.0f : 0.0f);
 			
 			if (editingGate > 0ul)
 				editingGate--;
@@ -1442,154 +1458,193 @@ struct SemiModularSynth : Module {
 					displayState = DISP_NORMAL;
 				revertDisplay--;
 			}
+			
+			publishDisplaySnapshot();
 		}// lightRefreshCounter
 		
 		if (clockIgnoreOnReset > 0l)
 			clockIgnoreOnReset--;
 
 		
-		// VCO
-		oscillatorVco.analog = params[VCO_MODE_PARAM].value > 0.0f;
-		float pitchFine = 3.0f * quadraticBipolar(params[VCO_FINE_PARAM].value);
-		float pitchCv = 12.0f * (inputs[VCO_PITCH_INPUT].active ? inputs[VCO_PITCH_INPUT].value : outputs[CV_OUTPUT].value);// Pre-patching
-		float pitchOctOffset = 12.0f * params[VCO_OCT_PARAM].value;
-		if (inputs[VCO_FM_INPUT].active) {
-			pitchCv += quadraticBipolar(params[VCO_FM_PARAM].value) * 12.0f * inputs[VCO_FM_INPUT].value;
+		// Synth section (VCO -> VCA -> VCF, with ADSR and LFO)
+		if ((lightRefreshCounter & userInputsStepSkipMask) == 0) {
+			refreshSynthControls();
 		}
-		oscillatorVco.setPitch(params[VCO_FREQ_PARAM].value, pitchFine + pitchCv + pitchOctOffset);
-		oscillatorVco.setPulseWidth(params[VCO_PW_PARAM].value + params[VCO_PWM_PARAM].value * inputs[VCO_PW_INPUT].value / 10.0f);
-		oscillatorVco.syncEnabled = inputs[VCO_SYNC_INPUT].active;
-		oscillatorVco.process(engineGetSampleTime(), inputs[VCO_SYNC_INPUT].value);
-		if (outputs[VCO_SIN_OUTPUT].active)
+		float sampleTime = engineGetSampleTime();
+		if ((lightRefreshCounter & userInputsStepSkipMask) == 0) {
+			refreshLfo(sampleTime * (float)(userInputsStepSkipMask + 1));
+		}
+		
+		// VCO
+		float pitchCv = 12.0f * (*vcoPitchSrc);
+		if (vcoFmActive)
+			pitchCv += vcoFmDepth * inputs[VCO_FM_INPUT].value;
+		oscillatorVco.setPitch(vcoPitchKnob, vcoPitchOffset + pitchCv);
+		oscillatorVco.setPulseWidth(vcoPw + vcoPwmDepth * inputs[VCO_PW_INPUT].value);
+		oscillatorVco.process(sampleTime, inputs[VCO_SYNC_INPUT].value);
+		if (vcoSinActive)
 			outputs[VCO_SIN_OUTPUT].value = 5.0f * oscillatorVco.sin();
-		if (outputs[VCO_TRI_OUTPUT].active)
+		if (vcoTriActive)
 			outputs[VCO_TRI_OUTPUT].value = 5.0f * oscillatorVco.tri();
-		if (outputs[VCO_SAW_OUTPUT].active)
+		if (vcoSawActive)
 			outputs[VCO_SAW_OUTPUT].value = 5.0f * oscillatorVco.saw();
-		//if (outputs[VCO_SQR_OUTPUT].active)
-			outputs[VCO_SQR_OUTPUT].value = 5.0f * oscillatorVco.sqr();		
+		outputs[VCO_SQR_OUTPUT].value = 5.0f * oscillatorVco.sqr();// always needed since pre-patched into VCA
 			
 			
 		// CLK
-		if ((lightRefreshCounter & userInputsStepSkipMask) == 0) {
-			oscillatorClk.setPitch(params[CLK_FREQ_PARAM].value + log2f(pulsesPerStep));
-			oscillatorClk.setPulseWidth(params[CLK_PW_PARAM].value);
-		}	
-		oscillatorClk.step(engineGetSampleTime());
+		oscillatorClk.step(sampleTime);
 		oscillatorClk.setReset(inputs[RESET_INPUT].value + params[RESET_PARAM].value + params[RUN_PARAM].value + inputs[RUNCV_INPUT].value);//inputs[RESET_INPUT].value);
 		clkValue = 5.0f * oscillatorClk.sqr();	
 		outputs[CLK_OUT_OUTPUT].value = clkValue;
 		
 		
 		// VCA
-		float vcaIn = inputs[VCA_IN1_INPUT].active ? inputs[VCA_IN1_INPUT].value : outputs[VCO_SQR_OUTPUT].value;// Pre-patching
-		float vcaLin = inputs[VCA_LIN1_INPUT].active ? inputs[VCA_LIN1_INPUT].value : outputs[ADSR_ENVELOPE_OUTPUT].value;// Pre-patching
-		float v = vcaIn * params[VCA_LEVEL1_PARAM].value;
-		v *= clamp(vcaLin / 10.0f, 0.0f, 1.0f);
-		outputs[VCA_OUT1_OUTPUT].value = v;
+		outputs[VCA_OUT1_OUTPUT].value = (*vcaInSrc) * vcaLevel * clamp((*vcaLinSrc) / 10.0f, 0.0f, 1.0f);
 
 				
 		// ADSR
-		float attack = clamp(params[ADSR_ATTACK_PARAM].value, 0.0f, 1.0f);
-		float decay = clamp(params[ADSR_DECAY_PARAM].value, 0.0f, 1.0f);
-		float sustain = clamp(params[ADSR_SUSTAIN_PARAM].value, 0.0f, 1.0f);
-		float release = clamp(params[ADSR_RELEASE_PARAM].value, 0.0f, 1.0f);
-		// Gate
-		float adsrIn = inputs[ADSR_GATE_INPUT].active ? inputs[ADSR_GATE_INPUT].value : outputs[GATE1_OUTPUT].value;// Pre-patching
-		bool gated = adsrIn >= 1.0f;
-		const float base = 20000.0f;
-		const float maxTime = 10.0f;
-		if (gated) {
-			if (decaying) {
-				// Decay
-				if (decay < 1e-4) {
-					env = sustain;
-				}
-				else {
-					env += powf(base, 1 - decay) / maxTime * (sustain - env) * engineGetSampleTime();
-				}
-			}
-			else {
-				// Attack
-				// Skip ahead if attack is all the way down (infinitely fast)
-				if (attack < 1e-4) {
-					env = 1.0f;
-				}
-				else {
-					env += powf(base, 1 - attack) / maxTime * (1.01f - env) * engineGetSampleTime();
-				}
-				if (env >= 1.0f) {
-					env = 1.0f;
-					decaying = true;
-				}
-			}
-		}
-		else {
-			// Release
-			if (release < 1e-4) {
-				env = 0.0f;
-			}
-			else {
-				env += powf(base, 1 - release) / maxTime * (0.0f - env) * engineGetSampleTime();
-			}
-			decaying = false;
-		}
-		outputs[ADSR_ENVELOPE_OUTPUT].value = 10.0f * env;
+		outputs[ADSR_ENVELOPE_OUTPUT].value = 10.0f * adsr.process((*adsrGateSrc) >= 1.0f, sampleTime);
 		
 		
 		// VCF
-		if (outputs[VCF_LPF_OUTPUT].active || outputs[VCF_HPF_OUTPUT].active) {
-		
-			float input = (inputs[VCF_IN_INPUT].active ? inputs[VCF_IN_INPUT].value : outputs[VCA_OUT1_OUTPUT].value) / 5.0f;// Pre-patching
-			float drive = clamp(params[VCF_DRIVE_PARAM].value + inputs[VCF_DRIVE_INPUT].value / 10.0f, 0.f, 1.f);
-			float gain = powf(1.f + drive, 5);
-			input *= gain;
-			// Add -60dB noise to bootstrap self-oscillation
-			input += 1e-6f * (2.f * randomUniform() - 1.f);
-			// Set resonance
-			float res = clamp(params[VCF_RES_PARAM].value + inputs[VCF_RES_INPUT].value / 10.f, 0.f, 1.f);
-			filter.resonance = powf(res, 2) * 10.f;
-			// Set cutoff frequency
-			float pitch = 0.f;
-			if (inputs[VCF_FREQ_INPUT].active)
-				pitch += inputs[VCF_FREQ_INPUT].value * quadraticBipolar(params[VCF_FREQ_CV_PARAM].value);
-			pitch += params[VCF_FREQ_PARAM].value * 10.f - 5.f;
-			//pitch += quadraticBipolar(params[FINE_PARAM].value * 2.f - 1.f) * 7.f / 12.f;
-			float cutoff = 261.626f * powf(2.f, pitch);
-			cutoff = clamp(cutoff, 1.f, 8000.f);
-			filter.setCutoff(cutoff);
-			filter.process(input, engineGetSampleTime());
-			outputs[VCF_LPF_OUTPUT].value = 5.f * filter.lowpass;
-			outputs[VCF_HPF_OUTPUT].value = 5.f * filter.highpass;	
+		if (vcfActive) {
+			if (vcfDriveActive)
+				vcf.setDrive(clamp(params[VCF_DRIVE_PARAM].value + inputs[VCF_DRIVE_INPUT].value / 10.0f, 0.f, 1.f));
+			if (vcfResActive)
+				vcf.setResonance(clamp(params[VCF_RES_PARAM].value + inputs[VCF_RES_INPUT].value / 10.f, 0.f, 1.f));
+			if (vcfFreqActive)
+				vcf.setPitch(vcfPitchKnob + inputs[VCF_FREQ_INPUT].value * vcfFreqCvDepth);
+			vcf.process((*vcfInSrc) / 5.0f, sampleTime);
+			outputs[VCF_LPF_OUTPUT].value = 5.f * vcf.lowpass();
+			outputs[VCF_HPF_OUTPUT].value = 5.f * vcf.highpass();	
 		}			
 		else {
 			outputs[VCF_LPF_OUTPUT].value = 0.0f;
 			outputs[VCF_HPF_OUTPUT].value = 0.0f;
 		}
 		
+		
+		// LFO (evaluated once per block in refreshLfo(), linearly interpolated here)
+		if (lfoSinActive) {
+			outputs[LFO_SIN_OUTPUT].value = lfoSinValue;
+			lfoSinValue += lfoSinDelta;
+		}
+		if (lfoShape2Active) {
+			outputs[LFO_TRI_OUTPUT].value = lfoShape2Value;
+			lfoShape2Value += lfoShape2Delta;
+		}
+		
+	}// step()
+	
+
+	void publishDisplaySnapshot() {
+		DisplaySnapshot snap;
+		snap.editingSequence = isEditingSequence();
+		snap.infoCopyPaste = infoCopyPaste;
+		snap.seqCopied = seqCopied;
+		snap.cpMode = params[CPMODE_PARAM].value;
+		snap.editingPpqn = editingPpqn != 0ul;
+		snap.pulsesPerStep = pulsesPerStep;
+		snap.displayState = displayState;
+		snap.runMode = snap.editingSequence ? sequences[seqIndexEdit].getRunMode() : runModeSong;
+		snap.length = snap.editingSequence ? sequences[seqIndexEdit].getLength() : phrases;
+		snap.transpose = sequences[seqIndexEdit].getTranspose();
+		snap.rotate = sequences[seqIndexEdit].getRotate();
+		snap.seqNum = snap.editingSequence ? seqIndexEdit : phrase[phraseIndexEdit];
+		displaySnapshot.write(snap);
+	}
+	
+	
+	void refreshSynthControls() {// knobs, connection states and pre-patching are refreshed once per block of samples
+		// VCO
+		oscillatorVco.analog = params[VCO_MODE_PARAM].value > 0.0f;
+		oscillatorVco.syncEnabled = inputs[VCO_SYNC_INPUT].active;
+		vcoPitchSrc = inputs[VCO_PITCH_INPUT].active ? &inputs[VCO_PITCH_INPUT].value : &outputs[CV_OUTPUT].value;// Pre-patching
+		vcoPitchKnob = params[VCO_FREQ_PARAM].value;
+		vcoPitchOffset = 3.0f * quadraticBipolar(params[VCO_FINE_PARAM].value) + 12.0f * params[VCO_OCT_PARAM].value;
+		vcoFmActive = inputs[VCO_FM_INPUT].active;
+		vcoFmDepth = quadraticBipolar(params[VCO_FM_PARAM].value) * 12.0f;
+		vcoPw = params[VCO_PW_PARAM].value;
+		vcoPwmDepth = params[VCO_PWM_PARAM].value / 10.0f;
+		vcoSinActive = outputs[VCO_SIN_OUTPUT].active;
+		vcoTriActive = outputs[VCO_TRI_OUTPUT].active;
+		vcoSawActive = outputs[VCO_SAW_OUTPUT].active;
+		
+		// CLK
+		oscillatorClk.setPitch(params[CLK_FREQ_PARAM].value + imLog2(pulsesPerStep));
+		oscillatorClk.setPulseWidth(params[CLK_PW_PARAM].value);
+		
+		// VCA
+		vcaInSrc = inputs[VCA_IN1_INPUT].active ? &inputs[VCA_IN1_INPUT].value : &outputs[VCO_SQR_OUTPUT].value;// Pre-patching
+		vcaLinSrc = inputs[VCA_LIN1_INPUT].active ? &inputs[VCA_LIN1_INPUT].value : &outputs[ADSR_ENVELOPE_OUTPUT].value;// Pre-patching
+		vcaLevel = params[VCA_LEVEL1_PARAM].value;
+		
+		// ADSR
+		adsrGateSrc = inputs[ADSR_GATE_INPUT].active ? &inputs[ADSR_GATE_INPUT].value : &outputs[GATE1_OUTPUT].value;// Pre-patching
+		adsr.setParams(clamp(params[ADSR_ATTACK_PARAM].value, 0.0f, 1.0f), clamp(params[ADSR_DECAY_PARAM].value, 0.0f, 1.0f),
+			clamp(params[ADSR_SUSTAIN_PARAM].value, 0.0f, 1.0f), clamp(params[ADSR_RELEASE_PARAM].value, 0.0f, 1.0f));
+		
+		// VCF (CV-modulated controls are instead set at audio rate in step())
+		vcfActive = outputs[VCF_LPF_OUTPUT].active || outputs[VCF_HPF_OUTPUT].active;
+		vcfInSrc = inputs[VCF_IN_INPUT].active ? &inputs[VCF_IN_INPUT].value : &outputs[VCA_OUT1_OUTPUT].value;// Pre-patching
+		vcfDriveActive = inputs[VCF_DRIVE_INPUT].active;
+		if (!vcfDriveActive)
+			vcf.setDrive(clamp(params[VCF_DRIVE_PARAM].value, 0.f, 1.f));
+		vcfResActive = inputs[VCF_RES_INPUT].active;
+		if (!vcfResActive)
+			vcf.setResonance(clamp(params[VCF_RES_PARAM].value, 0.f, 1.f));
+		vcfFreqActive = inputs[VCF_FREQ_INPUT].active;
+		vcfFreqCvDepth = quadraticBipolar(params[VCF_FREQ_CV_PARAM].value);
+		vcfPitchKnob = params[VCF_FREQ_PARAM].value * 10.f - 5.f;
+		if (!vcfFreqActive)
+			vcf.setPitch(vcfPitchKnob);
+		
 		// LFO
-		if (outputs[LFO_SIN_OUTPUT].active || outputs[LFO_TRI_OUTPUT].active) {
-			if ((lightRefreshCounter & userInputsStepSkipMask) == 0) {
-				oscillatorLfo.setPitch(params[LFO_FREQ_PARAM].value);
-			}
-			oscillatorLfo.step(engineGetSampleTime());
-			oscillatorLfo.setReset(inputs[LFO_RESET_INPUT].value + inputs[RESET_INPUT].value + params[RESET_PARAM].value + params[RUN_PARAM].value + inputs[RUNCV_INPUT].value);
-			float lfoGain = params[LFO_GAIN_PARAM].value;
-			float lfoOffset = (2.0f - lfoGain) * params[LFO_OFFSET_PARAM].value;
-			outputs[LFO_SIN_OUTPUT].value = 5.0f * (lfoOffset + lfoGain * oscillatorLfo.sin());
-			outputs[LFO_TRI_OUTPUT].value = 5.0f * (lfoOffset + lfoGain * oscillatorLfo.tri());	
-		} 
-		else {
+		lfoSinActive = outputs[LFO_SIN_OUTPUT].active;
+		lfoShape2Active = outputs[LFO_TRI_OUTPUT].active;
+		oscillatorLfo.setPitch(params[LFO_FREQ_PARAM].value);
+		lfoGain = params[LFO_GAIN_PARAM].value;
+		lfoOffset = (2.0f - lfoGain) * params[LFO_OFFSET_PARAM].value;
+	}
+	
+	
+	void refreshLfo(float blockTime) {// advances the LFO by one block, only the connected outputs are evaluated
+		static const float blockSizeInv = 1.0f / (float)(userInputsStepSkipMask + 1);
+		if (!lfoSinActive && !lfoShape2Active) {
 			outputs[LFO_SIN_OUTPUT].value = 0.0f;
 			outputs[LFO_TRI_OUTPUT].value = 0.0f;
-		}			
-		
-	}// step()
+			return;
+		}
+		oscillatorLfo.setReset(inputs[LFO_RESET_INPUT].value + inputs[RESET_INPUT].value + params[RESET_PARAM].value + params[RUN_PARAM].value + inputs[RUNCV_INPUT].value);
+		float sinStart = lfoSinActive ? oscillatorLfo.sin() : 0.0f;
+		float shape2Start = lfoShape2Active ? oscillatorLfo.shape(lfoShape2) : 0.0f;
+		float phaseStart = oscillatorLfo.phase;
+		oscillatorLfo.step(blockTime);
+		if (lfoSinActive) {
+			lfoSinValue = 5.0f * (lfoOffset + lfoGain * sinStart);
+			lfoSinDelta = (5.0f * (lfoOffset + lfoGain * oscillatorLfo.sin()) - lfoSinValue) * blockSizeInv;
+		}
+		else
+			outputs[LFO_SIN_OUTPUT].value = 0.0f;
+		if (lfoShape2Active) {
+			lfoShape2Value = 5.0f * (lfoOffset + lfoGain * shape2Start);
+			if (lfoShape2 == LowFrequencyOscillator::SHAPE_SQR || lfoShape2 == LowFrequencyOscillator::SHAPE_SH)
+				lfoShape2Delta = 0.0f;// stepped shapes are held, not interpolated
+			else if (lfoShape2 == LowFrequencyOscillator::SHAPE_SAW && oscillatorLfo.crossedSawJump(phaseStart)) {
+				lfoShape2Value = 5.0f * (lfoOffset + lfoGain * oscillatorLfo.saw());// jump to the value after the drop, a ramp across it would be a slow fall
+				lfoShape2Delta = 0.0f;
+			}
+			else
+				lfoShape2Delta = (5.0f * (lfoOffset + lfoGain * oscillatorLfo.shape(lfoShape2)) - lfoShape2Value) * blockSizeInv;
+		}
+		else
+			outputs[LFO_TRI_OUTPUT].value = 0.0f;
+	}
 	
 
 	inline void setGreenRed(int id, float green, float red) {
-		lights[id + 0].value = green;
-		lights[id + 1].value = red;
+		lightState.set(id + 0, green);
+		lightState.set(id + 1, red);
 	}
 	
 	inline void propagateCVtoTied(int seqn, int stepn) {
@@ -1635,16 +1690,16 @@ struct SemiModularSynth : Module {
 	
 	inline void setGateLight(bool gateOn, int lightIndex) {
 		if (!gateOn) {
-			lights[lightIndex + 0].value = 0.0f;
-			lights[lightIndex + 1].value = 0.0f;
+			lightState.set(lightIndex + 0, 0.0f);
+			lightState.set(lightIndex + 1, 0.0f);
 		}
 		else if (editingGateLength == 0l) {
-			lights[lightIndex + 0].value = 0.0f;
-			lights[lightIndex + 1].value = 1.0f;
+			lightState.set(lightIndex + 0, 0.0f);
+			lightState.set(lightIndex + 1, 1.0f);
 		}
 		else {
-			lights[lightIndex + 0].value = lightIndex == GATE1_LIGHT ? 1.0f : 0.2f;
-			lights[lightIndex + 1].value = lightIndex == GATE1_LIGHT ? 0.2f : 1.0f;
+			lightState.set(lightIndex + 0, lightIndex == GATE1_LIGHT ? 1.0f : 0.2f);
+			lightState.set(lightIndex + 1, lightIndex == GATE1_LIGHT ? 0.2f : 1.0f);
 		}
 	}
 
@@ -1656,35 +1711,25 @@ struct SemiModularSynthWidget : ModuleWidget {
 	SemiModularSynth *module;
 	DynamicSVGPanel *panel;
 
-	struct SequenceDisplayWidget : TransparentWidget {
+	struct SequenceDisplayWidget : CachedDisplayWidget {
 		SemiModularSynth *module;
-		std::shared_ptr<Font> font;
-		char displayStr[4];
-		
-		SequenceDisplayWidget() {
-			font = Font::load(assetPlugin(plugin, "res/fonts/Segment14.ttf"));
-		}
+		SemiModularSynth::DisplaySnapshot snap;// copy of the module's display snapshot, printContent() reads this instead of the module
 		
 		void runModeToStr(int num) {
 			if (num >= 0 && num < (NUM_MODES - 1))
 				snprintf(displayStr, 4, "%s", modeLabels[num].c_str());
 		}
 
-		void draw(NVGcontext *vg) override {
-			NVGcolor textColor = prepareDisplay(vg, &box, 18);
-			nvgFontFaceId(vg, font->handle);
-			bool editingSequence = module->isEditingSequence();
-
-			Vec textPos = Vec(6, 24);
-			nvgFillColor(vg, nvgTransRGBA(textColor, displayAlpha));
-			nvgText(vg, textPos.x, textPos.y, "~~~", NULL);
-			nvgFillColor(vg, textColor);
-			if (module->infoCopyPaste != 0l) {
-				if (module->infoCopyPaste > 0l)
+		void printContent() override {
+			if (!module->displaySnapshot.read(&snap))
+				return;// keep what is shown, a consistent snapshot will be read next frame
+			bool editingSequence = snap.editingSequence;
+			if (snap.infoCopyPaste != 0l) {
+				if (snap.infoCopyPaste > 0l)
 					snprintf(displayStr, 4, "CPY");
 				else {
-					float cpMode = module->params[SemiModularSynth::CPMODE_PARAM].value;
-					if (editingSequence && !module->seqCopied) {// cross paste to seq
+					float cpMode = snap.cpMode;
+					if (editingSequence && !snap.seqCopied) {// cross paste to seq
 						if (cpMode > 1.5f)// All = toggle gate 1
 							snprintf(displayStr, 4, "TG1");
 						else if (cpMode < 0.5f)// 4 = random CV
@@ -1692,7 +1737,7 @@ struct SemiModularSynthWidget : ModuleWidget {
 						else// 8 = random gate 1
 							snprintf(displayStr, 4, "RG1");
 					}
-					else if (!editingSequence && module->seqCopied) {// cross paste to song
+					else if (!editingSequence && snap.seqCopied) {// cross paste to song
 						if (cpMode > 1.5f)// All = init
 							snprintf(displayStr, 4, "CLR");
 						else if (cpMode < 0.5f)// 4 = increase by 1
@@ -1704,35 +1749,38 @@ struct SemiModularSynthWidget : ModuleWidget {
 						snprintf(displayStr, 4, "PST");
 				}
 			}
-			else if (module->editingPpqn != 0ul) {
-				snprintf(displayStr, 4, "x%2u", (unsigned) module->pulsesPerStep);
+			else if (snap.editingPpqn) {
+				snprintf(displayStr, 4, "x%2u", (unsigned) snap.pulsesPerStep);
 			}
-			else if (module->displayState == SemiModularSynth::DISP_MODE) {
-				if (editingSequence)
-					runModeToStr(module->sequences[module->seqIndexEdit].getRunMode());
-				else
-					runModeToStr(module->runModeSong);
+			else if (snap.displayState == SemiModularSynth::DISP_MODE) {
+				runModeToStr(snap.runMode);// of the sequence or of the song
 			}
-			else if (module->displayState == SemiModularSynth::DISP_LENGTH) {
-				if (editingSequence)
-					snprintf(displayStr, 4, "L%2u", (unsigned) module->sequences[module->seqIndexEdit].getLength());
-				else
-					snprintf(displayStr, 4, "L%2u", (unsigned) module->phrases);
+			else if (snap.displayState == SemiModularSynth::DISP_LENGTH) {
+				snprintf(displayStr, 4, "L%2u", (unsigned) snap.length);// of the sequence or of the song
 			}
-			else if (module->displayState == SemiModularSynth::DISP_TRANSPOSE) {
-				snprintf(displayStr, 4, "+%2u", (unsigned) abs(module->sequences[module->seqIndexEdit].getTranspose()));
-				if (module->sequences[module->seqIndexEdit].getTranspose() < 0)
+			else if (snap.displayState == SemiModularSynth::DISP_TRANSPOSE) {
+				snprintf(displayStr, 4, "+%2u", (unsigned) abs(snap.transpose));
+				if (snap.transpose < 0)
 					displayStr[0] = '-';
 			}
-			else if (module->displayState == SemiModularSynth::DISP_ROTATE) {
-				snprintf(displayStr, 4, ")%2u", (unsigned) abs(module->sequences[module->seqIndexEdit].getRotate()));
-				if (module->sequences[module->seqIndexEdit].getRotate() < 0)
+			else if (snap.displayState == SemiModularSynth::DISP_ROTATE) {
+				snprintf(displayStr, 4, ")%2u", (unsigned) abs(snap.rotate));
+				if (snap.rotate < 0)
 					displayStr[0] = '(';
 			}
 			else {// DISP_NORMAL
-				snprintf(displayStr, 4, " %2u", (unsigned) (editingSequence ? 
-					module->seqIndexEdit : module->phrase[module->phraseIndexEdit]) + 1 );
+				snprintf(displayStr, 4, " %2u", (unsigned) snap.seqNum + 1 );
 			}
+		}
+
+		void drawContent(NVGcontext *vg) override {
+			NVGcolor textColor = prepareDisplay(vg, &box, 18);
+			nvgFontFaceId(vg, getFontHandle(vg));
+
+			Vec textPos = Vec(6, 24);
+			nvgFillColor(vg, nvgTransRGBA(textColor, displayAlpha));
+			nvgText(vg, textPos.x, textPos.y, "~~~", NULL);
+			nvgFillColor(vg, textColor);
 			nvgText(vg, textPos.x, textPos.y, displayStr, NULL);
 		}
 	};		
@@ -1747,6 +1795,16 @@ struct SemiModularSynthWidget : ModuleWidget {
 			rightText = (module->panelTheme == panelTheme) ? "✔" : "";
 		}
 	};
+	struct LfoShapeItem : MenuItem {
+		SemiModularSynth *module;
+		int lfoShape;
+		void onAction(EventAction &e) override {
+			module->lfoShape2 = lfoShape;
+		}
+		void step() override {
+			rightText = (module->lfoShape2 == lfoShape) ? "✔" : "";
+		}
+	};
 	struct ResetOnRunItem : MenuItem {
 		SemiModularSynth *module;
 		void onAction(EventAction &e) override {
@@ -1824,6 +1882,22 @@ struct SemiModularSynthWidget : ModuleWidget {
 		holdItem->module = module;
 		menu->addChild(holdItem);
 
+		menu->addChild(new MenuLabel());// empty line
+		
+		MenuLabel *lfoLabel = new MenuLabel();
+		lfoLabel->text = "LFO TRI output shape";
+		menu->addChild(lfoLabel);
+		
+		static const char *lfoShapeNames[4] = {"Triangle", "Ramp", "Sample & hold", "Smooth random"};
+		static const int lfoShapeIds[4] = {LowFrequencyOscillator::SHAPE_TRI, LowFrequencyOscillator::SHAPE_SAW, LowFrequencyOscillator::SHAPE_SH, LowFrequencyOscillator::SHAPE_SMOOTH_RND};
+		for (int i = 0; i < 4; i++) {
+			LfoShapeItem *shapeItem = new LfoShapeItem();
+			shapeItem->text = lfoShapeNames[i];
+			shapeItem->module = module;
+			shapeItem->lfoShape = lfoShapeIds[i];
+			menu->addChild(shapeItem);
+		}
+
 		return menu;
 	}	
 	
@@ -1867,6 +1941,7 @@ struct SemiModularSynthWidget : ModuleWidget {
 					}
 					else {
 						module->phrase[module->phraseIndexEdit] = 0;
+						module->psk.invalidateSeqRun();
 					}
 				}
 			}
@@ -1887,6 +1962,7 @@ struct SemiModularSynthWidget : ModuleWidget {
 	// }
 	
 	SemiModularSynthWidget(SemiModularSynth *module) : ModuleWidget(module) {
+		IM_TIME_SCOPE("SemiModularSynth", TIMING_WIDGET);
 		this->module = module;
 		
 		// SEQUENCER 
@@ -1901,14 +1977,14 @@ struct SemiModularSynthWidget : ModuleWidget {
         addChild(panel);		
 		
 		// Screws
-		addChild(createDynamicScrew<IMScrew>(Vec(15, 0), &module->panelTheme));
-		addChild(createDynamicScrew<IMScrew>(Vec(15, 365), &module->panelTheme));
-		addChild(createDynamicScrew<IMScrew>(Vec((box.size.x - 90) * 1 / 3 + 30 , 0), &module->panelTheme));
-		addChild(createDynamicScrew<IMScrew>(Vec((box.size.x - 90) * 1 / 3 + 30 , 365), &module->panelTheme));
-		addChild(createDynamicScrew<IMScrew>(Vec((box.size.x - 90) * 2 / 3 + 45 , 0), &module->panelTheme));
-		addChild(createDynamicScrew<IMScrew>(Vec((box.size.x - 90) * 2 / 3 + 45 , 365), &module->panelTheme));
-		addChild(createDynamicScrew<IMScrew>(Vec(box.size.x-30, 0), &module->panelTheme));
-		addChild(createDynamicScrew<IMScrew>(Vec(box.size.x-30, 365), &module->panelTheme));
+		panel->addChild(createDynamicScrew<IMScrew>(Vec(15, 0), &module->panelTheme));
+		panel->addChild(createDynamicScrew<IMScrew>(Vec(15, 365), &module->panelTheme));
+		panel->addChild(createDynamicScrew<IMScrew>(Vec((box.size.x - 90) * 1 / 3 + 30 , 0), &module->panelTheme));
+		panel->addChild(createDynamicScrew<IMScrew>(Vec((box.size.x - 90) * 1 / 3 + 30 , 365), &module->panelTheme));
+		panel->addChild(createDynamicScrew<IMScrew>(Vec((box.size.x - 90) * 2 / 3 + 45 , 0), &module->panelTheme));
+		panel->addChild(createDynamicScrew<IMScrew>(Vec((box.size.x - 90) * 2 / 3 + 45 , 365), &module->panelTheme));
+		panel->addChild(createDynamicScrew<IMScrew>(Vec(box.size.x-30, 0), &module->panelTheme));
+		panel->addChild(createDynamicScrew<IMScrew>(Vec(box.size.x-30, 365), &module->panelTheme));
 
 		
 		
@@ -2198,6 +2274,23 @@ Model *modelSemiModularSynth = Model::create<SemiModularSynth, SemiModularSynthW
 
 /*CHANGE LOG
 
+0.6.17:
+refactor synth section into stages, with knobs, connections and pre-patching refreshed once per block of samples
+use fast exp2, tanh, sin and log2 approximations in the per-sample synth code (see FastMathUtil.hpp)
+LFO evaluated from a wavetable at control rate with interpolation, TRI output shape selectable in right-click menu (triangle, ramp, S&H, smooth random)
+move clock, run mode, phrase, slide and gate logic into shared PhraseSeqKernel (see PhraseSeqKernel.hpp)
+sequencer kernel can look ahead at the steps and phrases to come (random run modes and probabilities use the kernel's own generator)
+advanced gates come from the shared gate pattern table (AdvGateUtil), same gates as before for all pulses per step
+running sequence is cached in the kernel so that pulses and outputs don't look up the song each time
+slides use a filtered clock period measured by the new ClockInput front end (sub-sample edge position and period)
+segment displays are framebuffer cached and only redrawn when their text changes
+lights are written through LightState, so that only changed lights are written
+screws are drawn in the panel's framebuffer
+optional timing instrumentation (IM_TIMING)
+display reads a snapshot of the display state published at light refresh rate (SeqLock)
+control rate LFO ramp jumps at its drop instead of ramping across it
+reset ignores the clock for 1 ms and restarts the clock input, as in PhraseSeq16/32
+
 0.6.16:
 add gate status feedback in steps (white lights)
 
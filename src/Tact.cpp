@@ -58,6 +58,7 @@ struct Tact : Module {
 	float infoCVinLight[2] = {0.0f, 0.0f};
 	float paramReadRequest[2] = {-10.0f, -10.0f}; 
 	unsigned int lightRefreshCounter = 0;
+	LightState lightState;
 	Trigger topTriggers[2];
 	Trigger botTriggers[2];
 	Trigger topInvTriggers[2];
@@ -72,11 +73,13 @@ struct Tact : Module {
 
 	
 	Tact() : Module(NUM_PARAMS, NUM_INPUTS, NUM_OUTPUTS, NUM_LIGHTS) {
+		lightState.init(&lights);
 		onReset();
 	}
 
 	
 	void onReset() override {
+		IM_TIME_SCOPE("Tact", TIMING_RESET);
 		for (int i = 0; i < 2; i++) {
 			cv[i] = 0.0f;
 			storeCV[i] = 0.0f;
@@ -95,6 +98,8 @@ struct Tact : Module {
 
 	
 	json_t *toJson() override {
+		IM_TIME_SCOPE("Tact", TIMING_TOJSON);
+		IM_LOG_LIGHTS("Tact", lightState);
 		json_t *rootJ = json_object();
 
 		// cv
@@ -119,6 +124,7 @@ struct Tact : Module {
 
 	
 	void fromJson(json_t *rootJ) override {
+		IM_TIME_SCOPE("Tact", TIMING_FROMJSON);
 
 		// cv
 		json_t *cv0J = json_object_get(rootJ, "cv0");
@@ -279,7 +285,7 @@ struct Tact : Module {
 			}
 			// CV input lights
 			for (int i = 0; i < 2; i++)
-				lights[CVIN_LIGHTS + i * 2].value = infoCVinLight[i];
+				lightState.set(CVIN_LIGHTS + i * 2, infoCVinLight[i]);
 			
 			for (int i = 0; i < 2; i++) {
 				infoCVinLight[i] -= (infoCVinLight[i] / lightLambda) * sampleTime * displayRefreshStepSkips;
@@ -297,9 +303,9 @@ struct Tact : Module {
 		for (int i = 0; i < numLights; i++) {
 			float level = clamp( cvValue - ((float)(i)), 0.0f, 1.0f);
 			// Green diode
-			lights[TACT_LIGHTS + (chan * numLights * 2) + (numLights - 1 - i) * 2 + 0].setBrightness(level);
+			lightState.setBrightness(TACT_LIGHTS + (chan * numLights * 2) + (numLights - 1 - i) * 2 + 0, level);
 			// Red diode
-			lights[TACT_LIGHTS + (chan * numLights * 2) + (numLights - 1 - i) * 2 + 1].value = 0.0f;
+			lightState.set(TACT_LIGHTS + (chan * numLights * 2) + (numLights - 1 - i) * 2 + 1, 0.0f);
 		}
 	}
 	
@@ -307,9 +313,9 @@ struct Tact : Module {
 		for (int i = 0; i < numLights; i++) {
 			float level = (i == (int) round((float(infoCount)) / ((float)initInfoStore) * (float)(numLights - 1)) ? 1.0f : 0.0f);
 			// Green diode
-			lights[TACT_LIGHTS + (chan * numLights * 2) + (numLights - 1 - i) * 2 + 0].setBrightness(level);
+			lightState.setBrightness(TACT_LIGHTS + (chan * numLights * 2) + (numLights - 1 - i) * 2 + 0, level);
 			// Red diode
-			lights[TACT_LIGHTS + (chan * numLights * 2) + (numLights - 1 - i) * 2 + 1].value = 0.0f;
+			lightState.set(TACT_LIGHTS + (chan * numLights * 2) + (numLights - 1 - i) * 2 + 1, 0.0f);
 		}	
 	}
 };
@@ -385,6 +391,7 @@ struct TactWidget : ModuleWidget {
 	}	
 	
 	TactWidget(Tact *module) : ModuleWidget(module) {
+		IM_TIME_SCOPE("Tact", TIMING_WIDGET);
 		// Main panel from Inkscape
         DynamicSVGPanel *panel = new DynamicSVGPanel();
         panel->addPanel(SVG::load(assetPlugin(plugin, "res/light/Tact.svg")));
@@ -394,10 +401,10 @@ struct TactWidget : ModuleWidget {
         addChild(panel);
 
 		// Screws
-		addChild(createDynamicScrew<IMScrew>(Vec(15, 0), &module->panelTheme));
-		addChild(createDynamicScrew<IMScrew>(Vec(box.size.x-30, 0), &module->panelTheme));
-		addChild(createDynamicScrew<IMScrew>(Vec(15, 365), &module->panelTheme));
-		addChild(createDynamicScrew<IMScrew>(Vec(box.size.x-30, 365), &module->panelTheme));
+		panel->addChild(createDynamicScrew<IMScrew>(Vec(15, 0), &module->panelTheme));
+		panel->addChild(createDynamicScrew<IMScrew>(Vec(box.size.x-30, 0), &module->panelTheme));
+		panel->addChild(createDynamicScrew<IMScrew>(Vec(15, 365), &module->panelTheme));
+		panel->addChild(createDynamicScrew<IMScrew>(Vec(box.size.x-30, 365), &module->panelTheme));
 		
 		
 		static const int rowRuler0 = 34;
@@ -530,16 +537,19 @@ struct Tact1 : Module {
 
 	// No need to save
 	unsigned int lightRefreshCounter = 0;	
+	LightState lightState;
 	
 	inline bool isExpSliding(void) {return params[EXP_PARAM].value > 0.5f;}
 
 	
 	Tact1() : Module(NUM_PARAMS, NUM_INPUTS, NUM_OUTPUTS, NUM_LIGHTS) {
+		lightState.init(&lights);
 		onReset();
 	}
 
 	
 	void onReset() override {
+		IM_TIME_SCOPE("Tact1", TIMING_RESET);
 		cv = 0.0f;
 		rateMultiplier = 1.0f;
 	}
@@ -551,6 +561,8 @@ struct Tact1 : Module {
 
 	
 	json_t *toJson() override {
+		IM_TIME_SCOPE("Tact1", TIMING_TOJSON);
+		IM_LOG_LIGHTS("Tact1", lightState);
 		json_t *rootJ = json_object();
 
 		// cv
@@ -567,6 +579,7 @@ struct Tact1 : Module {
 
 	
 	void fromJson(json_t *rootJ) override {
+		IM_TIME_SCOPE("Tact1", TIMING_FROMJSON);
 
 		// cv
 		json_t *cvJ = json_object_get(rootJ, "cv");
@@ -634,9 +647,9 @@ struct Tact1 : Module {
 		for (int i = 0; i < numLights; i++) {
 			float level = clamp( cvValue - ((float)(i)), 0.0f, 1.0f);
 			// Green diode
-			lights[TACT_LIGHTS + (numLights - 1 - i) * 2 + 0].setBrightness(level);
+			lightState.setBrightness(TACT_LIGHTS + (numLights - 1 - i) * 2 + 0, level);
 			// Red diode
-			lights[TACT_LIGHTS + (numLights - 1 - i) * 2 + 1].value = 0.0f;
+			lightState.set(TACT_LIGHTS + (numLights - 1 - i) * 2 + 1, 0.0f);
 		}
 	}
 };
@@ -701,6 +714,7 @@ struct Tact1Widget : ModuleWidget {
 	}	
 	
 	Tact1Widget(Tact1 *module) : ModuleWidget(module) {
+		IM_TIME_SCOPE("Tact1", TIMING_WIDGET);
 		// Main panel from Inkscape
         DynamicSVGPanel *panel = new DynamicSVGPanel();
         panel->addPanel(SVG::load(assetPlugin(plugin, "res/light/Tact1.svg")));
@@ -710,10 +724,10 @@ struct Tact1Widget : ModuleWidget {
         addChild(panel);
 
 		// Screws
-		addChild(createDynamicScrew<IMScrew>(Vec(15, 0), &module->panelTheme));
-		addChild(createDynamicScrew<IMScrew>(Vec(box.size.x-30, 0), &module->panelTheme));
-		addChild(createDynamicScrew<IMScrew>(Vec(15, 365), &module->panelTheme));
-		addChild(createDynamicScrew<IMScrew>(Vec(box.size.x-30, 365), &module->panelTheme));
+		panel->addChild(createDynamicScrew<IMScrew>(Vec(15, 0), &module->panelTheme));
+		panel->addChild(createDynamicScrew<IMScrew>(Vec(box.size.x-30, 0), &module->panelTheme));
+		panel->addChild(createDynamicScrew<IMScrew>(Vec(15, 365), &module->panelTheme));
+		panel->addChild(createDynamicScrew<IMScrew>(Vec(box.size.x-30, 365), &module->panelTheme));
 		
 		
 		static const int rowRuler0 = 42;
@@ -754,6 +768,11 @@ Model *modelTact1 = Model::create<Tact1, Tact1Widget>("Impromptu Modular", "Tact
 
 /*CHANGE LOG
 
+0.6.17:
+lights are written through LightState, so that only changed lights are written
+screws are drawn in the panel's framebuffer
+optional timing instrumentation (IM_TIMING)
+
 0.6.12:
 input refresh optimization
 
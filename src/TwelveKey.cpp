@@ -54,6 +54,7 @@ struct TwelveKey : Module {
 
 	
 	unsigned int lightRefreshCounter = 0;
+	LightState lightState;
 	//float gateLight = 0.0f;
 	Trigger keyTriggers[12];
 	Trigger gateInputTrigger;
@@ -62,10 +63,12 @@ struct TwelveKey : Module {
 	
 
 	TwelveKey() : Module(NUM_PARAMS, NUM_INPUTS, NUM_OUTPUTS, NUM_LIGHTS) {
+		lightState.init(&lights);
 		onReset();
 	}
 
 	void onReset() override {
+		IM_TIME_SCOPE("TwelveKey", TIMING_RESET);
 		octaveNum = 4;
 		cv = 0.0f;
 		stateInternal = inputs[GATE_INPUT].active ? false : true;
@@ -82,6 +85,8 @@ struct TwelveKey : Module {
 	}
 
 	json_t *toJson() override {
+		IM_TIME_SCOPE("TwelveKey", TIMING_TOJSON);
+		IM_LOG_LIGHTS("TwelveKey", lightState);
 		json_t *rootJ = json_object();
 		
 		// panelTheme
@@ -100,6 +105,7 @@ struct TwelveKey : Module {
 	}
 
 	void fromJson(json_t *rootJ) override {
+		IM_TIME_SCOPE("TwelveKey", TIMING_FROMJSON);
 		// panelTheme
 		json_t *panelThemeJ = json_object_get(rootJ, "panelTheme");
 		if (panelThemeJ)
@@ -186,7 +192,7 @@ struct TwelveKey : Module {
 
 			// Key lights
 			for (int i = 0; i < 12; i++)
-				lights[KEY_LIGHTS + i].value = (( i == lastKeyPressed && (noteLightCounter > 0ul || params[KEY_PARAMS + i].value > 0.5f)) ? 1.0f : 0.0f);
+				lightState.set(KEY_LIGHTS + i, (( i == lastKeyPressed && (noteLightCounter > 0ul || params[KEY_PARAMS + i].value > 0.5f)) ? 1.0f : 0.0f));
 			
 			if (noteLightCounter > 0ul)
 				noteLightCounter--;
@@ -202,7 +208,7 @@ struct TwelveKeyWidget : ModuleWidget {
 		std::shared_ptr<Font> font;
 		
 		OctaveNumDisplayWidget() {
-			font = Font::load(assetPlugin(plugin, "res/fonts/Segment14.ttf"));
+			font = imAssets.getFont();
 		}
 
 		void draw(NVGcontext *vg) override {
@@ -262,6 +268,7 @@ struct TwelveKeyWidget : ModuleWidget {
 	
 	
 	TwelveKeyWidget(TwelveKey *module) : ModuleWidget(module) {
+		IM_TIME_SCOPE("TwelveKey", TIMING_WIDGET);
 		// Main panel from Inkscape
         DynamicSVGPanel *panel = new DynamicSVGPanel();
         panel->addPanel(SVG::load(assetPlugin(plugin, "res/light/TwelveKey.svg")));
@@ -271,10 +278,10 @@ struct TwelveKeyWidget : ModuleWidget {
         addChild(panel);
 
 		// Screws
-		addChild(createDynamicScrew<IMScrew>(Vec(15, 0), &module->panelTheme));
-		addChild(createDynamicScrew<IMScrew>(Vec(box.size.x-30, 0), &module->panelTheme));
-		addChild(createDynamicScrew<IMScrew>(Vec(15, 365), &module->panelTheme));
-		addChild(createDynamicScrew<IMScrew>(Vec(box.size.x-30, 365), &module->panelTheme));
+		panel->addChild(createDynamicScrew<IMScrew>(Vec(15, 0), &module->panelTheme));
+		panel->addChild(createDynamicScrew<IMScrew>(Vec(box.size.x-30, 0), &module->panelTheme));
+		panel->addChild(createDynamicScrew<IMScrew>(Vec(15, 365), &module->panelTheme));
+		panel->addChild(createDynamicScrew<IMScrew>(Vec(box.size.x-30, 365), &module->panelTheme));
 
 
 
@@ -357,6 +364,12 @@ Model *modelTwelveKey = Model::create<TwelveKey, TwelveKeyWidget>("Impromptu Mod
 
 /*CHANGE LOG
 
+0.6.17:
+display font taken from the plugin asset cache
+lights are written through LightState, so that only changed lights are written
+screws are drawn in the panel's framebuffer
+optional timing instrumentation (IM_TIMING)
+
 0.6.12:
 input refresh optimization
 
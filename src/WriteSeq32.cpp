@@ -79,6 +79,7 @@ struct WriteSeq32 : Module {
 
 
 	unsigned int lightRefreshCounter = 0;	
+	LightState lightState;
 	Trigger clockTrigger;
 	Trigger resetTrigger;
 	Trigger runningTrigger;
@@ -98,11 +99,13 @@ struct WriteSeq32 : Module {
 	
 	
 	WriteSeq32() : Module(NUM_PARAMS, NUM_INPUTS, NUM_OUTPUTS, NUM_LIGHTS) {
+		lightState.init(&lights);
 		onReset();
 	}
 	
 
 	void onReset() override {
+		IM_TIME_SCOPE("WriteSeq32", TIMING_RESET);
 		running = true;
 		indexStep = 0;
 		indexStepStage = 0;
@@ -143,6 +146,8 @@ struct WriteSeq32 : Module {
 
 	
 	json_t *toJson() override {
+		IM_TIME_SCOPE("WriteSeq32", TIMING_TOJSON);
+		IM_LOG_LIGHTS("WriteSeq32", lightState);
 		json_t *rootJ = json_object();
 
 		// panelTheme
@@ -183,6 +188,7 @@ struct WriteSeq32 : Module {
 	}
 
 	void fromJson(json_t *rootJ) override {
+		IM_TIME_SCOPE("WriteSeq32", TIMING_FROMJSON);
 		// panelTheme
 		json_t *panelThemeJ = json_object_get(rootJ, "panelTheme");
 		if (panelThemeJ)
@@ -433,11 +439,11 @@ struct WriteSeq32 : Module {
 			int index = (indexChannel == 3 ? indexStepStage : indexStep);
 			// Window lights
 			for (int i = 0; i < 4; i++) {
-				lights[WINDOW_LIGHTS + i].value = ((i == (index >> 3))?1.0f:0.0f);
+				lightState.set(WINDOW_LIGHTS + i, ((i == (index >> 3))?1.0f:0.0f));
 			}
 			// Step and gate lights
 			for (int index8 = 0, iGate = 0; index8 < 8; index8++) {
-				lights[STEP_LIGHTS + index8].value = (index8 == (index&0x7)) ? 1.0f : 0.0f;
+				lightState.set(STEP_LIGHTS + index8, (index8 == (index&0x7)) ? 1.0f : 0.0f);
 				iGate = (index&0x18) | index8;
 				float green = 0.0f;
 				float red = 0.0f;
@@ -449,20 +455,20 @@ struct WriteSeq32 : Module {
 			}
 				
 			// Channel lights		
-			lights[CHANNEL_LIGHTS + 0].value = (indexChannel == 0) ? 1.0f : 0.0f;// green
-			lights[CHANNEL_LIGHTS + 1].value = (indexChannel == 1) ? 1.0f : 0.0f;// yellow
-			lights[CHANNEL_LIGHTS + 2].value = (indexChannel == 2) ? 1.0f : 0.0f;// orange
-			lights[CHANNEL_LIGHTS + 3].value = (indexChannel == 3) ? 1.0f : 0.0f;// blue
+			lightState.set(CHANNEL_LIGHTS + 0, (indexChannel == 0) ? 1.0f : 0.0f);// green
+			lightState.set(CHANNEL_LIGHTS + 1, (indexChannel == 1) ? 1.0f : 0.0f);// yellow
+			lightState.set(CHANNEL_LIGHTS + 2, (indexChannel == 2) ? 1.0f : 0.0f);// orange
+			lightState.set(CHANNEL_LIGHTS + 3, (indexChannel == 3) ? 1.0f : 0.0f);// blue
 			
 			// Run light
-			lights[RUN_LIGHT].value = running ? 1.0f : 0.0f;
+			lightState.set(RUN_LIGHT, running ? 1.0f : 0.0f);
 			
 			// Write allowed light
-			lights[WRITE_LIGHT + 0].value = (canEdit)?1.0f:0.0f;
-			lights[WRITE_LIGHT + 1].value = (canEdit)?0.0f:1.0f;
+			lightState.set(WRITE_LIGHT + 0, (canEdit)?1.0f:0.0f);
+			lightState.set(WRITE_LIGHT + 1, (canEdit)?0.0f:1.0f);
 			
 			// Pending paste light
-			lights[PENDING_LIGHT].value = (pendingPaste == 0 ? 0.0f : 1.0f);
+			lightState.set(PENDING_LIGHT, (pendingPaste == 0 ? 0.0f : 1.0f));
 			
 			if (infoCopyPaste != 0l) {
 				if (infoCopyPaste > 0l)
@@ -477,8 +483,8 @@ struct WriteSeq32 : Module {
 	}
 	
 	inline void setGreenRed(int id, float green, float red) {
-		lights[id + 0].value = green;
-		lights[id + 1].value = red;
+		lightState.set(id + 0, green);
+		lightState.set(id + 1, red);
 	}
 
 };
@@ -486,16 +492,11 @@ struct WriteSeq32 : Module {
 
 struct WriteSeq32Widget : ModuleWidget {
 
-	struct NotesDisplayWidget : TransparentWidget {
+	struct NotesDisplayWidget : CachedDisplayWidget {
 		WriteSeq32 *module;
-		std::shared_ptr<Font> font;
-		char text[4];
 
-		NotesDisplayWidget() {
-			font = Font::load(assetPlugin(plugin, "res/fonts/Segment14.ttf"));
-		}
-		
-		void cvToStr(int index8) {
+		void cvToStr(int index8) {// text of note index8 is at displayStr[index8 * 4]
+			char *text = &displayStr[index8 * 4];
 			if (module->infoCopyPaste != 0l) {
 				if (index8 == 0) {
 					if (module->infoCopyPaste > 0l)
@@ -525,19 +526,20 @@ struct WriteSeq32Widget : ModuleWidget {
 			}
 		}
 
-		void draw(NVGcontext *vg) override {
+		void printContent() override {
+			for (int i = 0; i < 8; i++)
+				cvToStr(i);
+		}
+
+		void drawContent(NVGcontext *vg) override {
 			NVGcolor textColor = prepareDisplay(vg, &box, 18);
-			nvgFontFaceId(vg, font->handle);
+			nvgFontFaceId(vg, getFontHandle(vg));
 			nvgTextLetterSpacing(vg, -1.5);
 
-			for (int i = 0; i < 8; i++) {
-				Vec textPos = Vec(module->notesPos[i], 24);
-				nvgFillColor(vg, nvgTransRGBA(textColor, displayAlpha));
-				nvgText(vg, textPos.x, textPos.y, "~~~", NULL);
-				nvgFillColor(vg, textColor);
-				cvToStr(i);
-				nvgText(vg, textPos.x, textPos.y, text, NULL);
-			}
+			float posX[8];
+			for (int i = 0; i < 8; i++)
+				posX[i] = module->notesPos[i];
+			drawGhostedTexts(vg, textColor, "~~~", posX, 24.0f, displayStr, 4, 8);
 		}
 	};
 
@@ -547,7 +549,7 @@ struct WriteSeq32Widget : ModuleWidget {
 		std::shared_ptr<Font> font;
 		
 		StepsDisplayWidget() {
-			font = Font::load(assetPlugin(plugin, "res/fonts/Segment14.ttf"));
+			font = imAssets.getFont();
 		}
 
 		void draw(NVGcontext *vg) override {
@@ -622,6 +624,7 @@ struct WriteSeq32Widget : ModuleWidget {
 	
 	
 	WriteSeq32Widget(WriteSeq32 *module) : ModuleWidget(module) {
+		IM_TIME_SCOPE("WriteSeq32", TIMING_WIDGET);
 		// Main panel from Inkscape
         DynamicSVGPanel *panel = new DynamicSVGPanel();
         panel->addPanel(SVG::load(assetPlugin(plugin, "res/light/WriteSeq32.svg")));
@@ -631,10 +634,10 @@ struct WriteSeq32Widget : ModuleWidget {
         addChild(panel);
 
 		// Screws
-		addChild(createDynamicScrew<IMScrew>(Vec(15, 0), &module->panelTheme));
-		addChild(createDynamicScrew<IMScrew>(Vec(box.size.x-30, 0), &module->panelTheme));
-		addChild(createDynamicScrew<IMScrew>(Vec(15, 365), &module->panelTheme));
-		addChild(createDynamicScrew<IMScrew>(Vec(box.size.x-30, 365), &module->panelTheme));
+		panel->addChild(createDynamicScrew<IMScrew>(Vec(15, 0), &module->panelTheme));
+		panel->addChild(createDynamicScrew<IMScrew>(Vec(box.size.x-30, 0), &module->panelTheme));
+		panel->addChild(createDynamicScrew<IMScrew>(Vec(15, 365), &module->panelTheme));
+		panel->addChild(createDynamicScrew<IMScrew>(Vec(box.size.x-30, 365), &module->panelTheme));
 
 		// Column rulers (horizontal positions)
 		static const int columnRuler0 = 25;
@@ -785,6 +788,13 @@ Model *modelWriteSeq32 = Model::create<WriteSeq32, WriteSeq32Widget>("Impromptu
 
 /*CHANGE LOG
 
+0.6.17:
+display font taken from the plugin asset cache
+lights are written through LightState, so that only changed lights are written
+screws are drawn in the panel's framebuffer
+note display is framebuffer cached and drawn with drawGhostedTexts()
+optional timing instrumentation (IM_TIMING)
+
 0.6.16:
 add 2nd gate mode for held gates (with right click to turn off)
 
@@ -59,26 +59,33 @@ struct WriteSeq64 : Module {
 		NUM_LIGHTS
 	};
 
+	struct SeqStep {
+		float cv;
+		int gate;// 0 = off, 1 = clock gate, 2 = full gate
+	};
+	enum RecordModeIds {RECORD_OFF, RECORD_REPLACE, RECORD_OVERDUB};
+
 	// Need to save
 	int panelTheme = 0;
 	bool running;
 	//int indexChannel;
 	int indexStep[5];// [0;63] each
 	int indexSteps[5];// [1;64] each
-	float cv[5][64];
-	int gates[5][64];
+	SeqStep steps[5][64];// cv and gate of each step, a whole channel moves with one memcpy
 	bool resetOnRun;
+	int recordMode;// RECORD_OFF, RECORD_REPLACE or RECORD_OVERDUB, records at every clock when running
+	int recordChannels;// one bit per channel (1 to 4) that records when recordMode is on
 
 	// No need to save
-	float cvCPbuffer[64];// copy paste buffer for CVs
-	int gateCPbuffer[64];// copy paste buffer for gates
-	int stepsCPbuffer;
+	SeqStep stepsCPbuffer[64];// copy paste buffer
+	int lengthCPbuffer;
 	long infoCopyPaste;// 0 when no info, positive downward step counter timer when copy, negative upward when paste
 	int pendingPaste;// 0 = nothing to paste, 1 = paste on clk, 2 = paste on seq, destination channel in next msbits
 	long clockIgnoreOnReset;
 
 
 	unsigned int lightRefreshCounter = 0;	
+	LightState lightState;
 	int stepKnob = 0;
 	int stepsKnob = 0;
 	float resetLight = 0.0f;
@@ -103,30 +110,31 @@ struct WriteSeq64 : Module {
 
 
 	WriteSeq64() : Module(NUM_PARAMS, NUM_INPUTS, NUM_OUTPUTS, NUM_LIGHTS) {
+		lightState.init(&lights);
 		onReset();
 	}
 
 	
 	void onReset() override {
+		IM_TIME_SCOPE("WriteSeq64", TIMING_RESET);
 		running = true;
 		//indexChannel = 0;
+		for (int s = 0; s < 64; s++) {
+			stepsCPbuffer[s].cv = 0.0f;
+			stepsCPbuffer[s].gate = 1;
+		}
 		for (int c = 0; c < 5; c++) {
 			indexStep[c] = 0;
 			indexSteps[c] = 64;
-			for (int s = 0; s < 64; s++) {
-				cv[c][s] = 0.0f;
-				gates[c][s] = 1;
-			}
+			memcpy(steps[c], stepsCPbuffer, sizeof(stepsCPbuffer));
 		}
-		for (int s = 0; s < 64; s++) {
-			cvCPbuffer[s] = 0.0f;
-			gateCPbuffer[s] = 1;
-		}
-		stepsCPbuffer = 64;
+		lengthCPbuffer = 64;
 		infoCopyPaste = 0l;
 		pendingPaste = 0;
 		clockIgnoreOnReset = (long) (clockIgnoreOnResetDuration * engineGetSampleRate());
 		resetOnRun = false;
+		recordMode = RECORD_OFF;
+		recordChannels = 0x1;
 	}
 
 	
@@ -146,14 +154,16 @@ struct WriteSeq64 : Module {
 		// }
 		// stepsCPbuffer = 64;
 		for (int s = 0; s < 64; s++) {
-			cv[indexChannel][s] = quantize((randomUniform() *10.0f) - 4.0f, params[QUANTIZE_PARAM].value > 0.5f);
-			gates[indexChannel][s] = (randomUniform() > 0.5f) ? 1 : 0;
+			steps[indexChannel][s].cv = quantize((randomUniform() *10.0f) - 4.0f, params[QUANTIZE_PARAM].value > 0.5f);
+			steps[indexChannel][s].gate = (randomUniform() > 0.5f) ? 1 : 0;
 		}		
 		pendingPaste = 0;
 	}
 
 	
 	json_t *toJson() override {
+		IM_TIME_SCOPE("WriteSeq64", TIMING_TOJSON);
+		IM_LOG_LIGHTS("WriteSeq64", lightState);
 		json_t *rootJ = json_object();
 
 		// panelTheme
@@ -181,7 +191,7 @@ struct WriteSeq64 : Module {
 		json_t *cvJ = json_array();
 		for (int c = 0; c < 5; c++)
 			for (int s = 0; s < 64; s++) {
-				json_array_insert_new(cvJ, s + (c<<6), json_real(cv[c][s]));
+				json_array_insert_new(cvJ, s + (c<<6), json_real(steps[c][s].cv));
 			}
 		json_object_set_new(rootJ, "cv", cvJ);
 
@@ -189,18 +199,25 @@ struct WriteSeq64 : Module {
 		json_t *gatesJ = json_array();
 		for (int c = 0; c < 5; c++)
 			for (int s = 0; s < 64; s++) {
-				json_array_insert_new(gatesJ, s + (c<<6), json_integer(gates[c][s]));
+				json_array_insert_new(gatesJ, s + (c<<6), json_integer(steps[c][s].gate));
 			}
 		json_object_set_new(rootJ, "gates", gatesJ);
 
 		// resetOnRun
 		json_object_set_new(rootJ, "resetOnRun", json_boolean(resetOnRun));
 		
+		// recordMode
+		json_object_set_new(rootJ, "recordMode", json_integer(recordMode));
+		
+		// recordChannels
+		json_object_set_new(rootJ, "recordChannels", json_integer(recordChannels));
+		
 		return rootJ;
 	}
 
 	
 	void fromJson(json_t *rootJ) override {
+		IM_TIME_SCOPE("WriteSeq64", TIMING_FROMJSON);
 		// panelTheme
 		json_t *panelThemeJ = json_object_get(rootJ, "panelTheme");
 		if (panelThemeJ)
@@ -243,7 +260,7 @@ struct WriteSeq64 : Module {
 				for (int i = 0; i < 64; i++) {
 					json_t *cvArrayJ = json_array_get(cvJ, i + (c<<6));
 					if (cvArrayJ)
-						cv[c][i] = json_number_value(cvArrayJ);
+						steps[c][i].cv = json_number_value(cvArrayJ);
 				}
 		}
 		
@@ -254,7 +271,7 @@ struct WriteSeq64 : Module {
 				for (int i = 0; i < 64; i++) {
 					json_t *gateJ = json_array_get(gatesJ, i + (c<<6));
 					if (gateJ)
-						gates[c][i] = json_integer_value(gateJ);
+						steps[c][i].gate = json_integer_value(gateJ);
 				}
 		}
 		
@@ -262,6 +279,16 @@ struct WriteSeq64 : Module {
 		json_t *resetOnRunJ = json_object_get(rootJ, "resetOnRun");
 		if (resetOnRunJ)
 			resetOnRun = json_is_true(resetOnRunJ);
+
+		// recordMode
+		json_t *recordModeJ = json_object_get(rootJ, "recordMode");
+		if (recordModeJ)
+			recordMode = clamp((int)json_integer_value(recordModeJ), (int)RECORD_OFF, (int)RECORD_OVERDUB);
+
+		// recordChannels
+		json_t *recordChannelsJ = json_object_get(rootJ, "recordChannels");
+		if (recordChannelsJ)
+			recordChannels = ((int)json_integer_value(recordChannelsJ)) & 0xF;
 	}
 	
 	
@@ -292,11 +319,8 @@ struct WriteSeq64 : Module {
 			// Copy button
 			if (copyTrigger.process(params[COPY_PARAM].value)) {
 				infoCopyPaste = (long) (copyPasteInfoTime * engineGetSampleRate() / displayRefreshStepSkips);
-				for (int s = 0; s < 64; s++) {
-					cvCPbuffer[s] = cv[indexChannel][s];
-					gateCPbuffer[s] = gates[indexChannel][s];
-				}
-				stepsCPbuffer = indexSteps[indexChannel];
+				memcpy(stepsCPbuffer, steps[indexChannel], sizeof(stepsCPbuffer));
+				lengthCPbuffer = indexSteps[indexChannel];
 				pendingPaste = 0;
 			}
 			// Paste button
@@ -304,13 +328,10 @@ struct WriteSeq64 : Module {
 				if (params[PASTESYNC_PARAM].value < 0.5f || indexChannel == 4) {
 					// Paste realtime, no pending to schedule
 					infoCopyPaste = (long) (-1 * copyPasteInfoTime * engineGetSampleRate() / displayRefreshStepSkips);
-					for (int s = 0; s < 64; s++) {
-						cv[indexChannel][s] = cvCPbuffer[s];
-						gates[indexChannel][s] = gateCPbuffer[s];
-					}
-					indexSteps[indexChannel] = stepsCPbuffer;
-					if (indexStep[indexChannel] >= stepsCPbuffer)
-						indexStep[indexChannel] = stepsCPbuffer - 1;
+					memcpy(steps[indexChannel], stepsCPbuffer, sizeof(stepsCPbuffer));
+					indexSteps[indexChannel] = lengthCPbuffer;
+					if (indexStep[indexChannel] >= lengthCPbuffer)
+						indexStep[indexChannel] = lengthCPbuffer - 1;
 					pendingPaste = 0;
 				}
 				else {
@@ -321,13 +342,14 @@ struct WriteSeq64 : Module {
 				
 			// Gate button
 			if (gateTrigger.process(params[GATE_PARAM].value)) {
+				SeqStep *seqStep = &steps[indexChannel][indexStep[indexChannel]];
 				if (params[GATE_PARAM].value > 1.5f) {// right button click
-					gates[indexChannel][indexStep[indexChannel]] = 0;
+					seqStep->gate = 0;
 				}
 				else {
-					gates[indexChannel][indexStep[indexChannel]]++;
-					if (gates[indexChannel][indexStep[indexChannel]] > 2)
-						gates[indexChannel][indexStep[indexChannel]] = 0;
+					seqStep->gate++;
+					if (seqStep->gate > 2)
+						seqStep->gate = 0;
 				}
 			}
 			
@@ -361,10 +383,10 @@ struct WriteSeq64 : Module {
 			if (writeTrigger.process(params[WRITE_PARAM].value + inputs[WRITE_INPUT].value)) {
 				if (canEdit) {		
 					// CV
-					cv[indexChannel][indexStep[indexChannel]] = quantize(inputs[CV_INPUT].value, params[QUANTIZE_PARAM].value > 0.5f);
+					steps[indexChannel][indexStep[indexChannel]].cv = quantize(inputs[CV_INPUT].value, params[QUANTIZE_PARAM].value > 0.5f);
 					// Gate
 					if (inputs[GATE_INPUT].active)
-						gates[indexChannel][indexStep[indexChannel]] = (inputs[GATE_INPUT].value >= 1.0f) ? 1 : 0;
+						steps[indexChannel][indexStep[indexChannel]].gate = (inputs[GATE_INPUT].value >= 1.0f) ? 1 : 0;
 					// Autostep
 					if (params[AUTOSTEP_PARAM].value > 0.5f)
 						indexStep[indexChannel] = moveIndex(indexStep[indexChannel], indexStep[indexChannel] + 1, indexSteps[indexChannel]);
@@ -402,6 +424,12 @@ struct WriteSeq64 : Module {
 				indexStep[2] = moveIndex(indexStep[2], indexStep[2] + 1, indexSteps[2]);
 				indexStep[3] = moveIndex(indexStep[3], indexStep[3] + 1, indexSteps[3]);
 			}	
+			
+			// Stream record into the steps just reached
+			if (recordMode != RECORD_OFF && (clk12step || clk34step)) {
+				unsigned int clockedChannels = (clk12step ? 0x3 : 0x0) | (clk34step ? 0xC : 0x0);
+				recordSteps((unsigned int)recordChannels & clockedChannels);
+			}
 
 			// Pending paste on clock or end of seq
 			if ( ((pendingPaste&0x3) == 1) || ((pendingPaste&0x3) == 2 && indexStep[indexChannel] == 0) ) {
@@ -409,13 +437,10 @@ struct WriteSeq64 : Module {
 					 (clk34step && (indexChannel == 2 || indexChannel == 3)) ) {
 					infoCopyPaste = (long) (-1 * copyPasteInfoTime * engineGetSampleRate() / displayRefreshStepSkips);
 					int pasteChannel = pendingPaste>>2;
-					for (int s = 0; s < 64; s++) {
-						cv[pasteChannel][s] = cvCPbuffer[s];
-						gates[pasteChannel][s] = gateCPbuffer[s];
-					}
-					indexSteps[pasteChannel] = stepsCPbuffer;
-					if (indexStep[pasteChannel] >= stepsCPbuffer)
-						indexStep[pasteChannel] = stepsCPbuffer - 1;
+					memcpy(steps[pasteChannel], stepsCPbuffer, sizeof(stepsCPbuffer));
+					indexSteps[pasteChannel] = lengthCPbuffer;
+					if (indexStep[pasteChannel] >= lengthCPbuffer)
+						indexStep[pasteChannel] = lengthCPbuffer - 1;
 					pendingPaste = 0;
 				}
 			}
@@ -440,9 +465,10 @@ struct WriteSeq64 : Module {
 			bool clockHigh = false;
 			bool retriggingOnReset = (clockIgnoreOnReset != 0l && retrigGatesOnReset);
 			for (int i = 0; i < 4; i++) {
-				outputs[CV_OUTPUTS + i].value = cv[i][indexStep[i]];
+				SeqStep *seqStep = &steps[i][indexStep[i]];
+				outputs[CV_OUTPUTS + i].value = seqStep->cv;
 				clockHigh = i < 2 ? clock12Trigger.isHigh() : clock34Trigger.isHigh();
-				outputs[GATE_OUTPUTS + i].value = ( (((gates[i][indexStep[i]] == 1) && clockHigh) || gates[i][indexStep[i]] == 2) && !retriggingOnReset ) ? 10.0f : 0.0f;
+				outputs[GATE_OUTPUTS + i].value = ( (((seqStep->gate == 1) && clockHigh) || seqStep->gate == 2) && !retriggingOnReset ) ? 10.0f : 0.0f;
 			}
 		}
 		else {
@@ -450,7 +476,7 @@ struct WriteSeq64 : Module {
 			for (int i = 0; i < 4; i++) {
 				// CV
 				if (params[MONITOR_PARAM].value > 0.5f)
-					outputs[CV_OUTPUTS + i].value = cv[i][indexStep[i]];// each CV out monitors the current step CV of that channel
+					outputs[CV_OUTPUTS + i].value = steps[i][indexStep[i]].cv;// each CV out monitors the current step CV of that channel
 				else
 					outputs[CV_OUTPUTS + i].value = quantize(inputs[CV_INPUT].value, params[QUANTIZE_PARAM].value > 0.5f);// all CV outs monitor the CV in (only current channel will have a gate though)
 				
@@ -466,26 +492,27 @@ struct WriteSeq64 : Module {
 			// Gate light
 			float green = 0.0f;
 			float red = 0.0f;
-			if (gates[indexChannel][indexStep[indexChannel]] != 0) {
-				if (gates[indexChannel][indexStep[indexChannel]] == 1) 	green = 1.0f;
+			int gate = steps[indexChannel][indexStep[indexChannel]].gate;
+			if (gate != 0) {
+				if (gate == 1) 											green = 1.0f;
 				else {													green = 0.2f; red = 1.0f;}
 			}	
-			lights[GATE_LIGHT + 0].value = green;			
-			lights[GATE_LIGHT + 1].value = red;
+			lightState.set(GATE_LIGHT + 0, green);			
+			lightState.set(GATE_LIGHT + 1, red);
 			
 			// Reset light
-			lights[RESET_LIGHT].value =	resetLight;	
+			lightState.set(RESET_LIGHT, resetLight);	
 			resetLight -= (resetLight / lightLambda) * engineGetSampleTime() * displayRefreshStepSkips;
 
 			// Run light
-			lights[RUN_LIGHT].value = running ? 1.0f : 0.0f;
+			lightState.set(RUN_LIGHT, running ? 1.0f : 0.0f);
 			
 			// Write allowed light
-			lights[WRITE_LIGHT + 0].value = (canEdit)?1.0f:0.0f;
-			lights[WRITE_LIGHT + 1].value = (canEdit)?0.0f:1.0f;
+			lightState.set(WRITE_LIGHT + 0, (canEdit)?1.0f:0.0f);
+			lightState.set(WRITE_LIGHT + 1, (canEdit)?0.0f:1.0f);
 			
 			// Pending paste light
-			lights[PENDING_LIGHT].value = (pendingPaste == 0 ? 0.0f : 1.0f);
+			lightState.set(PENDING_LIGHT, (pendingPaste == 0 ? 0.0f : 1.0f));
 			
 			if (infoCopyPaste != 0l) {
 				if (infoCopyPaste > 0l)
@@ -498,23 +525,40 @@ struct WriteSeq64 : Module {
 		if (clockIgnoreOnReset > 0l)
 			clockIgnoreOnReset--;
 	}
+	
+	
+	inline void recordSteps(unsigned int channels) {
+		// replace writes the CV (and the gate when the gate input is connected) into every step reached
+		// overdub only writes when the gate input is high, so that rests keep what was there (nothing is written when it is not connected)
+		bool gateActive = inputs[GATE_INPUT].active;
+		bool gateHigh = gateActive && inputs[GATE_INPUT].value >= 1.0f;
+		if (recordMode == RECORD_OVERDUB && !gateHigh)
+			return;
+		SeqStep rec;
+		rec.cv = quantize(inputs[CV_INPUT].value, params[QUANTIZE_PARAM].value > 0.5f);
+		rec.gate = gateHigh ? 1 : 0;
+		for (int c = 0; c < 4; c++) {
+			if ((channels & (1 << c)) == 0)
+				continue;
+			SeqStep *seqStep = &steps[c][indexStep[c]];
+			if (gateActive)
+				*seqStep = rec;
+			else
+				seqStep->cv = rec.cv;
+		}
+	}
 };
 
 
 struct WriteSeq64Widget : ModuleWidget {
 
-	struct NoteDisplayWidget : TransparentWidget {
+	struct NoteDisplayWidget : CachedDisplayWidget {
 		WriteSeq64 *module;
-		std::shared_ptr<Font> font;
-		char text[7];
 
-		NoteDisplayWidget() {
-			font = Font::load(assetPlugin(plugin, "res/fonts/Segment14.ttf"));
-		}
-		
-		void cvToStr(void) {
+		void printContent() override {
+			char *text = displayStr;
 			int indexChannel = module->calcChan();
-			float cvVal = module->cv[indexChannel][module->indexStep[indexChannel]];
+			float cvVal = module->steps[indexChannel][module->indexStep[indexChannel]].cv;
 			if (module->infoCopyPaste != 0l) {
 				if (module->infoCopyPaste > 0l) {// if copy then display "Copy"
 					snprintf(text, 7, "COPY");
@@ -538,17 +582,13 @@ struct WriteSeq64Widget : ModuleWidget {
 			}
 		}
 
-		void draw(NVGcontext *vg) override {
+		void drawContent(NVGcontext *vg) override {
 			NVGcolor textColor = prepareDisplay(vg, &box, 18);
-			nvgFontFaceId(vg, font->handle);
+			nvgFontFaceId(vg, getFontHandle(vg));
 			nvgTextLetterSpacing(vg, -1.5);
 
-			Vec textPos = Vec(6, 24);
-			nvgFillColor(vg, nvgTransRGBA(textColor, displayAlpha));
-			nvgText(vg, textPos.x, textPos.y, "~~~~~~", NULL);
-			nvgFillColor(vg, textColor);
-			cvToStr();
-			nvgText(vg, textPos.x, textPos.y, text, NULL);
+			float posX = 6.0f;
+			drawGhostedTexts(vg, textColor, "~~~~~~", &posX, 24.0f, displayStr, 0, 1);
 		}
 	};
 
@@ -558,7 +598,7 @@ struct WriteSeq64Widget : ModuleWidget {
 		std::shared_ptr<Font> font;
 		
 		StepsDisplayWidget() {
-			font = Font::load(assetPlugin(plugin, "res/fonts/Segment14.ttf"));
+			font = imAssets.getFont();
 		}
 
 		void draw(NVGcontext *vg) override {
@@ -582,7 +622,7 @@ struct WriteSeq64Widget : ModuleWidget {
 		std::shared_ptr<Font> font;
 		
 		StepDisplayWidget() {
-			font = Font::load(assetPlugin(plugin, "res/fonts/Segment14.ttf"));
+			font = imAssets.getFont();
 		}
 
 		void draw(NVGcontext *vg) override {
@@ -607,7 +647,7 @@ struct WriteSeq64Widget : ModuleWidget {
 		std::shared_ptr<Font> font;
 		
 		ChannelDisplayWidget() {
-			font = Font::load(assetPlugin(plugin, "res/fonts/Segment14.ttf"));
+			font = imAssets.getFont();
 		}
 
 		void draw(NVGcontext *vg) override {
@@ -643,6 +683,26 @@ struct WriteSeq64Widget : ModuleWidget {
 			module->resetOnRun = !module->resetOnRun;
 		}
 	};
+	struct RecordModeItem : MenuItem {
+		WriteSeq64 *module;
+		int mode;
+		void onAction(EventAction &e) override {
+			module->recordMode = mode;
+		}
+		void step() override {
+			rightText = (module->recordMode == mode) ? "✔" : "";
+		}
+	};
+	struct RecordChannelItem : MenuItem {
+		WriteSeq64 *module;
+		int chan;
+		void onAction(EventAction &e) override {
+			module->recordChannels ^= (1 << chan);
+		}
+		void step() override {
+			rightText = ((module->recordChannels & (1 << chan)) != 0) ? "✔" : "";
+		}
+	};
 	Menu *createContextMenu() override {
 		Menu *menu = ModuleWidget::createContextMenu();
 
@@ -677,12 +737,41 @@ struct WriteSeq64Widget : ModuleWidget {
 		ResetOnRunItem *rorItem = MenuItem::create<ResetOnRunItem>("Reset on run", CHECKMARK(module->resetOnRun));
 		rorItem->module = module;
 		menu->addChild(rorItem);
+
+		menu->addChild(new MenuLabel());// empty line
+		
+		MenuLabel *recordLabel = new MenuLabel();
+		recordLabel->text = "Record on every clock";
+		menu->addChild(recordLabel);
+
+		RecordModeItem *recOffItem = MenuItem::create<RecordModeItem>("Off", CHECKMARK(module->recordMode == WriteSeq64::RECORD_OFF));
+		recOffItem->module = module;
+		recOffItem->mode = WriteSeq64::RECORD_OFF;
+		menu->addChild(recOffItem);
+
+		RecordModeItem *recReplaceItem = MenuItem::create<RecordModeItem>("Replace", CHECKMARK(module->recordMode == WriteSeq64::RECORD_REPLACE));
+		recReplaceItem->module = module;
+		recReplaceItem->mode = WriteSeq64::RECORD_REPLACE;
+		menu->addChild(recReplaceItem);
+
+		RecordModeItem *recOverdubItem = MenuItem::create<RecordModeItem>("Overdub", CHECKMARK(module->recordMode == WriteSeq64::RECORD_OVERDUB));
+		recOverdubItem->module = module;
+		recOverdubItem->mode = WriteSeq64::RECORD_OVERDUB;
+		menu->addChild(recOverdubItem);
+
+		for (int c = 0; c < 4; c++) {
+			RecordChannelItem *recChanItem = MenuItem::create<RecordChannelItem>(stringf("Record channel %i", c + 1), CHECKMARK((module->recordChannels & (1 << c)) != 0));
+			recChanItem->module = module;
+			recChanItem->chan = c;
+			menu->addChild(recChanItem);
+		}
 		
 		return menu;
 	}	
 	
 	
 	WriteSeq64Widget(WriteSeq64 *module) : ModuleWidget(module) {
+		IM_TIME_SCOPE("WriteSeq64", TIMING_WIDGET);
 		// Main panel from Inkscape
         DynamicSVGPanel *panel = new DynamicSVGPanel();
         panel->addPanel(SVG::load(assetPlugin(plugin, "res/light/WriteSeq64.svg")));
@@ -692,10 +781,10 @@ struct WriteSeq64Widget : ModuleWidget {
         addChild(panel);
 		
 		// Screws
-		addChild(createDynamicScrew<IMScrew>(Vec(15, 0), &module->panelTheme));
-		addChild(createDynamicScrew<IMScrew>(Vec(box.size.x-30, 0), &module->panelTheme));
-		addChild(createDynamicScrew<IMScrew>(Vec(15, 365), &module->panelTheme));
-		addChild(createDynamicScrew<IMScrew>(Vec(box.size.x-30, 365), &module->panelTheme));
+		panel->addChild(createDynamicScrew<IMScrew>(Vec(15, 0), &module->panelTheme));
+		panel->addChild(createDynamicScrew<IMScrew>(Vec(box.size.x-30, 0), &module->panelTheme));
+		panel->addChild(createDynamicScrew<IMScrew>(Vec(15, 365), &module->panelTheme));
+		panel->addChild(createDynamicScrew<IMScrew>(Vec(box.size.x-30, 365), &module->panelTheme));
 
 		
 		// ****** Top portion ******
@@ -841,6 +930,15 @@ Model *modelWriteSeq64 = Model::create<WriteSeq64, WriteSeq64Widget>("Impromptu
 
 /*CHANGE LOG
 
+0.6.17:
+display font taken from the plugin asset cache
+lights are written through LightState, so that only changed lights are written
+screws are drawn in the panel's framebuffer
+note display is framebuffer cached and drawn with drawGhostedTexts()
+optional timing instrumentation (IM_TIMING)
+steps stored as cv/gate structs, copy and paste are memcpy moves
+continuous record on every clock (replace or overdub) into any of channels 1 to 4
+
 0.6.16:
 add 2nd gate mode for held gates (with right click to turn off)
 
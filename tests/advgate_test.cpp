@@ -0,0 +1,100 @@
+//***********************************************************************************************
+//Impromptu Modular: Modules for VCV Rack by Marc Boulé
+//
+//Test of the shared advanced gate table (AdvGateUtil) against the gate codes that PhraseSeq16/32,
+//SemiModularSynth and GateSeq64 (24 step masks) and Foundry (96 step masks) computed before the
+//table, for all gate modes and all of their pulses per step, so that patches keep their gates.
+//Not part of the plugin, build and run from the plugin folder with:
+//  g++ -std=c++11 -O2 -I$(RACK_DIR)/include -I$(RACK_DIR)/dep/include -Isrc tests/advgate_test.cpp src/AdvGateUtil.cpp -o advgate_test && ./advgate_test
+//***********************************************************************************************
+
+
+#include "../src/PhraseSeqUtil.hpp"
+#include <cstdio>
+
+
+// PhraseSeqUtil.cpp and GateSeq64.cpp before the table
+static const uint32_t oldHitMask24[NUM_GATES] =
+{0x00003F, 0x0F0F0F, 0x000FFF, 0x0F0F00, 0x03FFFF, 0xFFFFFF, 0x00000F, 0x03F03F, 0x000F00, 0x03F000, 0x0F0000, 0};
+
+static int oldCode24(int gateMode, int ppqnCount, int pulsesPerStep) {
+	if (pulsesPerStep == 1 && gateMode == 0)
+		return 2;// clock high
+	if (gateMode == 11)
+		return (ppqnCount == 0 ? 3 : 0);
+	uint32_t shiftAmt = ppqnCount * (24 / pulsesPerStep);
+	return (int)((oldHitMask24[gateMode] >> shiftAmt) & (uint32_t)0x1);
+}
+
+
+// FoundrySequencerKernel.cpp before the table
+static const uint64_t oldHitMaskLow[NUM_GATES] =
+{0x0000000000FFFFFF, 0x0000FFFF0000FFFF, 0x0000FFFFFFFFFFFF, 0x0000FFFF00000000, 0xFFFFFFFFFFFFFFFF, 0xFFFFFFFFFFFFFFFF,
+ 0x000000000000FFFF, 0xFFFF000000FFFFFF, 0x0000FFFF00000000, 0xFFFF000000000000, 0x0000000000000000, 0};
+static const uint64_t oldHitMaskHigh[NUM_GATES] =
+{0x0000000000000000, 0x000000000000FFFF, 0x0000000000000000, 0x000000000000FFFF, 0x00000000000000FF, 0x00000000FFFFFFFF,
+ 0x0000000000000000, 0x00000000000000FF, 0x0000000000000000, 0x00000000000000FF, 0x000000000000FFFF, 0};
+
+static int oldCode96(int gateType, int ppqnCount, int ppsFiltered) {
+	if (ppsFiltered == 1 && gateType == 0)
+		return 2;// clock high pulse
+	if (gateType == 11)
+		return (ppqnCount == 0 ? 3 : 0);
+	uint64_t shiftAmt = ppqnCount * (96 / ppsFiltered);
+	if (shiftAmt >= 64)
+		return (int)((oldHitMaskHigh[gateType] >> (shiftAmt - (uint64_t)64)) & (uint64_t)0x1);
+	return (int)((oldHitMaskLow[gateType] >> shiftAmt) & (uint64_t)0x1);
+}
+
+
+int main() {
+	int bad = 0;
+	int checked = 0;
+
+	// PhraseSeq16/32 and SemiModularSynth: pps 1, 2, 4, 6 ... 24
+	for (int index = 0; index <= 12; index++) {
+		int pps = indexToPps(index);
+		for (int mode = 0; mode < NUM_GATES; mode++) {
+			for (int pulse = 0; pulse < pps; pulse++, checked++) {
+				int code = calcGateCode(mode, pulse, pps);
+				if (code != oldCode24(mode, pulse, pps)) {
+					if (bad < 10)
+						printf("PhraseSeq: mode %i, pps %i, pulse %i: code %i instead of %i\n", mode, pps, pulse, code, oldCode24(mode, pulse, pps));
+					bad++;
+				}
+			}
+		}
+	}
+
+	// GateSeq64: pps 1, 4, 6, 12, 24, gate modes are built-in patterns
+	const int ppsGS[5] = {1, 4, 6, 12, 24};
+	for (int i = 0; i < 5; i++) {
+		for (int mode = 0; mode < NUM_GATES; mode++) {
+			for (int pulse = 0; pulse < ppsGS[i]; pulse++, checked++) {
+				int code = advGates.getCode(mode, pulse, ppsGS[i]);
+				if (code != oldCode24(mode, pulse, ppsGS[i])) {
+					if (bad < 10)
+						printf("GateSeq64: mode %i, pps %i, pulse %i: code %i instead of %i\n", mode, ppsGS[i], pulse, code, oldCode24(mode, pulse, ppsGS[i]));
+					bad++;
+				}
+			}
+		}
+	}
+
+	// Foundry: pps 1, 2, 4, 6 ... 96
+	for (int pps = 1; pps <= 96; pps = (pps == 1 ? 2 : pps + 2)) {
+		for (int mode = 0; mode < NUM_GATES; mode++) {
+			for (int pulse = 0; pulse < pps; pulse++, checked++) {
+				int code = advGates.getCode(mode, pulse, pps);
+				if (code != oldCode96(mode, pulse, pps)) {
+					if (bad < 10)
+						printf("Foundry: mode %i, pps %i, pulse %i: code %i instead of %i\n", mode, pps, pulse, code, oldCode96(mode, pulse, pps));
+					bad++;
+				}
+			}
+		}
+	}
+
+	printf("%s: %i failure(s) in %i gate codes\n", bad == 0 ? "PASS" : "FAIL", bad, checked);
+	return bad == 0 ? 0 : 1;
+}
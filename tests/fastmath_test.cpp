@@ -0,0 +1,112 @@
+//***********************************************************************************************
+//Impromptu Modular: Modules for VCV Rack by Marc Boulé
+//
+//Test of the approximations in FastMathUtil.hpp against double precision libm, over the input
+//ranges given in the error bounds of that file. Prints the maximum absolute and relative errors
+//of the scalar and SSE versions, and fails when a documented bound is exceeded.
+//Not part of the plugin, build and run from the plugin folder with:
+//  g++ -std=c++11 -O2 -Isrc tests/fastmath_test.cpp -o fastmath_test && ./fastmath_test
+//***********************************************************************************************
+
+
+#include "../src/FastMathUtil.hpp"
+#ifndef __SSE2__
+#error the test also covers the SSE versions, build for x86 with SSE2
+#endif
+#include <cstdio>
+#include <cfloat>
+
+
+static const int NUM_POINTS = 4000000;// evenly spaced inputs per range
+
+
+struct ErrorStats {
+	double maxAbs = 0.0;
+	double maxRel = 0.0;
+	float xAbs = 0.0f;
+	float xRel = 0.0f;
+
+	void add(float x, double approx, double ref, double relFloor) {
+		double absErr = fabs(approx - ref);
+		if (absErr > maxAbs) {
+			maxAbs = absErr;
+			xAbs = x;
+		}
+		if (fabs(ref) >= relFloor) {// relative error is meaningless near zeros of the function
+			double relErr = absErr / fabs(ref);
+			if (relErr > maxRel) {
+				maxRel = relErr;
+				xRel = x;
+			}
+		}
+	}
+};
+
+
+static int bad = 0;
+
+static void report(const char *name, const char *range, const ErrorStats &stats, bool relBound, double bound) {
+	double err = relBound ? stats.maxRel : stats.maxAbs;
+	bool pass = err < bound;
+	printf("%-17s %-22s max abs %.3e (x = %g), max rel %.3e (x = %g), %s bound %.0e: %s\n", name, range,
+		stats.maxAbs, stats.xAbs, stats.maxRel, stats.xRel, relBound ? "rel" : "abs", bound, pass ? "ok" : "EXCEEDED");
+	if (!pass)
+		bad++;
+}
+
+
+// evaluates a scalar and an SSE version over [lo : hi], the SSE version is given the inputs 4 at a time
+template<typename ScalarF, typename RefF>
+static void testRange(const char *name, const char *range, float lo, float hi, ScalarF scalarF, __m128 (*sseF)(__m128),
+		RefF refF, double relFloor, bool relBound, double bound, bool logSpacing = false) {
+	ErrorStats scalarStats;
+	ErrorStats sseStats;
+	float xs[4];
+	for (int i = 0; i < NUM_POINTS; i += 4) {
+		for (int j = 0; j < 4; j++) {
+			double t = (double)(i + j) / (double)(NUM_POINTS - 1);
+			xs[j] = logSpacing ? (float)exp2(log2((double)lo) + t * (log2((double)hi) - log2((double)lo))) : (float)(lo + t * ((double)hi - lo));
+		}
+		float sseOut[4];
+		_mm_storeu_ps(sseOut, sseF(_mm_loadu_ps(xs)));
+		for (int j = 0; j < 4; j++) {
+			double ref = refF((double)xs[j]);
+			scalarStats.add(xs[j], (double)scalarF(xs[j]), ref, relFloor);
+			sseStats.add(xs[j], (double)sseOut[j], ref, relFloor);
+		}
+	}
+	report(name, range, scalarStats, relBound, bound);
+	char sseName[32];
+	snprintf(sseName, sizeof(sseName), "%s (SSE)", name);
+	report(sseName, range, sseStats, relBound, bound);
+}
+
+
+int main() {
+	testRange("fastExp2", "[-126 : 126]", -126.0f, 126.0f,
+		[](float x) {return fastExp2(x);}, fastExp2, [](double x) {return exp2(x);}, 0.0, true, 3e-7);
+	testRange("fastExp2", "[-4 : 4]", -4.0f, 4.0f,// octave range of the synth's pitch and FM
+		[](float x) {return fastExp2(x);}, fastExp2, [](double x) {return exp2(x);}, 0.0, true, 3e-7);
+
+	testRange("fastTanh", "[-20 : 20]", -20.0f, 20.0f,
+		[](float x) {return fastTanh(x);}, fastTanh, [](double x) {return tanh(x);}, 1e-3, false, 3e-7);
+	testRange("fastTanh", "[-2 : 2]", -2.0f, 2.0f,// knee of the filter saturation
+		[](float x) {return fastTanh(x);}, fastTanh, [](double x) {return tanh(x);}, 1e-3, false, 3e-7);
+	testRange("fastTanh", "[1e-30 : 20]", 1e-30f, 20.0f,// small-signal linearity of the filter (tanh is odd, as is fastTanh)
+		[](float x) {return fastTanh(x);}, fastTanh, [](double x) {return tanh(x);}, 0.0, true, 1e-6, true);
+	testRange("fastTanh", "[-20 : -1e-30]", 1e-30f, 20.0f,// x is reported as -x
+		[](float x) {return fastTanh(-x);}, [](__m128 x) {return fastTanh(_mm_sub_ps(_mm_setzero_ps(), x));}, [](double x) {return tanh(-x);}, 0.0, true, 1e-6, true);
+
+	testRange("fastSin2Pi", "[-100 : 100]", -100.0f, 100.0f,
+		[](float x) {return fastSin2Pi(x);}, fastSin2Pi, [](double x) {return sin(2.0 * M_PI * x);}, 1e-3, false, 3e-7);
+	testRange("fastSin2Pi", "[0 : 1]", 0.0f, 1.0f,// oscillator phase
+		[](float x) {return fastSin2Pi(x);}, fastSin2Pi, [](double x) {return sin(2.0 * M_PI * x);}, 1e-3, false, 3e-7);
+
+	testRange("fastLog2", "[FLT_MIN : FLT_MAX]", FLT_MIN, FLT_MAX,
+		[](float x) {return fastLog2(x);}, fastLog2, [](double x) {return log2(x);}, 1e-3, false, 5e-6, true);
+	testRange("fastLog2", "[0.001 : 1000]", 0.001f, 1000.0f,
+		[](float x) {return fastLog2(x);}, fastLog2, [](double x) {return log2(x);}, 1e-3, false, 5e-6, true);
+
+	printf("%s: %i bound(s) exceeded\n", bad == 0 ? "PASS" : "FAIL", bad);
+	return bad == 0 ? 0 : 1;
+}
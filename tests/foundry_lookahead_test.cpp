@@ -0,0 +1,128 @@
+//***********************************************************************************************
+//Impromptu Modular: Modules for VCV Rack by Marc Boulé
+//
+//Test of SequencerKernel::lookahead() (Foundry) against what clockStep() then plays, for track A and for a track B
+//that follows it (TKA run modes), with all run modes, random song and sequence content, pulses per step, clock delay
+//and gate probabilities.
+//Not part of the plugin, build and run from the plugin folder with:
+//  g++ -std=c++11 -O2 -I$(RACK_DIR)/include -I$(RACK_DIR)/dep/include -Isrc tests/foundry_lookahead_test.cpp src/FoundrySequencerKernel.cpp src/AdvGateUtil.cpp $(RACK_DIR)/dep/lib/libjansson.a -o foundry_lookahead_test && ./foundry_lookahead_test
+//***********************************************************************************************
+
+
+#include "../src/FoundrySequencerKernel.hpp"
+#include <cstdio>
+#include <cstdlib>
+
+
+// the kernel only needs the random functions from Rack (and jansson for its json code, not used here)
+namespace rack {
+	uint32_t randomu32() {return (uint32_t)rand();}
+	uint64_t randomu64() {return (((uint64_t)rand()) << 32) | (uint64_t)rand();}
+	float randomUniform() {return rand() / (RAND_MAX + 1.0f);}
+}
+
+
+static const int NUM_AHEAD = 200;// steps compared per trial
+static const int NUM_SEQS_USED = 8;
+
+
+static SequencerKernel trackA;
+static SequencerKernel trackB;
+
+
+static void randomizeTrack(SequencerKernel* sek, bool editingSequence, int numPhrases, int pps, int delay) {
+	sek->reset(editingSequence);
+	for (int seqn = 0; seqn < NUM_SEQS_USED; seqn++) {
+		sek->setSeqIndexEdit(seqn);
+		sek->randomizeSequence();
+	}
+	sek->setSeqIndexEdit(rand() % NUM_SEQS_USED);
+	for (int phrn = 0; phrn < numPhrases; phrn++) {
+		sek->setPhraseSeqNum(phrn, rand() % NUM_SEQS_USED);
+		sek->setPhraseReps(phrn, 1 + rand() % 3);
+	}
+	sek->setBegin(0);
+	sek->setEnd(numPhrases - 1);
+	sek->setRunModeSong(rand() % SequencerKernel::NUM_MODES);
+	sek->setPulsesPerStep(pps);
+	sek->setDelay(delay);
+}
+
+
+static void clockStep(bool editingSequence) {// track A then track B, as Foundry::step() and Sequencer::clockStep() do
+	bool phraseChange = trackA.clockStep(editingSequence, -1, 0.0f);
+	if (!editingSequence && phraseChange && trackB.getRunModeSong() == SequencerKernel::MODE_TKA) {
+		trackB.setPhraseIndexRun(trackA.getPhraseIndexRun());
+		trackB.setMoveStepIndexRunIgnore();
+	}
+	trackB.clockStep(editingSequence, -1, 0.0f);
+}
+
+
+static int compare(int trial, int n, const char* name, SequencerKernel* sek, SequencerKernel::LookaheadStep* ahead, bool editingSequence) {
+	int seqn = (editingSequence ? sek->getSeqIndexEdit() : sek->getPhraseSeq(sek->getPhraseIndexRun()));
+	int phraseIndex = (editingSequence ? -1 : sek->getPhraseIndexRun());
+	StepAttributes attribute = sek->getAttribute(editingSequence);
+	bool gate = attribute.getGate() && sek->getGateCode() != -1;
+	if (seqn != ahead->seq || phraseIndex != ahead->phraseIndex || sek->getStepIndexRun() != ahead->stepIndex ||
+			sek->getCV(editingSequence) != ahead->cv || gate != ahead->gate || attribute.getAttribute() != ahead->attribute.getAttribute()) {
+		printf("trial %i, step %i, track %s: seq %i phrase %i step %i gate %i instead of seq %i phrase %i step %i gate %i\n", trial, n, name,
+			seqn, phraseIndex, sek->getStepIndexRun(), gate, ahead->seq, ahead->phraseIndex, ahead->stepIndex, ahead->gate);
+		return 1;
+	}
+	return 0;
+}
+
+
+static int runTrial(int trial) {// returns the number of failures
+	bool editingSequence = (rand() % 3) == 0;
+	int numPhrases = 1 + rand() % 8;
+	int pps = 1 + rand() % 13;// raw knob value, see getPulsesPerStep()
+	int delay = rand() % 3;
+	randomizeTrack(&trackA, editingSequence, numPhrases, pps, delay);
+	randomizeTrack(&trackB, editingSequence, numPhrases, pps, delay);// lookahead of TKA tracks needs track A's pulses per step and delay
+	trackA.initRun(editingSequence);
+	trackB.initRun(editingSequence);
+	if (trackA.publishPendingRun())// as Sequencer::publishPendingRuns() does
+		trackB.publishRun();
+
+	static SequencerKernel::LookaheadStep aheadA[NUM_AHEAD];
+	static SequencerKernel::LookaheadStep aheadB[NUM_AHEAD];
+	static SequencerKernel::LookaheadStep aheadA2[NUM_AHEAD];
+	if (trackA.lookahead(aheadA, NUM_AHEAD, editingSequence) != NUM_AHEAD || trackB.lookahead(aheadB, NUM_AHEAD, editingSequence) != NUM_AHEAD ||
+			trackA.lookahead(aheadA2, NUM_AHEAD, editingSequence) != NUM_AHEAD) {
+		printf("trial %i: lookahead could not read the published run state\n", trial);
+		return 1;
+	}
+	for (int n = 0; n < NUM_AHEAD; n++) {
+		if (aheadA[n].stepIndex != aheadA2[n].stepIndex || aheadA[n].gate != aheadA2[n].gate) {
+			printf("trial %i: second lookahead differs at step %i\n", trial, n);
+			return 1;
+		}
+	}
+
+	int ppsFiltered = trackA.getPulsesPerStep();
+	for (int i = 0; i < delay; i++)
+		clockStep(editingSequence);
+	for (int n = 0; n < NUM_AHEAD; n++) {
+		for (int p = 0; p < ppsFiltered; p++)
+			clockStep(editingSequence);// new step on the last pulse
+		if (compare(trial, n, "A", &trackA, &aheadA[n], editingSequence) != 0 || compare(trial, n, "B", &trackB, &aheadB[n], editingSequence) != 0)
+			return 1;
+	}
+	return 0;
+}
+
+
+int main() {
+	static bool holdTiedNotes = true;
+	trackA.construct(0, nullptr, &holdTiedNotes);
+	trackB.construct(1, &trackA, &holdTiedNotes);
+	int bad = 0;
+	srand(1);
+	int trials = 2000;
+	for (int t = 0; t < trials; t++)
+		bad += runTrial(t);
+	printf("%s: %i failure(s) in %i trials\n", bad == 0 ? "PASS" : "FAIL", bad, trials);
+	return bad == 0 ? 0 : 1;
+}
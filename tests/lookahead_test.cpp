@@ -0,0 +1,138 @@
+//***********************************************************************************************
+//Impromptu Modular: Modules for VCV Rack by Marc Boulé
+//
+//Test of PhraseSeqKernel::lookahead() and lookaheadPhrases() against what clockStep() then plays, for the 1x16
+//(PhraseSeq16, SemiModularSynth) and 2x16/1x32 (PhraseSeq32) kernels, with all run modes, random song and
+//sequence content, pulses per step and gate 1 probabilities.
+//Not part of the plugin, build and run from the plugin folder with:
+//  g++ -std=c++11 -O2 -I$(RACK_DIR)/include -I$(RACK_DIR)/dep/include -Isrc tests/lookahead_test.cpp src/PhraseSeqUtil.cpp src/AdvGateUtil.cpp -o lookahead_test && ./lookahead_test
+//***********************************************************************************************
+
+
+#include "../src/PhraseSeqKernel.hpp"
+#include <cstdio>
+#include <cstdlib>
+
+
+// the kernel only needs the random functions from Rack
+namespace rack {
+	uint32_t randomu32() {return (uint32_t)rand();}
+	uint64_t randomu64() {return (((uint64_t)rand()) << 32) | (uint64_t)rand();}
+	float randomUniform() {return rand() / (RAND_MAX + 1.0f);}
+}
+
+
+static const int NUM_AHEAD = 200;// steps compared per trial
+static const int NUM_SEQS = 16;
+static const int NUM_PHRASES = 16;
+
+
+// song run modes where the song never plays the same phrase twice in a row (PPG plays the ends twice), so that each phrase change can be seen from the outside
+static bool isPhraseChangeVisible(int runModeSong, int phrases) {
+	return phrases >= 2 && runModeSong != MODE_PPG && runModeSong != MODE_BRN && runModeSong != MODE_RND && runModeSong != MODE_RN2;
+}
+
+
+template<int MAX_STEPS, int NUM_CHAN>
+static int runTrial(int trial, int numModes) {// returns the number of failures
+	typedef PhraseSeqKernel<MAX_STEPS, NUM_CHAN> Kernel;
+	static float cv[NUM_SEQS][MAX_STEPS];
+	static StepAttributes attributes[NUM_SEQS][MAX_STEPS];
+	static SeqAttributes sequences[NUM_SEQS];
+	static SeqAttributes sequencesB[NUM_SEQS];
+	static int phrase[NUM_PHRASES];
+	static Kernel psk;
+
+	// random content, channel B has its own length and run mode in half of the sequences (PhraseSeq32 2x16)
+	for (int s = 0; s < NUM_SEQS; s++) {
+		for (int i = 0; i < MAX_STEPS; i++) {
+			cv[s][i] = (float)(rand() % 61) / 12.0f - 2.0f;
+			attributes[s][i].randomize();
+			attributes[s][i].setGate1Mode(rand() % NUM_GATES);
+			attributes[s][i].setGate2Mode(rand() % NUM_GATES);
+		}
+		int chanSteps = (NUM_CHAN == 2 ? MAX_STEPS / 2 : MAX_STEPS);
+		sequences[s].init(1 + rand() % chanSteps, rand() % numModes);
+		if ((rand() % 2) == 0)
+			sequencesB[s] = sequences[s];
+		else
+			sequencesB[s].init(1 + rand() % chanSteps, rand() % numModes);
+	}
+	for (int p = 0; p < NUM_PHRASES; p++)
+		phrase[p] = rand() % NUM_SEQS;
+	int phrases = 1 + rand() % NUM_PHRASES;
+	int runModeSong = rand() % numModes;
+	int pulsesPerStep = indexToPps(rand() % 13);
+	int stepConfig = 1 + rand() % 2;// PhraseSeq32: 1 = 2x16, 2 = 1x32
+	bool editingSequence = (rand() % 3) == 0;
+	int seqIndexEdit = rand() % NUM_SEQS;
+	float gate1Prob = rand() / (float)RAND_MAX;
+
+	psk.construct(cv, attributes, sequences, phrase, &phrases, &runModeSong, &pulsesPerStep,
+		NUM_CHAN == 2 ? &stepConfig : nullptr, NUM_CHAN == 2 ? sequencesB : nullptr);
+	psk.initRun(editingSequence, seqIndexEdit, gate1Prob);
+	psk.publishPendingRun();// as the module's step() does
+
+	// lookahead must not change anything, and asking twice must give the same steps
+	static typename Kernel::LookaheadStep ahead[NUM_AHEAD];
+	static typename Kernel::LookaheadStep ahead2[NUM_AHEAD];
+	static int phrasesAhead[NUM_AHEAD];
+	if (psk.lookahead(ahead, NUM_AHEAD, editingSequence, seqIndexEdit, gate1Prob) != NUM_AHEAD ||
+			psk.lookahead(ahead2, NUM_AHEAD, editingSequence, seqIndexEdit, gate1Prob) != NUM_AHEAD ||
+			psk.lookaheadPhrases(phrasesAhead, NUM_AHEAD) != NUM_AHEAD) {
+		printf("trial %i: lookahead could not read the published run state\n", trial);
+		return 1;
+	}
+	for (int n = 0; n < NUM_AHEAD; n++) {
+		if (ahead[n].seq != ahead2[n].seq || ahead[n].stepIndex[0] != ahead2[n].stepIndex[0] || ahead[n].gate1[0] != ahead2[n].gate1[0]) {
+			printf("trial %i: second lookahead differs at step %i\n", trial, n);
+			return 1;
+		}
+	}
+
+	// clock through the same steps and compare
+	int chanStride = (NUM_CHAN == 2 ? stepConfig : 1);
+	int phraseChanges = 0;
+	int lastPhrase = psk.getPhraseIndexRun();
+	for (int n = 0; n < NUM_AHEAD; n++) {
+		for (int p = 0; p < pulsesPerStep; p++)
+			psk.clockStep(editingSequence, seqIndexEdit, gate1Prob, 0.5f, 0.0f);// new step on the last pulse (ppqnCount back to 0)
+		int seq = psk.getSeqRun(editingSequence, seqIndexEdit);
+		if (seq != ahead[n].seq || (!editingSequence && psk.getPhraseIndexRun() != ahead[n].phraseIndex)) {
+			printf("trial %i, step %i: seq %i, phrase %i instead of seq %i, phrase %i\n", trial, n, seq, psk.getPhraseIndexRun(), ahead[n].seq, ahead[n].phraseIndex);
+			return 1;
+		}
+		for (int i = 0; i < NUM_CHAN; i += chanStride) {
+			int stepOffset = i * Kernel::CHAN_STEPS + psk.getStepIndexRun(i);
+			StepAttributes attribute = attributes[seq][stepOffset];
+			bool gate1 = attribute.getGate1() && psk.getGate1Code(i) != -1;
+			if (stepOffset != ahead[n].stepIndex[i] || cv[seq][stepOffset] != ahead[n].cv[i] || gate1 != ahead[n].gate1[i] ||
+					attribute.getGate2() != ahead[n].gate2[i] || attribute.getSlide() != ahead[n].slide[i]) {
+				printf("trial %i, step %i, channel %i: step %i gate1 %i instead of step %i gate1 %i\n", trial, n, i, stepOffset, gate1, ahead[n].stepIndex[i], ahead[n].gate1[i]);
+				return 1;
+			}
+		}
+		if (!editingSequence && isPhraseChangeVisible(runModeSong, phrases) && psk.getPhraseIndexRun() != lastPhrase) {
+			if (psk.getPhraseIndexRun() != phrasesAhead[phraseChanges]) {
+				printf("trial %i, phrase change %i: phrase %i instead of %i\n", trial, phraseChanges, psk.getPhraseIndexRun(), phrasesAhead[phraseChanges]);
+				return 1;
+			}
+			phraseChanges++;
+			lastPhrase = psk.getPhraseIndexRun();
+		}
+	}
+	return 0;
+}
+
+
+int main() {
+	int bad = 0;
+	srand(1);
+	int trials = 3000;
+	for (int t = 0; t < trials; t++) {
+		bad += runTrial<16, 1>(t, NUM_MODES - 1);// no RN2 in PhraseSeq16 and SemiModularSynth
+		bad += runTrial<32, 2>(t, NUM_MODES);
+	}
+	printf("%s: %i failure(s) in %i trials\n", bad == 0 ? "PASS" : "FAIL", bad, trials * 2);
+	return bad == 0 ? 0 : 1;
+}
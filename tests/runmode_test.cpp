@@ -0,0 +1,80 @@
+//***********************************************************************************************
+//Impromptu Modular: Modules for VCV Rack by Marc Boulé
+//
+//Test of the run order tables in moveIndexRunMode() against the original switch stepping
+//(moveIndexRunModeNoTable()), including live length and mode changes in the middle of a pass.
+//Not part of the plugin, build and run from the plugin folder with:
+//  g++ -std=c++11 -O2 -I$(RACK_DIR)/include -I$(RACK_DIR)/dep/include -Isrc tests/runmode_test.cpp src/AdvGateUtil.cpp -o runmode_test && ./runmode_test
+//***********************************************************************************************
+
+
+#include "../src/PhraseSeqUtil.cpp"// for the static moveIndexRunModeNoTable()
+#include <cstdio>
+#include <cstdlib>
+
+
+// the run modes only need the random functions from Rack
+namespace rack {
+	uint32_t randomu32() {return (uint32_t)rand();}
+	uint64_t randomu64() {return (((uint64_t)rand()) << 32) | (uint64_t)rand();}
+	float randomUniform() {return rand() / (RAND_MAX + 1.0f);}
+}
+
+
+static const int deterministicModes[7] = {MODE_FWD, MODE_REV, MODE_PPG, MODE_PEN, MODE_FW2, MODE_FW3, MODE_FW4};
+
+
+int main() {
+	int bad = 0;
+
+	// fixed length and mode, from a reset
+	for (int m = 0; m < 7; m++) {
+		int mode = deterministicModes[m];
+		for (int n = 1; n <= 64; n++) {
+			int indexT = (mode == MODE_REV ? n - 1 : 0);
+			int indexS = indexT;
+			unsigned long historyT = 0;
+			unsigned long historyS = 0;
+			for (int k = 0; k < 1000; k++) {
+				bool crossT = moveIndexRunMode(&indexT, n, mode, &historyT);
+				bool crossS = moveIndexRunModeNoTable(&indexS, n, mode, &historyS, nullptr);
+				if (crossT != crossS || indexT != indexS) {
+					printf("fixed: mode %s length %i, step %i: index %i (boundary %i) instead of %i (%i)\n", modeLabels[mode].c_str(), n, k, indexT, crossT, indexS, crossS);
+					bad++;
+					break;
+				}
+			}
+		}
+	}
+
+	// live length changes (and some mode changes) in the middle of passes
+	srand(1);
+	int trials = 20000;
+	for (int t = 0; t < trials; t++) {
+		int mode = deterministicModes[rand() % 7];
+		int n = 1 + rand() % 64;
+		int indexT = (mode == MODE_REV ? n - 1 : 0);
+		int indexS = indexT;
+		unsigned long historyT = 0;
+		unsigned long historyS = 0;
+		for (int k = 0; k < 400; k++) {
+			int r = rand() % 100;
+			if (r < 4)
+				n = 1 + rand() % 64;
+			else if (r == 4)
+				mode = deterministicModes[rand() % 7];
+			if (indexT >= n)// as the modules do when the length is reduced below the current step
+				indexT = indexS = n - 1;
+			bool crossT = moveIndexRunMode(&indexT, n, mode, &historyT);
+			bool crossS = moveIndexRunModeNoTable(&indexS, n, mode, &historyS, nullptr);
+			if (crossT != crossS || indexT != indexS) {
+				printf("live: trial %i, mode %s length %i, step %i: index %i (boundary %i) instead of %i (%i)\n", t, modeLabels[mode].c_str(), n, k, indexT, crossT, indexS, crossS);
+				bad++;
+				break;
+			}
+		}
+	}
+
+	printf("%s: %i failure(s)\n", bad == 0 ? "PASS" : "FAIL", bad);
+	return bad == 0 ? 0 : 1;
+}
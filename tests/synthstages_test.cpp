@@ -0,0 +1,171 @@
+//***********************************************************************************************
+//Impromptu Modular: Modules for VCV Rack by Marc Boulé
+//
+//Test and benchmark of the ADSR and VCF stages of SemiModularSynth (FundamentalUtil.hpp), outside
+//of the module. The ADSR with its control-rate coefficients is compared to the original per-sample
+//Fundamental ADSR, and the VCF is checked for small-signal gain and linearity at its cutoff.
+//Not part of the plugin, build and run from the plugin folder with:
+//  g++ -std=c++11 -O2 -I$(RACK_DIR)/include -I$(RACK_DIR)/dep/include -Isrc tests/synthstages_test.cpp -o synthstages_test && ./synthstages_test
+//***********************************************************************************************
+
+
+#include "../src/FundamentalUtil.cpp"
+#include <cstdio>
+#include <cstdlib>
+#include <chrono>
+
+
+// the stages only need the random functions and the sample time from Rack
+namespace rack {
+	float randomUniform() {return rand() / (RAND_MAX + 1.0f);}
+	float randomNormal() {return 0.0f;}
+	float engineGetSampleTime() {return 1.0f / 44100.0f;}
+}
+
+
+static const float sampleTime = 1.0f / 44100.0f;
+static const int controlBlock = 16;// samples per control-rate update, as in SemiModularSynth::step()
+static int bad = 0;
+
+
+// Fundamental ADSR.cpp as it was evaluated in SemiModularSynth::step() before the stages, with powf() in every sample
+struct ReferenceADSR {
+	bool decaying = false;
+	float env = 0.0f;
+
+	float process(bool gated, float attack, float decay, float sustain, float release, float dt) {
+		const float base = 20000.0f;
+		const float maxTime = 10.0f;
+		if (gated) {
+			if (decaying) {
+				if (decay < 1e-4)
+					env = sustain;
+				else
+					env += powf(base, 1 - decay) / maxTime * (sustain - env) * dt;
+			}
+			else {
+				if (attack < 1e-4)
+					env = 1.0f;
+				else
+					env += powf(base, 1 - attack) / maxTime * (1.01f - env) * dt;
+				if (env >= 1.0f) {
+					env = 1.0f;
+					decaying = true;
+				}
+			}
+		}
+		else {
+			if (release < 1e-4)
+				env = 0.0f;
+			else
+				env += powf(base, 1 - release) / maxTime * (0.0f - env) * dt;
+			decaying = false;
+		}
+		return env;
+	}
+};
+
+
+static void testADSR() {
+	// random gates and knob moves (including the instantaneous stages), knobs are read once per control block
+	srand(1);
+	ADSREnvelope adsr;
+	ReferenceADSR ref;
+	float knobs[4] = {0.1f, 0.5f, 0.5f, 0.5f};
+	bool gated = false;
+	int firstMismatch = -1;
+	float maxErr = 0.0f;
+	for (int i = 0; i < 44100 * 60; i++) {
+		if ((i % controlBlock) == 0) {
+			if ((rand() % 2000) == 0)
+				gated = !gated;
+			if ((rand() % 500) == 0) {
+				int k = rand() % 4;
+				knobs[k] = ((rand() % 8) == 0) ? 0.0f : rand() / (float)RAND_MAX;
+			}
+			adsr.setParams(knobs[0], knobs[1], knobs[2], knobs[3]);
+		}
+		float env = adsr.process(gated, sampleTime);
+		float envRef = ref.process(gated, knobs[0], knobs[1], knobs[2], knobs[3], sampleTime);
+		float err = fabsf(env - envRef);
+		if (err > maxErr)
+			maxErr = err;
+		if (err != 0.0f && firstMismatch == -1)
+			firstMismatch = i;
+	}
+	printf("ADSR against per-sample Fundamental ADSR: max abs error %.3e%s\n", maxErr, firstMismatch == -1 ? "" : " (differs)");
+	if (firstMismatch != -1) {
+		printf("  first difference at sample %i\n", firstMismatch);
+		bad++;
+	}
+}
+
+
+// peak of the lowpass output for a sine at the cutoff, a 4-pole ladder without resonance gives 1/4 of the input amplitude there
+static float vcfGainAtCutoff(float amplitude, float cutoff) {
+	VoltageControlledFilter vcf;
+	vcf.setDrive(0.0f);
+	vcf.setResonance(0.0f);
+	vcf.setPitch(log2f(cutoff / 261.626f));
+	float peak = 0.0f;
+	int numSamples = 44100;
+	for (int i = 0; i < numSamples; i++) {
+		vcf.process(amplitude * sinf(2.0f * M_PI * cutoff * i * sampleTime), sampleTime);
+		if (i >= numSamples / 2)
+			peak = fmaxf(peak, fabsf(vcf.lowpass()));
+	}
+	return peak / amplitude;
+}
+
+static void testVCF() {
+	srand(1);
+	const float amplitudes[3] = {1e-2f, 1e-3f, 1e-4f};// small enough for the saturation to be negligible, 1e-4 is still 40dB over the bootstrap noise
+	for (int a = 0; a < 3; a++) {
+		float gain = vcfGainAtCutoff(amplitudes[a], 1000.0f);
+		bool pass = fabsf(gain - 0.25f) < 0.25f * 0.03f;
+		printf("VCF lowpass gain at cutoff, amplitude %.0e: %.4f (expected 0.25 +-3%%): %s\n", amplitudes[a], gain, pass ? "ok" : "FAILED");
+		if (!pass)
+			bad++;
+	}
+}
+
+
+template<typename F>
+static void bench(const char *name, F f) {
+	const int numSamples = 44100 * 10;
+	auto start = std::chrono::steady_clock::now();
+	float sink = 0.0f;
+	for (int i = 0; i < numSamples; i++)
+		sink += f(i);
+	auto stop = std::chrono::steady_clock::now();
+	double ns = std::chrono::duration<double, std::nano>(stop - start).count() / numSamples;
+	printf("%-28s %6.1f ns/sample (%.0f)\n", name, ns, sink * 0.0f);
+}
+
+static void benchmarks() {
+	ADSREnvelope adsr;
+	bench("ADSR process", [&](int i) {
+		if ((i % controlBlock) == 0)
+			adsr.setParams(0.1f, 0.5f, 0.5f, 0.5f);
+		return adsr.process((i % 22050) < 11025, sampleTime);
+	});
+	VoltageControlledFilter vcf;
+	bench("VCF process", [&](int i) {
+		if ((i % controlBlock) == 0) {
+			vcf.setDrive(0.2f);
+			vcf.setResonance(0.5f);
+			vcf.setPitch(1.0f);
+		}
+		vcf.process(((i & 0x7F) < 64) ? 1.0f : -1.0f, sampleTime);
+		return vcf.lowpass();
+	});
+}
+
+
+int main() {
+	testADSR();
+	testVCF();
+	benchmarks();
+	printf("%s: %i failure(s)\n", bad == 0 ? "PASS" : "FAIL", bad);
+	return bad == 0 ? 0 : 1;
+}